@@ -11,13 +11,16 @@
   It can be removed if it is not needed or the target device does not have two UART peripherals.
 
   The path to the firmware file must be adjusted to match the desired file on the system.
+  The version of the firmware is taken from its file name, the update is skipped if the
+  m.YON runs that version already.
 */
 
 #include "HardwareSerial.h"
 
 #include "miotyAtClient.h"
+#include "miotyAtFwUpdate.h"
+#include "miotyAtInfo.h"
 
-#include "XModem.h"
 #include "incbin.h"
 
 // change pins to your setup
@@ -31,14 +34,14 @@
 // adjust to your firmware file path, relative to this sketch
 #define FW_FILE_PATH "0544930_FW_m.YON_bidi_1.3.0.gbl"
 
-void crc_16_chksum(byte *data, size_t dataSize, byte *chksum);
+uint32_t clockMs(void *user);
+void setBaud(void *user, uint32_t baud);
+void progress(void *user, size_t sent, size_t size, uint32_t blockMs);
 
 
 HardwareSerial SerialMyon(MYON_RX_PIN, MYON_TX_PIN);
 HardwareSerial SerialPC(PC_RX_PIN, PC_TX_PIN);
 
-XModem xmodem;
-
 // include the FW update file in the arduino program
 INCBIN(FwFile, FW_FILE_PATH);
 
@@ -46,41 +49,56 @@ void setup() {
   SerialPC.begin(460800);
   SerialMyon.begin(9600);
 
-  // send an empty command, if the device is already in bootloader, this will exit it.
-  SerialMyon.write('\r');
-  delay(500);
-
-  // start bootloader
-  miotyAtClient_startBootloader();
-  SerialPC.println("Starting bootloader");
-  SerialMyon.end();
+  // the update needs a clock for its timeouts
+  miotyAtClient_ctx *ctx = miotyAtClient_defaultCtx();
+  miotyAtClient_setClock(ctx, clockMs);
 
-  // set baudrate to 115200 for the bootloader.
-  SerialMyon.begin(115200);
-  delay(500);
+  // check the firmware file and find its version
+  miotyAtFwUpdate_imageInfo image;
+  if (miotyAtFwUpdate_inspect((const uint8_t *)gFwFileData, gFwFileSize, FW_FILE_PATH, &image) != MIOTYATCLIENT_RETURN_CODE_OK) {
+    SerialPC.println("FW file is damaged");
+    return;
+  }
 
-  xmodem.begin(SerialMyon, XModem::ProtocolType::CRC_XMODEM);
-  // The predefined CRC calculation in the XModem library does not work on little endian systems, so we provide our own.
-  xmodem.setChksumHandler(&crc_16_chksum);
+  // start the bootloader, switch to 115200 baud for it and upload the firmware file,
+  // unless the m.YON runs its version already
+  miotyAtFwUpdate_config cfg;
+  miotyAtFwUpdate_defaultConfig(&cfg);
+  cfg.setBaud = setBaud;
+  cfg.progress = progress;
+  if (image.hasVersion) {
+    cfg.imageVersion = &image.version;
+  }
+  miotyAtFwUpdate_result result;
 
-  // upload firmware file
   SerialPC.println("Starting FW upload");
-  if (xmodem.send((unsigned char *)gFwFileData, gFwFileSize)) {
-    SerialPC.println("FW upload success");
+  miotyAtClient_returnCode ret = miotyAtFwUpdate_run(ctx, &cfg, (const uint8_t *)gFwFileData, gFwFileSize, &result);
+  if (ret == MIOTYATCLIENT_RETURN_CODE_OK && result.status == MIOTYATFWUPDATE_STATUS_SKIPPED) {
+    SerialPC.println("FW is up to date");
+  } else if (ret == MIOTYATCLIENT_RETURN_CODE_OK) {
+    SerialPC.print("FW upload success in ");
+    SerialPC.print(result.transferMs);
+    SerialPC.print(" ms, ");
+    SerialPC.print(result.blockMsAvg);
+    SerialPC.print(" ms per block, retries: ");
+    SerialPC.println(result.retries);
   } else {
-    SerialPC.println("FW upload failed");
+    SerialPC.print("FW upload failed in step ");
+    SerialPC.println(result.status);
   }
-  SerialMyon.end();
 
-  // set baudrate to 9600 again
-  SerialMyon.begin(9600);
+  // the modem restarts with the new firmware
   delay(500);
   // read info
-  uint8_t info_buffer[100] = { 0 };
-  size_t info_len = sizeof(info_buffer);
-  if (miotyAtClient_getEpInfo(info_buffer, &info_len) == MIOTYATCLIENT_RETURN_CODE_OK) {
-    SerialPC.write(info_buffer, info_len);
-    SerialPC.println("");
+  miotyAtInfo_epInfo info;
+  if (miotyAtInfo_readEpInfo(ctx, &info) == MIOTYATCLIENT_RETURN_CODE_OK) {
+    SerialPC.print(info.product);
+    SerialPC.print(" FW ");
+    SerialPC.print(info.fw.major);
+    SerialPC.print(".");
+    SerialPC.print(info.fw.minor);
+    SerialPC.print(".");
+    SerialPC.println(info.fw.patch);
   } else {
     SerialPC.println("Could not read information");
   }
@@ -95,29 +113,29 @@ void miotyAtClientWrite(const uint8_t *data, size_t len) {
 }
 
 bool miotyAtClientRead(uint8_t *data, size_t *len_out) {
-  int i = 0;
-  while (SerialMyon.available() > 0) {
+  size_t i = 0;
+  while (i < *len_out && SerialMyon.available() > 0) {
     data[i++] = SerialMyon.read();
   }
   *len_out = i;
   return true;
 }
 
-// XMODEM CRC16 implementation
-void crc_16_chksum(byte *data, size_t dataSize, byte *chksum) {
-  const uint16_t crc_prime = 0x1021;
-  uint16_t crc = 0;
-
-  for (size_t i = 0; i < dataSize; ++i) {
-    crc ^= (((uint16_t)data[i]) << 8);
-    for (byte j = 0; j < 8; ++j) {
-      if (crc & 0x8000) {
-        crc = (crc << 1) ^ crc_prime;
-      } else {
-        crc <<= 1;
-      }
-    }
+// callbacks of the firmware update
+uint32_t clockMs(void *user) {
+  return millis();
+}
+
+void setBaud(void *user, uint32_t baud) {
+  SerialMyon.end();
+  SerialMyon.begin(baud);
+}
+
+void progress(void *user, size_t sent, size_t size, uint32_t blockMs) {
+  // every 10 kB
+  if (sent % 10240 < 128) {
+    SerialPC.print(sent);
+    SerialPC.print(" / ");
+    SerialPC.println(size);
   }
-  chksum[0] = (crc >> 8) & 0xFF;
-  chksum[1] = crc & 0xFF;
 }
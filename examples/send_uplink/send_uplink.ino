@@ -29,11 +29,18 @@
 HardwareSerial SerialMyon(MYON_RX_PIN, MYON_TX_PIN);
 HardwareSerial SerialPC(PC_RX_PIN, PC_TX_PIN);
 
+uint32_t myonClock(void *user);
+
 
 void setup() {
   SerialPC.begin(460800);
   SerialMyon.begin(9600);
 
+  // let commands fail with a timeout instead of waiting forever for a silent modem
+  miotyAtClient_setClock(miotyAtClient_defaultCtx(), myonClock);
+  // answer repeated queries of EUI, short address, attachment etc. without asking the modem again
+  miotyAtClient_enableCache(miotyAtClient_defaultCtx(), true);
+
   // reset mYON
   miotyAtClient_reset();
   // wait for it to start up again
@@ -110,10 +117,15 @@ void miotyAtClientWrite(const uint8_t *data, size_t len) {
 }
 
 bool miotyAtClientRead (uint8_t *data, size_t *len_out) {
-  int i = 0;
-  while (SerialMyon.available() > 0) {
+  size_t i = 0;
+  while (i < *len_out && SerialMyon.available() > 0) {
     data[i++] = SerialMyon.read();
   }
   *len_out = i;
   return true;
 }
+
+// monotonic clock for the command deadlines
+uint32_t myonClock(void *user) {
+  return millis();
+}
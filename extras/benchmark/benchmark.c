@@ -0,0 +1,838 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       End-to-end benchmark of the client CPU cost per command.
+ *
+ * Every command is executed once against the simulator to record the modem response.
+ * The timed runs then replay that response from memory, so the numbers contain the
+ * client only: command encoding, response parsing and the queue, but no simulator.
+ *
+ * With -record the exchange of every command with the simulator is written to a recording per command
+ * and payload size (see miotyAtReplay.h) instead. -replay runs the commands against such recordings,
+ * e.g. a corpus made with an earlier version of the library: each is replayed once to check that the
+ * client still writes and reads exactly as recorded, then timed as fast as possible, or once at the
+ * recorded pace with -paced.
+ *
+ * Firmware updates are run against the XMODEM receiver of the simulator afterwards, with 128 byte and
+ * XMODEM-1K blocks, the fallback from a receiver without XMODEM-1K, corrupted blocks answered with NAK and
+ * a transfer cancelled by the receiver. They report the transfer time on the virtual clock of the
+ * simulator and the CPU time of the client, and check the image received by the simulator.
+ *
+ * Usage: myon_benchmark [-n iterations per round] [-csv] [-record dir | -replay dir [-paced]]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "miotyAtClient.h"
+#include "miotyAtFwUpdate.h"
+#include "miotyAtReplay.h"
+#include "myonSim.h"
+
+#define RESP_SIZE           MYONSIM_RESP_SIZE
+#define MARKS_SIZE          256
+#define STACK_PAINT_SIZE    (64 * 1024)
+#define STACK_PAINT_BYTE    0xA5
+#define NOINLINE            __attribute__((noinline))
+#define ROUNDS              5       // the fastest round counts, the others contain interference
+#define PATH_SIZE           512
+#define FW_IMAGE_SIZE       (48 * 1024 + 300)   // not a multiple of the block sizes, the last block is padded
+#define DOWNLINK_MPF        0x01
+#define TX_POWER            12      // set by the benchmark, the simulator starts with 14
+#define TEST_FREQUENCY      868000000
+
+static const size_t payload_sizes[] = { 1, 16, 64, 128, 256, 512, 1024 };
+static const size_t chunk_sizes[] = { 1, 4, 16, 32 };
+
+/* transport of the default context, recording from the simulator or replaying from memory */
+static struct {
+    bool        record;
+    myonSim     sim;
+    uint8_t     resp[RESP_SIZE];
+    size_t      respLen;
+    size_t      respPos;
+    size_t      chunk;
+    size_t      written;
+    size_t      marks[MARKS_SIZE];  // respLen at each write, replayed output only follows the write
+    size_t      markCount;
+    size_t      writes;
+} transport;
+
+static uint8_t payload[1024];
+static uint8_t rx_buf[1024];
+
+/* outputs of the last run besides rx_buf */
+static struct {
+    uint32_t    value;              // packet counter, transmit power, uplink mode or profile
+    size_t      len;                // of rx_buf
+    uint8_t     mpf;
+    uint8_t     msta;
+    bool        flag;
+    miotyAtClient_snapshot snapshot;
+} out;
+static uintptr_t paint_lo;
+
+typedef struct {
+    const char *name;
+    bool        sweep;                      // run with every payload size
+    void      (*setup)(size_t size);        // prepares the simulator for recording, may be NULL
+    miotyAtClient_returnCode (*run)(size_t size);
+    bool      (*check)(size_t size);        // compares the outputs of run with the simulator
+} bench_case;
+
+/* firmware update against the simulator, on its own client context */
+typedef struct {
+    const char *name;
+    bool        block1k;                    // sender tries XMODEM-1K
+    bool        receiver1k;                 // bootloader accepts XMODEM-1K
+    uint16_t    corruptPermille;            // of the blocks, answered with NAK
+    bool        cancel;                     // resume an interrupted transfer at a block the receiver does not expect
+    miotyAtFwUpdate_status status;          // expected
+} fw_case;
+
+static const fw_case fw_cases[] = {
+    { "128 byte blocks",        false, false,  0, false, MIOTYATFWUPDATE_STATUS_OK          },
+    { "1K blocks",              true,  true,   0, false, MIOTYATFWUPDATE_STATUS_OK          },
+    { "1K fallback to 128",     true,  false,  0, false, MIOTYATFWUPDATE_STATUS_OK          },
+    { "128 NAK retries",        false, false, 50, false, MIOTYATFWUPDATE_STATUS_OK          },
+    { "1K NAK retries",         true,  true,  50, false, MIOTYATFWUPDATE_STATUS_OK          },
+    { "cancelled by receiver",  false, false,  0, true,  MIOTYATFWUPDATE_STATUS_CANCELLED   },
+};
+
+static struct {
+    myonSim     sim;
+    uint8_t     image[FW_IMAGE_SIZE];
+    uint32_t    failAfterBlocks;            // the read callback fails once this many blocks were received, 0 never
+} fw;
+
+typedef struct {
+    double      nsPerCmd;
+    size_t      bytesOut;
+    size_t      bytesIn;
+    size_t      stack;
+    miotyAtClient_returnCode ret;
+} bench_result;
+
+
+void miotyAtClientWrite(const uint8_t *data, size_t len) {
+    transport.written += len;
+    if (transport.record) {
+        myonSim_write(&transport.sim, data, len);
+        if (transport.markCount < MARKS_SIZE)
+            transport.marks[transport.markCount++] = transport.respLen;
+    } else {
+        transport.writes++;
+    }
+}
+
+bool miotyAtClientRead(uint8_t *data, size_t *len_out) {
+    if (transport.record) {
+        myonSim_read(&transport.sim, data, len_out);
+        if (transport.respLen + *len_out <= sizeof(transport.resp)) {
+            memcpy(&transport.resp[transport.respLen], data, *len_out);
+            transport.respLen += *len_out;
+        }
+        return true;
+    }
+    size_t end = transport.writes < transport.markCount ? transport.marks[transport.writes] : transport.respLen;
+    size_t n = end - transport.respPos;
+    if (n > transport.chunk)
+        n = transport.chunk;
+    if (n > *len_out)
+        n = *len_out;
+    memcpy(data, &transport.resp[transport.respPos], n);
+    transport.respPos += n;
+    *len_out = n;
+    return true;
+}
+
+
+static bool fw_read(void *user, uint8_t *data, size_t *len_out) {
+    if (fw.failAfterBlocks && fw.sim.stats.fwBlocks >= fw.failAfterBlocks) {
+        fw.failAfterBlocks = 0;
+        return false;
+    }
+    return myonSim_read(user, data, len_out);
+}
+
+
+static void setup_downlink(size_t size) {
+    myonSim_queueDownlink(&transport.sim, payload, size, DOWNLINK_MPF);
+}
+
+static void setup_detached(size_t size) {
+    (void)size;
+    transport.sim.attached = 0;
+}
+
+static void setup_attached(size_t size) {
+    (void)size;
+    transport.sim.attached = 1;
+}
+
+static miotyAtClient_returnCode run_uni(size_t size) {
+    return miotyAtClient_sendMessageUni(payload, size, &out.value);
+}
+
+static miotyAtClient_returnCode run_uni_mpf(size_t size) {
+    return miotyAtClient_sendMessageUniMPF(payload, size, &out.value);
+}
+
+static miotyAtClient_returnCode run_uni_transparent(size_t size) {
+    return miotyAtClient_sendMessageUniTransparent(payload, size, &out.value);
+}
+
+static miotyAtClient_returnCode run_bidi(size_t size) {
+    out.len = sizeof(rx_buf);
+    return miotyAtClient_sendMessageBidi(payload, size, rx_buf, &out.len, &out.mpf, &out.value);
+}
+
+static miotyAtClient_returnCode run_bidi_mpf(size_t size) {
+    out.len = sizeof(rx_buf);
+    return miotyAtClient_sendMessageBidiMPF(payload, size, rx_buf, &out.len, &out.mpf, &out.value);
+}
+
+static miotyAtClient_returnCode run_bidi_transparent(size_t size) {
+    out.len = sizeof(rx_buf);
+    out.mpf = DOWNLINK_MPF;     // not reported by the transparent mode
+    return miotyAtClient_sendMessageBidiTransparent(payload, size, rx_buf, &out.len, &out.value);
+}
+
+static miotyAtClient_returnCode run_get_eui(size_t size) {
+    (void)size;
+    return miotyAtClient_getOrSetEui(rx_buf, false);
+}
+
+static miotyAtClient_returnCode run_set_eui(size_t size) {
+    (void)size;
+    return miotyAtClient_getOrSetEui(payload, true);
+}
+
+static miotyAtClient_returnCode run_get_short_address(size_t size) {
+    (void)size;
+    return miotyAtClient_getOrSetShortAddress(rx_buf, false);
+}
+
+static miotyAtClient_returnCode run_set_short_address(size_t size) {
+    (void)size;
+    return miotyAtClient_getOrSetShortAddress(payload, true);
+}
+
+static miotyAtClient_returnCode run_get_ipv6(size_t size) {
+    (void)size;
+    return miotyAtClient_getOrSetIPv6SubnetMask(rx_buf, false);
+}
+
+static miotyAtClient_returnCode run_set_network_key(size_t size) {
+    (void)size;
+    return miotyAtClient_setNetworkKey(payload);
+}
+
+static miotyAtClient_returnCode run_refresh_packet_counter(size_t size) {
+    (void)size;
+    return miotyAtClient_refreshPacketCounter(&out.value);
+}
+
+static miotyAtClient_returnCode run_packet_counter(size_t size) {
+    (void)size;
+    return miotyAtClient_getPacketCounter(&out.value);
+}
+
+static miotyAtClient_returnCode run_get_tx_power(size_t size) {
+    (void)size;
+    return miotyAtClient_getOrSetTransmitPower(&out.value, false);
+}
+
+static miotyAtClient_returnCode run_set_tx_power(size_t size) {
+    (void)size;
+    out.value = TX_POWER;
+    return miotyAtClient_getOrSetTransmitPower(&out.value, true);
+}
+
+static miotyAtClient_returnCode run_uplink_mode(size_t size) {
+    (void)size;
+    return miotyAtClient_uplinkMode(&out.value, false);
+}
+
+static miotyAtClient_returnCode run_uplink_profile(size_t size) {
+    (void)size;
+    return miotyAtClient_uplinkProfile(&out.value, false);
+}
+
+static miotyAtClient_returnCode run_attach_local(size_t size) {
+    (void)size;
+    return miotyAtClient_macAttachLocal(&out.msta);
+}
+
+static miotyAtClient_returnCode run_detach_local(size_t size) {
+    (void)size;
+    return miotyAtClient_macDetachLocal(&out.msta);
+}
+
+static miotyAtClient_returnCode run_attach(size_t size) {
+    (void)size;
+    return miotyAtClient_macAttach(payload, &out.msta);
+}
+
+static miotyAtClient_returnCode run_detach(size_t size) {
+    (void)size;
+    return miotyAtClient_macDetach(payload, 4, &out.msta);
+}
+
+static miotyAtClient_returnCode run_get_attachment(size_t size) {
+    (void)size;
+    return miotyAtClient_getAttachment(&out.flag);
+}
+
+static miotyAtClient_returnCode run_downlink_request(size_t size) {
+    (void)size;
+    return miotyAtClient_downlinkRequestResponseFlag(&out.flag, false);
+}
+
+static miotyAtClient_returnCode run_ep_info(size_t size) {
+    (void)size;
+    out.len = sizeof(rx_buf);
+    return miotyAtClient_getEpInfo(rx_buf, &out.len);
+}
+
+static miotyAtClient_returnCode run_core_lib_info(size_t size) {
+    (void)size;
+    out.len = sizeof(rx_buf);
+    return miotyAtClient_getCoreLibInfo(rx_buf, &out.len);
+}
+
+static miotyAtClient_returnCode run_snapshot(size_t size) {
+    (void)size;
+    return miotyAtClient_getSnapshot(&out.snapshot);
+}
+
+static miotyAtClient_returnCode run_tx_inhibit(size_t size) {
+    (void)size;
+    return miotyAtClient_txInhibit(&out.flag, false);
+}
+
+static miotyAtClient_returnCode run_tx_active(size_t size) {
+    (void)size;
+    return miotyAtClient_txActive(&out.flag, false);
+}
+
+static miotyAtClient_returnCode run_rx_active(size_t size) {
+    (void)size;
+    return miotyAtClient_rxActive(&out.flag, false);
+}
+
+static miotyAtClient_returnCode run_tx_cont_unmodulated(size_t size) {
+    (void)size;
+    return miotyAtClient_startTxContUnmodulated(TEST_FREQUENCY);
+}
+
+static miotyAtClient_returnCode run_tx_cont_modulated(size_t size) {
+    (void)size;
+    return miotyAtClient_startTxContModulated(TEST_FREQUENCY);
+}
+
+static miotyAtClient_returnCode run_tx_off(size_t size) {
+    (void)size;
+    return miotyAtClient_stopTxCont();
+}
+
+static miotyAtClient_returnCode run_rx_cont(size_t size) {
+    (void)size;
+    return miotyAtClient_startRxCont(TEST_FREQUENCY);
+}
+
+static miotyAtClient_returnCode run_rx_off(size_t size) {
+    (void)size;
+    return miotyAtClient_stopRxCont();
+}
+
+static miotyAtClient_returnCode run_reset(size_t size) {
+    (void)size;
+    return miotyAtClient_reset();
+}
+
+/* the checks compare what the last run returned with the simulator after the recorded command */
+
+static bool check_uplink(size_t size) {
+    (void)size;
+    return transport.sim.stats.uplinks == 1 && out.value == transport.sim.packetCounter;
+}
+
+static bool check_bidi(size_t size) {
+    return check_uplink(size) && transport.sim.stats.downlinks == 1 && out.len == size
+           && memcmp(rx_buf, payload, size) == 0 && out.mpf == DOWNLINK_MPF;
+}
+
+static bool check_get_eui(size_t size) {
+    (void)size;
+    return memcmp(rx_buf, transport.sim.eui, sizeof(transport.sim.eui)) == 0;
+}
+
+static bool check_set_eui(size_t size) {
+    (void)size;
+    return memcmp(transport.sim.eui, payload, sizeof(transport.sim.eui)) == 0;
+}
+
+static bool check_get_short_address(size_t size) {
+    (void)size;
+    return memcmp(rx_buf, transport.sim.shortAddress, sizeof(transport.sim.shortAddress)) == 0;
+}
+
+static bool check_set_short_address(size_t size) {
+    (void)size;
+    return memcmp(transport.sim.shortAddress, payload, sizeof(transport.sim.shortAddress)) == 0;
+}
+
+static bool check_get_ipv6(size_t size) {
+    (void)size;
+    return memcmp(rx_buf, transport.sim.ipv6, sizeof(transport.sim.ipv6)) == 0;
+}
+
+static bool check_set_network_key(size_t size) {
+    (void)size;
+    return transport.sim.networkKeySet && memcmp(transport.sim.networkKey, payload, sizeof(transport.sim.networkKey)) == 0;
+}
+
+static bool check_packet_counter(size_t size) {
+    (void)size;
+    return out.value == transport.sim.packetCounter;
+}
+
+static bool check_tx_power(size_t size) {
+    (void)size;
+    return out.value == transport.sim.txPower;
+}
+
+static bool check_set_tx_power(size_t size) {
+    (void)size;
+    return transport.sim.txPower == TX_POWER;
+}
+
+static bool check_uplink_mode(size_t size) {
+    (void)size;
+    return out.value == transport.sim.uplinkMode;
+}
+
+static bool check_uplink_profile(size_t size) {
+    (void)size;
+    return out.value == transport.sim.uplinkProfile;
+}
+
+static bool check_attached(size_t size) {
+    (void)size;
+    return out.msta == 1 && transport.sim.attached;
+}
+
+static bool check_detached(size_t size) {
+    (void)size;
+    return out.msta == 0 && !transport.sim.attached;
+}
+
+static bool check_get_attachment(size_t size) {
+    (void)size;
+    return out.flag == (transport.sim.attached != 0);
+}
+
+static bool check_downlink_request(size_t size) {
+    (void)size;
+    return out.flag == (transport.sim.downlinkRequest != 0);
+}
+
+static bool check_ep_info(size_t size) {
+    (void)size;
+    return out.len == strlen(transport.sim.epInfo) && memcmp(rx_buf, transport.sim.epInfo, out.len) == 0;
+}
+
+static bool check_core_lib_info(size_t size) {
+    (void)size;
+    return out.len == strlen(transport.sim.libVersion) && memcmp(rx_buf, transport.sim.libVersion, out.len) == 0;
+}
+
+static bool check_snapshot(size_t size) {
+    (void)size;
+    const miotyAtClient_snapshot *s = &out.snapshot;
+    const myonSim *sim = &transport.sim;
+    return s->valid == MIOTYATCLIENT_SNAPSHOT_ALL && strcmp(s->epInfo, sim->epInfo) == 0
+           && strcmp(s->coreLibInfo, sim->libVersion) == 0 && memcmp(s->eui, sim->eui, sizeof(s->eui)) == 0
+           && memcmp(s->shortAddress, sim->shortAddress, sizeof(s->shortAddress)) == 0
+           && s->packetCounter == sim->packetCounter && s->attached == (sim->attached != 0)
+           && s->downlinkRequest == (sim->downlinkRequest != 0) && s->txPower == sim->txPower
+           && s->uplinkMode == sim->uplinkMode && s->uplinkProfile == sim->uplinkProfile;
+}
+
+static bool check_tx_inhibit(size_t size) {
+    (void)size;
+    return out.flag == (transport.sim.txInhibit != 0);
+}
+
+static bool check_tx_active(size_t size) {
+    (void)size;
+    return out.flag == (transport.sim.txActive != 0);
+}
+
+static bool check_rx_active(size_t size) {
+    (void)size;
+    return out.flag == (transport.sim.rxActive != 0);
+}
+
+static bool check_test_on(size_t size) {
+    (void)size;
+    return transport.sim.testFrequency == TEST_FREQUENCY;
+}
+
+static bool check_test_off(size_t size) {
+    (void)size;
+    return transport.sim.testFrequency == 0;
+}
+
+static bool check_reset(size_t size) {
+    (void)size;
+    return transport.sim.stats.commands == 1;
+}
+
+static const bench_case cases[] = {
+    { "sendMessageUni",                 true,  NULL,            run_uni,                    check_uplink            },
+    { "sendMessageUniMPF",              true,  NULL,            run_uni_mpf,                check_uplink            },
+    { "sendMessageUniTransparent",      true,  NULL,            run_uni_transparent,        check_uplink            },
+    { "sendMessageBidi",                true,  setup_downlink,  run_bidi,                   check_bidi              },
+    { "sendMessageBidiMPF",             true,  setup_downlink,  run_bidi_mpf,               check_bidi              },
+    { "sendMessageBidiTransparent",     true,  setup_downlink,  run_bidi_transparent,       check_bidi              },
+    { "getOrSetEui get",                false, NULL,            run_get_eui,                check_get_eui           },
+    { "getOrSetEui set",                false, NULL,            run_set_eui,                check_set_eui           },
+    { "getOrSetShortAddress get",       false, NULL,            run_get_short_address,      check_get_short_address },
+    { "getOrSetShortAddress set",       false, NULL,            run_set_short_address,      check_set_short_address },
+    { "getOrSetIPv6SubnetMask get",     false, NULL,            run_get_ipv6,               check_get_ipv6          },
+    { "setNetworkKey",                  false, NULL,            run_set_network_key,        check_set_network_key   },
+    { "refreshPacketCounter",           false, NULL,            run_refresh_packet_counter, check_packet_counter    },
+    { "getPacketCounter",               false, NULL,            run_packet_counter,         check_packet_counter    },
+    { "getOrSetTransmitPower get",      false, NULL,            run_get_tx_power,           check_tx_power          },
+    { "getOrSetTransmitPower set",      false, NULL,            run_set_tx_power,           check_set_tx_power      },
+    { "uplinkMode",                     false, NULL,            run_uplink_mode,            check_uplink_mode       },
+    { "uplinkProfile",                  false, NULL,            run_uplink_profile,         check_uplink_profile    },
+    { "macAttachLocal",                 false, setup_detached,  run_attach_local,           check_attached          },
+    { "macDetachLocal",                 false, setup_attached,  run_detach_local,           check_detached          },
+    { "macAttach",                      false, setup_detached,  run_attach,                 check_attached          },
+    { "macDetach",                      false, setup_attached,  run_detach,                 check_detached          },
+    { "getAttachment",                  false, NULL,            run_get_attachment,         check_get_attachment    },
+    { "downlinkRequestResponseFlag",    false, NULL,            run_downlink_request,       check_downlink_request  },
+    { "getEpInfo",                      false, NULL,            run_ep_info,                check_ep_info           },
+    { "getCoreLibInfo",                 false, NULL,            run_core_lib_info,          check_core_lib_info     },
+    { "getSnapshot",                    false, NULL,            run_snapshot,               check_snapshot          },
+    { "txInhibit",                      false, NULL,            run_tx_inhibit,             check_tx_inhibit        },
+    { "txActive",                       false, NULL,            run_tx_active,              check_tx_active         },
+    { "rxActive",                       false, NULL,            run_rx_active,              check_rx_active         },
+    { "startTxContUnmodulated",         false, NULL,            run_tx_cont_unmodulated,    check_test_on           },
+    { "startTxContModulated",           false, NULL,            run_tx_cont_modulated,      check_test_on           },
+    { "stopTxCont",                     false, NULL,            run_tx_off,                 check_test_off          },
+    { "startRxCont",                    false, NULL,            run_rx_cont,                check_test_on           },
+    { "stopRxCont",                     false, NULL,            run_rx_off,                 check_test_off          },
+    { "reset",                          false, NULL,            run_reset,                  check_reset             },
+};
+
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// fills the unused stack below the caller with a pattern
+static NOINLINE void stack_paint(void) {
+    volatile uint8_t area[STACK_PAINT_SIZE];
+    for (size_t i = 0; i < sizeof(area); i++)
+        area[i] = STACK_PAINT_BYTE;
+    paint_lo = (uintptr_t)area;
+}
+
+// stack used below top since the last stack_paint
+static NOINLINE size_t stack_used(const uint8_t *top) {
+    const volatile uint8_t *p = (const volatile uint8_t *)paint_lo;
+    while (p < top && *p == STACK_PAINT_BYTE)
+        p++;
+    return (size_t)(top - (const uint8_t *)p);
+}
+
+static NOINLINE size_t measure_stack(const bench_case *c, size_t size) {
+    const uint8_t *top = __builtin_frame_address(0);
+    transport.respPos = 0;
+    transport.writes = 0;
+    stack_paint();
+    c->run(size);
+    return stack_used(top);
+}
+
+static bench_result run_case(const bench_case *c, size_t size, size_t chunk, unsigned iterations) {
+    bench_result res = { 0 };
+
+    /* record the response of the simulator */
+    myonSim_init(&transport.sim, NULL);
+    if (c->setup)
+        c->setup(size);
+    transport.record = true;
+    transport.respLen = 0;
+    transport.written = 0;
+    transport.markCount = 0;
+    res.ret = c->run(size);
+    res.bytesOut = transport.written;
+    res.bytesIn = transport.respLen;
+    if (res.ret == MIOTYATCLIENT_RETURN_CODE_OK && !c->check(size))
+        res.ret = MIOTYATCLIENT_RETURN_CODE_ERR;
+
+    /* replay it */
+    transport.record = false;
+    transport.chunk = chunk;
+    res.stack = measure_stack(c, size);
+    for (int round = 0; round < ROUNDS; round++) {
+        uint64_t start = now_ns();
+        for (unsigned i = 0; i < iterations; i++) {
+            transport.respPos = 0;
+            transport.writes = 0;
+            c->run(size);
+        }
+        double ns = (double)(now_ns() - start) / iterations;
+        if (round == 0 || ns < res.nsPerCmd)
+            res.nsPerCmd = ns;
+    }
+    /* the replayed response has to give the same result */
+    if (res.ret == MIOTYATCLIENT_RETURN_CODE_OK && !c->check(size))
+        res.ret = MIOTYATCLIENT_RETURN_CODE_ERR;
+    return res;
+}
+
+// recording of a command in dir, spaces in the name are replaced
+static void case_path(char *path, const char *dir, const char *name, size_t size) {
+    int n = snprintf(path, PATH_SIZE, "%s/%s_%zu.mrec", dir, name, size);
+    for (char *p = path + strlen(dir); n > 0 && *p; p++)
+        if (*p == ' ')
+            *p = '_';
+}
+
+static bool record_case(const bench_case *c, size_t size, const char *path) {
+    miotyAtReplay_recorder recorder;
+    myonSim_init(&transport.sim, NULL);
+    if (c->setup)
+        c->setup(size);
+    transport.record = true;
+    transport.respLen = 0;
+    if (miotyAtReplay_record(&recorder, miotyAtClient_defaultCtx(), path) != MIOTYATCLIENT_RETURN_CODE_OK) {
+        perror(path);
+        return false;
+    }
+    miotyAtClient_returnCode ret = c->run(size);
+    if (miotyAtReplay_stopRecording(&recorder, miotyAtClient_defaultCtx()) != MIOTYATCLIENT_RETURN_CODE_OK) {
+        perror(path);
+        return false;
+    }
+    return ret == MIOTYATCLIENT_RETURN_CODE_OK && c->check(size);
+}
+
+// replays a recording with the default context, false if it is missing or the client deviated from it
+static bool replay_case(const bench_case *c, size_t size, const char *path, unsigned iterations, bool paced,
+                        bench_result *res) {
+    miotyAtReplay replay;
+    miotyAtClient_ctx *ctx = miotyAtClient_defaultCtx();
+    if (miotyAtReplay_open(&replay, path) != MIOTYATCLIENT_RETURN_CODE_OK)
+        return false;
+    const miotyAtClient_ctx saved = *ctx;
+    miotyAtReplay_bind(&replay, ctx, paced);
+
+    uint64_t start = now_ns();
+    res->ret = c->run(size);
+    res->nsPerCmd = (double)(now_ns() - start);
+    bool exact = miotyAtReplay_finished(&replay) && miotyAtReplay_mismatches(&replay) == 0;
+    for (int round = 0; !paced && round < ROUNDS; round++) {
+        start = now_ns();
+        for (unsigned i = 0; i < iterations; i++) {
+            miotyAtReplay_rewind(&replay);
+            c->run(size);
+        }
+        double ns = (double)(now_ns() - start) / iterations;
+        if (round == 0 || ns < res->nsPerCmd)
+            res->nsPerCmd = ns;
+    }
+
+    ctx->write = saved.write;
+    ctx->writev = saved.writev;
+    ctx->read = saved.read;
+    ctx->clock = saved.clock;
+    ctx->idle = saved.idle;
+    ctx->user = saved.user;
+    miotyAtReplay_close(&replay);
+    return exact;
+}
+
+static void print_result(bool csv, const char *name, size_t size, size_t chunk, const bench_result *r) {
+    const double cmdsPerSec = r->nsPerCmd > 0 ? 1e9 / r->nsPerCmd : 0;
+    if (csv)
+        printf("%s,%zu,%zu,%.0f,%.1f,%zu,%zu,%zu,%d\n", name, size, chunk, cmdsPerSec, r->nsPerCmd,
+               r->bytesOut, r->bytesIn, r->stack, r->ret);
+    else
+        printf("%-30s %7zu %5zu %12.0f %10.1f %8zu %8zu %7zu %4d\n", name, size, chunk, cmdsPerSec, r->nsPerCmd,
+               r->bytesOut, r->bytesIn, r->stack, r->ret);
+}
+
+// hash of the simulator over the image and the padding of its last block
+static uint32_t fw_hash(size_t received) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < received; i++)
+        hash = (hash ^ (i < sizeof(fw.image) ? fw.image[i] : 0x1A)) * 16777619u;
+    return hash;
+}
+
+// runs one update against a fresh simulator, false if the outcome is not the expected one
+static bool run_fw_case(const fw_case *c, bool csv) {
+    myonSim_config simCfg = {
+        .baudRate = 9600, .bootloaderBaudRate = 115200, .latencyUs = 20000, .blockLatencyUs = 3000,
+        .bootloader1k = c->receiver1k, .corruptPermille = c->corruptPermille,
+    };
+    myonSim_init(&fw.sim, &simCfg);
+    miotyAtClient_ctx ctx;
+    miotyAtClient_init(&ctx, myonSim_write, fw_read, &fw.sim);
+    miotyAtClient_setClock(&ctx, myonSim_clockMs);
+    miotyAtFwUpdate_config cfg;
+    miotyAtFwUpdate_defaultConfig(&cfg);
+    cfg.block1k = c->block1k;
+
+    miotyAtFwUpdate_result result, interrupted;
+    uint64_t start = now_ns();
+    if (c->cancel) {
+        /* the host stops reading during the transfer, the bootloader still waits for the next block */
+        fw.failAfterBlocks = 100;
+        if (miotyAtFwUpdate_run(&ctx, &cfg, fw.image, sizeof(fw.image), &interrupted) != MIOTYATCLIENT_RETURN_CODE_ATReadFailed)
+            return false;
+        interrupted.bytesSent += 10 * interrupted.blockSize;
+        interrupted.blocks += 10;
+        cfg.resume = &interrupted;
+        start = now_ns();
+    }
+    const miotyAtClient_returnCode ret = miotyAtFwUpdate_run(&ctx, &cfg, fw.image, sizeof(fw.image), &result);
+    const double ms = (double)(now_ns() - start) / 1e6;
+
+    bool ok = result.status == c->status;
+    if (c->status == MIOTYATFWUPDATE_STATUS_OK)
+        ok = ok && ret == MIOTYATCLIENT_RETURN_CODE_OK && fw.sim.stats.fwUpdates == 1
+             && fw.sim.stats.fwBytes >= sizeof(fw.image) && fw.sim.stats.fwHash == fw_hash(fw.sim.stats.fwBytes)
+             && result.fallback == (c->block1k && !c->receiver1k) && (result.retries > 0 || c->corruptPermille == 0);
+    else
+        ok = ok && ret == MIOTYATCLIENT_RETURN_CODE_ERR && fw.sim.stats.fwUpdates == 0 && !fw.sim.bootloader;
+
+    const unsigned block = c->block1k && !result.fallback ? 1024 : 128;
+    const double kBps = result.transferMs ? (double)result.bytesSent / result.transferMs : 0;
+    if (csv)
+        printf("%s,%u,%u,%u,%u,%.2f,%.3f,%d,%d\n", c->name, block, result.blocks, result.retries,
+               result.transferMs, kBps, ms, result.status, ok ? 0 : 1);
+    else
+        printf("%-30s %5u %7u %7u %10u %8.2f %8.3f %6d %4d\n", c->name, block, result.blocks, result.retries,
+               result.transferMs, kBps, ms, result.status, ok ? 0 : 1);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    unsigned iterations = 2000;
+    bool csv = false;
+    bool paced = false;
+    const char *recordDir = NULL;
+    const char *replayDir = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            iterations = (unsigned)strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-csv") == 0)
+            csv = true;
+        else if (strcmp(argv[i], "-record") == 0 && i + 1 < argc)
+            recordDir = argv[++i];
+        else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc)
+            replayDir = argv[++i];
+        else if (strcmp(argv[i], "-paced") == 0)
+            paced = true;
+        else {
+            fprintf(stderr, "usage: %s [-n iterations] [-csv] [-record dir | -replay dir [-paced]]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (iterations == 0)
+        iterations = 1;
+    for (size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 31 + 7);
+    for (size_t i = 0; i < sizeof(fw.image); i++)
+        fw.image[i] = (uint8_t)(i * 131 + (i >> 8));
+
+    if (csv && !recordDir)
+        printf("command,payload,read_chunk,cmds_per_s,ns_per_cmd,bytes_out,bytes_in,stack,return_code\n");
+    else if (!recordDir)
+        printf("%-30s %7s %5s %12s %10s %8s %8s %7s %4s\n", "command", "payload", "chunk", "cmds/s", "ns/cmd",
+               "out B", "in B", "stack", "ret");
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const bench_case *c = &cases[i];
+        const size_t nSizes = c->sweep ? sizeof(payload_sizes) / sizeof(payload_sizes[0]) : 1;
+        for (size_t s = 0; s < nSizes; s++) {
+            const size_t size = c->sweep ? payload_sizes[s] : 0;
+            char path[PATH_SIZE];
+            if (recordDir) {
+                case_path(path, recordDir, c->name, size);
+                if (!record_case(c, size, path))
+                    failed++;
+                continue;
+            }
+            if (replayDir) {
+                /* chunk 0: as recorded, bytes and stack are not measured */
+                bench_result r = { 0 };
+                case_path(path, replayDir, c->name, size);
+                if (!replay_case(c, size, path, iterations, paced, &r)) {
+                    fprintf(stderr, "%s: missing or not replayed exactly\n", path);
+                    failed++;
+                }
+                print_result(csv, c->name, size, 0, &r);
+                if (r.ret != MIOTYATCLIENT_RETURN_CODE_OK)
+                    failed++;
+                continue;
+            }
+            for (size_t k = 0; k < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); k++) {
+                bench_result r = run_case(c, size, chunk_sizes[k], iterations);
+                print_result(csv, c->name, size, chunk_sizes[k], &r);
+                if (r.ret != MIOTYATCLIENT_RETURN_CODE_OK)
+                    failed++;
+            }
+        }
+    }
+    if (recordDir || replayDir)
+        return failed ? 1 : 0;
+
+    if (csv)
+        printf("update,block,blocks,retries,transfer_ms,kB_per_s,cpu_ms,status,failed\n");
+    else
+        printf("\n%-30s %5s %7s %7s %10s %8s %8s %6s %4s\n", "firmware update", "block", "blocks", "retries",
+               "xfer ms", "kB/s", "cpu ms", "status", "fail");
+    for (size_t i = 0; i < sizeof(fw_cases) / sizeof(fw_cases[0]); i++) {
+        if (!run_fw_case(&fw_cases[i], csv))
+            failed++;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,42 @@
+# Decodes the trace dump written by the trace case with myon_trace and checks the transcript line by line.
+#
+#   cmake -DMYON_TRACE=path/to/myon_trace -DDUMP=trace.dump -P check_trace.cmake
+
+cmake_policy(SET CMP0007 NEW)
+
+execute_process(COMMAND ${MYON_TRACE} ${DUMP} OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "myon_trace ${DUMP} failed (${rc}):\n${out}")
+endif()
+
+# the records of the session in order: command number, direction and the bytes with control characters escaped
+set(expected
+    "#1   -> AT-MEUI?\\r"
+    "#1   <- -MEUI:8\\t70B3D56770000001\\x1A\\r\\n0\\r\\n"
+    "#1   == 0 OK  (AT-MEUI?)"
+    "#2   -> AT-U=5\\t68656C6C6F\\x1A\\r"
+    "#2   <- -MPCT:1\\r\\n0\\r\\n"
+    "#2   == 0 OK  (AT-U)"
+    "#3   -> AT-MEUI?\\r"
+    "#3   <- AT!ERR:1\\r\\n2\\r\\n"
+    "#3   == 201 ATgenericErr  (AT-MEUI?)"
+)
+
+string(REPLACE "\n" ";" lines "${out}")
+list(REMOVE_ITEM lines "")
+list(LENGTH expected count)
+list(LENGTH lines got)
+# a header line before the records, nothing after the last one
+math(EXPR want "${count} + 1")
+if(NOT got EQUAL want)
+    message(FATAL_ERROR "expected ${count} records, got:\n${out}")
+endif()
+foreach(i RANGE 1 ${count})
+    math(EXPR e "${i} - 1")
+    list(GET expected ${e} line)
+    list(GET lines ${i} decoded)
+    string(FIND "${decoded}" "${line}" at)
+    if(at EQUAL -1)
+        message(FATAL_ERROR "record ${i}: expected \"${line}\", got \"${decoded}\"")
+    endif()
+endforeach()
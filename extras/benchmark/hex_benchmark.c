@@ -0,0 +1,163 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Throughput of the hex encode/decode kernels, every available kernel against the scalar one.
+ *
+ * Usage: myon_hex_benchmark [-n bytes per round] [-csv]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "data_tools/hex_kernels.h"
+
+#define ROUNDS              5       // the fastest round counts, the others contain interference
+
+static const size_t sizes[] = { 8, 16, 32, 64, 256, 1024, 4096 };
+
+static const struct {
+    hex_kernel  kernel;
+    const char *name;
+} kernels[] = {
+    { HEX_KERNEL_SCALAR, "scalar" },
+    { HEX_KERNEL_SSE2,   "sse2"   },
+    { HEX_KERNEL_AVX2,   "avx2"   },
+    { HEX_KERNEL_NEON,   "neon"   },
+};
+
+static uint8_t bytes[4096];
+static uint8_t decoded[4096];
+static char hex[2 * 4096];
+static volatile uint8_t sink;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+// bytes per ns, i.e. GB/s, of the fastest round
+static double measure(bool decode, size_t size, size_t total) {
+    size_t iterations = total / size ? total / size : 1;
+    double best = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < iterations; i++) {
+            if (decode)
+                hex_decode(hex, size, decoded);
+            else
+                hex_encode(bytes, size, hex);
+            sink = decode ? decoded[i % size] : (uint8_t)hex[i % size];
+        }
+        double rate = (double)(iterations * size) / (double)(now_ns() - start + 1);
+        if (rate > best)
+            best = rate;
+    }
+    return best;
+}
+
+// all kernels must produce the result of the scalar one
+static bool verify(hex_kernel kernel) {
+    static char ref[2 * 4096];
+    static const char bad[] = { 'G', 'g', '/', ':', '@', '`', ' ', '\x1A', '\xC1' };
+
+    hex_setKernel(HEX_KERNEL_SCALAR);
+    hex_encode(bytes, sizeof(bytes), ref);
+    hex_setKernel(kernel);
+    for (size_t n = 0; n <= 100; n++) {
+        hex_encode(bytes, n, hex);
+        if (memcmp(hex, ref, 2 * n) != 0 || !hex_decode(hex, n, decoded) || memcmp(decoded, bytes, n) != 0)
+            return false;
+    }
+    /* lower case is accepted */
+    for (size_t i = 0; i < 2 * 100; i++)
+        hex[i] = (hex[i] >= 'A' && hex[i] <= 'F') ? hex[i] + 'a' - 'A' : hex[i];
+    if (!hex_decode(hex, 100, decoded) || memcmp(decoded, bytes, 100) != 0)
+        return false;
+    /* every position of a non hex character is detected */
+    for (size_t i = 0; i < 2 * 100; i++) {
+        char saved = hex[i];
+        hex[i] = bad[i % sizeof(bad)];
+        bool ok = hex_decode(hex, 100, decoded);
+        hex[i] = saved;
+        if (ok)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    size_t total = 1 << 24;
+    bool csv = false;
+    bool failed = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            total = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "-csv") == 0) {
+            csv = true;
+        } else {
+            fprintf(stderr, "usage: %s [-n bytes per round] [-csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    srand(1);
+    for (size_t i = 0; i < sizeof(bytes); i++)
+        bytes[i] = (uint8_t)rand();
+
+    if (csv)
+        printf("kernel,size,encode_gbps,decode_gbps,encode_speedup,decode_speedup\n");
+    else
+        printf("%-8s %6s %12s %12s %9s %9s\n", "kernel", "size", "enc GB/s", "dec GB/s", "enc x", "dec x");
+
+    double scalar[2][sizeof(sizes) / sizeof(sizes[0])] = { { 0 } };
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!hex_setKernel(kernels[k].kernel))
+            continue;
+        if (!verify(kernels[k].kernel)) {
+            fprintf(stderr, "%s: result differs from the scalar kernel\n", kernels[k].name);
+            failed = true;
+            continue;
+        }
+        hex_setKernel(kernels[k].kernel);
+        hex_encode(bytes, sizeof(bytes), hex);
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            double enc = measure(false, sizes[s], total);
+            double dec = measure(true, sizes[s], total);
+            if (kernels[k].kernel == HEX_KERNEL_SCALAR) {
+                scalar[0][s] = enc;
+                scalar[1][s] = dec;
+            }
+            printf(csv ? "%s,%zu,%.3f,%.3f,%.2f,%.2f\n" : "%-8s %6zu %12.3f %12.3f %9.2f %9.2f\n",
+                   kernels[k].name, sizes[s], enc, dec, enc / scalar[0][s], dec / scalar[1][s]);
+        }
+    }
+    return failed ? 1 : 0;
+}
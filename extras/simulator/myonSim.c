@@ -0,0 +1,789 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Host side simulator of a m.YON MIOTY™ modem.
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stddef.h>
+#include "myonSim.h"
+
+/* error codes of the AT protocol, see miotyAtClient_returnCode */
+#define MAC_ERR_GENERIC         1
+#define MAC_ERR_NOT_ATTACHED    6
+#define MAC_ERR_KEY_NOT_SET     7
+#define MAC_ERR_ALREADY_ATTACHED 8
+#define MAC_ERR_NO_DOWNLINK     12
+#define MAC_ERR_BUSY            18
+#define AT_ERR_GENERIC          1
+#define AT_ERR_UNKNOWN_CMD      2
+#define AT_ERR_PARAM_OOB        3
+#define AT_ERR_SIZE_MISMATCH    4
+#define AT_ERR_UNEXPECTED_CHAR  6
+
+/* longest wait of myonSim_serve for room in the output buffer of its fd */
+#define SERVE_TIMEOUT_MS        1000
+
+/* XMODEM of the bootloader */
+#define XM_SOH                  0x01
+#define XM_STX                  0x02
+#define XM_EOT                  0x04
+#define XM_ACK                  0x06
+#define XM_NAK                  0x15
+#define XM_CAN                  0x18
+#define BOOT_POLL_US            1000000     // interval of the transfer requests
+
+/* virtual time when the modem is idle and the client polls without idleStepUs */
+#define IDLE_STEP_US            1000
+
+enum {
+    CMD_BYTES,          // query and set of a fixed size byte array
+    CMD_KEY,            // set only byte array
+    CMD_INT,            // query and set of an integer
+    CMD_INT_RO,         // query only integer
+    CMD_STRING,         // execute, answers a string
+    CMD_UPLINK,
+    CMD_ATTACH,         // execute or set, answers the MAC state
+    CMD_TEST,           // set, starts a TX/RX test
+    CMD_TEST_OFF,       // execute, stops a TX/RX test
+    CMD_NO_RESPONSE,
+};
+
+/* flags of CMD_UPLINK and CMD_ATTACH */
+#define UL_BIDI         0x01
+#define UL_MAC          0x02    // needs an attached end-point
+#define UL_DLMPF        0x04    // downlink carries a -DLMPF: field
+#define ATT_ATTACH      0x01
+#define ATT_OTA         0x02    // over the air, with argument
+#define NR_FACTORY      0x01    // CMD_NO_RESPONSE restoring the factory state
+#define NR_BOOT         0x02    // CMD_NO_RESPONSE restarting the firmware, followed by the boot banner
+#define NR_BOOTLOADER   0x04    // CMD_NO_RESPONSE starting the XMODEM bootloader
+
+typedef struct {
+    const char *name;
+    uint8_t     type;
+    uint8_t     flags;
+    uint8_t     size;           // of CMD_BYTES/CMD_KEY
+    size_t      offset;         // of the state member in myonSim
+} sim_cmd;
+
+static const sim_cmd sim_cmds[] = {
+    { "AT-MEUI",    CMD_BYTES,  0, 8,  offsetof(myonSim, eui)             },
+    { "AT-MSAD",    CMD_BYTES,  0, 2,  offsetof(myonSim, shortAddress)    },
+    { "AT-MIP6",    CMD_BYTES,  0, 8,  offsetof(myonSim, ipv6)            },
+    { "AT-MNWK",    CMD_KEY,    0, 16, offsetof(myonSim, networkKey)      },
+    { "AT-MPCT",    CMD_INT_RO, 0, 0,  offsetof(myonSim, packetCounter)   },
+    { "AT-MAS",     CMD_INT_RO, 0, 0,  offsetof(myonSim, attached)        },
+    { "AT-UTPL",    CMD_INT,    0, 0,  offsetof(myonSim, txPower)         },
+    { "AT-UM",      CMD_INT,    0, 0,  offsetof(myonSim, uplinkMode)      },
+    { "AT-UP",      CMD_INT,    0, 0,  offsetof(myonSim, uplinkProfile)   },
+    { "AT-MRDR",    CMD_INT,    0, 0,  offsetof(myonSim, downlinkRequest) },
+    { "AT-TXINH",   CMD_INT,    0, 0,  offsetof(myonSim, txInhibit)       },
+    { "AT-TXACT",   CMD_INT,    0, 0,  offsetof(myonSim, txActive)        },
+    { "AT-RXACT",   CMD_INT,    0, 0,  offsetof(myonSim, rxActive)        },
+    { "ATI",        CMD_STRING, 0, 0,  offsetof(myonSim, epInfo)          },
+    { "AT-LIBV",    CMD_STRING, 0, 0,  offsetof(myonSim, libVersion)      },
+    { "AT-U",       CMD_UPLINK, UL_MAC, 0, 0 },
+    { "AT-UMPF",    CMD_UPLINK, UL_MAC, 0, 0 },
+    { "AT-B",       CMD_UPLINK, UL_MAC | UL_BIDI | UL_DLMPF, 0, 0 },
+    { "AT-BMPF",    CMD_UPLINK, UL_MAC | UL_BIDI | UL_DLMPF, 0, 0 },
+    { "AT-TU",      CMD_UPLINK, 0, 0, 0 },
+    { "AT-TB",      CMD_UPLINK, UL_BIDI, 0, 0 },
+    { "AT-MALO",    CMD_ATTACH, ATT_ATTACH, 0, 0 },
+    { "AT-MDLO",    CMD_ATTACH, 0, 0, 0 },
+    { "AT-MAOA",    CMD_ATTACH, ATT_ATTACH | ATT_OTA, 0, 0 },
+    { "AT-MDOA",    CMD_ATTACH, ATT_OTA, 0, 0 },
+    { "AT$TXCU",    CMD_TEST,   0, 0, 0 },
+    { "AT$TXCMLP",  CMD_TEST,   0, 0, 0 },
+    { "AT$RXCONT",  CMD_TEST,   0, 0, 0 },
+    { "AT$TXOFF",   CMD_TEST_OFF, 0, 0, 0 },
+    { "AT$RXOFF",   CMD_TEST_OFF, 0, 0, 0 },
+    { "AT-RST",     CMD_NO_RESPONSE, NR_BOOT, 0, 0 },
+    { "ATZ",        CMD_NO_RESPONSE, NR_FACTORY | NR_BOOT, 0, 0 },
+    { "AT-SBTL",    CMD_NO_RESPONSE, NR_BOOTLOADER, 0, 0 },
+    { "AT-SHDN",    CMD_NO_RESPONSE, 0, 0, 0 },
+};
+
+static void execute(myonSim *sim);
+static void bootloader_start(myonSim *sim);
+static void bootloader_end(myonSim *sim);
+static void bootloader_rx(myonSim *sim, uint8_t c);
+static void bootloader_block(myonSim *sim);
+static void bootloader_answer(myonSim *sim, uint8_t c, uint32_t latencyUs);
+static bool start_response(myonSim *sim);
+static bool run_cmd(myonSim *sim, const sim_cmd *cmd, char form, const char *arg, size_t argLen);
+static bool run_uplink(myonSim *sim, const sim_cmd *cmd, const char *arg, size_t argLen);
+static bool run_attach(myonSim *sim, const sim_cmd *cmd, char form, const char *arg, size_t argLen);
+static long parse_bytes(const char *arg, size_t argLen, uint8_t *out, size_t outSize);
+static bool parse_uint(const char *arg, size_t argLen, uint32_t *value);
+static void put(myonSim *sim, const char *fmt, ...);
+static void put_hex(myonSim *sim, const char *key, const uint8_t *data, size_t len);
+static void put_result(myonSim *sim, char result);
+static void at_error(myonSim *sim, uint32_t code);
+static void mac_error(myonSim *sim, uint32_t code);
+static myonSim_fault draw_fault(myonSim *sim);
+static uint32_t next_random(myonSim *sim);
+static uint64_t byte_us(const myonSim *sim);
+static size_t available(const myonSim *sim);
+
+
+void myonSim_init(myonSim *sim, const myonSim_config *cfg) {
+    static const uint8_t eui[8] = { 0x70, 0xB3, 0xD5, 0x67, 0x70, 0x00, 0x00, 0x01 };
+    memset(sim, 0, sizeof(*sim));
+    if (cfg)
+        sim->cfg = *cfg;
+    sim->rng = sim->cfg.seed ? sim->cfg.seed : 0x2545F491;
+    memcpy(sim->eui, eui, sizeof(eui));
+    sim->shortAddress[1] = 0x01;
+    sim->networkKeySet = 1;
+    sim->attached = 1;
+    sim->txPower = 14;
+    sim->epInfo = "Swissphone m.YON_bidi FW:1.3.0 HW:1.0 AT:2.2.0";
+    sim->libVersion = "MIOTY EP lib 2.2.0";
+}
+
+void myonSim_write(void *user, const uint8_t *data, size_t len) {
+    myonSim *sim = user;
+    sim->stats.bytesIn += len;
+    sim->nowUs += len * byte_us(sim);
+    for (size_t i = 0; i < len; i++) {
+        char c = (char)data[i];
+        if (sim->bootloader) {
+            bootloader_rx(sim, data[i]);
+        } else if (c == '\r') {
+            execute(sim);
+            sim->lineLen = 0;
+            sim->lineOverflow = false;
+        } else if (c == '\n') {
+            /* tolerated line feed after a command */
+        } else if (sim->lineLen < sizeof(sim->line)) {
+            sim->line[sim->lineLen++] = c;
+        } else {
+            sim->lineOverflow = true;
+        }
+    }
+}
+
+bool myonSim_read(void *user, uint8_t *data, size_t *len_out) {
+    myonSim *sim = user;
+    size_t avail = available(sim);
+
+    /* the bootloader repeats its transfer request until the first block arrives */
+    if (avail == 0 && sim->bootloader && !sim->fwStarted && sim->respPos >= sim->respLen) {
+        if (sim->nowUs >= sim->fwPollUs) {
+            bootloader_answer(sim, 'C', 0);
+            sim->fwPollUs = sim->nowUs + BOOT_POLL_US;
+            avail = available(sim);
+        }
+    }
+
+    if (avail == 0) {
+        /* the client waits, let the virtual time pass */
+        if (sim->cfg.idleStepUs)
+            sim->nowUs += sim->cfg.idleStepUs;
+        else if (sim->respPos < sim->respLen)
+            sim->nowUs = sim->respStartUs + (sim->respPos + 1) * byte_us(sim);
+        else
+            sim->nowUs += IDLE_STEP_US;
+        avail = available(sim);
+    }
+
+    size_t n = *len_out;
+    if (sim->cfg.maxChunk) {
+        size_t chunk = sim->cfg.maxChunk;
+        if (sim->cfg.randomChunks)
+            chunk = 1 + next_random(sim) % chunk;
+        if (n > chunk)
+            n = chunk;
+    }
+    if (n > avail)
+        n = avail;
+    memcpy(data, &sim->resp[sim->respPos], n);
+    sim->respPos += n;
+    sim->stats.bytesOut += n;
+    *len_out = n;
+    return true;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+bool myonSim_serve(myonSim *sim, int fd) {
+    uint8_t buf[256];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0)
+            myonSim_write(sim, buf, (size_t)n);
+        else if (n == 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        else if (errno != EINTR)
+            return false;
+    }
+    /* the latency passes on the virtual clock, the answer is sent right away */
+    while (myonSim_pending(sim)) {
+        size_t len = sizeof(buf);
+        myonSim_read(sim, buf, &len);
+        size_t off = 0;
+        while (off < len) {
+            ssize_t n = write(fd, &buf[off], len - off);
+            if (n > 0) {
+                off += (size_t)n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                struct pollfd pfd = { .fd = fd, .events = POLLOUT, .revents = 0 };
+                if (poll(&pfd, 1, SERVE_TIMEOUT_MS) <= 0)
+                    return false;
+            } else if (n == 0 || errno != EINTR) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+uint32_t myonSim_clockMs(void *user) {
+    const myonSim *sim = user;
+    return (uint32_t)(sim->nowUs / 1000);
+}
+
+bool myonSim_queueDownlink(myonSim *sim, const uint8_t *data, size_t len, uint8_t mpf) {
+    if (sim->downlinkCount >= MYONSIM_DOWNLINK_QUEUE || len > MYONSIM_DOWNLINK_SIZE)
+        return false;
+    myonSim_downlink *dl = &sim->downlinks[(sim->downlinkHead + sim->downlinkCount) % MYONSIM_DOWNLINK_QUEUE];
+    memcpy(dl->data, data, len);
+    dl->len = len;
+    dl->mpf = mpf;
+    sim->downlinkCount++;
+    return true;
+}
+
+void myonSim_injectFault(myonSim *sim, myonSim_fault fault) {
+    sim->nextFault = fault;
+}
+
+bool myonSim_pending(const myonSim *sim) {
+    return sim->respPos < sim->respLen;
+}
+
+bool myonSim_unsolicited(myonSim *sim, const char *text) {
+    size_t len = strlen(text);
+    bool busy = start_response(sim);
+    if (len >= sizeof(sim->resp) - sim->respLen)
+        return false;
+    put(sim, "%s", text);
+    if (!busy)
+        sim->respStartUs = sim->nowUs;
+    return true;
+}
+
+
+// answers the complete command line
+static void execute(myonSim *sim) {
+    const char *line = sim->line;
+    size_t len = sim->lineLen;
+    if (len == 0)
+        return;
+    sim->stats.commands++;
+
+    /* a command received while the previous output is still being sent is answered after it */
+    const bool busy = start_response(sim);
+    const size_t base = sim->respLen;
+    if (busy && sim->cfg.rejectBusy) {
+        mac_error(sim, MAC_ERR_BUSY);
+        return;
+    }
+
+    /* split "<name>[?|=<arg>]" */
+    size_t nameLen = 0;
+    while (nameLen < len && line[nameLen] != '?' && line[nameLen] != '=')
+        nameLen++;
+    char form = nameLen < len ? line[nameLen] : 0;
+    const char *arg = nameLen < len ? line + nameLen + 1 : line + len;
+    size_t argLen = line + len - arg;
+
+    const sim_cmd *cmd = NULL;
+    for (size_t i = 0; i < sizeof(sim_cmds) / sizeof(sim_cmds[0]); i++) {
+        if (strlen(sim_cmds[i].name) == nameLen && memcmp(sim_cmds[i].name, line, nameLen) == 0) {
+            cmd = &sim_cmds[i];
+            break;
+        }
+    }
+
+    bool respond = true;
+    if (sim->lineOverflow)
+        at_error(sim, AT_ERR_PARAM_OOB);
+    else if (cmd == NULL)
+        at_error(sim, AT_ERR_UNKNOWN_CMD);
+    else
+        respond = run_cmd(sim, cmd, form, arg, argLen);
+    if (!respond)
+        return;
+
+    myonSim_fault fault = sim->nextFault != MYONSIM_FAULT_NONE ? sim->nextFault : draw_fault(sim);
+    sim->nextFault = MYONSIM_FAULT_NONE;
+    switch (fault) {
+    case MYONSIM_FAULT_AT_ERROR:
+        sim->respLen = base;
+        at_error(sim, AT_ERR_GENERIC);
+        break;
+    case MYONSIM_FAULT_MAC_ERROR:
+        sim->respLen = base;
+        mac_error(sim, MAC_ERR_GENERIC);
+        break;
+    case MYONSIM_FAULT_DROP:
+        sim->respLen = base;
+        break;
+    case MYONSIM_FAULT_CORRUPT:
+        sim->resp[base + next_random(sim) % (sim->respLen - base)] ^= 1 << (next_random(sim) % 7);
+        break;
+    default:
+        break;
+    }
+    if (fault != MYONSIM_FAULT_NONE)
+        sim->stats.faults++;
+
+    if (busy)
+        return;
+    sim->respStartUs = sim->nowUs + sim->cfg.latencyUs;
+    if (cmd && cmd->type == CMD_UPLINK)
+        sim->respStartUs += sim->cfg.uplinkLatencyUs;
+}
+
+// restarts into the bootloader, its first transfer request follows after latencyUs
+static void bootloader_start(myonSim *sim) {
+    sim->bootloader = true;
+    sim->fwStarted = false;
+    sim->fwSeq = 1;
+    sim->fwLen = 0;
+    sim->fwPollUs = sim->nowUs + sim->cfg.latencyUs;
+    sim->stats.fwBytes = 0;
+    sim->stats.fwHash = 2166136261u;
+    sim->appBaudRate = sim->cfg.baudRate;
+    if (sim->cfg.bootloaderBaudRate)
+        sim->cfg.baudRate = sim->cfg.bootloaderBaudRate;
+}
+
+static void bootloader_end(myonSim *sim) {
+    sim->bootloader = false;
+    sim->cfg.baudRate = sim->appBaudRate;
+}
+
+static void bootloader_rx(myonSim *sim, uint8_t c) {
+    if (sim->fwLen > 0) {
+        sim->fwBlock[sim->fwLen++] = c;
+        if (sim->fwLen == sim->fwNeed) {
+            bootloader_block(sim);
+            sim->fwLen = 0;
+        }
+        return;
+    }
+    switch (c) {
+    case XM_SOH:
+    case XM_STX:
+        sim->fwBlock[0] = c;
+        sim->fwLen = 1;
+        sim->fwNeed = (c == XM_STX ? 1024 : 128) + 5;
+        sim->fwStarted = true;
+        break;
+    case XM_EOT:
+        /* the answer is sent at the bootloader baud rate, the AT interface follows */
+        bootloader_answer(sim, XM_ACK, sim->cfg.latencyUs);
+        sim->cfg.baudRate = sim->appBaudRate;
+        sim->bootloader = false;
+        sim->stats.fwUpdates++;
+        break;
+    case XM_CAN:
+        bootloader_end(sim);
+        break;
+    default:
+        /* anything else before the transfer, e.g. a CR, ends the bootloader */
+        if (!sim->fwStarted)
+            bootloader_end(sim);
+        break;
+    }
+}
+
+// checks a complete block and answers it
+static void bootloader_block(myonSim *sim) {
+    const uint8_t *b = sim->fwBlock;
+    const size_t size = sim->fwNeed - 5;
+    uint16_t crc = 0;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint16_t)(b[3 + i] << 8);
+        for (int j = 0; j < 8; j++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    bool valid = (uint8_t)(b[1] + b[2]) == 0xFF && crc == (uint16_t)((b[3 + size] << 8) | b[4 + size])
+                 && (size == 128 || sim->cfg.bootloader1k);
+
+    myonSim_fault fault = sim->nextFault != MYONSIM_FAULT_NONE ? sim->nextFault : draw_fault(sim);
+    sim->nextFault = MYONSIM_FAULT_NONE;
+    if (fault != MYONSIM_FAULT_NONE) {
+        sim->stats.faults++;
+        if (fault == MYONSIM_FAULT_DROP)
+            return;
+        valid = false;
+    }
+
+    const uint32_t latency = sim->cfg.blockLatencyUs;
+    if (!valid) {
+        sim->stats.fwNaks++;
+        bootloader_answer(sim, XM_NAK, latency);
+    } else if (b[1] == sim->fwSeq) {
+        for (size_t i = 0; i < size; i++)
+            sim->stats.fwHash = (sim->stats.fwHash ^ b[3 + i]) * 16777619u;
+        sim->stats.fwBytes += size;
+        sim->stats.fwBlocks++;
+        sim->fwSeq++;
+        bootloader_answer(sim, XM_ACK, latency);
+    } else if (b[1] == (uint8_t)(sim->fwSeq - 1)) {
+        /* the acknowledge was lost, the sender repeated the block */
+        bootloader_answer(sim, XM_ACK, latency);
+    } else {
+        bootloader_answer(sim, XM_CAN, latency);
+        bootloader_answer(sim, XM_CAN, latency);
+        bootloader_end(sim);
+    }
+}
+
+// sends a control character latencyUs from now, or after the output still pending
+static void bootloader_answer(myonSim *sim, uint8_t c, uint32_t latencyUs) {
+    if (!start_response(sim))
+        sim->respStartUs = sim->nowUs + latencyUs;
+    if (sim->respLen < sizeof(sim->resp))
+        sim->resp[sim->respLen++] = (char)c;
+}
+
+// drops the output read already, returns true if there is output left to send before the new one
+static bool start_response(myonSim *sim) {
+    const bool busy = sim->respPos < sim->respLen;
+    if (busy) {
+        size_t unread = sim->respLen - sim->respPos;
+        memmove(sim->resp, sim->resp + sim->respPos, unread);
+        sim->respStartUs += sim->respPos * byte_us(sim);
+        sim->respLen = unread;
+    } else {
+        sim->respLen = 0;
+    }
+    sim->respPos = 0;
+    return busy;
+}
+
+// builds the response of a known command, returns false if it has none
+static bool run_cmd(myonSim *sim, const sim_cmd *cmd, char form, const char *arg, size_t argLen) {
+    uint8_t *member = (uint8_t *)sim + cmd->offset;
+    const char *key = cmd->name + 2;
+    uint32_t value;
+
+    switch (cmd->type) {
+    case CMD_BYTES:
+    case CMD_KEY:
+        if (form == '?' && cmd->type == CMD_BYTES) {
+            put_hex(sim, key, member, cmd->size);
+        } else if (form == '=') {
+            uint8_t buf[16];
+            long n = parse_bytes(arg, argLen, buf, sizeof(buf));
+            if (n < 0) {
+                at_error(sim, AT_ERR_UNEXPECTED_CHAR);
+                return true;
+            }
+            if (n != cmd->size) {
+                at_error(sim, AT_ERR_SIZE_MISMATCH);
+                return true;
+            }
+            memcpy(member, buf, cmd->size);
+            if (cmd->type == CMD_KEY)
+                sim->networkKeySet = 1;
+        } else {
+            at_error(sim, AT_ERR_UNKNOWN_CMD);
+            return true;
+        }
+        break;
+
+    case CMD_INT:
+    case CMD_INT_RO:
+        if (form == '?') {
+            memcpy(&value, member, sizeof(value));
+            put(sim, "%s:%lu\r\n", key, (unsigned long)value);
+        } else if (form == '=' && cmd->type == CMD_INT) {
+            if (!parse_uint(arg, argLen, &value)) {
+                at_error(sim, AT_ERR_UNEXPECTED_CHAR);
+                return true;
+            }
+            memcpy(member, &value, sizeof(value));
+        } else {
+            at_error(sim, AT_ERR_UNKNOWN_CMD);
+            return true;
+        }
+        break;
+
+    case CMD_STRING: {
+        const char *text;
+        memcpy(&text, member, sizeof(text));
+        put(sim, "%s:%s\r\n", cmd->name, text ? text : "");
+        break;
+    }
+
+    case CMD_UPLINK:
+        if (form != '=') {
+            at_error(sim, AT_ERR_UNKNOWN_CMD);
+            return true;
+        }
+        return run_uplink(sim, cmd, arg, argLen);
+
+    case CMD_ATTACH:
+        return run_attach(sim, cmd, form, arg, argLen);
+
+    case CMD_TEST:
+        if (form != '=' || !parse_uint(arg, argLen, &value)) {
+            at_error(sim, AT_ERR_UNEXPECTED_CHAR);
+            return true;
+        }
+        sim->testFrequency = value;
+        break;
+
+    case CMD_TEST_OFF:
+        sim->testFrequency = 0;
+        break;
+
+    default: // CMD_NO_RESPONSE
+        if (cmd->flags & NR_FACTORY) {
+            sim->packetCounter = 0;
+            sim->attached = 0;
+            sim->downlinkCount = 0;
+        }
+        if (cmd->flags & NR_BOOTLOADER)
+            bootloader_start(sim);
+        if ((cmd->flags & NR_BOOT) && sim->bootBanner) {
+            put(sim, "%s", sim->bootBanner);
+            return true;
+        }
+        return false;
+    }
+    put_result(sim, '0');
+    return true;
+}
+
+static bool run_uplink(myonSim *sim, const sim_cmd *cmd, const char *arg, size_t argLen) {
+    uint8_t payload[MYONSIM_LINE_SIZE / 2];
+    long n = parse_bytes(arg, argLen, payload, sizeof(payload));
+    if (n < 0) {
+        at_error(sim, n == -2 ? AT_ERR_SIZE_MISMATCH : AT_ERR_UNEXPECTED_CHAR);
+        return true;
+    }
+    if ((cmd->flags & UL_MAC) && !sim->attached) {
+        mac_error(sim, MAC_ERR_NOT_ATTACHED);
+        return true;
+    }
+
+    sim->stats.uplinks++;
+    sim->packetCounter++;
+    if (!(cmd->flags & UL_BIDI)) {
+        put(sim, "-MPCT:%lu\r\n", (unsigned long)sim->packetCounter);
+        put_result(sim, '0');
+        return true;
+    }
+
+    if (sim->downlinkCount == 0) {
+        put(sim, "-MPCT:%lu\r\n", (unsigned long)sim->packetCounter);
+        mac_error(sim, MAC_ERR_NO_DOWNLINK);
+        return true;
+    }
+    const myonSim_downlink *dl = &sim->downlinks[sim->downlinkHead];
+    sim->downlinkHead = (sim->downlinkHead + 1) % MYONSIM_DOWNLINK_QUEUE;
+    sim->downlinkCount--;
+    sim->stats.downlinks++;
+
+    /* "AT-B" answers "-B:", "AT-TB" answers "-TB:" */
+    char key[4] = "-B";
+    if (strcmp(cmd->name, "AT-TB") == 0)
+        strcpy(key, "-TB");
+    put_hex(sim, key, dl->data, dl->len);
+    if (cmd->flags & UL_DLMPF)
+        put_hex(sim, "-DLMPF", &dl->mpf, 1);
+    put(sim, "-MPCT:%lu\r\n", (unsigned long)sim->packetCounter);
+    put_result(sim, '0');
+    return true;
+}
+
+static bool run_attach(myonSim *sim, const sim_cmd *cmd, char form, const char *arg, size_t argLen) {
+    const bool attach = cmd->flags & ATT_ATTACH;
+    if (cmd->flags & ATT_OTA) {
+        uint8_t data[16];
+        long n = form == '=' ? parse_bytes(arg, argLen, data, sizeof(data)) : -1;
+        if (n < 0 || (attach && n != 4)) {
+            at_error(sim, AT_ERR_SIZE_MISMATCH);
+            return true;
+        }
+    } else if (form != 0) {
+        at_error(sim, AT_ERR_UNKNOWN_CMD);
+        return true;
+    }
+    if (attach && !sim->networkKeySet) {
+        mac_error(sim, MAC_ERR_KEY_NOT_SET);
+        return true;
+    }
+    if (attach && sim->attached) {
+        mac_error(sim, MAC_ERR_ALREADY_ATTACHED);
+        return true;
+    }
+    if (!attach && !sim->attached) {
+        mac_error(sim, MAC_ERR_NOT_ATTACHED);
+        return true;
+    }
+    sim->attached = attach;
+    put(sim, "-MSTA:%u\r\n", attach ? 1u : 0u);
+    put_result(sim, '0');
+    return true;
+}
+
+// parses "<len>\t<hex>\x1A", returns the number of bytes, -1 on a syntax error, -2 on a size mismatch
+static long parse_bytes(const char *arg, size_t argLen, uint8_t *out, size_t outSize) {
+    size_t i = 0;
+    uint32_t len = 0;
+    if (argLen == 0 || arg[argLen - 1] != '\x1A')
+        return -1;
+    argLen--;
+    while (i < argLen && arg[i] >= '0' && arg[i] <= '9')
+        len = len * 10 + (arg[i++] - '0');
+    if (i == 0 || i >= argLen || arg[i++] != '\t')
+        return -1;
+    if (argLen - i != 2 * (size_t)len || len > outSize)
+        return -2;
+    for (size_t j = 0; j < len; j++) {
+        uint8_t b = 0;
+        for (int k = 0; k < 2; k++) {
+            char c = arg[i++];
+            b <<= 4;
+            if (c >= '0' && c <= '9')
+                b |= c - '0';
+            else if (c >= 'A' && c <= 'F')
+                b |= c - 'A' + 10;
+            else if (c >= 'a' && c <= 'f')
+                b |= c - 'a' + 10;
+            else
+                return -1;
+        }
+        out[j] = b;
+    }
+    return (long)len;
+}
+
+static bool parse_uint(const char *arg, size_t argLen, uint32_t *value) {
+    uint32_t v = 0;
+    if (argLen == 0)
+        return false;
+    for (size_t i = 0; i < argLen; i++) {
+        if (arg[i] < '0' || arg[i] > '9')
+            return false;
+        v = v * 10 + (arg[i] - '0');
+    }
+    *value = v;
+    return true;
+}
+
+static void put(myonSim *sim, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(sim->resp + sim->respLen, sizeof(sim->resp) - sim->respLen, fmt, ap);
+    va_end(ap);
+    if (n > 0)
+        sim->respLen += (size_t)n < sizeof(sim->resp) - sim->respLen ? (size_t)n : sizeof(sim->resp) - sim->respLen - 1;
+}
+
+static void put_hex(myonSim *sim, const char *key, const uint8_t *data, size_t len) {
+    static const char hex[] = "0123456789ABCDEF";
+    put(sim, "%s:%lu\t", key, (unsigned long)len);
+    for (size_t i = 0; i < len && sim->respLen + 2 < sizeof(sim->resp); i++) {
+        sim->resp[sim->respLen++] = hex[data[i] >> 4];
+        sim->resp[sim->respLen++] = hex[data[i] & 0x0F];
+    }
+    put(sim, "\x1A\r\n");
+}
+
+static void put_result(myonSim *sim, char result) {
+    put(sim, "%c\r\n", result);
+}
+
+static void at_error(myonSim *sim, uint32_t code) {
+    put(sim, "AT!ERR:%lu\r\n", (unsigned long)code);
+    put_result(sim, '2');
+}
+
+static void mac_error(myonSim *sim, uint32_t code) {
+    put(sim, "-MNFO:%lu\r\n", (unsigned long)code);
+    put_result(sim, '1');
+}
+
+static myonSim_fault draw_fault(myonSim *sim) {
+    const myonSim_config *cfg = &sim->cfg;
+    if (!cfg->atErrorPermille && !cfg->macErrorPermille && !cfg->dropPermille && !cfg->corruptPermille)
+        return MYONSIM_FAULT_NONE;
+    uint32_t r = next_random(sim) % 1000;
+    if (r < cfg->atErrorPermille)
+        return MYONSIM_FAULT_AT_ERROR;
+    r -= cfg->atErrorPermille;
+    if (r < cfg->macErrorPermille)
+        return MYONSIM_FAULT_MAC_ERROR;
+    r -= cfg->macErrorPermille;
+    if (r < cfg->dropPermille)
+        return MYONSIM_FAULT_DROP;
+    r -= cfg->dropPermille;
+    if (r < cfg->corruptPermille)
+        return MYONSIM_FAULT_CORRUPT;
+    return MYONSIM_FAULT_NONE;
+}
+
+// xorshift32, reproducible for a given seed
+static uint32_t next_random(myonSim *sim) {
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+static uint64_t byte_us(const myonSim *sim) {
+    return sim->cfg.baudRate ? 10000000ull / sim->cfg.baudRate : 0;
+}
+
+// response bytes completely received by the client at the current virtual time, but not read yet
+static size_t available(const myonSim *sim) {
+    const uint64_t byteUs = byte_us(sim);
+    if (sim->respPos >= sim->respLen || sim->nowUs < sim->respStartUs)
+        return 0;
+    uint64_t done = byteUs ? (sim->nowUs - sim->respStartUs) / byteUs : sim->respLen;
+    if (done > sim->respLen)
+        done = sim->respLen;
+    return done > sim->respPos ? (size_t)(done - sim->respPos) : 0;
+}
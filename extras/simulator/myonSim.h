@@ -0,0 +1,272 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Host side simulator of a m.YON MIOTY™ modem for testing and benchmarking the client.
+ *
+ * The simulator implements the AT protocol subset used by miotyAtClient and plugs in as the
+ * transport of a client context:
+ *
+ *      myonSim sim;
+ *      myonSim_init(&sim, NULL);
+ *      miotyAtClient_init(&ctx, myonSim_write, myonSim_read, &sim);
+ *      miotyAtClient_setClock(&ctx, myonSim_clockMs);
+ *
+ * AT-SBTL starts a bootloader that receives a firmware image with XMODEM-CRC, optionally XMODEM-1K,
+ * and returns to the AT interface after the end of transmission; stats tells what it received.
+ *
+ * It runs on a virtual clock, so baud rate pacing and response latency cost no real time
+ * and every run is reproducible for a given seed.
+ */
+
+#ifndef _MYON_SIM_H
+#define _MYON_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MYONSIM_LINE_SIZE
+/** Longest command line accepted, longer commands are answered with an AT error */
+#define MYONSIM_LINE_SIZE       4096
+#endif
+
+#ifndef MYONSIM_DOWNLINK_SIZE
+/** Largest scripted downlink */
+#define MYONSIM_DOWNLINK_SIZE   1024
+#endif
+
+#ifndef MYONSIM_DOWNLINK_QUEUE
+/** Number of scripted downlinks that can be queued */
+#define MYONSIM_DOWNLINK_QUEUE  8
+#endif
+
+/** Longest response, a downlink with its header lines */
+#define MYONSIM_RESP_SIZE       (2 * MYONSIM_DOWNLINK_SIZE + 128)
+
+/** Faults the simulator can inject into the response of a command */
+typedef enum myonSim_fault {
+    MYONSIM_FAULT_NONE      = 0,
+    MYONSIM_FAULT_AT_ERROR  = 1,    // answer with a generic AT error
+    MYONSIM_FAULT_MAC_ERROR = 2,    // answer with a generic MAC error
+    MYONSIM_FAULT_DROP      = 3,    // do not answer at all
+    MYONSIM_FAULT_CORRUPT   = 4,    // flip a bit in one byte of the answer
+} myonSim_fault;
+
+/** Behaviour of the simulated modem and its UART */
+typedef struct myonSim_config {
+    uint32_t    baudRate;           // UART speed with 10 bits per byte, 0 for no pacing
+    uint32_t    latencyUs;          // time from the end of a command to the first response byte
+    uint32_t    uplinkLatencyUs;    // additional time for uplinks, the air time
+    uint32_t    idleStepUs;         // virtual time passing per read without data, 0 to jump to the next byte
+    size_t      maxChunk;           // most bytes returned by one read, 0 for no limit
+    bool        randomChunks;       // return a random number of 1 to maxChunk bytes per read
+    bool        rejectBusy;         // refuse commands received while a response is pending with MAC error 18,
+                                    // instead of answering them right after it
+    uint32_t    bootloaderBaudRate; // UART speed of the bootloader started with AT-SBTL, 0 for baudRate
+    uint32_t    blockLatencyUs;     // time the bootloader takes to store an XMODEM block
+    bool        bootloader1k;       // the bootloader accepts XMODEM-1K blocks
+    uint16_t    atErrorPermille;    // probability of MYONSIM_FAULT_AT_ERROR per command
+    uint16_t    macErrorPermille;   // probability of MYONSIM_FAULT_MAC_ERROR per command
+    uint16_t    dropPermille;       // probability of MYONSIM_FAULT_DROP per command
+    uint16_t    corruptPermille;    // probability of MYONSIM_FAULT_CORRUPT per command
+    uint32_t    seed;               // of the random number generator, 0 for a fixed default
+} myonSim_config;
+
+/** Counters of the simulator */
+typedef struct myonSim_stats {
+    uint32_t    commands;           // complete command lines received
+    uint32_t    uplinks;
+    uint32_t    downlinks;          // scripted downlinks delivered
+    uint32_t    faults;             // injected faults
+    uint64_t    bytesIn;            // bytes written by the client
+    uint64_t    bytesOut;           // bytes read by the client
+    uint32_t    fwBlocks;           // XMODEM blocks accepted by the bootloader
+    uint32_t    fwNaks;             // XMODEM blocks refused
+    uint32_t    fwUpdates;          // transfers completed with EOT
+    uint32_t    fwBytes;            // of the last transfer, padding included
+    uint32_t    fwHash;             // FNV-1a of the bytes of the last transfer
+} myonSim_stats;
+
+/** Scripted downlink, delivered with the next bidirectional uplink */
+typedef struct myonSim_downlink {
+    uint8_t     data[MYONSIM_DOWNLINK_SIZE];
+    size_t      len;
+    uint8_t     mpf;
+} myonSim_downlink;
+
+/**
+ * @brief State of one simulated modem. The modem state members may be changed at any time,
+ *        the others are private.
+ */
+typedef struct myonSim {
+    myonSim_config  cfg;
+    myonSim_stats   stats;
+    uint64_t        nowUs;          // virtual time
+
+    /* modem state, initialized as a provisioned and attached end-point */
+    uint8_t         eui[8];
+    uint8_t         shortAddress[2];
+    uint8_t         ipv6[8];
+    uint8_t         networkKey[16];
+    uint32_t        networkKeySet;
+    uint32_t        attached;
+    uint32_t        packetCounter;
+    uint32_t        txPower;
+    uint32_t        uplinkMode;
+    uint32_t        uplinkProfile;
+    uint32_t        downlinkRequest;
+    uint32_t        txInhibit;
+    uint32_t        txActive;
+    uint32_t        rxActive;
+    uint32_t        testFrequency;  // of a running TX/RX test, 0 if none
+    const char     *epInfo;         // answer of ATI
+    const char     *libVersion;     // answer of AT-LIBV
+    const char     *bootBanner;     // output after AT-RST and ATZ, NULL for none
+
+    /* command being received */
+    char            line[MYONSIM_LINE_SIZE];
+    size_t          lineLen;
+    bool            lineOverflow;
+
+    /* XMODEM receiver of the bootloader */
+    bool            bootloader;     // AT-SBTL was received, the transfer is not finished
+    bool            fwStarted;      // a block was received, no more requests
+    uint8_t         fwSeq;          // number of the next block
+    uint8_t         fwBlock[1029];  // block being received, header and CRC included
+    size_t          fwLen;
+    size_t          fwNeed;         // size of the block being received
+    uint64_t        fwPollUs;       // time of the next transfer request
+    uint32_t        appBaudRate;    // restored when the bootloader ends
+
+    /* response being sent */
+    char            resp[MYONSIM_RESP_SIZE];
+    size_t          respLen;
+    size_t          respPos;
+    uint64_t        respStartUs;    // time the first byte is available
+
+    myonSim_downlink downlinks[MYONSIM_DOWNLINK_QUEUE];
+    uint8_t         downlinkHead;
+    uint8_t         downlinkCount;
+    myonSim_fault   nextFault;
+    uint32_t        rng;
+} myonSim;
+
+/**
+ * @brief Initialize a simulated modem
+ *
+ * @param[out]  sim     Simulator
+ * @param[in]   cfg     Behaviour, NULL for an unpaced modem answering immediately without faults
+ */
+void myonSim_init(myonSim *sim, const myonSim_config *cfg);
+
+/**
+ * @brief Transport write callback, signature of miotyAtClient_writeFn
+ *
+ * @param[in]   user    Simulator
+ * @param[in]   data    Bytes written by the client
+ * @param[in]   len     Number of bytes in data
+ */
+void myonSim_write(void *user, const uint8_t *data, size_t len);
+
+/**
+ * @brief Transport read callback, signature of miotyAtClient_readFn. Never blocks.
+ *
+ * @param[in]       user        Simulator
+ * @param[out]      data        Buffer for the response bytes
+ * @param[in,out]   len_out     Size of data, set to the number of bytes returned
+ *
+ * @return      always true
+ */
+bool myonSim_read(void *user, uint8_t *data, size_t *len_out);
+
+/**
+ * @brief Virtual clock in ms, signature of miotyAtClient_clockFn
+ *
+ * @param[in]   user    Simulator
+ */
+uint32_t myonSim_clockMs(void *user);
+
+/**
+ * @brief Queue a downlink, returned by the next bidirectional uplink
+ *
+ * Bidirectional uplinks without queued downlink are answered with MacNoDownlinkReceived.
+ *
+ * @param[in,out]   sim     Simulator
+ * @param[in]       data    Downlink payload
+ * @param[in]       len     Size of data, at most MYONSIM_DOWNLINK_SIZE
+ * @param[in]       mpf     MPF field of the downlink
+ *
+ * @return      false if the queue is full or the downlink too large
+ */
+bool myonSim_queueDownlink(myonSim *sim, const uint8_t *data, size_t len, uint8_t mpf);
+
+/**
+ * @brief Inject a fault into the response of the next command, in addition to the random faults
+ *
+ * @param[in,out]   sim     Simulator
+ * @param[in]       fault   Fault to inject
+ */
+void myonSim_injectFault(myonSim *sim, myonSim_fault fault);
+
+/**
+ * @brief Check whether response bytes are still waiting to be read
+ */
+bool myonSim_pending(const myonSim *sim);
+
+/**
+ * @brief Output text that belongs to no command, e.g. an unsolicited result code, after the pending output
+ *
+ * @param[in,out]   sim     Simulator
+ * @param[in]       text    Bytes to send including the line ends, e.g. "+DLIND:3\r\n"
+ *
+ * @return      false if the text does not fit into the response buffer
+ */
+bool myonSim_unsolicited(myonSim *sim, const char *text);
+
+#if defined(__unix__) || defined(__APPLE__)
+/**
+ * @brief Serve a file descriptor instead of the callbacks, e.g. the peer of a miotyAtSerial loopback
+ *
+ * Hands everything readable from fd to the simulator and writes its whole answer back,
+ * the fd must be non-blocking. Call whenever fd is readable or from the idle callback of the client.
+ *
+ * @param[in,out]   sim     Simulator
+ * @param[in]       fd      Non-blocking file descriptor
+ *
+ * @return      false if reading or writing fd failed
+ */
+bool myonSim_serve(myonSim *sim, int fd);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1513 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Scenario checks of the host modules against the modem simulator.
+ *
+ * Usage: myon_cases [case...]
+ *
+ * Every case drives a module end to end against myonSim and checks the outcome, without arguments all
+ * cases run. The host build registers each case as a test, so ctest runs them with the build.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "data_tools/crc32.h"
+#include "miotyAtClient.h"
+#include "miotyAtFwUpdate.h"
+#include "miotyAtInfo.h"
+#include "miotyAtJournal.h"
+#include "miotyAtRetry.h"
+#include "miotyAtSerial.h"
+#include "miotyAtTrace.h"
+#include "miotyAtUplinkQueue.h"
+#include "myonSim.h"
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return false; \
+        } \
+    } while (0)
+
+typedef struct {
+    const char *name;
+    bool      (*run)(void);
+} sim_case;
+
+#ifndef MYON_FIRMWARE_IMAGE
+/** Release image the firmware cases inspect, relative to the root of the repository */
+#define MYON_FIRMWARE_IMAGE "extras/firmware/0544930_FW_m.YON_bidi_1.3.0.gbl"
+#endif
+
+static uint8_t payload[1024];
+static uint8_t image[40 * 1024 + 300];  // firmware image, not a multiple of the block sizes
+
+
+/* serial transport over a pseudo terminal, the simulator serves the other end */
+
+static myonSim serial_sim;
+static miotyAtSerial serial;
+static bool serial_done;
+static miotyAtClient_returnCode serial_ret;
+
+static void serial_idle(void *user) {
+    myonSim_serve(&serial_sim, miotyAtSerial_peerFd(&serial));
+    miotyAtSerial_idle(user);
+}
+
+static void serial_complete(miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user) {
+    (void)ctx;
+    (void)user;
+    serial_done = true;
+    serial_ret = result->returnCode;
+}
+
+static bool case_serial_loopback(void) {
+    miotyAtClient_ctx ctx;
+    CHECK(miotyAtSerial_open(&serial, "/dev/null", 12345) == MIOTYATCLIENT_RETURN_CODE_ArgumentOOR);
+    CHECK(miotyAtSerial_openLoopback(&serial) == MIOTYATCLIENT_RETURN_CODE_OK);
+    myonSim_init(&serial_sim, NULL);
+    miotyAtSerial_bind(&serial, &ctx);
+    miotyAtClient_setIdle(&ctx, serial_idle);
+
+    /* blocking functions, large writes and pipelined queries */
+    uint8_t eui[8];
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    uint32_t counter = 0;
+    for (int i = 0; i < 20; i++)
+        CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, sizeof(payload), &counter) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(counter == 20 && serial_sim.stats.uplinks == 20);
+    miotyAtClient_snapshot snapshot;
+    miotyAtClient_setPipelining(&ctx, 4);
+    CHECK(miotyAtClient_getSnapshot_ex(&ctx, &snapshot) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(snapshot.valid == MIOTYATCLIENT_SNAPSHOT_ALL);
+    miotyAtClient_setPipelining(&ctx, 1);
+
+    /* event loop */
+    uint8_t info[64];
+    miotyAtClient_cmd cmd = {
+        .atCmd = "ATI", .sizeCmd = 3, .form = MIOTYATCLIENT_CMD_FORM_EXEC, .respType = MIOTYATPARSER_VALUE_STRING,
+        .rxData = info, .sizeRxData = sizeof(info), .done = serial_complete,
+    };
+    serial_done = false;
+    CHECK(miotyAtClient_submit(&ctx, &cmd) == MIOTYATCLIENT_RETURN_CODE_OK);
+    for (int loops = 0; !serial_done; loops++) {
+        struct pollfd fds[2] = {
+            { .fd = miotyAtSerial_fd(&serial), .events = POLLIN },
+            { .fd = miotyAtSerial_peerFd(&serial), .events = POLLIN },
+        };
+        CHECK(loops < 100 && poll(fds, 2, 50) >= 0);
+        if (fds[1].revents)
+            myonSim_serve(&serial_sim, fds[1].fd);
+        CHECK(miotyAtSerial_service(&serial, &ctx));
+    }
+    CHECK(serial_ret == MIOTYATCLIENT_RETURN_CODE_OK);
+
+    /* the modem end hangs up, the running command fails instead of waiting for its deadline */
+    close(serial.peerFd);
+    serial.peerFd = -1;
+    miotyAtClient_setIdle(&ctx, miotyAtSerial_idle);
+    const uint32_t start = miotyAtSerial_clockMs(NULL);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_ATReadFailed);
+    CHECK(miotyAtSerial_error(&serial) == EIO);
+    CHECK(miotyAtSerial_clockMs(NULL) - start < MIOTYATCLIENT_TIMEOUT_DEFAULT_MS);
+    miotyAtSerial_close(&serial);
+    return true;
+}
+
+
+/* a blocking read callback: it is only called while an answer is on its way, unless URC handlers are registered */
+
+static myonSim blocking_sim;
+static uint32_t blocking_reads, blocking_stalls;
+
+// a read of the unpaced simulator without data would block forever
+static bool blocking_read(void *user, uint8_t *data, size_t *len_out) {
+    bool ok = myonSim_read(user, data, len_out);
+    blocking_reads++;
+    if (*len_out == 0)
+        blocking_stalls++;
+    return ok;
+}
+
+static void blocking_urc(miotyAtClient_ctx *ctx, const miotyAtClient_urc *urc, void *user) {
+    (void)ctx;
+    (void)urc;
+    (*(int *)user)++;
+}
+
+static bool case_blocking_read(void) {
+    miotyAtClient_ctx ctx;
+    myonSim_init(&blocking_sim, NULL);
+    blocking_sim.bootBanner = NULL;
+    miotyAtClient_init(&ctx, myonSim_write, blocking_read, &blocking_sim);
+    blocking_reads = blocking_stalls = 0;
+
+    /* commands without answer do not read at all, the others only until their answer is complete */
+    CHECK(miotyAtClient_reset_ex(&ctx) == MIOTYATCLIENT_RETURN_CODE_OK && blocking_reads == 0);
+    uint8_t eui[8];
+    uint32_t counter;
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_refreshPacketCounter_ex(&ctx, &counter) == MIOTYATCLIENT_RETURN_CODE_OK);
+    const uint32_t reads = blocking_reads;
+    CHECK(miotyAtClient_factoryReset_ex(&ctx) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_startBootloader_ex(&ctx) == MIOTYATCLIENT_RETURN_CODE_OK);
+    myonSim_init(&blocking_sim, NULL);
+    blocking_sim.bootBanner = NULL;
+    CHECK(miotyAtClient_shutdown_ex(&ctx) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(reads > 0 && blocking_reads == reads && blocking_stalls == 0);
+
+    /* with a handler the callback is called between commands too, until it has no more data */
+    int urcs = 0;
+    CHECK(miotyAtClient_addUrcHandler(&ctx, "+STATE", MIOTYATPARSER_VALUE_INT, blocking_urc, &urcs) == MIOTYATCLIENT_RETURN_CODE_OK);
+    myonSim_unsolicited(&blocking_sim, "+STATE:3\r\n");
+    blocking_reads = blocking_stalls = 0;
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(urcs == 1 && blocking_stalls == 1);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(blocking_stalls == 2);
+    return true;
+}
+
+
+/* modem errors: MAC and AT errors of any number map to codes that can not be taken for others */
+
+static const char *errors_answer;       // read once after every write
+
+static void errors_write(void *user, const uint8_t *data, size_t len) {
+    (void)data;
+    (void)len;
+    *(const char **)user = errors_answer;
+}
+
+static bool errors_read(void *user, uint8_t *data, size_t *len_out) {
+    const char **pending = user;
+    size_t len = *pending ? strlen(*pending) : 0;
+    if (len > *len_out)
+        len = *len_out;
+    memcpy(data, *pending, len);
+    *pending = len ? *pending + len : NULL;
+    *len_out = len;
+    return true;
+}
+
+static void errors_done(miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user) {
+    (void)ctx;
+    *(miotyAtClient_result *)user = *result;
+}
+
+static bool case_modem_errors(void) {
+    static const struct {
+        const char                 *answer;
+        miotyAtClient_returnCode    code;
+        uint32_t                    modemError;
+    } answers[] = {
+        { "0\r\n",                     MIOTYATCLIENT_RETURN_CODE_OK,                                    0 },
+        { "-MNFO:18\r\n1\r\n",         MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished,           18 },
+        { "-MERR:100\r\n1\r\n",        MIOTYATCLIENT_RETURN_CODE_FeatureNotSupported,                 100 },
+        { "-MERR:199\r\n1\r\n",        (miotyAtClient_returnCode)199,                                 199 },
+        { "-MERR:0\r\n1\r\n",          MIOTYATCLIENT_RETURN_CODE_MacError,                              0 },
+        { "-MERR:201\r\n1\r\n",        MIOTYATCLIENT_RETURN_CODE_MacError,                            201 },
+        { "-MERR:250\r\n1\r\n",        MIOTYATCLIENT_RETURN_CODE_MacError,                            250 },
+        { "1\r\n",                     MIOTYATCLIENT_RETURN_CODE_ERR,                                   0 },
+        { "AT!ERR:3\r\n2\r\n",         MIOTYATCLIENT_RETURN_CODE_ATParamOOB,                            3 },
+        { "AT!ERR:49\r\n2\r\n",        (miotyAtClient_returnCode)249,                                  49 },
+        { "AT!ERR:50\r\n2\r\n",        MIOTYATCLIENT_RETURN_CODE_ATErr,                                50 },
+        { "AT!ERR:52\r\n2\r\n",        MIOTYATCLIENT_RETURN_CODE_ATErr,                                52 },
+        { "AT!ERR:4294967295\r\n2\r\n", MIOTYATCLIENT_RETURN_CODE_ATErr,                       4294967295u },
+        { "2\r\n",                     MIOTYATCLIENT_RETURN_CODE_ATErr,                                 0 },
+    };
+    const char *pending = NULL;
+    miotyAtClient_ctx ctx;
+    miotyAtClient_init(&ctx, errors_write, errors_read, &pending);
+    for (size_t i = 0; i < sizeof(answers) / sizeof(answers[0]); i++) {
+        miotyAtClient_result result;
+        miotyAtClient_cmd cmd = {
+            .atCmd = "AT-MALO", .sizeCmd = 7, .form = MIOTYATCLIENT_CMD_FORM_EXEC, .done = errors_done, .user = &result,
+        };
+        errors_answer = answers[i].answer;
+        CHECK(miotyAtClient_submit(&ctx, &cmd) == MIOTYATCLIENT_RETURN_CODE_OK);
+        while (miotyAtClient_poll(&ctx))
+            ;
+        CHECK(result.returnCode == answers[i].code && result.modemError == answers[i].modemError);
+    }
+    return true;
+}
+
+
+/* snapshot: pipeline depth by clock and setPipelining, a command queue already full */
+
+static myonSim snapshot_sim;
+static miotyAtClient_ctx snapshot_ctx;
+static uint8_t snapshot_unanswered;     // most commands written and not answered when a write started
+
+static void snapshot_write(void *user, const uint8_t *data, size_t len) {
+    if (snapshot_ctx.written > snapshot_unanswered)
+        snapshot_unanswered = snapshot_ctx.written;
+    myonSim_write(user, data, len);
+}
+
+static bool case_snapshot(void) {
+    myonSim_config cfg = { .baudRate = 115200, .latencyUs = 2000 };
+    miotyAtClient_snapshot snapshot;
+    myonSim_init(&snapshot_sim, &cfg);
+    snapshot_sim.packetCounter = 42;
+    miotyAtClient_init(&snapshot_ctx, snapshot_write, myonSim_read, &snapshot_sim);
+
+    /* without a clock nothing is written ahead unless the application allows it */
+    CHECK(miotyAtClient_getSnapshot_ex(&snapshot_ctx, &snapshot) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(snapshot.valid == MIOTYATCLIENT_SNAPSHOT_ALL && snapshot.pipelineDepth == 1 && snapshot.packetCounter == 42);
+    CHECK(snapshot_unanswered == 1);
+    miotyAtClient_setPipelining(&snapshot_ctx, 3);
+    CHECK(miotyAtClient_getSnapshot_ex(&snapshot_ctx, &snapshot) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(snapshot.valid == MIOTYATCLIENT_SNAPSHOT_ALL && snapshot.pipelineDepth == 3 && snapshot_unanswered == 3);
+
+    /* with a clock the default depth is raised, a depth chosen by the application is kept */
+    miotyAtClient_setClock(&snapshot_ctx, myonSim_clockMs);
+    CHECK(miotyAtClient_getSnapshot_ex(&snapshot_ctx, &snapshot) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(snapshot.valid == MIOTYATCLIENT_SNAPSHOT_ALL && snapshot.pipelineDepth == 3);
+    miotyAtClient_setPipelining(&snapshot_ctx, 1);
+    snapshot_unanswered = 0;
+    CHECK(miotyAtClient_getSnapshot_ex(&snapshot_ctx, &snapshot) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(snapshot.valid == MIOTYATCLIENT_SNAPSHOT_ALL && snapshot.pipelineDepth == 1 && snapshot_unanswered == 1);
+    miotyAtClient_ctx fresh;
+    miotyAtClient_init(&fresh, myonSim_write, myonSim_read, &snapshot_sim);
+    miotyAtClient_setClock(&fresh, myonSim_clockMs);
+    CHECK(miotyAtClient_getSnapshot_ex(&fresh, &snapshot) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(snapshot.valid == MIOTYATCLIENT_SNAPSHOT_ALL && snapshot.pipelineDepth == MIOTYATCLIENT_CMD_QUEUE_SIZE);
+
+    /* the queries wait for room behind commands submitted before */
+    uint8_t info[MIOTYATCLIENT_CMD_QUEUE_SIZE][64];
+    for (int i = 0; i < MIOTYATCLIENT_CMD_QUEUE_SIZE; i++) {
+        miotyAtClient_cmd cmd = {
+            .atCmd = "ATI", .sizeCmd = 3, .form = MIOTYATCLIENT_CMD_FORM_EXEC, .respType = MIOTYATPARSER_VALUE_STRING,
+            .rxData = info[i], .sizeRxData = sizeof(info[i]),
+        };
+        CHECK(miotyAtClient_submit(&snapshot_ctx, &cmd) == MIOTYATCLIENT_RETURN_CODE_OK);
+    }
+    CHECK(miotyAtClient_getSnapshot_ex(&snapshot_ctx, &snapshot) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(snapshot.valid == MIOTYATCLIENT_SNAPSHOT_ALL && !miotyAtClient_poll(&snapshot_ctx));
+    return true;
+}
+
+
+/* cache: settings read once, sets written through, invalidated by reset, attach and on request */
+
+static bool case_cache(void) {
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    uint8_t eui[8];
+    uint32_t power;
+    bool attached;
+    myonSim_init(&sim, NULL);
+    miotyAtClient_init(&ctx, myonSim_write, myonSim_read, &sim);
+
+    /* disabled by default, every query goes to the modem */
+    for (int i = 0; i < 2; i++)
+        CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.commands == 2);
+
+    miotyAtClient_enableCache(&ctx, true);
+    for (int i = 0; i < 3; i++) {
+        CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+        CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+        CHECK(miotyAtClient_getAttachment_ex(&ctx, &attached) == MIOTYATCLIENT_RETURN_CODE_OK);
+    }
+    CHECK(sim.stats.commands == 5);
+    CHECK(memcmp(eui, sim.eui, sizeof(eui)) == 0 && power == sim.txPower && attached);
+
+    /* a set is written to the modem and serves the next queries */
+    power = 10;
+    CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, true) == MIOTYATCLIENT_RETURN_CODE_OK);
+    power = 0;
+    CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.commands == 6 && sim.txPower == 10 && power == 10);
+    /* a refused set leaves the modem setting unknown */
+    myonSim_injectFault(&sim, MYONSIM_FAULT_AT_ERROR);
+    power = 12;
+    CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, true) != MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.commands == 8 && power == sim.txPower);
+
+    /* changed behind the back of the cache, e.g. with submit: stale until invalidated */
+    const uint32_t cached = power;
+    sim.txPower = 8;
+    sim.eui[7] ^= 0xFF;
+    CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.commands == 8 && power == cached && cached != 8);
+    miotyAtClient_invalidateCache(&ctx);
+    CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.commands == 10 && power == 8 && memcmp(eui, sim.eui, sizeof(eui)) == 0);
+
+    /* a reset forgets everything, the reset itself is one command */
+    CHECK(miotyAtClient_reset_ex(&ctx) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_getAttachment_ex(&ctx, &attached) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.commands == 14);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK && sim.stats.commands == 14);
+
+    /* so do a detach and an attach, the attachment is read again */
+    uint8_t msta;
+    CHECK(miotyAtClient_macDetachLocal_ex(&ctx, &msta) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_getAttachment_ex(&ctx, &attached) == MIOTYATCLIENT_RETURN_CODE_OK && !attached);
+    CHECK(miotyAtClient_macAttachLocal_ex(&ctx, &msta) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_getAttachment_ex(&ctx, &attached) == MIOTYATCLIENT_RETURN_CODE_OK && attached);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.commands == 19);
+
+    /* disabling forgets the values as well */
+    miotyAtClient_enableCache(&ctx, false);
+    miotyAtClient_enableCache(&ctx, true);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK && sim.stats.commands == 20);
+    return true;
+}
+
+
+/* packet counter mirror: followed through uplinks, skips and resets reported */
+
+static struct {
+    uint32_t                            count;
+    miotyAtClient_packetCounterEvent    event;
+    uint32_t                            expected;
+    uint32_t                            actual;
+} counter_log;
+
+static void counter_event(miotyAtClient_ctx *ctx, miotyAtClient_packetCounterEvent event, uint32_t expected, uint32_t actual) {
+    (void)ctx;
+    counter_log.count++;
+    counter_log.event = event;
+    counter_log.expected = expected;
+    counter_log.actual = actual;
+}
+
+#define LOGGED(n, e, exp, act) \
+    (counter_log.count == (n) && counter_log.event == (e) && counter_log.expected == (exp) && counter_log.actual == (act))
+
+static bool case_packet_counter(void) {
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    uint32_t counter = 0, mirrored = 0;
+    myonSim_init(&sim, NULL);
+    sim.packetCounter = 100;
+    miotyAtClient_init(&ctx, myonSim_write, myonSim_read, &sim);
+    miotyAtClient_setPacketCounterEvent(&ctx, counter_event);
+    memset(&counter_log, 0, sizeof(counter_log));
+
+    /* the first counter starts the mirror, uplinks continue it, reading it needs no command */
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK && counter == 101);
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK && counter == 102);
+    uint32_t commands = sim.stats.commands;
+    CHECK(miotyAtClient_getPacketCounter_ex(&ctx, &mirrored) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(mirrored == 102 && sim.stats.commands == commands && counter_log.count == 0);
+
+    /* uplinks the context did not see, e.g. sent by the bootloader or another host: a skip */
+    sim.packetCounter += 5;
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK && counter == 108);
+    CHECK(LOGGED(1, MIOTYATCLIENT_PACKET_COUNTER_SKIP, 103, 108));
+    CHECK(miotyAtClient_getPacketCounter_ex(&ctx, &mirrored) == MIOTYATCLIENT_RETURN_CODE_OK && mirrored == 108);
+    /* the same counter read back is no event */
+    CHECK(miotyAtClient_refreshPacketCounter_ex(&ctx, &mirrored) == MIOTYATCLIENT_RETURN_CODE_OK && mirrored == 108);
+    CHECK(counter_log.count == 1);
+
+    /* the counter went back behind the context: a reset */
+    sim.packetCounter = 3;
+    CHECK(miotyAtClient_refreshPacketCounter_ex(&ctx, &mirrored) == MIOTYATCLIENT_RETURN_CODE_OK && mirrored == 3);
+    CHECK(LOGGED(2, MIOTYATCLIENT_PACKET_COUNTER_RESET, 108, 3));
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK && counter == 4);
+    CHECK(counter_log.count == 2);
+
+    /* a factory reset clears the counter of the modem, the mirror reports it against the last known one */
+    CHECK(miotyAtClient_factoryReset_ex(&ctx) == MIOTYATCLIENT_RETURN_CODE_OK && sim.packetCounter == 0);
+    commands = sim.stats.commands;
+    CHECK(miotyAtClient_getPacketCounter_ex(&ctx, &mirrored) == MIOTYATCLIENT_RETURN_CODE_OK && mirrored == 0);
+    CHECK(sim.stats.commands == commands + 1 && LOGGED(3, MIOTYATCLIENT_PACKET_COUNTER_RESET, 4, 0));
+    uint8_t msta;
+    CHECK(miotyAtClient_macAttachLocal_ex(&ctx, &msta) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK && counter == 1);
+    CHECK(counter_log.count == 3);
+    /* an attach that keeps the counter is no event, one that reports it further on is a skip */
+    CHECK(miotyAtClient_macDetachLocal_ex(&ctx, &msta) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_macAttachLocal_ex(&ctx, &msta) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK && counter == 2);
+    CHECK(counter_log.count == 3);
+    CHECK(miotyAtClient_macDetachLocal_ex(&ctx, &msta) == MIOTYATCLIENT_RETURN_CODE_OK);
+    sim.packetCounter = 40;
+    CHECK(miotyAtClient_macAttachLocal_ex(&ctx, &msta) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK && counter == 41);
+    CHECK(LOGGED(4, MIOTYATCLIENT_PACKET_COUNTER_SKIP, 3, 41));
+
+    /* an uplink without answer leaves the counter unknown, it is read from the modem again */
+    myonSim_init(&sim, NULL);
+    sim.packetCounter = 1;
+    miotyAtClient_setClock(&ctx, myonSim_clockMs);
+    myonSim_injectFault(&sim, MYONSIM_FAULT_DROP);
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_Timeout);
+    CHECK(miotyAtClient_getPacketCounter_ex(&ctx, &mirrored) == MIOTYATCLIENT_RETURN_CODE_OK && mirrored == 2);
+    CHECK(sim.stats.commands == 2 && counter_log.count == 4);
+    return true;
+}
+
+#undef LOGGED
+
+
+/* retries: lost answers of queries are retried, uplinks that may have been sent are not */
+
+static void retry_sleep(void *user, uint32_t ms) {
+    ((myonSim *)user)->nowUs += (uint64_t)ms * 1000;
+}
+
+static bool case_retry_uplink(void) {
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    miotyAtRetry retry;
+    myonSim_init(&sim, NULL);
+    miotyAtClient_init(&ctx, myonSim_write, myonSim_read, &sim);
+    miotyAtClient_setClock(&ctx, myonSim_clockMs);
+    miotyAtRetry_init(&retry, &ctx);
+    miotyAtRetry_setSleep(&retry, retry_sleep, &sim);
+
+    /* the answer of the uplink is lost after the modem sent it */
+    uint32_t counter = 0;
+    myonSim_injectFault(&sim, MYONSIM_FAULT_DROP);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_Timeout);
+    CHECK(sim.stats.uplinks == 1 && retry.stats.retries == 0);
+    uint8_t data[64];
+    size_t sizeData = sizeof(data);
+    uint8_t mpf;
+    myonSim_injectFault(&sim, MYONSIM_FAULT_DROP);
+    CHECK(miotyAtRetry_sendMessageBidi(&retry, payload, 10, data, &sizeData, &mpf, &counter)
+          == MIOTYATCLIENT_RETURN_CODE_Timeout);
+    CHECK(sim.stats.uplinks == 2 && retry.stats.retries == 0);
+
+    /* a modem error means nothing was sent */
+    myonSim_injectFault(&sim, MYONSIM_FAULT_MAC_ERROR);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(retry.stats.retries == 1 && counter == sim.packetCounter);
+
+    /* the same codes are retried for the other deadline classes */
+    CHECK(miotyAtRetry_classify(MIOTYATCLIENT_RETURN_CODE_Timeout, MIOTYATCLIENT_TIMEOUT_DEFAULT, NULL) == MIOTYATRETRY_RETRY);
+    CHECK(miotyAtRetry_classify(MIOTYATCLIENT_RETURN_CODE_ATReadFailed, MIOTYATCLIENT_TIMEOUT_ATTACH, NULL) == MIOTYATRETRY_RETRY);
+    CHECK(miotyAtRetry_classify(MIOTYATCLIENT_RETURN_CODE_MacNoDownlinkReceived, MIOTYATCLIENT_TIMEOUT_BIDI, NULL)
+          == MIOTYATRETRY_FATAL);
+    CHECK(miotyAtRetry_classify(MIOTYATCLIENT_RETURN_CODE_DownlinkDataCorrupted, MIOTYATCLIENT_TIMEOUT_BIDI, NULL)
+          == MIOTYATRETRY_FATAL);
+    return true;
+}
+
+// every command the simulator gets fails with a MAC error, which is retried in every deadline class
+static void retry_failing(myonSim *sim, bool failing) {
+    sim->cfg.macErrorPermille = failing ? 1000 : 0;
+}
+
+static struct {
+    miotyAtRetry_event  events[8];
+    uint32_t            count;
+    uint8_t             vetoAttempt;    // the retry after this attempt is vetoed, 0 never
+} retry_log;
+
+static bool retry_hook(const miotyAtRetry_event *event, void *user) {
+    (void)user;
+    if (retry_log.count < sizeof(retry_log.events) / sizeof(retry_log.events[0]))
+        retry_log.events[retry_log.count] = *event;
+    retry_log.count++;
+    return event->attempt != retry_log.vetoAttempt;
+}
+
+static uint32_t retry_reattaches;
+
+static miotyAtClient_returnCode retry_reattach(miotyAtClient_ctx *ctx, void *user) {
+    (void)user;
+    uint8_t msta;
+    retry_reattaches++;
+    return miotyAtClient_macAttachLocal_ex(ctx, &msta);
+}
+
+static miotyAtClient_returnCode retry_query(miotyAtClient_ctx *ctx, void *arg) {
+    return miotyAtClient_getOrSetEui_ex(ctx, arg, false);
+}
+
+static void retry_setup(myonSim *sim, miotyAtClient_ctx *ctx, miotyAtRetry *retry) {
+    myonSim_init(sim, NULL);
+    miotyAtClient_init(ctx, myonSim_write, myonSim_read, sim);
+    miotyAtClient_setClock(ctx, myonSim_clockMs);
+    miotyAtRetry_init(retry, ctx);
+    miotyAtRetry_setSleep(retry, retry_sleep, sim);
+    memset(&retry_log, 0, sizeof(retry_log));
+    retry_reattaches = 0;
+}
+
+static bool case_retry_budget(void) {
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    miotyAtRetry retry;
+    uint32_t counter;
+    retry_setup(&sim, &ctx, &retry);
+    miotyAtRetry_setBudget(&retry, 3, 2);
+
+    /* 3 attempts take 2 retries, the next call gets the last one and is cut short */
+    retry_failing(&sim, true);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 3 && retry.stats.retries == 2 && retry.stats.exhausted == 0);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 5 && retry.stats.retries == 3 && retry.stats.exhausted == 1);
+    /* an empty budget leaves the first attempt only, in every deadline class */
+    uint8_t eui[8];
+    CHECK(miotyAtRetry_run(&retry, MIOTYATCLIENT_TIMEOUT_DEFAULT, retry_query, eui) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 6 && retry.stats.retries == 3 && retry.stats.exhausted == 2);
+
+    /* two calls succeeding at once earn one retry back, which the next failure spends */
+    retry_failing(&sim, false);
+    for (int i = 0; i < 2; i++)
+        CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(counter == sim.packetCounter);
+    retry_failing(&sim, true);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 10 && retry.stats.retries == 4 && retry.stats.exhausted == 3);
+
+    /* without budget only the attempts limit the retries */
+    miotyAtRetry_setBudget(&retry, 0, 0);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 13 && retry.stats.retries == 6 && retry.stats.exhausted == 3);
+    CHECK(retry.stats.calls == 7);
+    return true;
+}
+
+static bool case_retry_reattach(void) {
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    miotyAtRetry retry;
+    uint32_t counter;
+    retry_setup(&sim, &ctx, &retry);
+    miotyAtRetry_setHook(&retry, retry_hook, NULL);
+
+    /* without a reattach callback a lost attachment is fatal */
+    sim.attached = 0;
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacNodeNotAttached);
+    CHECK(sim.stats.commands == 1 && retry.stats.retries == 0 && retry_log.count == 0);
+
+    /* attached again before the next attempt, which sends the uplink */
+    miotyAtRetry_setReattach(&retry, retry_reattach, NULL);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(retry_reattaches == 1 && retry.stats.reattaches == 1 && retry.stats.retries == 1);
+    CHECK(sim.attached && sim.stats.uplinks == 1 && counter == sim.packetCounter && sim.stats.commands == 4);
+    CHECK(retry_log.count == 1 && retry_log.events[0].action == MIOTYATRETRY_REATTACH);
+    CHECK(retry_log.events[0].returnCode == MIOTYATCLIENT_RETURN_CODE_MacNodeNotAttached);
+    CHECK(retry_log.events[0].timeoutClass == MIOTYATCLIENT_TIMEOUT_UPLINK && retry_log.events[0].attempt == 1);
+
+    /* a failed reattach ends the call with its return code */
+    sim.attached = 0;
+    sim.networkKeySet = 0;
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacNetworkKeyNotSet);
+    CHECK(retry_reattaches == 2 && retry.stats.reattaches == 2 && retry.stats.retries == 1 && sim.stats.uplinks == 1);
+    return true;
+}
+
+static bool case_retry_hook(void) {
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    miotyAtRetry retry;
+    uint32_t counter;
+    retry_setup(&sim, &ctx, &retry);
+    miotyAtRetry_setHook(&retry, retry_hook, NULL);
+    miotyAtRetry_setBudget(&retry, 5, 0);
+
+    /* every retry is reported before its delay, with the failure it follows */
+    retry_failing(&sim, true);
+    const uint64_t start = sim.nowUs;
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(retry_log.count == 2 && retry.stats.retries == 2 && sim.stats.commands == 3);
+    uint64_t slept = 0;
+    for (uint8_t i = 0; i < 2; i++) {
+        const miotyAtRetry_event *e = &retry_log.events[i];
+        CHECK(e->returnCode == MIOTYATCLIENT_RETURN_CODE_MacError && e->action == MIOTYATRETRY_RETRY);
+        CHECK(e->timeoutClass == MIOTYATCLIENT_TIMEOUT_UPLINK && e->attempt == i + 1);
+        slept += e->delayMs;
+    }
+    CHECK(sim.nowUs - start >= slept * 1000);
+
+    /* a vetoed retry ends the call and gives its share of the budget back */
+    retry_log.count = 0;
+    retry_log.vetoAttempt = 2;
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(retry_log.count == 2 && retry.stats.retries == 3 && retry.stats.vetoed == 1 && sim.stats.commands == 5);
+    retry_log.count = 0;
+    retry_log.vetoAttempt = 1;
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(retry_log.count == 1 && retry.stats.retries == 3 && retry.stats.vetoed == 2 && sim.stats.commands == 6);
+    /* 3 of the 5 retries were spent, the vetoed ones were given back */
+    retry_log.vetoAttempt = 0;
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(retry.stats.retries == 5 && retry.stats.exhausted == 1);
+
+    /* fatal failures and successes are not reported */
+    retry_log.count = 0;
+    retry_failing(&sim, false);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_OK);
+    myonSim_injectFault(&sim, MYONSIM_FAULT_DROP);
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_Timeout);
+    CHECK(retry_log.count == 0);
+    return true;
+}
+
+static bool case_retry_limits(void) {
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    miotyAtRetry retry;
+    uint32_t counter;
+    uint8_t eui[8];
+    retry_setup(&sim, &ctx, &retry);
+    miotyAtRetry_setHook(&retry, retry_hook, NULL);
+    miotyAtRetry_setBudget(&retry, 0, 0);
+    retry_failing(&sim, true);
+
+    /* the defaults: 4 attempts for queries, 3 for uplinks, 2 for attach, delays from the base up to the cap */
+    CHECK(miotyAtRetry_run(&retry, MIOTYATCLIENT_TIMEOUT_DEFAULT, retry_query, eui) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 4 && retry_log.count == 3);
+    const uint32_t queryCaps[] = { 100, 200, 400 };
+    for (int i = 0; i < 3; i++)
+        CHECK(retry_log.events[i].delayMs >= queryCaps[i] / 2 && retry_log.events[i].delayMs <= queryCaps[i]);
+    retry_log.count = 0;
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 7 && retry_log.count == 2);
+    CHECK(retry_log.events[0].delayMs >= 1000 && retry_log.events[0].delayMs <= 2000);
+    CHECK(retry_log.events[1].delayMs >= 2000 && retry_log.events[1].delayMs <= 4000);
+    uint8_t msta;
+    sim.attached = 0;
+    retry_log.count = 0;
+    CHECK(miotyAtRetry_run(&retry, MIOTYATCLIENT_TIMEOUT_ATTACH, (miotyAtRetry_opFn)miotyAtClient_macAttachLocal_ex, &msta)
+          == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 9 && retry_log.count == 1);
+    CHECK(retry_log.events[0].timeoutClass == MIOTYATCLIENT_TIMEOUT_ATTACH && retry_log.events[0].delayMs >= 2500);
+
+    /* limits set per class do not touch the other classes */
+    const miotyAtRetry_limits queries = { 2, 10, 10 }, uplinks = { 5, 1, 4 }, once = { 1, 100, 100 };
+    miotyAtRetry_setLimits(&retry, MIOTYATCLIENT_TIMEOUT_DEFAULT, &queries);
+    miotyAtRetry_setLimits(&retry, MIOTYATCLIENT_TIMEOUT_UPLINK, &uplinks);
+    miotyAtRetry_setLimits(&retry, MIOTYATCLIENT_TIMEOUT_BIDI, &once);
+    retry_log.count = 0;
+    CHECK(miotyAtRetry_run(&retry, MIOTYATCLIENT_TIMEOUT_DEFAULT, retry_query, eui) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 11 && retry_log.count == 1 && retry_log.events[0].delayMs >= 5);
+    CHECK(retry_log.events[0].delayMs <= 10);
+    retry_log.count = 0;
+    CHECK(miotyAtRetry_sendMessageUni(&retry, payload, 10, &counter) == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 16 && retry_log.count == 4);
+    /* 1, 2, 4 and then capped at 4 ms */
+    for (int i = 0; i < 4; i++) {
+        const uint32_t cap = i < 3 ? 1u << i : 4;
+        CHECK(retry_log.events[i].attempt == i + 1 && retry_log.events[i].delayMs >= (cap + 1) / 2);
+        CHECK(retry_log.events[i].delayMs <= cap);
+    }
+    retry_log.count = 0;
+    uint8_t data[64];
+    size_t sizeData = sizeof(data);
+    uint8_t mpf;
+    CHECK(miotyAtRetry_sendMessageBidi(&retry, payload, 10, data, &sizeData, &mpf, &counter)
+          == MIOTYATCLIENT_RETURN_CODE_MacError);
+    CHECK(sim.stats.commands == 17 && retry_log.count == 0);
+    CHECK(retry.stats.retries == 3 + 2 + 1 + 1 + 4);
+    return true;
+}
+
+
+/* firmware update from a source: double buffering, short reads, failures and resumed transfers */
+
+static myonSim fw_sim;
+static struct {
+    size_t      failAt;         // reading from this offset fails, 0 never
+    size_t      bytes;          // read so far
+    uint32_t    calls;
+} fw_src;
+static uint32_t fw_failAfterBlocks;     // the transport fails once this many blocks were received, 0 never
+
+// hands out at most 100 bytes per call and sometimes a single one
+static bool fw_source_read(void *user, size_t offset, uint8_t *data, size_t *len_out) {
+    (void)user;
+    if (fw_src.failAt && offset + *len_out > fw_src.failAt)
+        return false;
+    size_t n = *len_out > 100 ? 100 : *len_out;
+    if (++fw_src.calls % 7 == 0)
+        n = 1;
+    memcpy(data, &image[offset], n);
+    fw_src.bytes += n;
+    *len_out = n;
+    return true;
+}
+
+static bool fw_transport_read(void *user, uint8_t *data, size_t *len_out) {
+    if (fw_failAfterBlocks && fw_sim.stats.fwBlocks >= fw_failAfterBlocks) {
+        fw_failAfterBlocks = 0;
+        return false;
+    }
+    return myonSim_read(user, data, len_out);
+}
+
+static void fw_setup(miotyAtClient_ctx *ctx, bool receiver1k) {
+    myonSim_config cfg = {
+        .baudRate = 9600, .bootloaderBaudRate = 115200, .latencyUs = 20000, .blockLatencyUs = 3000,
+        .bootloader1k = receiver1k,
+    };
+    myonSim_init(&fw_sim, &cfg);
+    miotyAtClient_init(ctx, myonSim_write, fw_transport_read, &fw_sim);
+    miotyAtClient_setClock(ctx, myonSim_clockMs);
+    memset(&fw_src, 0, sizeof(fw_src));
+    fw_failAfterBlocks = 0;
+}
+
+// the simulator received the whole image once, padded to the last block
+static bool fw_received(void) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < fw_sim.stats.fwBytes; i++)
+        hash = (hash ^ (i < sizeof(image) ? image[i] : 0x1A)) * 16777619u;
+    return fw_sim.stats.fwUpdates == 1 && fw_sim.stats.fwBytes >= sizeof(image)
+           && fw_sim.stats.fwBytes - sizeof(image) < 128 && fw_sim.stats.fwHash == hash;
+}
+
+static bool case_fw_source(void) {
+    static uint8_t buffer[2 * 1024];
+    miotyAtFwUpdate_source src = { fw_source_read, NULL, sizeof(image), buffer, 2 * 128 };
+    miotyAtFwUpdate_config cfg;
+    miotyAtFwUpdate_defaultConfig(&cfg);
+    miotyAtFwUpdate_result result;
+    miotyAtClient_ctx ctx;
+
+    /* short reads are continued, every byte is read once: the next block is read ahead into the other buffer */
+    fw_setup(&ctx, false);
+    CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(result.status == MIOTYATFWUPDATE_STATUS_OK && result.blockSize == 128 && fw_received());
+    CHECK(fw_src.bytes == sizeof(image));
+
+    /* XMODEM-1K needs two 1024 byte buffers, with less 128 byte blocks are sent */
+    cfg.block1k = true;
+    fw_setup(&ctx, true);
+    CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(result.blocks > sizeof(image) / 128 && fw_received());
+    src.sizeBuffer = sizeof(buffer);
+    fw_setup(&ctx, true);
+    CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(result.blocks < sizeof(image) / 1024 + 4 && fw_received() && fw_src.bytes == sizeof(image));
+
+    /* blocks refused with NAK are sent again from their buffer, not read again */
+    cfg.block1k = false;
+    src.sizeBuffer = 2 * 128;
+    fw_setup(&ctx, false);
+    fw_sim.cfg.corruptPermille = 100;
+    CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(result.retries > 0 && fw_received() && fw_src.bytes == sizeof(image));
+    return true;
+}
+
+static bool case_fw_source_failure(void) {
+    static uint8_t buffer[2 * 128];
+    miotyAtFwUpdate_source src = { fw_source_read, NULL, sizeof(image), buffer, sizeof(buffer) };
+    miotyAtFwUpdate_config cfg;
+    miotyAtFwUpdate_defaultConfig(&cfg);
+    miotyAtFwUpdate_result result;
+    miotyAtClient_ctx ctx;
+
+    /* the read ahead fails while the block before is in flight, the transfer stops at that block */
+    fw_setup(&ctx, false);
+    fw_src.failAt = 20000;
+    CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_ATReadFailed);
+    CHECK(result.status == MIOTYATFWUPDATE_STATUS_SOURCE);
+    CHECK(result.bytesSent == 20000 / 128 * 128 && fw_sim.stats.fwBytes == result.bytesSent && fw_sim.bootloader);
+
+    /* the source works again, the bootloader still waits for the next block */
+    fw_src.failAt = 0;
+    cfg.resume = &result;
+    CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(result.resumed && result.bytesSent == sizeof(image) && fw_received());
+
+    /* an image shorter than announced */
+    cfg.resume = NULL;
+    src.size = sizeof(image) + 10;
+    fw_setup(&ctx, false);
+    fw_src.failAt = sizeof(image);
+    CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_ATReadFailed);
+    CHECK(result.status == MIOTYATFWUPDATE_STATUS_SOURCE && fw_sim.stats.fwUpdates == 0);
+    return true;
+}
+
+static bool case_fw_resume(void) {
+    static uint8_t buffer[2 * 1024];
+    miotyAtFwUpdate_source src = { fw_source_read, NULL, sizeof(image), buffer, sizeof(buffer) };
+    miotyAtFwUpdate_config cfg;
+    miotyAtFwUpdate_defaultConfig(&cfg);
+    miotyAtFwUpdate_result result, kept;
+    miotyAtClient_ctx ctx;
+
+    /* the transport fails with the acknowledge of a block in flight, the kept result resumes the transfer */
+    for (int block1k = 0; block1k < 2; block1k++) {
+        cfg.block1k = block1k;
+        cfg.resume = NULL;
+        fw_setup(&ctx, true);
+        fw_failAfterBlocks = 12;
+        CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_ATReadFailed);
+        CHECK(result.status == MIOTYATFWUPDATE_STATUS_TRANSPORT && fw_sim.bootloader);
+        CHECK(result.blocks <= fw_sim.stats.fwBlocks && result.blockSize == (block1k ? 1024 : 128));
+        kept = result;
+        cfg.resume = &kept;
+        CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+        CHECK(result.resumed && result.status == MIOTYATFWUPDATE_STATUS_OK && fw_received());
+    }
+
+    /* from memory, resuming with the result the interrupted run is written to */
+    cfg.block1k = false;
+    cfg.resume = NULL;
+    fw_setup(&ctx, false);
+    fw_failAfterBlocks = 200;
+    CHECK(miotyAtFwUpdate_run(&ctx, &cfg, image, sizeof(image), &result) == MIOTYATCLIENT_RETURN_CODE_ATReadFailed);
+    cfg.resume = &result;
+    CHECK(miotyAtFwUpdate_run(&ctx, &cfg, image, sizeof(image), &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(result.resumed && fw_received());
+
+    /* the modem restarted meanwhile, its new bootloader requests the transfer from the start */
+    kept.bytesSent = 100 * 128;
+    kept.blocks = 100;
+    kept.blockSize = 128;
+    cfg.resume = &kept;
+    fw_setup(&ctx, false);
+    CHECK(miotyAtClient_startBootloader_ex(&ctx) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtFwUpdate_runSource(&ctx, &cfg, &src, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(!result.resumed && result.bytesSent == sizeof(image) && fw_received());
+    return true;
+}
+
+/* firmware version: ATI and AT-LIBV answers parsed, a .gbl image inspected, an update of the running version skipped */
+
+#define VERSION_IS(v, a, b, c)  ((v).major == (a) && (v).minor == (b) && (v).patch == (c))
+
+static bool case_info_parsers(void) {
+    miotyAtInfo_epInfo ep;
+    miotyAtInfo_coreLibInfo lib;
+    miotyAtInfo_version version;
+
+    /* the answers of the simulator, read and parsed at once */
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    myonSim_init(&sim, NULL);
+    miotyAtClient_init(&ctx, myonSim_write, myonSim_read, &sim);
+    CHECK(miotyAtInfo_readEpInfo(&ctx, &ep) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(strcmp(ep.vendor, "Swissphone") == 0 && strcmp(ep.product, "m.YON_bidi") == 0);
+    CHECK(ep.fields == (MIOTYATINFO_EP_FW | MIOTYATINFO_EP_HW | MIOTYATINFO_EP_AT));
+    CHECK(VERSION_IS(ep.fw, 1, 3, 0) && VERSION_IS(ep.hw, 1, 0, 0) && VERSION_IS(ep.at, 2, 2, 0));
+    CHECK(miotyAtInfo_readCoreLibInfo(&ctx, &lib) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(strcmp(lib.name, "MIOTY EP lib") == 0 && VERSION_IS(lib.version, 2, 2, 0));
+
+    /* answers without a usable version are reported as unexpected */
+    sim.epInfo = "Swissphone m.YON_bidi HW:1.0 AT:2.2.0";
+    CHECK(miotyAtInfo_readEpInfo(&ctx, &ep) == MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar);
+    CHECK(ep.fields == (MIOTYATINFO_EP_HW | MIOTYATINFO_EP_AT) && strcmp(ep.product, "m.YON_bidi") == 0);
+    sim.libVersion = "MIOTY EP lib";
+    CHECK(miotyAtInfo_readCoreLibInfo(&ctx, &lib) == MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar);
+
+    /* versions in any order, unknown words skipped, names cut */
+    const char *odd = "\tSwissphoneWirelessAG_Switzerland m.YON  AT:2.2 X:1 FW:1.4.0\r\n";
+    CHECK(miotyAtInfo_parseEpInfo(odd, strlen(odd), &ep));
+    CHECK(strcmp(ep.vendor, "SwissphoneWirelessAG_Sw") == 0 && strcmp(ep.product, "m.YON") == 0);
+    CHECK(ep.fields == (MIOTYATINFO_EP_FW | MIOTYATINFO_EP_AT) && VERSION_IS(ep.fw, 1, 4, 0) && VERSION_IS(ep.at, 2, 2, 0));
+    const char *malformed[] = {
+        "", "   ", "Swissphone m.YON_bidi", "Swissphone m.YON_bidi FW:", "Swissphone m.YON_bidi FW:1",
+        "Swissphone m.YON_bidi FW:1.", "Swissphone m.YON_bidi FW:1.3.0.7", "Swissphone m.YON_bidi FW:70000.0.0",
+        "Swissphone m.YON_bidi FW:1.3x", "Swissphone m.YON_bidi FW 1.3.0",
+    };
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+        CHECK(!miotyAtInfo_parseEpInfo(malformed[i], strlen(malformed[i]), &ep));
+        CHECK(!(ep.fields & MIOTYATINFO_EP_FW) && VERSION_IS(ep.fw, 0, 0, 0));
+    }
+    /* the length counts, not a terminating NUL */
+    CHECK(!miotyAtInfo_parseEpInfo("Swissphone m.YON FW:1.3.0", 18, &ep));
+
+    CHECK(miotyAtInfo_parseCoreLibInfo("2.2.0", 5, &lib) && lib.name[0] == '\0' && VERSION_IS(lib.version, 2, 2, 0));
+    const char *padded = " MIOTY  EP lib 2.10.3 \r\n";
+    CHECK(miotyAtInfo_parseCoreLibInfo(padded, strlen(padded), &lib));
+    CHECK(strcmp(lib.name, "MIOTY  EP lib") == 0 && VERSION_IS(lib.version, 2, 10, 3));
+    const char *libMalformed[] = { "", "MIOTY EP lib", "MIOTY EP lib 2", "MIOTY EP lib v2.2.0", "MIOTY EP lib 2.2.0b" };
+    for (size_t i = 0; i < sizeof(libMalformed) / sizeof(libMalformed[0]); i++) {
+        CHECK(!miotyAtInfo_parseCoreLibInfo(libMalformed[i], strlen(libMalformed[i]), &lib));
+        CHECK(VERSION_IS(lib.version, 0, 0, 0));
+    }
+
+    /* versions alone */
+    CHECK(miotyAtInfo_parseVersion("1.3.0-rc", 8, &version) == 5 && VERSION_IS(version, 1, 3, 0));
+    CHECK(miotyAtInfo_parseVersion("65535.0", 7, &version) == 7 && VERSION_IS(version, 65535, 0, 0));
+    CHECK(miotyAtInfo_parseVersion("65536.0", 7, &version) == 0 && miotyAtInfo_parseVersion("13", 2, &version) == 0);
+    miotyAtInfo_version older = { 1, 2, 9 }, newer = { 1, 3, 0 };
+    CHECK(miotyAtInfo_compareVersion(&older, &newer) < 0 && miotyAtInfo_compareVersion(&newer, &older) > 0);
+    CHECK(miotyAtInfo_compareVersion(&newer, &newer) == 0);
+    return true;
+}
+
+// reads the shipped release image, the host build passes its path
+static uint8_t *fw_load_release(size_t *size) {
+    FILE *f = fopen(MYON_FIRMWARE_IMAGE, "rb");
+    if (!f) {
+        perror(MYON_FIRMWARE_IMAGE);
+        return NULL;
+    }
+    static uint8_t release[256 * 1024];
+    *size = fread(release, 1, sizeof(release), f);
+    const bool complete = feof(f) && !ferror(f);
+    fclose(f);
+    return complete ? release : NULL;
+}
+
+static bool case_fw_inspect(void) {
+    size_t size;
+    uint8_t *release = fw_load_release(&size);
+    CHECK(release != NULL && size > 12);
+
+    /* the end tag holds the CRC-32 of everything before its value */
+    const uint8_t *end = &release[size - 12];
+    CHECK(end[0] == 0xFC && end[1] == 0x04 && end[2] == 0x04 && end[3] == 0xFC);
+    const uint32_t stored = end[8] | (uint32_t)end[9] << 8 | (uint32_t)end[10] << 16 | (uint32_t)end[11] << 24;
+    CHECK(crc32_update(0, release, size - 4) == stored);
+
+    /* an encrypted release, its version comes from the file name */
+    miotyAtFwUpdate_imageInfo info;
+    CHECK(miotyAtFwUpdate_inspect(release, size, MYON_FIRMWARE_IMAGE, &info) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK((info.tags & MIOTYATFWUPDATE_GBL_ENCRYPTED) && !(info.tags & MIOTYATFWUPDATE_GBL_APPLICATION));
+    CHECK(info.hasVersion && info.versionFromName && VERSION_IS(info.version, 1, 3, 0));
+    CHECK(miotyAtFwUpdate_inspect(release, size, NULL, &info) == MIOTYATCLIENT_RETURN_CODE_OK && !info.hasVersion);
+
+    /* a flipped bit breaks the CRC, a cut image misses the end tag */
+    release[size / 2] ^= 0x10;
+    CHECK(miotyAtFwUpdate_inspect(release, size, MYON_FIRMWARE_IMAGE, &info) == MIOTYATCLIENT_RETURN_CODE_ERR);
+    release[size / 2] ^= 0x10;
+    CHECK(miotyAtFwUpdate_inspect(release, size - 12, MYON_FIRMWARE_IMAGE, &info) == MIOTYATCLIENT_RETURN_CODE_ERR);
+    CHECK(miotyAtFwUpdate_inspect(release, size, MYON_FIRMWARE_IMAGE, &info) == MIOTYATCLIENT_RETURN_CODE_OK);
+    return true;
+}
+
+static bool case_fw_skip(void) {
+    size_t size;
+    const uint8_t *release = fw_load_release(&size);
+    CHECK(release != NULL);
+    miotyAtFwUpdate_imageInfo info;
+    CHECK(miotyAtFwUpdate_inspect(release, size, MYON_FIRMWARE_IMAGE, &info) == MIOTYATCLIENT_RETURN_CODE_OK);
+    miotyAtFwUpdate_config cfg;
+    miotyAtFwUpdate_defaultConfig(&cfg);
+    cfg.block1k = true;
+    cfg.imageVersion = &info.version;
+    miotyAtFwUpdate_result result;
+    miotyAtClient_ctx ctx;
+
+    /* the simulator runs 1.3.0 already: ATI only, no bootloader and no XMODEM traffic */
+    fw_setup(&ctx, true);
+    CHECK(miotyAtFwUpdate_run(&ctx, &cfg, release, size, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(result.status == MIOTYATFWUPDATE_STATUS_SKIPPED && VERSION_IS(result.modemVersion, 1, 3, 0));
+    CHECK(result.bytesSent == 0 && result.blocks == 0);
+    CHECK(fw_sim.stats.commands == 1 && !fw_sim.bootloader);
+    CHECK(fw_sim.stats.fwBlocks == 0 && fw_sim.stats.fwNaks == 0 && fw_sim.stats.fwUpdates == 0);
+
+    /* an older modem is updated */
+    fw_setup(&ctx, true);
+    fw_sim.epInfo = "Swissphone m.YON_bidi FW:1.2.9 HW:1.0 AT:2.2.0";
+    CHECK(miotyAtFwUpdate_run(&ctx, &cfg, release, size, &result) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(result.status == MIOTYATFWUPDATE_STATUS_OK && VERSION_IS(result.modemVersion, 1, 2, 9));
+    CHECK(result.bytesSent == size && fw_sim.stats.fwUpdates == 1 && fw_sim.stats.fwBytes >= size);
+    return true;
+}
+
+#undef VERSION_IS
+
+/* journal recovery after crashes: during its creation and with an uplink written to the modem */
+
+// a failed check leaves the journal open, the case fails anyway
+static bool journal_recovery(const char *path, int fd) {
+    myonSim sim;
+    myonSim_init(&sim, NULL);
+    miotyAtClient_ctx ctx;
+    miotyAtClient_init(&ctx, myonSim_write, myonSim_read, &sim);
+    miotyAtClient_setClock(&ctx, myonSim_clockMs);
+    miotyAtJournal journal;
+
+    /* created and sized, the header not yet written: empty and zero headed files are created anew */
+    CHECK(ftruncate(fd, 0) == 0);
+    CHECK(miotyAtJournal_open(&journal, &ctx, path, 4, 32, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    miotyAtJournal_close(&journal);
+    CHECK(ftruncate(fd, 0) == 0 && ftruncate(fd, 4096) == 0);
+    CHECK(miotyAtJournal_open(&journal, &ctx, path, 4, 32, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtJournal_pending(&journal) == 0 && journal.slotCount == 4);
+
+    /* the modem sends the uplink, the answer is lost and the process dies: committed without sending again */
+    CHECK(miotyAtJournal_append(&journal, MIOTYATCLIENT_UPLINK_UNI, payload, 10) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtJournal_flush(&journal) == MIOTYATCLIENT_RETURN_CODE_OK && sim.stats.uplinks == 1);
+    CHECK(miotyAtJournal_append(&journal, MIOTYATCLIENT_UPLINK_UNI, payload, 11) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtJournal_append(&journal, MIOTYATCLIENT_UPLINK_UNI, payload, 12) == MIOTYATCLIENT_RETURN_CODE_OK);
+    myonSim_injectFault(&sim, MYONSIM_FAULT_DROP);
+    CHECK(miotyAtJournal_flush(&journal) == MIOTYATCLIENT_RETURN_CODE_Timeout && sim.stats.uplinks == 2);
+    miotyAtJournal_close(&journal);
+    CHECK(miotyAtJournal_open(&journal, &ctx, path, 4, 32, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtJournal_pending(&journal) == 2 && miotyAtJournal_flush(&journal) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.uplinks == 3 && miotyAtJournal_pending(&journal) == 0);
+
+    /* the modem refuses the uplink before the process dies: the counter did not move, it is sent again */
+    sim.attached = 0;
+    CHECK(miotyAtJournal_append(&journal, MIOTYATCLIENT_UPLINK_UNI, payload, 13) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtJournal_flush(&journal) != MIOTYATCLIENT_RETURN_CODE_OK && sim.stats.uplinks == 3);
+    miotyAtJournal_close(&journal);
+    sim.attached = 1;
+    CHECK(miotyAtJournal_open(&journal, &ctx, path, 4, 32, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtJournal_pending(&journal) == 1 && miotyAtJournal_flush(&journal) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(sim.stats.uplinks == 4 && miotyAtJournal_pending(&journal) == 0);
+    miotyAtJournal_close(&journal);
+    return true;
+}
+
+static bool case_journal_recovery(void) {
+    char path[] = "/tmp/myon_journal_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    bool ok = journal_recovery(path, fd);
+    close(fd);
+    unlink(path);
+    return ok;
+}
+
+/* uplink queue: priorities, drop policies, time to live, watermarks and pushes from callbacks */
+
+static myonSim queue_sim;
+static miotyAtClient_ctx queue_ctx;
+static uint8_t queue_log[32];   // ids of the completed messages, in order
+static miotyAtClient_returnCode queue_ret[32];
+static size_t queue_logged;
+static int queue_signals, queue_active;
+
+static void queue_done(miotyAtUplinkQueue *queue, const miotyAtClient_result *result, void *user) {
+    (void)queue;
+    if (queue_logged < sizeof(queue_log)) {
+        queue_log[queue_logged] = (uint8_t)(uintptr_t)user;
+        queue_ret[queue_logged++] = result->returnCode;
+    }
+}
+
+// the message with id 100 + n pushes the one with id 100 + n - 1 from its callback, at the lowest class, down to 101
+static void queue_done_push(miotyAtUplinkQueue *queue, const miotyAtClient_result *result, void *user) {
+    queue_done(queue, result, user);
+    uintptr_t id = (uintptr_t)user;
+    if (id > 101)
+        miotyAtUplinkQueue_push(queue, MIOTYATCLIENT_UPLINK_UNI, MIOTYATUPLINKQUEUE_PRIORITY_LOW, payload, 10, 0,
+                                queue_done_push, (void *)(id - 1));
+}
+
+static void queue_backpressure(miotyAtUplinkQueue *queue, bool active, void *user) {
+    (void)queue;
+    (void)user;
+    queue_signals++;
+    queue_active = active;
+}
+
+static void queue_setup(miotyAtUplinkQueue *queue, miotyAtUplinkQueue_dropPolicy policy) {
+    myonSim_init(&queue_sim, NULL);
+    miotyAtClient_init(&queue_ctx, myonSim_write, myonSim_read, &queue_sim);
+    miotyAtClient_setClock(&queue_ctx, myonSim_clockMs);
+    miotyAtUplinkQueue_init(queue, &queue_ctx, policy);
+    queue_logged = 0;
+    queue_signals = queue_active = 0;
+}
+
+static miotyAtClient_returnCode queue_push(miotyAtUplinkQueue *queue, miotyAtUplinkQueue_priority priority, uint8_t id,
+                                           uint32_t ttlMs) {
+    queue_sim.nowUs += 1000;    // distinct ages
+    return miotyAtUplinkQueue_push(queue, MIOTYATCLIENT_UPLINK_UNI, priority, payload, 10, ttlMs, queue_done,
+                                   (void *)(uintptr_t)id);
+}
+
+static bool queue_drain(miotyAtUplinkQueue *queue) {
+    for (int loops = 0; miotyAtUplinkQueue_poll(queue); loops++)
+        CHECK(loops < 10000);
+    return true;
+}
+
+static bool queue_logged_as(const uint8_t *ids, const miotyAtClient_returnCode *rets, size_t n) {
+    return queue_logged == n && memcmp(queue_log, ids, n) == 0 && memcmp(queue_ret, rets, n * sizeof(*rets)) == 0;
+}
+
+#define OK      MIOTYATCLIENT_RETURN_CODE_OK
+#define DROPPED MIOTYATCLIENT_RETURN_CODE_Dropped
+#define EXPIRED MIOTYATCLIENT_RETURN_CODE_Expired
+
+static bool case_uplink_queue_order(void) {
+    miotyAtUplinkQueue queue;
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_NEWEST);
+
+    /* the first ones go to the client at once, the others by class and FIFO within a class */
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 1, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 2, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 3, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 4, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 5, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 6, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 7, 0) == OK);
+    miotyAtUplinkQueue_stats stats;
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.inFlight == MIOTYATUPLINKQUEUE_IN_FLIGHT && stats.depth == 7 - MIOTYATUPLINKQUEUE_IN_FLIGHT);
+    CHECK(queue_drain(&queue));
+    static const uint8_t ids[] = { 1, 2, 5, 7, 4, 6, 3 };
+    static const miotyAtClient_returnCode rets[] = { OK, OK, OK, OK, OK, OK, OK };
+    CHECK(queue_logged_as(ids, rets, 7) && queue_sim.stats.uplinks == 7);
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.pushed == 7 && stats.sent == 7 && stats.maxDepth == 5 && miotyAtUplinkQueue_count(&queue) == 0);
+    return true;
+}
+
+static bool case_uplink_queue_drop(void) {
+    miotyAtUplinkQueue queue;
+    miotyAtUplinkQueue_stats stats;
+
+    /* newest: a full queue rejects the message, without calling its callback */
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_NEWEST);
+    for (uint8_t id = 1; id <= MIOTYATUPLINKQUEUE_SIZE; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, id, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 99, 0) == DROPPED && queue_logged == 0);
+    CHECK(queue_drain(&queue));
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.sent == MIOTYATUPLINKQUEUE_SIZE && stats.dropped == 1 && queue_logged == MIOTYATUPLINKQUEUE_SIZE);
+
+    /* oldest: the longest waiting message of any class makes room, messages in flight stay */
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_OLDEST);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 1, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 2, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 3, 0) == OK);
+    for (uint8_t id = 4; id <= MIOTYATUPLINKQUEUE_SIZE; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, id, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 50, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 51, 0) == OK);
+    CHECK(queue_logged == 2 && queue_log[0] == 3 && queue_log[1] == 4 && queue_ret[0] == DROPPED && queue_ret[1] == DROPPED);
+    CHECK(queue_drain(&queue));
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.sent == MIOTYATUPLINKQUEUE_SIZE && stats.dropped == 2 && queue_log[queue_logged - 1] == 51);
+
+    /* lowest: the newest message of the lowest class below the new one, none for the lowest class */
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_LOWEST);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 1, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 2, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 3, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 4, 0) == OK);
+    for (uint8_t id = 5; id <= MIOTYATUPLINKQUEUE_SIZE; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, id, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 50, 0) == DROPPED && queue_logged == 0);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 51, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 52, 0) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 53, 0) == DROPPED);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 54, 0) == OK);
+    CHECK(queue_logged == 3 && queue_log[0] == 4 && queue_log[1] == 3 && queue_log[2] == 52);
+    CHECK(queue_drain(&queue));
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.sent == MIOTYATUPLINKQUEUE_SIZE && stats.dropped == 5 && queue_log[5] == 54);
+    return true;
+}
+
+static bool case_uplink_queue_ttl(void) {
+    miotyAtUplinkQueue queue;
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_NEWEST);
+
+    /* messages waiting longer than their time to live are reported instead of sent */
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 1, 50) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 2, 50) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 3, 50) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 4, 500) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_LOW, 5, 0) == OK);
+    queue_sim.nowUs += 100000;
+    miotyAtUplinkQueue_service(&queue);
+    CHECK(queue_logged == 1 && queue_log[0] == 3 && queue_ret[0] == EXPIRED);
+    CHECK(queue_drain(&queue));
+    static const uint8_t ids[] = { 3, 1, 2, 4, 5 };
+    static const miotyAtClient_returnCode rets[] = { EXPIRED, OK, OK, OK, OK };
+    CHECK(queue_logged_as(ids, rets, 5));
+
+    /* a full queue expires messages before it drops one */
+    queue_logged = 0;
+    for (uint8_t id = 1; id <= MIOTYATUPLINKQUEUE_SIZE; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, id, id == 5 ? 10 : 0) == OK);
+    queue_sim.nowUs += 20000;
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 9, 0) == OK);
+    CHECK(queue_logged == 1 && queue_log[0] == 5 && queue_ret[0] == EXPIRED);
+    CHECK(queue_drain(&queue));
+    miotyAtUplinkQueue_stats stats;
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.expired == 2 && stats.dropped == 0 && stats.sent == 4 + MIOTYATUPLINKQUEUE_SIZE);
+
+    /* without a clock nothing expires */
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_NEWEST);
+    miotyAtClient_setClock(&queue_ctx, NULL);
+    for (uint8_t id = 1; id <= 3; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, id, 1) == OK);
+    queue_sim.nowUs += 100000;
+    CHECK(queue_drain(&queue));
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.expired == 0 && stats.sent == 3);
+    return true;
+}
+
+static bool case_uplink_queue_watermarks(void) {
+    miotyAtUplinkQueue queue;
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_NEWEST);
+    miotyAtUplinkQueue_setWatermarks(&queue, 4, 2, queue_backpressure, NULL);
+
+    /* active at 4 used slots, in flight included, released at 2 and signalled once per change */
+    for (uint8_t id = 1; id <= 3; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, id, 0) == OK);
+    CHECK(queue_signals == 0 && !miotyAtUplinkQueue_backpressure(&queue));
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 4, 0) == OK);
+    CHECK(queue_signals == 1 && queue_active && miotyAtUplinkQueue_backpressure(&queue));
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, 5, 0) == OK);
+    CHECK(queue_signals == 1);
+    while (miotyAtUplinkQueue_count(&queue) > 3)
+        miotyAtUplinkQueue_poll(&queue);
+    CHECK(queue_signals == 1 && queue_active);
+    while (miotyAtUplinkQueue_count(&queue) > 2)
+        miotyAtUplinkQueue_poll(&queue);
+    CHECK(queue_signals == 2 && !queue_active && !miotyAtUplinkQueue_backpressure(&queue));
+    CHECK(queue_drain(&queue) && queue_signals == 2);
+
+    /* watermarks set on a queue already above them signal at once */
+    for (uint8_t id = 1; id <= 3; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, id, 0) == OK);
+    miotyAtUplinkQueue_setWatermarks(&queue, 2, 1, queue_backpressure, NULL);
+    CHECK(queue_signals == 3 && queue_active);
+    CHECK(queue_drain(&queue) && queue_signals == 4 && !queue_active);
+    return true;
+}
+
+static bool case_uplink_queue_reentry(void) {
+    miotyAtUplinkQueue queue;
+    miotyAtUplinkQueue_stats stats;
+
+    /* completed uplinks push the next message from their callback */
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_NEWEST);
+    CHECK(miotyAtUplinkQueue_push(&queue, MIOTYATCLIENT_UPLINK_UNI, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, payload, 10, 0,
+                                  queue_done_push, (void *)(uintptr_t)110) == OK);
+    CHECK(queue_drain(&queue));
+    CHECK(queue_logged == 10 && queue_log[9] == 101 && queue_sim.stats.uplinks == 10);
+
+    /* a dropped message pushes again while the queue is full, the new message took the slot of the victim first */
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_LOWEST);
+    for (uint8_t id = 1; id < MIOTYATUPLINKQUEUE_SIZE; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, id, 0) == OK);
+    CHECK(miotyAtUplinkQueue_push(&queue, MIOTYATCLIENT_UPLINK_UNI, MIOTYATUPLINKQUEUE_PRIORITY_LOW, payload, 10, 5,
+                                  queue_done_push, (void *)(uintptr_t)103) == OK);
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 20, 0) == OK);
+    CHECK(queue_logged == 1 && queue_log[0] == 103 && queue_ret[0] == DROPPED);
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.dropped == 2 && miotyAtUplinkQueue_count(&queue) == MIOTYATUPLINKQUEUE_SIZE);
+    CHECK(queue_drain(&queue));
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.sent == MIOTYATUPLINKQUEUE_SIZE && stats.expired == 0 && miotyAtUplinkQueue_count(&queue) == 0);
+
+    /* an expired message pushes again while a push to the full queue makes room */
+    queue_setup(&queue, MIOTYATUPLINKQUEUE_DROP_NEWEST);
+    for (uint8_t id = 1; id < MIOTYATUPLINKQUEUE_SIZE; id++)
+        CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL, id, 0) == OK);
+    CHECK(miotyAtUplinkQueue_push(&queue, MIOTYATCLIENT_UPLINK_UNI, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, payload, 10, 5,
+                                  queue_done_push, (void *)(uintptr_t)104) == OK);
+    queue_sim.nowUs += 10000;
+    CHECK(queue_push(&queue, MIOTYATUPLINKQUEUE_PRIORITY_HIGH, 20, 0) == DROPPED);   // the callback got the slot
+    CHECK(queue_logged == 1 && queue_log[0] == 104 && queue_ret[0] == EXPIRED);
+    CHECK(queue_drain(&queue));
+    miotyAtUplinkQueue_getStats(&queue, &stats);
+    CHECK(stats.expired == 1 && stats.dropped == 1 && stats.sent == MIOTYATUPLINKQUEUE_SIZE + 2);
+    CHECK(queue_log[queue_logged - 1] == 101);
+    return true;
+}
+
+#undef OK
+#undef DROPPED
+#undef EXPIRED
+
+#if MIOTYATCLIENT_METRICS
+
+/* metrics: counts, errors and latencies of each command, built with MIOTYATCLIENT_METRICS=1 */
+
+static uint32_t metrics_clockUs(void *user) {
+    return (uint32_t)((myonSim *)user)->nowUs;
+}
+
+static bool case_metrics(void) {
+    myonSim_config cfg = { .baudRate = 115200, .latencyUs = 1500 };
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    miotyAtClient_metrics m;
+    myonSim_init(&sim, &cfg);
+    miotyAtClient_init(&ctx, myonSim_write, myonSim_read, &sim);
+    miotyAtClient_setClock(&ctx, myonSim_clockMs);
+    miotyAtClient_setMetricsClock(&ctx, metrics_clockUs);
+
+    uint8_t eui[8];
+    uint32_t power = 14;
+    for (int i = 0; i < 3; i++)
+        CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    myonSim_injectFault(&sim, MYONSIM_FAULT_AT_ERROR);
+    const miotyAtClient_returnCode atError = miotyAtClient_getOrSetEui_ex(&ctx, eui, false);
+    CHECK(atError != MIOTYATCLIENT_RETURN_CODE_OK);
+    myonSim_injectFault(&sim, MYONSIM_FAULT_DROP);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_Timeout);
+    CHECK(miotyAtClient_getOrSetTransmitPower_ex(&ctx, &power, true) == MIOTYATCLIENT_RETURN_CODE_OK);
+    miotyAtClient_getMetrics(&ctx, &m);
+
+    const miotyAtClient_cmdMetrics *meui = &m.commands[0], *utpl = &m.commands[1];
+    CHECK(strcmp(meui->atCmd, "AT-MEUI") == 0 && meui->count == 5 && meui->errors == 2 && meui->timeouts == 1);
+    CHECK(strcmp(utpl->atCmd, "AT-UTPL") == 0 && utpl->count == 1 && utpl->errors == 0 && utpl->timeouts == 0);
+    CHECK(m.commands[2].atCmd[0] == '\0' && m.otherCommands == 0);
+    CHECK(miotyAtClient_metricsReturnCode(&m, MIOTYATCLIENT_RETURN_CODE_OK) == 4);
+    CHECK(miotyAtClient_metricsReturnCode(&m, atError) == 1);
+    CHECK(miotyAtClient_metricsReturnCode(&m, MIOTYATCLIENT_RETURN_CODE_Timeout) == 1);
+
+    /* the modem answers after 1.5 ms, the timeout takes the whole default deadline */
+    CHECK(meui->timed == 5 && utpl->timed == 1);
+    CHECK(meui->latencyMin >= 1500 && meui->latencyMax >= MIOTYATCLIENT_TIMEOUT_DEFAULT_MS * 1000);
+    CHECK(utpl->latencyMin >= 1500 && utpl->latencyMin == utpl->latencyMax && utpl->latencySum == utpl->latencyMin);
+    uint32_t histogram = 0;
+    for (int i = 0; i < MIOTYATCLIENT_METRICS_BUCKETS; i++)
+        histogram += meui->latency[i];
+    CHECK(histogram == 5 && meui->latencySum >= 4 * meui->latencyMin + meui->latencyMax);
+
+    /* every byte written belongs to a command, every byte read is counted */
+    CHECK(m.txBytes == sim.stats.bytesIn && meui->txBytes + utpl->txBytes == m.txBytes);
+    CHECK(m.rxBytes == sim.stats.bytesOut && meui->rxBytes + utpl->rxBytes <= m.rxBytes);
+
+    miotyAtClient_resetMetrics(&ctx);
+    miotyAtClient_getMetrics(&ctx, &m);
+    CHECK(m.txBytes == 0 && m.commands[0].atCmd[0] == '\0');
+    return true;
+}
+#endif
+
+#if MIOTYATCLIENT_TRACE
+
+/* trace: a short session recorded and dumped to trace.dump, which the host build decodes with myon_trace */
+
+static bool case_trace(void) {
+    myonSim_config cfg = { .latencyUs = 1500 };   // no pacing, every answer is read in one chunk
+    myonSim sim;
+    miotyAtClient_ctx ctx;
+    miotyAtTrace trace;
+    static uint8_t ring[2048];
+    static uint8_t dump[sizeof(ring) + MIOTYATTRACE_FILE_HEADER];
+    myonSim_init(&sim, &cfg);
+    miotyAtClient_init(&ctx, myonSim_write, myonSim_read, &sim);
+    miotyAtClient_setClock(&ctx, myonSim_clockMs);
+    miotyAtTrace_init(&trace, ring, sizeof(ring));
+    miotyAtClient_setTrace(&ctx, &trace);
+
+    uint8_t eui[8];
+    uint32_t counter = 0;
+    const uint8_t text[] = "hello";
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+    CHECK(miotyAtClient_sendMessageUni_ex(&ctx, text, sizeof(text) - 1, &counter) == MIOTYATCLIENT_RETURN_CODE_OK);
+    myonSim_injectFault(&sim, MYONSIM_FAULT_AT_ERROR);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) != MIOTYATCLIENT_RETURN_CODE_OK);
+    miotyAtClient_setTrace(&ctx, NULL);
+    CHECK(miotyAtClient_getOrSetEui_ex(&ctx, eui, false) == MIOTYATCLIENT_RETURN_CODE_OK);
+
+    /* nothing was overwritten, and the dump has to fit exactly */
+    const size_t size = miotyAtTrace_dump(&trace, NULL, 0);
+    CHECK(trace.dropped == 0 && size > MIOTYATTRACE_FILE_HEADER && size <= sizeof(dump));
+    CHECK(miotyAtTrace_dump(&trace, dump, size - 1) == 0 && miotyAtTrace_dump(&trace, dump, size) == size);
+    FILE *f = fopen("trace.dump", "wb");
+    CHECK(f != NULL);
+    const bool written = fwrite(dump, 1, size, f) == size;
+    CHECK(fclose(f) == 0 && written);
+    return true;
+}
+#endif
+
+
+static const sim_case cases[] = {
+    { "serial_loopback",        case_serial_loopback        },
+    { "blocking_read",          case_blocking_read          },
+    { "modem_errors",           case_modem_errors           },
+    { "snapshot",               case_snapshot               },
+    { "cache",                  case_cache                  },
+    { "packet_counter",         case_packet_counter         },
+    { "retry_uplink",           case_retry_uplink           },
+    { "retry_budget",           case_retry_budget           },
+    { "retry_reattach",         case_retry_reattach         },
+    { "retry_hook",             case_retry_hook             },
+    { "retry_limits",           case_retry_limits           },
+    { "fw_source",              case_fw_source              },
+    { "fw_source_failure",      case_fw_source_failure      },
+    { "fw_resume",              case_fw_resume              },
+    { "info_parsers",           case_info_parsers           },
+    { "fw_inspect",             case_fw_inspect             },
+    { "fw_skip",                case_fw_skip                },
+    { "journal_recovery",       case_journal_recovery       },
+    { "uplink_queue_order",     case_uplink_queue_order     },
+    { "uplink_queue_drop",      case_uplink_queue_drop      },
+    { "uplink_queue_ttl",       case_uplink_queue_ttl       },
+    { "uplink_queue_watermarks", case_uplink_queue_watermarks },
+    { "uplink_queue_reentry",   case_uplink_queue_reentry   },
+#if MIOTYATCLIENT_METRICS
+    { "metrics",                case_metrics                },
+#endif
+#if MIOTYATCLIENT_TRACE
+    { "trace",                  case_trace                  },
+#endif
+};
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        size_t k = 0;
+        while (k < sizeof(cases) / sizeof(cases[0]) && strcmp(argv[i], cases[k].name) != 0)
+            k++;
+        if (k == sizeof(cases) / sizeof(cases[0])) {
+            fprintf(stderr, "usage: %s [case...], cases:", argv[0]);
+            for (k = 0; k < sizeof(cases) / sizeof(cases[0]); k++)
+                fprintf(stderr, " %s", cases[k].name);
+            fprintf(stderr, "\n");
+            return 2;
+        }
+    }
+    for (size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (uint8_t)(i * 31 + 7);
+    for (size_t i = 0; i < sizeof(image); i++)
+        image[i] = (uint8_t)(i * 131 + (i >> 8));
+
+    int failed = 0;
+    for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++)
+            selected |= strcmp(argv[i], cases[k].name) == 0;
+        if (!selected)
+            continue;
+        const bool ok = cases[k].run();
+        printf("%-30s %s\n", cases[k].name, ok ? "ok" : "FAILED");
+        if (!ok)
+            failed++;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Renders a trace dump (see miotyAtTrace.h) as an annotated AT transcript.
+ *
+ * Usage: myon_trace [-g gap ms] dump
+ *
+ * Every record is printed on one line: time since the first record, time since the previous one, number of
+ * the command, direction and the bytes with control characters escaped. Completions show the return code and
+ * the command they belong to. Pauses of at least the gap are marked, bytes that are not text are counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "miotyAtTrace.h"
+
+static const struct {
+    unsigned    code;
+    const char *name;
+} codes[] = {
+    {   0, "OK" },                      {   1, "MacError" },                {   2, "MacFramingError" },
+    {   3, "ArgumentSizeMismatch" },    {   4, "ArgumentOOR" },             {   5, "BufferSizeInsufficient" },
+    {   6, "MacNodeNotAttached" },      {   7, "MacNetworkKeyNotSet" },     {   8, "MacAlreadyAttached" },
+    {   9, "ERR" },                     {  10, "MacDownlinkNotAvailable" }, {  11, "UplinkPackingErr" },
+    {  12, "MacNoDownlinkReceived" },   {  13, "MacOptionNotAllowed" },     {  14, "MacDownlinkErr" },
+    {  15, "MacDefaultsNotSet" },       {  18, "PreviousCommandNotFinished" },
+    {  22, "DownlinkDataCorrupted" },   { 100, "FeatureNotSupported" },     { 200, "ATErr" },
+    { 201, "ATgenericErr" },            { 202, "ATCommandNotKnown" },       { 203, "ATParamOOB" },
+    { 204, "ATDataSizeMismatch" },      { 206, "ATUnexpectedChar" },        { 207, "ATArgInvalid" },
+    { 208, "ATReadFailed" },            { 250, "Timeout" },                 { 251, "Expired" },
+    { 252, "Dropped" },
+};
+
+// first line of the command written with each number, to annotate its completion
+static char commands[256][24];
+
+static uint32_t get_le32(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static const char *code_name(unsigned code) {
+    for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++)
+        if (codes[i].code == code)
+            return codes[i].name;
+    return "?";
+}
+
+// prints the bytes with control characters escaped, returns the number of bytes that are not text
+static size_t print_escaped(const uint8_t *data, size_t len) {
+    size_t binary = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if (c == '\r')
+            fputs("\\r", stdout);
+        else if (c == '\n')
+            fputs("\\n", stdout);
+        else if (c == '\t')
+            fputs("\\t", stdout);
+        else if (c == '\\')
+            fputs("\\\\", stdout);
+        else if (c >= 0x20 && c < 0x7F)
+            putchar(c);
+        else {
+            printf("\\x%02X", c);
+            /* Ctrl-Z ends the data of a set command */
+            if (c != 0x1A)
+                binary++;
+        }
+    }
+    return binary;
+}
+
+static void remember_command(uint8_t cmd, const uint8_t *data, size_t len) {
+    char *text = commands[cmd];
+    size_t n = 0;
+    while (n < len && n < sizeof(commands[0]) - 1 && data[n] >= 0x20 && data[n] < 0x7F && data[n] != '=')
+        n++;
+    memcpy(text, data, n);
+    text[n] = '\0';
+}
+
+int main(int argc, char **argv) {
+    double gapMs = 0;
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-g") && i + 1 < argc)
+            gapMs = atof(argv[++i]);
+        else if (argv[i][0] != '-' && !path)
+            path = argv[i];
+        else {
+            fprintf(stderr, "usage: %s [-g gap ms] dump\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s [-g gap ms] dump\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *dump = malloc(size > 0 ? (size_t)size : 1);
+    if (!dump || size < MIOTYATTRACE_FILE_HEADER || fread(dump, 1, (size_t)size, f) != (size_t)size ||
+        memcmp(dump, "MTRC", 4) != 0 || dump[4] != MIOTYATTRACE_VERSION) {
+        fprintf(stderr, "%s: not a trace dump of version %d\n", path, MIOTYATTRACE_VERSION);
+        fclose(f);
+        free(dump);
+        return 1;
+    }
+    fclose(f);
+
+    const uint32_t ticksPerSecond = get_le32(&dump[8]) ? get_le32(&dump[8]) : 1000;
+    const uint32_t dropped = get_le32(&dump[12]);
+    const double msPerTick = 1000.0 / ticksPerSecond;
+    if (dropped)
+        printf("# %u older records were overwritten\n", dropped);
+    printf("# %12s %10s %4s %s\n", "time/ms", "delta/ms", "cmd", "data");
+
+    size_t pos = MIOTYATTRACE_FILE_HEADER;
+    uint32_t first = 0;
+    uint32_t previous = 0;
+    bool started = false;
+    uint8_t lastWritten = 0;
+    while (pos + MIOTYATTRACE_RECORD_HEADER <= (size_t)size) {
+        const uint8_t *header = &dump[pos];
+        const uint32_t time = get_le32(header);
+        const uint8_t type = header[4] & ~MIOTYATTRACE_TRUNCATED;
+        const uint8_t cmd = header[5];
+        const size_t len = header[6] | (size_t)header[7] << 8;
+        const uint8_t *data = header + MIOTYATTRACE_RECORD_HEADER;
+        if (pos + MIOTYATTRACE_RECORD_HEADER + len > (size_t)size) {
+            printf("# record at offset %zu is cut off\n", pos);
+            break;
+        }
+        pos += MIOTYATTRACE_RECORD_HEADER + len;
+        if (!started) {
+            first = previous = time;
+            started = true;
+        }
+        /* unsigned differences, the clock may wrap */
+        const double delta = (uint32_t)(time - previous) * msPerTick;
+        if (gapMs > 0 && delta >= gapMs)
+            printf("# ----- gap of %.3f ms -----\n", delta);
+        printf("  %12.3f %+10.3f ", (uint32_t)(time - first) * msPerTick, delta);
+        if (cmd)
+            printf("#%-3u ", cmd);
+        else
+            printf("%4s ", "-");
+        previous = time;
+
+        switch (type) {
+        case MIOTYATTRACE_TX: {
+            fputs("-> ", stdout);
+            size_t binary = print_escaped(data, len);
+            if (binary)
+                printf("  [%zu bytes not text]", binary);
+            /* long commands are written in several chunks, the first one names them */
+            if (cmd && cmd != lastWritten)
+                remember_command(cmd, data, len);
+            lastWritten = cmd;
+            break;
+        }
+        case MIOTYATTRACE_RX: {
+            fputs("<- ", stdout);
+            size_t binary = print_escaped(data, len);
+            if (binary)
+                printf("  [%zu bytes not text]", binary);
+            break;
+        }
+        case MIOTYATTRACE_DONE: {
+            unsigned code = len >= 2 ? (unsigned)(data[0] | data[1] << 8) : 0;
+            printf("== %u %s", code, code_name(code));
+            if (commands[cmd][0])
+                printf("  (%s)", commands[cmd]);
+            break;
+        }
+        default:
+            printf("?? type %u, %zu bytes", type, len);
+            break;
+        }
+        if (header[4] & MIOTYATTRACE_TRUNCATED)
+            fputs("  [cut]", stdout);
+        putchar('\n');
+    }
+    free(dump);
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       CRC-32 as used by zlib and the end tag of Gecko bootloader (.gbl) images.
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ***** INCLUDES *********************************************************************************
+#include <inttypes.h>
+#include <stddef.h>
+
+// ***** PROTOTYPES *******************************************************************************
+
+/**
+ * \brief       Continue a CRC-32 over more data
+ *
+ * \param[in]   crc     CRC of the data before, 0 to start
+ * \param[in]   data    Data
+ * \param[in]   n       Number of bytes
+ *
+ * \return      CRC of the data before and data
+ */
+uint32_t crc32_update(uint32_t crc, uint8_t const * data, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC32_H_ */
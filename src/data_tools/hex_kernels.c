@@ -0,0 +1,370 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Byte array <-> hex string kernels.
+ */
+
+
+// SOURCE CODE
+// ***** INCLUDES *********************************************************************************
+#include "hex_kernels.h"
+#include "char_tools.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define HEX_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define HEX_HAVE_AVX2 1                 // compiled for AVX2, always available
+#include <immintrin.h>
+#elif defined(HEX_HAVE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEX_HAVE_AVX2 1
+#define HEX_AVX2_RUNTIME 1              // compiled separately, used if the CPU supports it
+#define HEX_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#ifndef HEX_AVX2_TARGET
+#define HEX_AVX2_TARGET
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define HEX_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+// ***** DEFINES **********************************************************************************
+/* the selected kernels are published as one pointer, threads resolving it at the same time store the same value */
+#if !defined(HEX_HAVE_SSE2) && !defined(HEX_HAVE_AVX2) && !defined(HEX_HAVE_NEON)
+#define HEX_SCALAR_ONLY 1               // e.g. AVR and Cortex-M, the pointer never changes
+#define KERNELS_LOAD(ptr)           (*(ptr))
+#define KERNELS_STORE(ptr, val)     (*(ptr) = (val))
+#elif defined(__GNUC__)
+#define KERNELS_LOAD(ptr)           __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define KERNELS_STORE(ptr, val)     __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define KERNELS_ATOMIC              _Atomic
+#define KERNELS_LOAD(ptr)           atomic_load_explicit(ptr, memory_order_acquire)
+#define KERNELS_STORE(ptr, val)     atomic_store_explicit(ptr, val, memory_order_release)
+#else
+/* pointer sized aligned accesses, e.g. MSVC on x64 */
+#define KERNELS_ATOMIC              volatile
+#define KERNELS_LOAD(ptr)           (*(ptr))
+#define KERNELS_STORE(ptr, val)     (*(ptr) = (val))
+#endif
+
+#ifndef KERNELS_ATOMIC
+#define KERNELS_ATOMIC
+#endif
+
+// ***** DECLARATIONS *****************************************************************************
+typedef struct {
+    hex_kernel  kernel;
+    void      (*encode)(uint8_t const * src, size_t n, char * dest);
+    bool      (*decode)(char const * src, size_t n, uint8_t * dest);
+} kernel_ops;
+
+// ***** LOCAL VARIABLES **************************************************************************
+
+// ***** PROTOTYPES *******************************************************************************
+static void encode_scalar(uint8_t const * src, size_t n, char * dest);
+static bool decode_scalar(char const * src, size_t n, uint8_t * dest);
+static hex_kernel best_kernel(void);
+
+// ***** FUNCTIONS ********************************************************************************
+
+static void encode_scalar(uint8_t const * src, size_t n, char * dest) {
+    for(size_t i = 0; i < n; i++) {
+        dest[2*i]   = char_nibble2hex(src[i] >> 4);
+        dest[2*i+1] = char_nibble2hex(src[i]);
+    }
+}
+
+// value of a hex digit, 0xFF for any other character
+static uint8_t nibble(char const c) {
+    uint8_t d = (uint8_t)c - '0';
+    if(d < 10) return d;
+    uint8_t a = ((uint8_t)c | 0x20) - 'a';
+    if(a < 6) return a + 10;
+    return 0xFF;
+}
+
+static bool decode_scalar(char const * src, size_t n, uint8_t * dest) {
+    uint8_t invalid = 0;
+    for(size_t i = 0; i < n; i++) {
+        uint8_t hi = nibble(src[2*i]);
+        uint8_t lo = nibble(src[2*i+1]);
+        invalid |= (hi | lo) & 0xF0;
+        dest[i] = (uint8_t)(hi << 4) | (lo & 0x0F);
+    }
+    return invalid == 0;
+}
+
+#ifdef HEX_HAVE_SSE2
+// 16 nibbles to their hex characters
+static inline __m128i sse2_nibble2hex(__m128i n) {
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), letter);
+}
+
+static void encode_sse2(uint8_t const * src, size_t n, char * dest) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i b = _mm_loadu_si128((__m128i const *)(src + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), mask);
+        __m128i lo = _mm_and_si128(b, mask);
+        _mm_storeu_si128((__m128i *)(dest + 2*i),      sse2_nibble2hex(_mm_unpacklo_epi8(hi, lo)));
+        _mm_storeu_si128((__m128i *)(dest + 2*i + 16), sse2_nibble2hex(_mm_unpackhi_epi8(hi, lo)));
+    }
+    encode_scalar(src + i, n - i, dest + 2*i);
+}
+
+// 16 characters to their nibble values, *invalid gets bits set for non hex characters
+static inline __m128i sse2_hex2nibble(__m128i c, __m128i * invalid) {
+    /* unsigned x < limit as signed compare of x^0x80 < limit^0x80 */
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i a = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_cmplt_epi8(_mm_xor_si128(d, bias), _mm_set1_epi8((char)(0x80 + 10)));
+    __m128i isAlpha = _mm_cmplt_epi8(_mm_xor_si128(a, bias), _mm_set1_epi8((char)(0x80 + 6)));
+    *invalid = _mm_or_si128(*invalid, _mm_xor_si128(_mm_or_si128(isDigit, isAlpha), _mm_set1_epi8(-1)));
+    return _mm_or_si128(_mm_and_si128(isDigit, d),
+                        _mm_and_si128(isAlpha, _mm_add_epi8(a, _mm_set1_epi8(10))));
+}
+
+// 8 pairs of nibbles (high nibble first) to 8 bytes in the low byte of each 16 bit lane
+static inline __m128i sse2_pairs2bytes(__m128i v) {
+    __m128i w = _mm_or_si128(_mm_slli_epi16(v, 4), _mm_srli_epi16(v, 8));
+    return _mm_and_si128(w, _mm_set1_epi16(0x00FF));
+}
+
+static bool decode_sse2(char const * src, size_t n, uint8_t * dest) {
+    __m128i invalid = _mm_setzero_si128();
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        __m128i v0 = sse2_hex2nibble(_mm_loadu_si128((__m128i const *)(src + 2*i)), &invalid);
+        __m128i v1 = sse2_hex2nibble(_mm_loadu_si128((__m128i const *)(src + 2*i + 16)), &invalid);
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_packus_epi16(sse2_pairs2bytes(v0), sse2_pairs2bytes(v1)));
+    }
+    bool ok = _mm_movemask_epi8(invalid) == 0;
+    return decode_scalar(src + 2*i, n - i, dest + i) && ok;
+}
+#endif
+
+#ifdef HEX_HAVE_AVX2
+static inline HEX_AVX2_TARGET __m256i avx2_nibble2hex(__m256i n) {
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(n, _mm256_set1_epi8(9)), _mm256_set1_epi8('A' - '0' - 10));
+    return _mm256_add_epi8(_mm256_add_epi8(n, _mm256_set1_epi8('0')), letter);
+}
+
+static HEX_AVX2_TARGET void encode_avx2(uint8_t const * src, size_t n, char * dest) {
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i b = _mm256_loadu_si256((__m256i const *)(src + i));
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi16(b, 4), mask);
+        __m256i lo = _mm256_and_si256(b, mask);
+        /* unpack works per 128 bit lane: lo holds bytes 0-7 and 16-23, hi 8-15 and 24-31 */
+        __m256i l = avx2_nibble2hex(_mm256_unpacklo_epi8(hi, lo));
+        __m256i h = avx2_nibble2hex(_mm256_unpackhi_epi8(hi, lo));
+        _mm256_storeu_si256((__m256i *)(dest + 2*i),      _mm256_permute2x128_si256(l, h, 0x20));
+        _mm256_storeu_si256((__m256i *)(dest + 2*i + 32), _mm256_permute2x128_si256(l, h, 0x31));
+    }
+    encode_scalar(src + i, n - i, dest + 2*i);
+}
+
+static inline HEX_AVX2_TARGET __m256i avx2_hex2nibble(__m256i c, __m256i * invalid) {
+    /* unsigned x < limit as signed compare of limit^0x80 > x^0x80 */
+    const __m256i bias = _mm256_set1_epi8((char)0x80);
+    __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i a = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i isDigit = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 10)), _mm256_xor_si256(d, bias));
+    __m256i isAlpha = _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(0x80 + 6)), _mm256_xor_si256(a, bias));
+    *invalid = _mm256_or_si256(*invalid, _mm256_xor_si256(_mm256_or_si256(isDigit, isAlpha), _mm256_set1_epi8(-1)));
+    return _mm256_or_si256(_mm256_and_si256(isDigit, d),
+                           _mm256_and_si256(isAlpha, _mm256_add_epi8(a, _mm256_set1_epi8(10))));
+}
+
+static inline HEX_AVX2_TARGET __m256i avx2_pairs2bytes(__m256i v) {
+    __m256i w = _mm256_or_si256(_mm256_slli_epi16(v, 4), _mm256_srli_epi16(v, 8));
+    return _mm256_and_si256(w, _mm256_set1_epi16(0x00FF));
+}
+
+static HEX_AVX2_TARGET bool decode_avx2(char const * src, size_t n, uint8_t * dest) {
+    __m256i invalid = _mm256_setzero_si256();
+    size_t i = 0;
+    for(; i + 32 <= n; i += 32) {
+        __m256i v0 = avx2_hex2nibble(_mm256_loadu_si256((__m256i const *)(src + 2*i)), &invalid);
+        __m256i v1 = avx2_hex2nibble(_mm256_loadu_si256((__m256i const *)(src + 2*i + 32)), &invalid);
+        /* packus works per 128 bit lane, the qword permutation restores the order */
+        __m256i packed = _mm256_packus_epi16(avx2_pairs2bytes(v0), avx2_pairs2bytes(v1));
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    bool ok = _mm256_movemask_epi8(invalid) == 0;
+    return decode_scalar(src + 2*i, n - i, dest + i) && ok;
+}
+#endif
+
+#ifdef HEX_HAVE_NEON
+static inline uint8x16_t neon_nibble2hex(uint8x16_t n) {
+    uint8x16_t letter = vandq_u8(vcgtq_u8(n, vdupq_n_u8(9)), vdupq_n_u8('A' - '0' - 10));
+    return vaddq_u8(vaddq_u8(n, vdupq_n_u8('0')), letter);
+}
+
+static void encode_neon(uint8_t const * src, size_t n, char * dest) {
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        uint8x16_t b = vld1q_u8(src + i);
+        uint8x16x2_t out;
+        out.val[0] = neon_nibble2hex(vshrq_n_u8(b, 4));
+        out.val[1] = neon_nibble2hex(vandq_u8(b, vdupq_n_u8(0x0F)));
+        vst2q_u8((uint8_t *)(dest + 2*i), out);
+    }
+    encode_scalar(src + i, n - i, dest + 2*i);
+}
+
+static inline uint8x16_t neon_hex2nibble(uint8x16_t c, uint8x16_t * invalid) {
+    uint8x16_t d = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t a = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isDigit = vcltq_u8(d, vdupq_n_u8(10));
+    uint8x16_t isAlpha = vcltq_u8(a, vdupq_n_u8(6));
+    *invalid = vorrq_u8(*invalid, vmvnq_u8(vorrq_u8(isDigit, isAlpha)));
+    return vorrq_u8(vandq_u8(isDigit, d), vandq_u8(isAlpha, vaddq_u8(a, vdupq_n_u8(10))));
+}
+
+static bool decode_neon(char const * src, size_t n, uint8_t * dest) {
+    uint8x16_t invalid = vdupq_n_u8(0);
+    size_t i = 0;
+    for(; i + 16 <= n; i += 16) {
+        uint8x16x2_t c = vld2q_u8((uint8_t const *)(src + 2*i));     // even and odd characters
+        uint8x16_t hi = neon_hex2nibble(c.val[0], &invalid);
+        uint8x16_t lo = neon_hex2nibble(c.val[1], &invalid);
+        vst1q_u8(dest + i, vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    }
+    bool ok = vmaxvq_u8(invalid) == 0;
+    return decode_scalar(src + 2*i, n - i, dest + i) && ok;
+}
+#endif
+
+/* kernels selectable with hex_setKernel */
+static const kernel_ops ops_scalar = { HEX_KERNEL_SCALAR, encode_scalar, decode_scalar };
+#ifdef HEX_HAVE_SSE2
+static const kernel_ops ops_sse2 = { HEX_KERNEL_SSE2, encode_sse2, decode_sse2 };
+#endif
+#ifdef HEX_HAVE_AVX2
+static const kernel_ops ops_avx2 = { HEX_KERNEL_AVX2, encode_avx2, decode_avx2 };
+#endif
+#ifdef HEX_HAVE_NEON
+static const kernel_ops ops_neon = { HEX_KERNEL_NEON, encode_neon, decode_neon };
+#endif
+
+#ifdef HEX_SCALAR_ONLY
+static const kernel_ops * kernels = &ops_scalar;
+#else
+static const kernel_ops * KERNELS_ATOMIC kernels;   // NULL until resolved
+#endif
+
+static hex_kernel best_kernel(void) {
+#if defined(HEX_AVX2_RUNTIME)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return HEX_KERNEL_AVX2;
+    return HEX_KERNEL_SSE2;
+#elif defined(HEX_HAVE_AVX2)
+    return HEX_KERNEL_AVX2;
+#elif defined(HEX_HAVE_SSE2)
+    return HEX_KERNEL_SSE2;
+#elif defined(HEX_HAVE_NEON)
+    return HEX_KERNEL_NEON;
+#else
+    return HEX_KERNEL_SCALAR;
+#endif
+}
+
+// kernels of kernel, NULL if they are not available on this CPU
+static const kernel_ops * find_kernels(hex_kernel kernel) {
+    if(kernel == HEX_KERNEL_AUTO) kernel = best_kernel();
+
+    switch(kernel) {
+    case HEX_KERNEL_SCALAR:
+        return &ops_scalar;
+#ifdef HEX_HAVE_SSE2
+    case HEX_KERNEL_SSE2:
+        return &ops_sse2;
+#endif
+#ifdef HEX_HAVE_AVX2
+    case HEX_KERNEL_AVX2:
+#ifdef HEX_AVX2_RUNTIME
+        __builtin_cpu_init();
+        if(!__builtin_cpu_supports("avx2")) return NULL;
+#endif
+        return &ops_avx2;
+#endif
+#ifdef HEX_HAVE_NEON
+    case HEX_KERNEL_NEON:
+        return &ops_neon;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+// selected kernels, the best ones on the first call
+static const kernel_ops * resolve_kernels(void) {
+    const kernel_ops *ops = KERNELS_LOAD(&kernels);
+    if(ops == NULL) {
+        ops = find_kernels(HEX_KERNEL_AUTO);
+        KERNELS_STORE(&kernels, ops);
+    }
+    return ops;
+}
+
+bool hex_setKernel(hex_kernel kernel) {
+    const kernel_ops *ops = find_kernels(kernel);
+    if(ops == NULL) return false;
+    KERNELS_STORE(&kernels, ops);
+    return true;
+}
+
+hex_kernel hex_getKernel(void) {
+    return resolve_kernels()->kernel;
+}
+
+void hex_encode(uint8_t const * src, size_t n, char * dest) {
+    /* short arrays, e.g. EUI and short address, are not worth a dispatch */
+    if(n < 16) {
+        encode_scalar(src, n, dest);
+        return;
+    }
+    resolve_kernels()->encode(src, n, dest);
+}
+
+bool hex_decode(char const * src, size_t n, uint8_t * dest) {
+    if(n < 16) return decode_scalar(src, n, dest);
+    return resolve_kernels()->decode(src, n, dest);
+}
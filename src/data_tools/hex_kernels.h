@@ -0,0 +1,96 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Byte array <-> hex string kernels, vectorised with SSE2/AVX2 or NEON where available.
+ *
+ * The dispatching functions pick the widest kernel the CPU supports: AVX2 is selected at
+ * compile time with -mavx2 or at run time on x86 with GCC/Clang, SSE2 and NEON (AArch64)
+ * at compile time. All other targets, e.g. AVR and Cortex-M, use the scalar kernels.
+ * The kernels are resolved on the first call; the functions may be called from several threads.
+ */
+
+#ifndef HEX_KERNELS_H_
+#define HEX_KERNELS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ***** INCLUDES *********************************************************************************
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// ***** DEFINES **********************************************************************************
+
+/** Kernels for \ref hex_setKernel */
+typedef enum hex_kernel {
+    HEX_KERNEL_AUTO   = 0,  // widest kernel supported by the CPU
+    HEX_KERNEL_SCALAR = 1,
+    HEX_KERNEL_SSE2   = 2,
+    HEX_KERNEL_AVX2   = 3,
+    HEX_KERNEL_NEON   = 4,
+} hex_kernel;
+
+// ***** PROTOTYPES *******************************************************************************
+
+/**
+ * \brief       Encode bytes as upper case hex characters. No NULL termination!
+ *
+ * \param[in]   src     Bytes to encode
+ * \param[in]   n       Number of bytes
+ * \param[out]  dest    Memory for 2*n characters
+ */
+void hex_encode(uint8_t const * src, size_t n, char * dest);
+
+/**
+ * \brief       Decode hex characters to bytes, upper and lower case are accepted.
+ *
+ * \param[in]   src     2*n hex characters
+ * \param[in]   n       Number of bytes to produce
+ * \param[out]  dest    Memory for n bytes, undefined if false is returned
+ *
+ * \return      false if src contains a character that is not a hex digit
+ */
+bool hex_decode(char const * src, size_t n, uint8_t * dest);
+
+/**
+ * \brief       Select the kernels used by hex_encode/hex_decode, e.g. to compare them in a benchmark.
+ *
+ * \return      false if the kernel is not available on this CPU, the selection is unchanged then
+ */
+bool hex_setKernel(hex_kernel kernel);
+
+/**
+ * \brief       Kernel currently used, never HEX_KERNEL_AUTO
+ */
+hex_kernel hex_getKernel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEX_KERNELS_H_ */
@@ -33,6 +33,7 @@
 #include <stddef.h>
 #include "string_tools.h"
 #include "char_tools.h"
+#include "hex_kernels.h"
 
 // ***** DEFINES **********************************************************************************
 // ***** DECLARATIONS *****************************************************************************
@@ -130,21 +131,16 @@ char * string_byte2hex_zt(uint8_t const b, char dest[3]) {
     return dest;
 }
 
-uint_fast16_t string_byteArray2hex(uint8_t const * byteArray, uint_fast16_t const nBytes, char * dest, uint_fast16_t const destSize) {
-    if(destSize < 2 * nBytes) { return 0; }
+size_t string_byteArray2hex(uint8_t const * byteArray, size_t const nBytes, char * dest, size_t const destSize) {
+    if(destSize / 2 < nBytes) { return 0; }
 
-    for(uint_fast16_t i = 0; i < nBytes; i++) {
-        string_byte2hex(byteArray[i], &dest[i*2]);
-    }
+    hex_encode(byteArray, nBytes, dest);
 
     return 2*nBytes;
 }
 
-uint8_t string_hex2byteArray(unsigned char const * hexString, uint8_t const hexStringLength, uint8_t * dest, uint8_t destSize){
+uint8_t string_hex2byteArray(unsigned char const * hexString, size_t const hexStringLength, uint8_t * dest, size_t destSize){
     if(destSize < hexStringLength/2 || hexStringLength&1) { return 0; }
 
-    for(uint_fast16_t i = 0; i < destSize; i++) {
-        *(dest+i) = char_hex2uint(*(hexString+2*i))<<4 | char_hex2uint(*(hexString+2*i+1));
-    }
-    return 1;
+    return hex_decode((char const *)hexString, hexStringLength/2, dest) ? 1 : 0;
 }
@@ -31,6 +31,7 @@
 #define LIB_C_MODULES_STRINGS_STRING_TOOLS_H_
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -110,14 +111,33 @@ void string_byte2hex(uint8_t const b, char dest[2]);
  */
 char* string_byte2hex_zt(uint8_t const b, char dest[3]);
 
-uint8_t string_hex2byteArray(unsigned char const * hexString, uint8_t const hexStringLength, uint8_t * dest, uint8_t destSize);
+/**
+ * \brief       Hex ascii char array to byte array routine.
+ *
+ * \param[in]   hexString       The string to be transformed, two characters per byte
+ * \param[in]   hexStringLength Length of the hexadecimal string, must be even
+ * \param[out]  dest            Memory location the bytes will be written to.
+ * \param[in]   destSize        Size of dest in byte
+ *
+ * \return      1 if hexStringLength/2 bytes were written to dest, 0 if dest is too small, the length is odd
+ *              or hexString contains a character that is not a hex digit.
+ */
+uint8_t string_hex2byteArray(unsigned char const * hexString, size_t const hexStringLength, uint8_t * dest, size_t destSize);
+
+/**
+ * \brief       Byte array to hex ascii char array routine, upper case. No NULL termination!
+ *
+ * \param[in]   byteArray   Bytes to convert
+ * \param[in]   nBytes      Number of bytes in byteArray
+ * \param[out]  dest        Memory location the ascii hex array will be written to.
+ * \param[in]   destSize    Size of dest, at least 2*nBytes
+ *
+ * \return      Number of characters written, 0 if dest is too small
+ */
+size_t string_byteArray2hex(uint8_t const * byteArray, size_t const nBytes, char * dest, size_t const destSize);
 
 #ifdef __cplusplus
 }
 #endif
 
-
-
-uint_fast16_t string_byteArray2hex(uint8_t const * byteArray, uint_fast16_t const nBytes, char * dest, uint_fast16_t const destSize);
-
 #endif /* LIB_C_MODULES_STRINGS_STRING_TOOLS_H_ */
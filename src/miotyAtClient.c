@@ -28,235 +28,680 @@
  */
 
 #include "miotyAtClient.h"
+#include "miotyAtParser.h"
+#include "miotyAtTrace.h"
 #include "data_tools/string_tools.h"
 
-static miotyAtClient_returnCode get_info_bytes(const char *atCmd, size_t sizeCmd, uint8_t *buffer, size_t *sizeBuf);
-static miotyAtClient_returnCode set_info_bytes(const char *atCmd, size_t sizeCmd, const uint8_t *data, size_t size_data);
-static miotyAtClient_returnCode get_info_int(const char *atCmd, size_t sizeCmd, uint32_t *res);
-static miotyAtClient_returnCode set_info_int(const char *atCmd, size_t sizeCmd, uint32_t *info);
-static miotyAtClient_returnCode get_info_string(const char *atCmd, size_t sizeCmd, uint8_t *buffer, size_t *sizeBuf);
-static miotyAtClient_returnCode checkATresponseMsg(uint32_t *packetCounter);
-static void get_packet_counter(char *response_buf, uint32_t *packetCounter);
-static void get_DLMPF(char *response_buf, uint8_t *dlmpf);
-static void get_MSTA(char *response_buf, uint8_t *msta);
-static void write_cmd_bytes(const char *atCmd, size_t sizeCmd, const uint8_t *data, size_t sizeData);
-static miotyAtClient_returnCode get_int_data_AtResponse(const char *atCmd, size_t sizeCmd, uint32_t *res, char *response_buf);
-static miotyAtClient_returnCode get_data_AtResponse(const char *atCmd, size_t sizeCmd, uint8_t *buffer, size_t *sizeBuf, char *response_buf);
-static miotyAtClient_returnCode get_string_AtResponse(const char *atCmd, size_t sizeCmd, uint8_t *buffer, size_t *sizeBuf, char *response_buf);
-static miotyAtClient_returnCode check_AtResponse(char *response_buf);
-
-
-miotyAtClient_returnCode miotyAtClient_reset(void) {
-    char cmd[7] = "AT-RST\r";
-    miotyAtClientWrite((uint8_t *)cmd, sizeof(cmd));
-    /* this command has no answer */
-    return MIOTYATCLIENT_RETURN_CODE_OK;
+/* number of queries of a snapshot, one per MIOTYATCLIENT_SNAPSHOT_* bit */
+#define SNAPSHOT_ITEMS    10
+
+/* reads of output received between commands before the next one is written, without clock */
+#define DRAIN_READS       64
+
+// queries of miotyAtClient_getSnapshot in flight, the queries are the user pointers of their commands
+typedef struct snapshot_state snapshot_state;
+typedef struct {
+    snapshot_state         *state;
+    uint8_t                 item;           // index into snapshot_cmds
+} snapshot_query;
+
+struct snapshot_state {
+    miotyAtClient_snapshot *snapshot;
+    uint16_t                pending;        // MIOTYATCLIENT_SNAPSHOT_* bits submitted and not answered yet
+    uint16_t                refused;        // refused by the modem while it was busy
+    bool                    sequential;     // repeating the refused queries one by one
+    snapshot_query          queries[SNAPSHOT_ITEMS];
+};
+
+/*
+ * AT commands of the client, one line per command:
+ *   id, mnemonic,
+ *   form without argument (EXEC, QUERY or NONE), form with argument (SET_INT, SET_BYTES or NONE),
+ *   type and key of the response field, of the form without argument if there is one, "" for the
+ *   key named after the command, timeout class and flags.
+ */
+#define AT_COMMANDS(X) \
+    X(RST,     "AT-RST",     EXEC,  NONE,      NONE,   "",    DEFAULT, NO_RESPONSE) \
+    X(Z,       "ATZ",        EXEC,  NONE,      NONE,   "",    DEFAULT, NO_RESPONSE) \
+    X(SBTL,    "AT-SBTL",    EXEC,  NONE,      NONE,   "",    DEFAULT, NO_RESPONSE) \
+    X(SHDN,    "AT-SHDN",    EXEC,  NONE,      NONE,   "",    DEFAULT, NO_RESPONSE) \
+    X(I,       "ATI",        EXEC,  NONE,      STRING, "",    DEFAULT, NONE)        \
+    X(LIBV,    "AT-LIBV",    EXEC,  NONE,      STRING, "",    DEFAULT, NONE)        \
+    X(MNWK,    "AT-MNWK",    NONE,  SET_BYTES, NONE,   "",    DEFAULT, NONE)        \
+    X(MIP6,    "AT-MIP6",    QUERY, SET_BYTES, DATA,   "",    DEFAULT, NONE)        \
+    X(MEUI,    "AT-MEUI",    QUERY, SET_BYTES, DATA,   "",    DEFAULT, NONE)        \
+    X(MSAD,    "AT-MSAD",    QUERY, SET_BYTES, DATA,   "",    DEFAULT, NONE)        \
+    X(MPCT,    "AT-MPCT",    QUERY, NONE,      INT,    "",    DEFAULT, NONE)        \
+    X(MAS,     "AT-MAS",     QUERY, NONE,      INT,    "",    DEFAULT, NONE)        \
+    X(MRDR,    "AT-MRDR",    QUERY, SET_INT,   INT,    "",    DEFAULT, NONE)        \
+    X(UTPL,    "AT-UTPL",    QUERY, SET_INT,   INT,    "",    DEFAULT, NONE)        \
+    X(UM,      "AT-UM",      QUERY, SET_INT,   INT,    "",    DEFAULT, NONE)        \
+    X(UP,      "AT-UP",      QUERY, SET_INT,   INT,    "",    DEFAULT, NONE)        \
+    X(MAOA,    "AT-MAOA",    NONE,  SET_BYTES, NONE,   "",    ATTACH,  NONE)        \
+    X(MDOA,    "AT-MDOA",    NONE,  SET_BYTES, NONE,   "",    ATTACH,  NONE)        \
+    X(MALO,    "AT-MALO",    EXEC,  NONE,      NONE,   "",    DEFAULT, NONE)        \
+    X(MDLO,    "AT-MDLO",    EXEC,  NONE,      NONE,   "",    DEFAULT, NONE)        \
+    X(TXINH,   "AT-TXINH",   QUERY, SET_INT,   INT,    "",    DEFAULT, NONE)        \
+    X(TXACT,   "AT-TXACT",   QUERY, SET_INT,   INT,    "",    DEFAULT, NONE)        \
+    X(RXACT,   "AT-RXACT",   QUERY, SET_INT,   INT,    "",    DEFAULT, NONE)        \
+    X(TXCU,    "AT$TXCU",    NONE,  SET_INT,   NONE,   "",    DEFAULT, NONE)        \
+    X(TXCMLP,  "AT$TXCMLP",  NONE,  SET_INT,   NONE,   "",    DEFAULT, NONE)        \
+    X(TXOFF,   "AT$TXOFF",   EXEC,  NONE,      NONE,   "",    DEFAULT, NONE)        \
+    X(RXCONT,  "AT$RXCONT",  NONE,  SET_INT,   NONE,   "",    DEFAULT, NONE)        \
+    X(RXOFF,   "AT$RXOFF",   EXEC,  NONE,      NONE,   "",    DEFAULT, NONE)        \
+    X(U,       "AT-U",       NONE,  SET_BYTES, NONE,   "",    UPLINK,  NONE)        \
+    X(UMPF,    "AT-UMPF",    NONE,  SET_BYTES, NONE,   "",    UPLINK,  NONE)        \
+    X(B,       "AT-B",       NONE,  SET_BYTES, DATA,   "-B",  BIDI,    NONE)        \
+    X(BMPF,    "AT-BMPF",    NONE,  SET_BYTES, DATA,   "-B",  BIDI,    NONE)        \
+    X(TU,      "AT-TU",      NONE,  SET_BYTES, NONE,   "",    UPLINK,  NONE)        \
+    X(TB,      "AT-TB",      NONE,  SET_BYTES, DATA,   "-TB", BIDI,    NONE)
+
+typedef enum {
+#define CMD_ID(id, mnemonic, form, setForm, respType, respKey, timeoutClass, flags) CMD_##id,
+    AT_COMMANDS(CMD_ID)
+#undef CMD_ID
+    CMD_COUNT
+} cmd_id;
+
+// command being written, pieces are gathered in iov or copied to buf and passed on in chunks
+typedef struct {
+    miotyAtClient_ctx      *ctx;
+    miotyAtClient_iovec     iov[MIOTYATCLIENT_WRITEV_MAX];
+    size_t                  count;
+    size_t                  fill;           // bytes used in buf
+    size_t                  mark;           // bytes of buf already referenced in iov
+    uint8_t                 buf[MIOTYATCLIENT_WRITE_CHUNK_SIZE];
+#if MIOTYATCLIENT_METRICS
+    uint32_t                sent;           // bytes passed to the transport
+#endif
+#if MIOTYATCLIENT_TRACE
+    uint8_t                 traceCmd;       // number of the command in the trace
+#endif
+} tx_stream;
+
+static void cmd_init(miotyAtClient_cmd *cmd, cmd_id id, bool set);
+static miotyAtClient_returnCode get_info_bytes(miotyAtClient_ctx *ctx, cmd_id id, uint8_t *buffer, size_t *sizeBuf);
+static miotyAtClient_returnCode set_info_bytes(miotyAtClient_ctx *ctx, cmd_id id, const uint8_t *data, size_t size_data);
+static miotyAtClient_returnCode get_info_int(miotyAtClient_ctx *ctx, cmd_id id, uint32_t *res);
+static miotyAtClient_returnCode set_info_int(miotyAtClient_ctx *ctx, cmd_id id, uint32_t *info);
+static miotyAtClient_returnCode exec_cmd(miotyAtClient_ctx *ctx, cmd_id id);
+static miotyAtClient_returnCode send_message(miotyAtClient_ctx *ctx, miotyAtClient_uplinkType type, const uint8_t *msg, size_t sizeMsg,
+                                             uint8_t *data, size_t *size_data, uint8_t *dl_mpf, uint32_t *packetCounter);
+static miotyAtClient_returnCode msta_cmd(miotyAtClient_ctx *ctx, miotyAtClient_cmd *cmd, uint8_t *msta);
+static miotyAtClient_returnCode run_cmd(miotyAtClient_ctx *ctx, miotyAtClient_cmd *cmd, miotyAtClient_result *result);
+static void run_cmd_done(miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user);
+static void get_packet_counter(const miotyAtClient_result *result, uint32_t *packetCounter);
+static void get_DLMPF(const miotyAtClient_result *result, uint8_t *dlmpf);
+static void get_MSTA(const miotyAtClient_result *result, uint8_t *msta);
+static miotyAtClient_returnCode cached_bytes(miotyAtClient_ctx *ctx, uint8_t bit, uint8_t *cached, cmd_id id,
+                                             uint8_t *bytes, size_t size, bool set);
+static miotyAtClient_returnCode cached_int(miotyAtClient_ctx *ctx, uint8_t bit, uint32_t *cached, cmd_id id,
+                                           uint32_t *value, bool set);
+static void counter_reset(miotyAtClient_ctx *ctx);
+static void observe_packet_counter(miotyAtClient_ctx *ctx, uint32_t counter, bool uplink);
+static void snapshot_run(miotyAtClient_ctx *ctx, snapshot_state *state, uint16_t items);
+static void snapshot_done(miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user);
+static void snapshot_store(miotyAtClient_ctx *ctx, miotyAtClient_snapshot *snapshot, uint8_t item, const miotyAtClient_result *result);
+static size_t poll_once(miotyAtClient_ctx *ctx);
+static size_t feed_ring(miotyAtClient_ctx *ctx);
+static void parse(miotyAtClient_ctx *ctx, const uint8_t *data, size_t len);
+static void drain_idle(miotyAtClient_ctx *ctx);
+static bool listening(const miotyAtClient_ctx *ctx);
+static void time_out(miotyAtClient_ctx *ctx);
+static bool quieting(miotyAtClient_ctx *ctx);
+static void start_next(miotyAtClient_ctx *ctx);
+static bool pipelinable(const miotyAtClient_cmd *cmd);
+static void start_parser(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd);
+static void start_idle(miotyAtClient_ctx *ctx);
+static void set_urc_keys(miotyAtClient_ctx *ctx);
+static void dispatch_urc(miotyAtClient_ctx *ctx);
+static uint32_t cmd_timeout(const miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd);
+static void complete_cmd(miotyAtClient_ctx *ctx, miotyAtClient_returnCode returnCode);
+static miotyAtClient_returnCode parser_return_code(const miotyAtParser *parser);
+static uint32_t parser_modem_error(const miotyAtParser *parser);
+static void write_cmd(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd);
+static void write_cmd_bytes(tx_stream *tx, const uint8_t *data, size_t sizeData);
+static void tx_mark(tx_stream *tx);
+static void tx_flush(tx_stream *tx);
+static void tx_copy(tx_stream *tx, const void *data, size_t len);
+static void tx_ref(tx_stream *tx, const void *data, size_t len);
+#if MIOTYATCLIENT_METRICS
+static bool metrics_now(const miotyAtClient_ctx *ctx, uint32_t *now);
+static void metrics_begin(miotyAtClient_ctx *ctx);
+static void metrics_end(miotyAtClient_ctx *ctx);
+static void metrics_written(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd, uint32_t sent);
+static void metrics_received(miotyAtClient_ctx *ctx, size_t len);
+static void metrics_completed(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd, miotyAtClient_returnCode returnCode);
+static void metrics_urc(miotyAtClient_ctx *ctx);
+static miotyAtClient_cmdMetrics *metrics_slot(miotyAtClient_metrics *metrics, const miotyAtClient_cmd *cmd);
+static uint8_t metrics_code_index(miotyAtClient_returnCode code);
+#define METRICS_SENT(tx, n)                         ((tx)->sent += (uint32_t)(n))
+#define METRICS_WRITTEN(ctx, cmd, tx)               metrics_written(ctx, cmd, (tx)->sent)
+#define METRICS_RECEIVED(ctx, len)                  metrics_received(ctx, len)
+#define METRICS_COMPLETED(ctx, cmd, returnCode)     metrics_completed(ctx, cmd, returnCode)
+#define METRICS_URC(ctx)                            metrics_urc(ctx)
+#else
+#define METRICS_SENT(tx, n)                         ((void)0)
+#define METRICS_WRITTEN(ctx, cmd, tx)               ((void)0)
+#define METRICS_RECEIVED(ctx, len)                  ((void)0)
+#define METRICS_COMPLETED(ctx, cmd, returnCode)     ((void)0)
+#define METRICS_URC(ctx)                            ((void)0)
+#endif
+#if MIOTYATCLIENT_TRACE
+static void trace_written(tx_stream *tx, const miotyAtClient_cmd *cmd);
+static void trace_record(miotyAtClient_ctx *ctx, miotyAtTrace_type type, uint8_t cmd, const miotyAtClient_iovec *iov, size_t count);
+static void trace_sent(tx_stream *tx, const void *data, size_t len);
+static void trace_received(miotyAtClient_ctx *ctx, const uint8_t *data, size_t len);
+static void trace_completed(miotyAtClient_ctx *ctx, miotyAtClient_returnCode returnCode);
+#define TRACE_WRITTEN(tx, cmd)                      trace_written(tx, cmd)
+#define TRACE_TX(tx, iov, count)                    trace_record((tx)->ctx, MIOTYATTRACE_TX, (tx)->traceCmd, iov, count)
+#define TRACE_TX_BYTES(tx, data, len)               trace_sent(tx, data, len)
+#define TRACE_RX(ctx, data, len)                    trace_received(ctx, data, len)
+#define TRACE_COMPLETED(ctx, returnCode)            trace_completed(ctx, returnCode)
+#else
+#define TRACE_WRITTEN(tx, cmd)                      ((void)0)
+#define TRACE_TX(tx, iov, count)                    ((void)0)
+#define TRACE_TX_BYTES(tx, data, len)               ((void)0)
+#define TRACE_RX(ctx, data, len)                    ((void)0)
+#define TRACE_COMPLETED(ctx, returnCode)            ((void)0)
+#endif
+
+#if defined(__AVR__)
+/* single byte indices on 8 bit MCUs, volatile accesses are atomic and not reordered */
+#define RX_LOAD_ACQUIRE(ptr)        (*(ptr))
+#define RX_STORE_RELEASE(ptr, val)  (*(ptr) = (val))
+#define METRICS_FENCE()             ((void)0)
+#elif defined(__GNUC__)
+#define RX_LOAD_ACQUIRE(ptr)        __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define RX_STORE_RELEASE(ptr, val)  __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#define METRICS_FENCE()             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+/* the indices are word sized volatile objects, the fences order the ring accesses around them */
+#define RX_LOAD_ACQUIRE(ptr)        rx_load_acquire(ptr)
+#define RX_STORE_RELEASE(ptr, val)  (atomic_thread_fence(memory_order_release), *(ptr) = (val))
+#define METRICS_FENCE()             atomic_thread_fence(memory_order_seq_cst)
+static inline miotyAtClient_rxIndex rx_load_acquire(const volatile miotyAtClient_rxIndex *ptr) {
+    miotyAtClient_rxIndex val = *ptr;
+    atomic_thread_fence(memory_order_acquire);
+    return val;
 }
+#else
+#error "the receive ring and the metrics need GCC compatible atomics or C11 <stdatomic.h> on this compiler"
+#endif
 
-miotyAtClient_returnCode miotyAtClient_factoryReset(void) {
-    char cmd[4] = "ATZ\r";
-    miotyAtClientWrite((uint8_t *)cmd, sizeof(cmd));
-    /* this command has no answer */
-    return MIOTYATCLIENT_RETURN_CODE_OK;
+typedef struct {
+    miotyAtClient_result   *result;
+    bool                    done;
+} run_state;
+
+/* private flag of queued commands: written while the modem was still busy with the previous one */
+#define CMD_FLAG_AHEAD          0x80
+/* private flag of queued commands: atCmd is followed by the terminator of its form, "?\r" or "\r" */
+#define CMD_FLAG_TERMINATED     0x40
+
+/* bits of miotyAtClient_cache.valid */
+#define CACHE_EUI               0x01
+#define CACHE_SHORT_ADDRESS     0x02
+#define CACHE_ATTACHED          0x04
+#define CACHE_DOWNLINK_REQUEST  0x08
+#define CACHE_TX_POWER          0x10
+#define CACHE_UPLINK_MODE       0x20
+#define CACHE_UPLINK_PROFILE    0x40
+
+#define CMD_FORM_NONE           0xFF
+#define CMD_FORM_EXEC           MIOTYATCLIENT_CMD_FORM_EXEC
+#define CMD_FORM_QUERY          MIOTYATCLIENT_CMD_FORM_QUERY
+#define CMD_FORM_SET_INT        MIOTYATCLIENT_CMD_FORM_SET_INT
+#define CMD_FORM_SET_BYTES      MIOTYATCLIENT_CMD_FORM_SET_BYTES
+#define CMD_END_NONE            ""
+#define CMD_END_EXEC            "\r"
+#define CMD_END_QUERY           "?\r"
+#define CMD_FLAGS_NONE          0
+#define CMD_FLAGS_NO_RESPONSE   MIOTYATCLIENT_CMD_FLAG_NO_RESPONSE
+
+/* the mnemonic is stored with the terminator of its form without argument, so that form is one write */
+static const struct {
+    const char *text;
+    const char *respKey;        // NULL for the key named after the command
+    uint8_t     sizeCmd;        // of the mnemonic
+    uint8_t     form;           // without argument, CMD_FORM_NONE if there is none
+    uint8_t     setForm;        // with argument
+    uint8_t     respType;
+    uint8_t     sizeRespKey;
+    uint8_t     timeoutClass;
+    uint8_t     flags;
+} at_cmds[CMD_COUNT] = {
+#define CMD_DESC(id, mnemonic, form, setForm, respType, respKey, timeoutClass, flags) \
+    [CMD_##id] = { mnemonic CMD_END_##form, sizeof(respKey) > 1 ? respKey : NULL, sizeof(mnemonic) - 1, \
+                   CMD_FORM_##form, CMD_FORM_##setForm, MIOTYATPARSER_VALUE_##respType, sizeof(respKey) - 1, \
+                   MIOTYATCLIENT_TIMEOUT_##timeoutClass, CMD_FLAGS_##flags },
+    AT_COMMANDS(CMD_DESC)
+#undef CMD_DESC
+};
+
+static const uint8_t uplink_cmds[] = {
+    [MIOTYATCLIENT_UPLINK_UNI]              = CMD_U,
+    [MIOTYATCLIENT_UPLINK_UNI_MPF]          = CMD_UMPF,
+    [MIOTYATCLIENT_UPLINK_BIDI]             = CMD_B,
+    [MIOTYATCLIENT_UPLINK_BIDI_MPF]         = CMD_BMPF,
+    [MIOTYATCLIENT_UPLINK_UNI_TRANSPARENT]  = CMD_TU,
+    [MIOTYATCLIENT_UPLINK_BIDI_TRANSPARENT] = CMD_TB,
+};
+
+/* queries of a snapshot in the order of the MIOTYATCLIENT_SNAPSHOT_* bits */
+static const uint8_t snapshot_cmds[SNAPSHOT_ITEMS] = {
+    CMD_I, CMD_LIBV, CMD_MEUI, CMD_MSAD, CMD_MPCT, CMD_MAS, CMD_UTPL, CMD_UM, CMD_UP, CMD_MRDR,
+};
+
+
+void miotyAtClient_init(miotyAtClient_ctx *ctx, miotyAtClient_writeFn write, miotyAtClient_readFn read, void *user) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->write = write;
+    ctx->read = read;
+    ctx->user = user;
+    ctx->timeouts[MIOTYATCLIENT_TIMEOUT_DEFAULT] = MIOTYATCLIENT_TIMEOUT_DEFAULT_MS;
+    ctx->timeouts[MIOTYATCLIENT_TIMEOUT_UPLINK] = MIOTYATCLIENT_TIMEOUT_UPLINK_MS;
+    ctx->timeouts[MIOTYATCLIENT_TIMEOUT_BIDI] = MIOTYATCLIENT_TIMEOUT_BIDI_MS;
+    ctx->timeouts[MIOTYATCLIENT_TIMEOUT_ATTACH] = MIOTYATCLIENT_TIMEOUT_ATTACH_MS;
+    ctx->pipelineDepth = MIOTYATCLIENT_PIPELINE_DEPTH;
+    start_idle(ctx);
 }
 
-miotyAtClient_returnCode miotyAtClient_startBootloader(void) {
-    char cmd[8] = "AT-SBTL\r";
-    miotyAtClientWrite((uint8_t *)cmd, sizeof(cmd));
-    /* this command has no answer */
+void miotyAtClient_setClock(miotyAtClient_ctx *ctx, miotyAtClient_clockFn clock) {
+    ctx->clock = clock;
+    if (clock && ctx->active)
+        ctx->deadline = clock(ctx->user) + cmd_timeout(ctx, &ctx->queue[ctx->queueHead]);
+}
+
+void miotyAtClient_setTimeout(miotyAtClient_ctx *ctx, miotyAtClient_timeoutClass timeoutClass, uint32_t timeoutMs) {
+    if (timeoutClass < MIOTYATCLIENT_TIMEOUT_CLASS_COUNT)
+        ctx->timeouts[timeoutClass] = timeoutMs;
+}
+
+void miotyAtClient_prepareUplink(miotyAtClient_cmd *cmd, miotyAtClient_uplinkType type, const uint8_t *msg, size_t sizeMsg,
+                                 uint8_t *data, size_t sizeData) {
+    cmd_init(cmd, uplink_cmds[type], true);
+    cmd->data = msg;
+    cmd->sizeData = sizeMsg;
+    if (cmd->respType != MIOTYATPARSER_VALUE_NONE) {
+        cmd->rxData = data;
+        cmd->sizeRxData = sizeData;
+    }
+}
+
+miotyAtClient_returnCode miotyAtClient_submit(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd) {
+    if (ctx->queueCount >= MIOTYATCLIENT_CMD_QUEUE_SIZE)
+        return MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished;
+    ctx->queue[(ctx->queueHead + ctx->queueCount) % MIOTYATCLIENT_CMD_QUEUE_SIZE] = *cmd;
+    ctx->queueCount++;
+    start_next(ctx);
     return MIOTYATCLIENT_RETURN_CODE_OK;
 }
 
-miotyAtClient_returnCode miotyAtClient_shutdown(void) {
-    char cmd[8] = "AT-SHDN\r";
-    miotyAtClientWrite((uint8_t *)cmd, sizeof(cmd));
-    /* this command has no answer */
+bool miotyAtClient_poll(miotyAtClient_ctx *ctx) {
+    poll_once(ctx);
+    return ctx->queueCount != 0 || quieting(ctx);
+}
+
+void miotyAtClient_feed(miotyAtClient_ctx *ctx, const uint8_t *data, size_t len) {
+    ctx->feeding = true;
+    parse(ctx, data, len);
+    ctx->feeding = false;
+    start_next(ctx);
+}
+
+#if MIOTYATCLIENT_RX_RING_SIZE > 0
+size_t miotyAtClient_feedRx(miotyAtClient_ctx *ctx, const uint8_t *data, size_t len) {
+    const miotyAtClient_rxIndex head = ctx->rxHead;
+    const miotyAtClient_rxIndex tail = RX_LOAD_ACQUIRE(&ctx->rxTail);
+    size_t space = MIOTYATCLIENT_RX_RING_SIZE - (miotyAtClient_rxIndex)(head - tail);
+    if (len > space) {
+        ctx->rxDropped += len - space;
+        len = space;
+    }
+    for (size_t i = 0; i < len; i++)
+        ctx->rxRing[(miotyAtClient_rxIndex)(head + i) & (MIOTYATCLIENT_RX_RING_SIZE - 1)] = data[i];
+    RX_STORE_RELEASE(&ctx->rxHead, (miotyAtClient_rxIndex)(head + len));
+    return len;
+}
+#endif
+
+void miotyAtClient_setWritev(miotyAtClient_ctx *ctx, miotyAtClient_writevFn writev) {
+    ctx->writev = writev;
+}
+
+void miotyAtClient_setIdle(miotyAtClient_ctx *ctx, miotyAtClient_idleFn idle) {
+    ctx->idle = idle;
+}
+
+void miotyAtClient_enableCache(miotyAtClient_ctx *ctx, bool enable) {
+    ctx->cache.enabled = enable;
+    ctx->cache.valid = 0;
+}
+
+void miotyAtClient_invalidateCache(miotyAtClient_ctx *ctx) {
+    ctx->cache.valid = 0;
+}
+
+void miotyAtClient_setPacketCounterEvent(miotyAtClient_ctx *ctx, miotyAtClient_packetCounterFn event) {
+    ctx->onPacketCounter = event;
+}
+
+void miotyAtClient_setPipelining(miotyAtClient_ctx *ctx, uint8_t depth) {
+    ctx->pipelineDepth = depth < MIOTYATCLIENT_CMD_QUEUE_SIZE ? depth : MIOTYATCLIENT_CMD_QUEUE_SIZE;
+    ctx->pipelineSet = true;
+    ctx->pipelineRejected = false;
+}
+
+miotyAtClient_returnCode miotyAtClient_addUrcHandler(miotyAtClient_ctx *ctx, const char *key, miotyAtParser_valueType type,
+                                                     miotyAtClient_urcFn handler, void *user) {
+    if (key == NULL) {
+        ctx->urcLineHandler = handler;
+        ctx->urcLineUser = user;
+        set_urc_keys(ctx);
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    }
+    size_t keyLen = strlen(key);
+    if (keyLen == 0 || keyLen > MIOTYATPARSER_KEY_SIZE)
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentOOR;
+    uint8_t i = 0;
+    while (i < ctx->urcCount && strcmp(ctx->urcKeys[i].key, key) != 0)
+        i++;
+    if (i == MIOTYATCLIENT_URC_HANDLERS)
+        return MIOTYATCLIENT_RETURN_CODE_BufferSizeInsufficient;
+    ctx->urcKeys[i].key = key;
+    ctx->urcKeys[i].keyLen = keyLen;
+    ctx->urcKeys[i].type = type;
+    ctx->urcHandlers[i] = handler;
+    ctx->urcUsers[i] = user;
+    if (i == ctx->urcCount)
+        ctx->urcCount++;
+    set_urc_keys(ctx);
     return MIOTYATCLIENT_RETURN_CODE_OK;
 }
 
-miotyAtClient_returnCode miotyAtClient_setNetworkKey(const uint8_t *nwKey) {
-    return set_info_bytes("AT-MNWK", 7, nwKey, 16);
+void miotyAtClient_removeUrcHandler(miotyAtClient_ctx *ctx, const char *key) {
+    if (key == NULL) {
+        ctx->urcLineHandler = NULL;
+        ctx->urcLineUser = NULL;
+    }
+    for (uint8_t i = 0; key != NULL && i < ctx->urcCount; i++) {
+        if (strcmp(ctx->urcKeys[i].key, key) == 0) {
+            ctx->urcCount--;
+            ctx->urcKeys[i] = ctx->urcKeys[ctx->urcCount];
+            ctx->urcHandlers[i] = ctx->urcHandlers[ctx->urcCount];
+            ctx->urcUsers[i] = ctx->urcUsers[ctx->urcCount];
+            break;
+        }
+    }
+    set_urc_keys(ctx);
 }
 
-miotyAtClient_returnCode miotyAtClient_getOrSetIPv6SubnetMask(uint8_t *ipv6, bool set) {
-    if (set)
-        return set_info_bytes("AT-MIP6", 7, ipv6, 8);
-    size_t size_bytes = 8;
-    return get_info_bytes("AT-MIP6", 7, ipv6, &size_bytes);
+size_t miotyAtClient_pending(const miotyAtClient_ctx *ctx) {
+    return ctx->queueCount;
 }
 
-miotyAtClient_returnCode miotyAtClient_getOrSetEui(uint8_t *eui64, bool set) {
-    if (set)
-        return set_info_bytes("AT-MEUI", 7, eui64, 8);
-    size_t size_bytes = 8;
-    return get_info_bytes("AT-MEUI", 7, eui64, &size_bytes);
+#if MIOTYATCLIENT_METRICS
+void miotyAtClient_setMetricsClock(miotyAtClient_ctx *ctx, miotyAtClient_clockFn clock) {
+    ctx->metricsClock = clock;
 }
 
-miotyAtClient_returnCode miotyAtClient_getOrSetShortAddress(uint8_t *shortAddress, bool set) {
-    if (set)
-        return set_info_bytes("AT-MSAD", 7, shortAddress, 2);
-    size_t size_bytes = 2;
-    return get_info_bytes("AT-MSAD", 7, shortAddress, &size_bytes);
+void miotyAtClient_getMetrics(const miotyAtClient_ctx *ctx, miotyAtClient_metrics *metrics) {
+    /* sequence lock: the copy is valid if the count was even and did not change meanwhile */
+    uint32_t seq;
+    do {
+        do {
+            seq = ctx->metricsSeq;
+        } while (seq & 1);
+        METRICS_FENCE();
+        memcpy(metrics, (const void *)&ctx->metrics, sizeof(*metrics));
+        METRICS_FENCE();
+    } while (ctx->metricsSeq != seq);
 }
 
-miotyAtClient_returnCode miotyAtClient_getPacketCounter(uint32_t *counter) {
-    return get_info_int("AT-MPCT", 7, counter);
+void miotyAtClient_resetMetrics(miotyAtClient_ctx *ctx) {
+    metrics_begin(ctx);
+    memset(&ctx->metrics, 0, sizeof(ctx->metrics));
+    metrics_end(ctx);
 }
 
-miotyAtClient_returnCode miotyAtClient_getOrSetTransmitPower(uint32_t *txPower, bool set) {
-    if (set)
-        return set_info_int("AT-UTPL", 7, txPower);
-    return get_info_int("AT-UTPL", 7, txPower);
+uint32_t miotyAtClient_metricsReturnCode(const miotyAtClient_metrics *metrics, miotyAtClient_returnCode code) {
+    return metrics->returnCodes[metrics_code_index(code)];
 }
+#endif
 
-miotyAtClient_returnCode miotyAtClient_uplinkMode(uint32_t *ulMode, bool set) {
-    if (set)
-        return set_info_int("AT-UM", 5, ulMode);
-    return get_info_int("AT-UM", 5, ulMode);
+#if MIOTYATCLIENT_TRACE
+void miotyAtClient_setTrace(miotyAtClient_ctx *ctx, struct miotyAtTrace *trace) {
+    ctx->trace = trace;
+}
+#endif
+
+miotyAtClient_returnCode miotyAtClient_getSnapshot_ex(miotyAtClient_ctx *ctx, miotyAtClient_snapshot *snapshot) {
+    snapshot_state state = { .snapshot = snapshot };
+    const uint8_t depth = ctx->pipelineDepth;
+    const uint32_t start = ctx->clock ? ctx->clock(ctx->user) : 0;
+
+    snapshot->valid = 0;
+    snapshot->returnCode = MIOTYATCLIENT_RETURN_CODE_OK;
+    snapshot->pipelineDepth = 0;
+    /* the depth set with setPipelining is kept, the default one raised with a clock that times out a modem answering nothing */
+    if (!ctx->pipelineSet && !ctx->pipelineRejected && ctx->clock && depth < MIOTYATCLIENT_CMD_QUEUE_SIZE)
+        ctx->pipelineDepth = MIOTYATCLIENT_CMD_QUEUE_SIZE;
+    snapshot_run(ctx, &state, MIOTYATCLIENT_SNAPSHOT_ALL);
+    /* the modem does not take commands while it is busy, ask again for what it refused, one by one */
+    if (ctx->pipelineRejected) {
+        ctx->pipelineDepth = 1;
+        state.sequential = true;
+        snapshot_run(ctx, &state, state.refused);
+    } else {
+        ctx->pipelineDepth = depth;
+    }
+    if (ctx->clock)
+        snapshot->durationMs = ctx->clock(ctx->user) - start;
+    else
+        snapshot->durationMs = 0;
+    return snapshot->returnCode;
+}
+
+miotyAtClient_returnCode miotyAtClient_reset_ex(miotyAtClient_ctx *ctx) {
+    ctx->cache.valid = 0;
+    /* this command has no answer */
+    return exec_cmd(ctx, CMD_RST);
+}
+
+miotyAtClient_returnCode miotyAtClient_factoryReset_ex(miotyAtClient_ctx *ctx) {
+    ctx->cache.valid = 0;
+    counter_reset(ctx);
+    /* this command has no answer */
+    return exec_cmd(ctx, CMD_Z);
+}
+
+miotyAtClient_returnCode miotyAtClient_startBootloader_ex(miotyAtClient_ctx *ctx) {
+    ctx->cache.valid = 0;
+    /* this command has no answer */
+    return exec_cmd(ctx, CMD_SBTL);
 }
 
-miotyAtClient_returnCode miotyAtClient_uplinkProfile(uint32_t *ulProfile, bool set) {
+miotyAtClient_returnCode miotyAtClient_shutdown_ex(miotyAtClient_ctx *ctx) {
+    ctx->cache.valid = 0;
+    /* this command has no answer */
+    return exec_cmd(ctx, CMD_SHDN);
+}
+
+miotyAtClient_returnCode miotyAtClient_setNetworkKey_ex(miotyAtClient_ctx *ctx, const uint8_t *nwKey) {
+    return set_info_bytes(ctx, CMD_MNWK, nwKey, 16);
+}
+
+miotyAtClient_returnCode miotyAtClient_getOrSetIPv6SubnetMask_ex(miotyAtClient_ctx *ctx, uint8_t *ipv6, bool set) {
     if (set)
-        return set_info_int("AT-UP", 5, ulProfile);
-    return get_info_int("AT-UP", 5, ulProfile);
+        return set_info_bytes(ctx, CMD_MIP6, ipv6, 8);
+    size_t size_bytes = 8;
+    return get_info_bytes(ctx, CMD_MIP6, ipv6, &size_bytes);
+}
+
+miotyAtClient_returnCode miotyAtClient_getOrSetEui_ex(miotyAtClient_ctx *ctx, uint8_t *eui64, bool set) {
+    return cached_bytes(ctx, CACHE_EUI, ctx->cache.eui, CMD_MEUI, eui64, 8, set);
 }
 
-miotyAtClient_returnCode miotyAtClient_sendMessageUni(const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
-    write_cmd_bytes("AT-U", 4, msg, sizeMsg);
-    return checkATresponseMsg(packetCounter);
+miotyAtClient_returnCode miotyAtClient_getOrSetShortAddress_ex(miotyAtClient_ctx *ctx, uint8_t *shortAddress, bool set) {
+    return cached_bytes(ctx, CACHE_SHORT_ADDRESS, ctx->cache.shortAddress, CMD_MSAD, shortAddress, 2, set);
 }
 
-miotyAtClient_returnCode miotyAtClient_sendMessageUniMPF(const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
-    write_cmd_bytes("AT-UMPF", 7, msg, sizeMsg);
-    return checkATresponseMsg(packetCounter);
+miotyAtClient_returnCode miotyAtClient_getPacketCounter_ex(miotyAtClient_ctx *ctx, uint32_t *counter) {
+    if (ctx->packetCounterValid) {
+        *counter = ctx->packetCounter;
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    }
+    return miotyAtClient_refreshPacketCounter_ex(ctx, counter);
 }
 
-miotyAtClient_returnCode miotyAtClient_sendMessageBidi(const uint8_t *msg, size_t sizeMsg,
-                                                       uint8_t *data, size_t *size_data,
-                                                       uint8_t *dl_mpf, uint32_t *packetCounter) {
-    write_cmd_bytes("AT-B", 4, msg, sizeMsg);
-    char response_buf[200];
-    miotyAtClient_returnCode ret = get_data_AtResponse( "AT-B", 4, data, size_data, response_buf);
-    get_packet_counter(response_buf, packetCounter);
+miotyAtClient_returnCode miotyAtClient_refreshPacketCounter_ex(miotyAtClient_ctx *ctx, uint32_t *counter) {
+    uint32_t value;
+    miotyAtClient_returnCode ret = get_info_int(ctx, CMD_MPCT, &value);
     if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
         return ret;
-    get_DLMPF(response_buf, dl_mpf);
-
+    observe_packet_counter(ctx, value, false);
+    *counter = value;
     return ret;
 }
 
-miotyAtClient_returnCode miotyAtClient_sendMessageBidiMPF(const uint8_t *msg, size_t sizeMsg,
-                                                          uint8_t *data, size_t *size_data,
-                                                          uint8_t *dl_mpf, uint32_t *packetCounter) {
-    write_cmd_bytes("AT-BMPF", 7, msg, sizeMsg);
-    char response_buf[200];
-    miotyAtClient_returnCode ret = get_data_AtResponse( "AT-B", 4, data, size_data, response_buf);
-    get_packet_counter(response_buf, packetCounter);
-    if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
-        return ret;
-    get_DLMPF(response_buf, dl_mpf);
+miotyAtClient_returnCode miotyAtClient_getOrSetTransmitPower_ex(miotyAtClient_ctx *ctx, uint32_t *txPower, bool set) {
+    return cached_int(ctx, CACHE_TX_POWER, &ctx->cache.txPower, CMD_UTPL, txPower, set);
+}
 
-    return ret;
+miotyAtClient_returnCode miotyAtClient_uplinkMode_ex(miotyAtClient_ctx *ctx, uint32_t *ulMode, bool set) {
+    return cached_int(ctx, CACHE_UPLINK_MODE, &ctx->cache.uplinkMode, CMD_UM, ulMode, set);
 }
 
-miotyAtClient_returnCode miotyAtClient_sendMessageUniTransparent(const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
-    write_cmd_bytes("AT-TU", 5, msg, sizeMsg);
-    return checkATresponseMsg(packetCounter);
+miotyAtClient_returnCode miotyAtClient_uplinkProfile_ex(miotyAtClient_ctx *ctx, uint32_t *ulProfile, bool set) {
+    return cached_int(ctx, CACHE_UPLINK_PROFILE, &ctx->cache.uplinkProfile, CMD_UP, ulProfile, set);
 }
 
-miotyAtClient_returnCode miotyAtClient_sendMessageBidiTransparent(const uint8_t *msg, size_t sizeMsg,
-                                                                  uint8_t *data, size_t *size_data,
-                                                                  uint32_t *packetCounter) {
-    write_cmd_bytes("AT-TB", 5, msg, sizeMsg);
-    char response_buf[200];
-    miotyAtClient_returnCode ret = get_data_AtResponse( "AT-TB", 5, data, size_data, response_buf);
-    get_packet_counter(response_buf, packetCounter);
-    return ret;
+miotyAtClient_returnCode miotyAtClient_sendMessageUni_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
+    return send_message(ctx, MIOTYATCLIENT_UPLINK_UNI, msg, sizeMsg, NULL, NULL, NULL, packetCounter);
 }
 
-miotyAtClient_returnCode miotyAtClient_macAttach(const uint8_t *nonce4B, uint8_t *msta) {
-    write_cmd_bytes("AT-MAOA", 7, nonce4B, 4);
-    char response_buf[200];
-    miotyAtClient_returnCode ret = check_AtResponse( response_buf);
-    if ( ret != MIOTYATCLIENT_RETURN_CODE_OK)
-        return ret;
-    get_MSTA(response_buf, msta);
+miotyAtClient_returnCode miotyAtClient_sendMessageUniMPF_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
+    return send_message(ctx, MIOTYATCLIENT_UPLINK_UNI_MPF, msg, sizeMsg, NULL, NULL, NULL, packetCounter);
+}
 
-    return ret;
+miotyAtClient_returnCode miotyAtClient_sendMessageBidi_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                          uint8_t *data, size_t *size_data,
+                                                          uint8_t *dl_mpf, uint32_t *packetCounter) {
+    return send_message(ctx, MIOTYATCLIENT_UPLINK_BIDI, msg, sizeMsg, data, size_data, dl_mpf, packetCounter);
 }
 
-miotyAtClient_returnCode miotyAtClient_macDetach(const uint8_t *data, size_t sizeData, uint8_t *msta) {
-    write_cmd_bytes("AT-MDOA", 7, data, sizeData);
-    char response_buf[200];
-    miotyAtClient_returnCode ret = check_AtResponse( response_buf);
-    if ( ret != MIOTYATCLIENT_RETURN_CODE_OK)
-        return ret;
-    get_MSTA(response_buf, msta);
+miotyAtClient_returnCode miotyAtClient_sendMessageBidiMPF_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                             uint8_t *data, size_t *size_data,
+                                                             uint8_t *dl_mpf, uint32_t *packetCounter) {
+    return send_message(ctx, MIOTYATCLIENT_UPLINK_BIDI_MPF, msg, sizeMsg, data, size_data, dl_mpf, packetCounter);
+}
 
-    return ret;
+miotyAtClient_returnCode miotyAtClient_sendMessageUniTransparent_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
+    return send_message(ctx, MIOTYATCLIENT_UPLINK_UNI_TRANSPARENT, msg, sizeMsg, NULL, NULL, NULL, packetCounter);
 }
 
-miotyAtClient_returnCode miotyAtClient_macAttachLocal(uint8_t *msta) {
-    miotyAtClientWrite((uint8_t *)"AT-MALO\r", 8);
-    char response_buf[200];
-    miotyAtClient_returnCode ret = check_AtResponse( response_buf);
-    if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
-        return ret;
-    get_MSTA(response_buf, msta);
+miotyAtClient_returnCode miotyAtClient_sendMessageBidiTransparent_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                                     uint8_t *data, size_t *size_data,
+                                                                     uint32_t *packetCounter) {
+    return send_message(ctx, MIOTYATCLIENT_UPLINK_BIDI_TRANSPARENT, msg, sizeMsg, data, size_data, NULL, packetCounter);
+}
 
-    return ret;
+miotyAtClient_returnCode miotyAtClient_macAttach_ex(miotyAtClient_ctx *ctx, const uint8_t *nonce4B, uint8_t *msta) {
+    ctx->cache.valid = 0;
+    counter_reset(ctx);
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, CMD_MAOA, true);
+    cmd.data = nonce4B;
+    cmd.sizeData = 4;
+    return msta_cmd(ctx, &cmd, msta);
 }
 
-miotyAtClient_returnCode miotyAtClient_macDetachLocal(uint8_t *msta) {
-    miotyAtClientWrite((uint8_t *)"AT-MDLO\r", 8);
-    char response_buf[200];
-    miotyAtClient_returnCode ret = check_AtResponse( response_buf);
-    if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
-        return ret;
-    get_MSTA(response_buf, msta);
+miotyAtClient_returnCode miotyAtClient_macDetach_ex(miotyAtClient_ctx *ctx, const uint8_t *data, size_t sizeData, uint8_t *msta) {
+    ctx->cache.valid = 0;
+    counter_reset(ctx);
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, CMD_MDOA, true);
+    cmd.data = data;
+    cmd.sizeData = sizeData;
+    return msta_cmd(ctx, &cmd, msta);
+}
 
-    return ret;
+miotyAtClient_returnCode miotyAtClient_macAttachLocal_ex(miotyAtClient_ctx *ctx, uint8_t *msta) {
+    ctx->cache.valid = 0;
+    counter_reset(ctx);
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, CMD_MALO, false);
+    return msta_cmd(ctx, &cmd, msta);
+}
+
+miotyAtClient_returnCode miotyAtClient_macDetachLocal_ex(miotyAtClient_ctx *ctx, uint8_t *msta) {
+    ctx->cache.valid = 0;
+    counter_reset(ctx);
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, CMD_MDLO, false);
+    return msta_cmd(ctx, &cmd, msta);
 }
 
-miotyAtClient_returnCode miotyAtClient_getAttachment(bool *attached) {
+miotyAtClient_returnCode miotyAtClient_getAttachment_ex(miotyAtClient_ctx *ctx, bool *attached) {
+    if (ctx->cache.valid & CACHE_ATTACHED) {
+        if (attached != NULL)
+            *attached = ctx->cache.attached;
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    }
     uint32_t result;
-    miotyAtClient_returnCode ret = get_info_int("AT-MAS", 6, &result);
+    miotyAtClient_returnCode ret = get_info_int(ctx, CMD_MAS, &result);
     if (ret == MIOTYATCLIENT_RETURN_CODE_OK && attached != NULL)
     {
         *attached = result;
     }
+    if (ret == MIOTYATCLIENT_RETURN_CODE_OK && ctx->cache.enabled) {
+        ctx->cache.attached = result;
+        ctx->cache.valid |= CACHE_ATTACHED;
+    }
     return ret;
 }
 
-miotyAtClient_returnCode miotyAtClient_downlinkRequestResponseFlag(bool *flag, bool set) {
+miotyAtClient_returnCode miotyAtClient_downlinkRequestResponseFlag_ex(miotyAtClient_ctx *ctx, bool *flag, bool set) {
     uint32_t val;
+    miotyAtClient_returnCode ret;
     if (set) {
         val = *flag;
-        return set_info_int("AT-MRDR", 7, &val);
+        ctx->cache.valid &= ~CACHE_DOWNLINK_REQUEST;
+        ret = set_info_int(ctx, CMD_MRDR, &val);
+    } else if (ctx->cache.valid & CACHE_DOWNLINK_REQUEST) {
+        *flag = ctx->cache.downlinkRequest;
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    } else {
+        ret = get_info_int(ctx, CMD_MRDR, &val);
+        if (ret == MIOTYATCLIENT_RETURN_CODE_OK)
+        {
+            *flag = val;
+        }
     }
-    miotyAtClient_returnCode ret = get_info_int("AT-MRDR", 7, &val);
-    if (ret == MIOTYATCLIENT_RETURN_CODE_OK)
-    {
-        *flag = val;
+    if (ret == MIOTYATCLIENT_RETURN_CODE_OK && ctx->cache.enabled) {
+        ctx->cache.downlinkRequest = val;
+        ctx->cache.valid |= CACHE_DOWNLINK_REQUEST;
     }
     return ret;
 }
 
-miotyAtClient_returnCode miotyAtClient_getEpInfo(uint8_t *buffer, size_t *sizeBuf) {
-    return get_info_string("ATI", 3, buffer, sizeBuf);
+miotyAtClient_returnCode miotyAtClient_getEpInfo_ex(miotyAtClient_ctx *ctx, uint8_t *buffer, size_t *sizeBuf) {
+    return get_info_bytes(ctx, CMD_I, buffer, sizeBuf);
 }
 
-miotyAtClient_returnCode miotyAtClient_getCoreLibInfo(uint8_t *buffer, size_t *sizeBuf) {
-    return get_info_string("AT-LIBV", 7, buffer, sizeBuf);
+miotyAtClient_returnCode miotyAtClient_getCoreLibInfo_ex(miotyAtClient_ctx *ctx, uint8_t *buffer, size_t *sizeBuf) {
+    return get_info_bytes(ctx, CMD_LIBV, buffer, sizeBuf);
 }
 
-miotyAtClient_returnCode miotyAtClient_txInhibit(bool *enable, bool set) {
+miotyAtClient_returnCode miotyAtClient_txInhibit_ex(miotyAtClient_ctx *ctx, bool *enable, bool set) {
     uint32_t val;
     if (set) {
         val = *enable;
-        return set_info_int("AT-TXINH", 8, &val);
+        return set_info_int(ctx, CMD_TXINH, &val);
     }
-    miotyAtClient_returnCode ret = get_info_int("AT-TXINH", 8, &val);
+    miotyAtClient_returnCode ret = get_info_int(ctx, CMD_TXINH, &val);
     if (ret == MIOTYATCLIENT_RETURN_CODE_OK)
     {
         *enable = val;
@@ -264,13 +709,13 @@ miotyAtClient_returnCode miotyAtClient_txInhibit(bool *enable, bool set) {
     return ret;
 }
 
-miotyAtClient_returnCode miotyAtClient_txActive(bool *enable, bool set) {
+miotyAtClient_returnCode miotyAtClient_txActive_ex(miotyAtClient_ctx *ctx, bool *enable, bool set) {
     uint32_t val;
     if (set) {
         val = *enable;
-        return set_info_int("AT-TXACT", 8, &val);
+        return set_info_int(ctx, CMD_TXACT, &val);
     }
-    miotyAtClient_returnCode ret = get_info_int("AT-TXACT", 8, &val);
+    miotyAtClient_returnCode ret = get_info_int(ctx, CMD_TXACT, &val);
     if (ret == MIOTYATCLIENT_RETURN_CODE_OK)
     {
         *enable = val;
@@ -278,13 +723,13 @@ miotyAtClient_returnCode miotyAtClient_txActive(bool *enable, bool set) {
     return ret;
 }
 
-miotyAtClient_returnCode miotyAtClient_rxActive(bool *enable, bool set) {
+miotyAtClient_returnCode miotyAtClient_rxActive_ex(miotyAtClient_ctx *ctx, bool *enable, bool set) {
     uint32_t val;
     if (set) {
         val = *enable;
-        return set_info_int("AT-RXACT", 8, &val);
+        return set_info_int(ctx, CMD_RXACT, &val);
     }
-    miotyAtClient_returnCode ret = get_info_int("AT-RXACT", 8, &val);
+    miotyAtClient_returnCode ret = get_info_int(ctx, CMD_RXACT, &val);
     if (ret == MIOTYATCLIENT_RETURN_CODE_OK)
     {
         *enable = val;
@@ -292,329 +737,899 @@ miotyAtClient_returnCode miotyAtClient_rxActive(bool *enable, bool set) {
     return ret;
 }
 
-miotyAtClient_returnCode miotyAtClient_startTxContUnmodulated(uint32_t frequency) {
-    return set_info_int("AT$TXCU", 7, &frequency);
+miotyAtClient_returnCode miotyAtClient_startTxContUnmodulated_ex(miotyAtClient_ctx *ctx, uint32_t frequency) {
+    return set_info_int(ctx, CMD_TXCU, &frequency);
 }
 
-miotyAtClient_returnCode miotyAtClient_startTxContModulated(uint32_t frequency) {
-    return set_info_int("AT$TXCMLP", 9, &frequency);
+miotyAtClient_returnCode miotyAtClient_startTxContModulated_ex(miotyAtClient_ctx *ctx, uint32_t frequency) {
+    return set_info_int(ctx, CMD_TXCMLP, &frequency);
 }
 
-miotyAtClient_returnCode miotyAtClient_stopTxCont(void) {
-    miotyAtClientWrite((uint8_t *)"AT$TXOFF\r", 9);
-    char response_buf[10];
-    return check_AtResponse( response_buf);
+miotyAtClient_returnCode miotyAtClient_stopTxCont_ex(miotyAtClient_ctx *ctx) {
+    return exec_cmd(ctx, CMD_TXOFF);
 }
 
-miotyAtClient_returnCode miotyAtClient_startRxCont(uint32_t frequency) {
-    return set_info_int("AT$RXCONT", 9, &frequency);
+miotyAtClient_returnCode miotyAtClient_startRxCont_ex(miotyAtClient_ctx *ctx, uint32_t frequency) {
+    return set_info_int(ctx, CMD_RXCONT, &frequency);
 }
 
-miotyAtClient_returnCode miotyAtClient_stopRxCont(void) {
-    miotyAtClientWrite((uint8_t *)"AT$RXOFF\r", 9);
-    char response_buf[10];
-    return check_AtResponse( response_buf);
+miotyAtClient_returnCode miotyAtClient_stopRxCont_ex(miotyAtClient_ctx *ctx) {
+    return exec_cmd(ctx, CMD_RXOFF);
+}
+
+
+// the command in the form without argument, or with argument if set or if it has no other form
+static void cmd_init(miotyAtClient_cmd *cmd, cmd_id id, bool set) {
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->atCmd = at_cmds[id].text;
+    cmd->sizeCmd = at_cmds[id].sizeCmd;
+    cmd->timeoutClass = at_cmds[id].timeoutClass;
+    cmd->flags = at_cmds[id].flags;
+    if (set && at_cmds[id].form != CMD_FORM_NONE) {
+        cmd->form = at_cmds[id].setForm;
+        return;
+    }
+    cmd->respType = at_cmds[id].respType;
+    cmd->respKey = at_cmds[id].respKey;
+    cmd->sizeRespKey = at_cmds[id].sizeRespKey;
+    if (at_cmds[id].form == CMD_FORM_NONE) {
+        cmd->form = at_cmds[id].setForm;
+    } else {
+        cmd->form = at_cmds[id].form;
+        cmd->flags |= CMD_FLAG_TERMINATED;
+    }
 }
 
+// data and string answers
+static miotyAtClient_returnCode get_info_bytes(miotyAtClient_ctx *ctx, cmd_id id, uint8_t *buffer, size_t *sizeBuf) {
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, id, false);
+    cmd.rxData = buffer;
+    cmd.sizeRxData = *sizeBuf;
+    miotyAtClient_result result;
+    miotyAtClient_returnCode ret = run_cmd(ctx, &cmd, &result);
+    if (ret == MIOTYATCLIENT_RETURN_CODE_OK || ret == MIOTYATCLIENT_RETURN_CODE_BufferSizeInsufficient)
+        *sizeBuf = result.sizeData;
+    return ret;
+}
 
-static miotyAtClient_returnCode get_info_bytes(const char *atCmd, size_t sizeCmd, uint8_t *buffer, size_t *sizeBuf) {
-    char cmd[sizeCmd+2];
-    strcpy(cmd, atCmd);
-    cmd[sizeCmd] = '?';
-    cmd[sizeCmd+1] = '\r';
-    miotyAtClientWrite((uint8_t *)cmd, sizeof(cmd));
-    char response_buf[200];
-    return get_data_AtResponse( atCmd, sizeCmd, buffer, sizeBuf, response_buf);
+static miotyAtClient_returnCode set_info_bytes(miotyAtClient_ctx *ctx, cmd_id id, const uint8_t *data, size_t sizeData) {
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, id, true);
+    cmd.data = data;
+    cmd.sizeData = sizeData;
+    miotyAtClient_result result;
+    return run_cmd(ctx, &cmd, &result);
 }
 
-static miotyAtClient_returnCode set_info_bytes(const char *atCmd, size_t sizeCmd, const uint8_t *data, size_t sizeData) {
-    write_cmd_bytes(atCmd, sizeCmd, data, sizeData);
-    char response_buf[200];
-    return check_AtResponse(response_buf);
+static miotyAtClient_returnCode get_info_int(miotyAtClient_ctx *ctx, cmd_id id, uint32_t *res) {
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, id, false);
+    miotyAtClient_result result;
+    miotyAtClient_returnCode ret = run_cmd(ctx, &cmd, &result);
+    if (ret == MIOTYATCLIENT_RETURN_CODE_OK)
+        *res = result.value;
+    return ret;
 }
 
-static miotyAtClient_returnCode get_info_int(const char *atCmd, size_t sizeCmd, uint32_t *res) {
-    char cmd[sizeCmd+2];
-    strcpy(cmd, atCmd);
-    cmd[sizeCmd] = '?';
-    cmd[sizeCmd+1] = '\r';
-    miotyAtClientWrite((uint8_t *)cmd, sizeof(cmd));
-    char response_buf[200];
-    return get_int_data_AtResponse( atCmd, sizeCmd, res, response_buf);
+static miotyAtClient_returnCode set_info_int(miotyAtClient_ctx *ctx, cmd_id id, uint32_t *info) {
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, id, true);
+    cmd.value = *info;
+    miotyAtClient_result result;
+    return run_cmd(ctx, &cmd, &result);
 }
 
-static miotyAtClient_returnCode set_info_int(const char *atCmd, size_t sizeCmd, uint32_t *info) {
-    char buf[12] = {0};
-    uint8_t len_info =  string_uint2str_la_zt(*info, buf) - buf;
-    char cmd[sizeCmd+2+len_info];
-    strcpy(cmd, atCmd);
-    cmd[sizeCmd] = '=';
-    strcpy(cmd+sizeCmd+1, buf);
-    cmd[sizeCmd+1+len_info] = '\r';
-    miotyAtClientWrite((uint8_t *)cmd, sizeof(cmd));
-    char response_buf[200];
-    return check_AtResponse( response_buf);
+static miotyAtClient_returnCode exec_cmd(miotyAtClient_ctx *ctx, cmd_id id) {
+    miotyAtClient_cmd cmd;
+    cmd_init(&cmd, id, false);
+    miotyAtClient_result result;
+    return run_cmd(ctx, &cmd, &result);
 }
 
-static miotyAtClient_returnCode get_info_string(const char *atCmd, size_t sizeCmd, uint8_t *buffer, size_t *sizeBuf) {
-    char cmd[sizeCmd+1];
-    strcpy(cmd, atCmd);
-    cmd[sizeCmd] = '\r';
-    miotyAtClientWrite((uint8_t *)cmd, sizeof(cmd));
-    char response_buf[200];
-    return get_string_AtResponse( atCmd, sizeCmd, buffer, sizeBuf, response_buf);
+static miotyAtClient_returnCode send_message(miotyAtClient_ctx *ctx, miotyAtClient_uplinkType type, const uint8_t *msg, size_t sizeMsg,
+                                             uint8_t *data, size_t *size_data, uint8_t *dl_mpf, uint32_t *packetCounter) {
+    miotyAtClient_cmd cmd;
+    miotyAtClient_prepareUplink(&cmd, type, msg, sizeMsg, data, size_data ? *size_data : 0);
+    miotyAtClient_result result;
+    miotyAtClient_returnCode ret = run_cmd(ctx, &cmd, &result);
+    get_packet_counter(&result, packetCounter);
+    if ((ret != MIOTYATCLIENT_RETURN_CODE_OK && ret != MIOTYATCLIENT_RETURN_CODE_BufferSizeInsufficient) || size_data == NULL)
+        return ret;
+    *size_data = result.sizeData;
+    get_DLMPF(&result, dl_mpf);
+
+    return ret;
 }
 
-static miotyAtClient_returnCode checkATresponseMsg(uint32_t *packetCounter) {
-    char response_buf[200];
-    miotyAtClient_returnCode ret = check_AtResponse( response_buf);
-    get_packet_counter(response_buf, packetCounter);
+static miotyAtClient_returnCode msta_cmd(miotyAtClient_ctx *ctx, miotyAtClient_cmd *cmd, uint8_t *msta) {
+    miotyAtClient_result result;
+    miotyAtClient_returnCode ret = run_cmd(ctx, cmd, &result);
+    if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
+        return ret;
+    get_MSTA(&result, msta);
+
     return ret;
 }
 
-static void get_packet_counter(char *response_buf, uint32_t *packetCounter) {
-    char *pos = strstr(response_buf, "-MPCT:");
-    if( (pos != NULL) && (packetCounter != NULL) ) {
-        *packetCounter = atoi((pos+6));
+// queues the command and drives the client until it is completed
+static miotyAtClient_returnCode run_cmd(miotyAtClient_ctx *ctx, miotyAtClient_cmd *cmd, miotyAtClient_result *result) {
+    run_state state = { .result = result, .done = false };
+    cmd->done = run_cmd_done;
+    cmd->user = &state;
+    result->seen = 0;
+    result->sizeData = 0;
+
+    miotyAtClient_returnCode ret = miotyAtClient_submit(ctx, cmd);
+    if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
+        return ret;
+    while (!state.done) {
+        if (poll_once(ctx) == 0 && !state.done && ctx->idle)
+            ctx->idle(ctx->user);
+    }
+    return result->returnCode;
+}
+
+static void run_cmd_done(miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user) {
+    (void)ctx;
+    run_state *state = user;
+    *state->result = *result;
+    state->done = true;
+}
+
+static void get_packet_counter(const miotyAtClient_result *result, uint32_t *packetCounter) {
+    if( (result->seen & MIOTYATPARSER_SEEN_MPCT) && (packetCounter != NULL) ) {
+        *packetCounter = result->packetCounter;
     }
 }
 
-static void get_DLMPF(char *response_buf, uint8_t *dlmpf) {
+static void get_DLMPF(const miotyAtClient_result *result, uint8_t *dlmpf) {
     if (!dlmpf) {
         return;
     }
-    char *pos = strstr(response_buf, "-DLMPF:1\t");
-    if(pos != NULL) {
-        string_hex2byteArray((uint8_t *)pos + 9, 2, dlmpf, 1);
-    }
-    else {
-        *dlmpf = 0;
-    }
-}
-
-static void get_MSTA(char *response_buf, uint8_t *msta) {
-    char *pos = strstr(response_buf, "-MSTA:");
-    if( (pos != NULL) && (msta != NULL) )
-        *msta = atoi(pos+6);
-}
-
-// converts uint8_t data to hexadecimal string representation
-static void write_cmd_bytes(const char *atCmd, size_t sizeCmd, const uint8_t *data, size_t sizeData) {
-    uint8_t const dataStringSize = 2*sizeData;
-    char lenString[4];
-    uint8_t digits = string_uint2str_la_zt(sizeData, lenString) - lenString;
-    char dataString[dataStringSize];
-    string_byteArray2hex(data, sizeData, dataString, dataStringSize);
-    char cmd[sizeCmd+sizeof(dataString)+5+digits];
-    strcpy(cmd, atCmd);
-    cmd[sizeCmd] = '=';
-    strcpy(cmd+sizeCmd+1, lenString);
-    cmd[sizeCmd+1+digits] = '\t';
-    strcpy(cmd+sizeCmd+digits+2, dataString);
-    cmd[sizeCmd+dataStringSize+digits+2] = '\x1A';
-    cmd[sizeCmd+dataStringSize+digits+3] = '\r';
-    
-    miotyAtClientWrite((uint8_t *) cmd, sizeof(cmd));
-}
-
-static miotyAtClient_returnCode get_int_data_AtResponse(const char *atCmd, size_t sizeCmd, uint32_t *res, char *response_buf) {
-    uint8_t pos=0;
-    miotyAtClient_returnCode return_code = MIOTYATCLIENT_RETURN_CODE_ERR;
-    while(1) {
-        uint8_t buf[30];
-        size_t len = 30;
-        if(miotyAtClientRead(buf, &len) == true) {
-        
-            for (uint8_t i=0; i<len; i++) {
-                if(isalpha(buf[i]))
-                    buf[i] = toupper(buf[i]);
-                response_buf[i+pos] = buf[i];
-            }
-            pos += len;
-            response_buf[pos] = '\0';
-            if (strstr(response_buf, "\r\n0\r\n") || strstr(response_buf, "0\r\n")==response_buf) {
-                return_code = MIOTYATCLIENT_RETURN_CODE_OK;
-                char *pos = strstr(response_buf, atCmd+2);
-                pos += sizeCmd-1;
-                *res = atoi(pos);
+    *dlmpf = result->dlMpf;
+}
+
+static void get_MSTA(const miotyAtClient_result *result, uint8_t *msta) {
+    if( (result->seen & MIOTYATPARSER_SEEN_MSTA) && (msta != NULL) )
+        *msta = result->msta;
+}
+
+// get or set of a byte array setting through the cache, the cache is only filled if enabled
+static miotyAtClient_returnCode cached_bytes(miotyAtClient_ctx *ctx, uint8_t bit, uint8_t *cached, cmd_id id,
+                                             uint8_t *bytes, size_t size, bool set) {
+    miotyAtClient_returnCode ret;
+    if (set) {
+        /* the modem may have taken the value even if the command failed */
+        ctx->cache.valid &= ~bit;
+        ret = set_info_bytes(ctx, id, bytes, size);
+    } else if (ctx->cache.valid & bit) {
+        memcpy(bytes, cached, size);
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    } else {
+        size_t sizeBytes = size;
+        ret = get_info_bytes(ctx, id, bytes, &sizeBytes);
+        if (ret == MIOTYATCLIENT_RETURN_CODE_OK && sizeBytes != size)
+            return ret;     // a short answer is passed on, but not cached
+    }
+    if (ret == MIOTYATCLIENT_RETURN_CODE_OK && ctx->cache.enabled) {
+        memcpy(cached, bytes, size);
+        ctx->cache.valid |= bit;
+    }
+    return ret;
+}
+
+// get or set of an integer setting through the cache, the cache is only filled if enabled
+static miotyAtClient_returnCode cached_int(miotyAtClient_ctx *ctx, uint8_t bit, uint32_t *cached, cmd_id id,
+                                           uint32_t *value, bool set) {
+    miotyAtClient_returnCode ret;
+    if (set) {
+        ctx->cache.valid &= ~bit;
+        ret = set_info_int(ctx, id, value);
+    } else if (ctx->cache.valid & bit) {
+        *value = *cached;
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    } else {
+        ret = get_info_int(ctx, id, value);
+    }
+    if (ret == MIOTYATCLIENT_RETURN_CODE_OK && ctx->cache.enabled) {
+        *cached = *value;
+        ctx->cache.valid |= bit;
+    }
+    return ret;
+}
+
+// submits the queries of items as fast as the queue takes them and waits for their answers
+static void snapshot_run(miotyAtClient_ctx *ctx, snapshot_state *state, uint16_t items) {
+    miotyAtClient_snapshot *snapshot = state->snapshot;
+    uint8_t next = 0;
+    state->refused = 0;
+    /* the queue may be full of other commands before the first query is taken */
+    while (next < SNAPSHOT_ITEMS || state->pending != 0) {
+        for (; next < SNAPSHOT_ITEMS; next++) {
+            if (!(items & (1u << next)))
+                continue;
+            miotyAtClient_cmd cmd;
+            cmd_init(&cmd, snapshot_cmds[next], false);
+            cmd.done = snapshot_done;
+            cmd.user = &state->queries[next];
+            switch (1u << next) {
+            case MIOTYATCLIENT_SNAPSHOT_EP_INFO:
+                cmd.rxData = (uint8_t *)snapshot->epInfo;
+                cmd.sizeRxData = sizeof(snapshot->epInfo) - 1;
+                break;
+            case MIOTYATCLIENT_SNAPSHOT_CORE_LIB_INFO:
+                cmd.rxData = (uint8_t *)snapshot->coreLibInfo;
+                cmd.sizeRxData = sizeof(snapshot->coreLibInfo) - 1;
+                break;
+            case MIOTYATCLIENT_SNAPSHOT_EUI:
+                cmd.rxData = snapshot->eui;
+                cmd.sizeRxData = sizeof(snapshot->eui);
                 break;
-            } else if (strstr(response_buf, "\r\n1\r\n")) {
-                char *err_pos = strstr(response_buf, "-MNFO:");
-                if (err_pos == NULL)
-                    err_pos = strstr(response_buf, "-MERR:");
-                if (err_pos == NULL) {
-                    return_code = MIOTYATCLIENT_RETURN_CODE_ERR;
-                    break;
-                }
-                err_pos += 6;
-                return_code = atoi(err_pos);
+            case MIOTYATCLIENT_SNAPSHOT_SHORT_ADDRESS:
+                cmd.rxData = snapshot->shortAddress;
+                cmd.sizeRxData = sizeof(snapshot->shortAddress);
                 break;
-            } else if (strstr(response_buf, "\r\n2\r\n")) {
-                char *err_pos = strstr(response_buf, "AT!ERR:");
-                if (err_pos == NULL) {
-                    return_code = MIOTYATCLIENT_RETURN_CODE_ATErr;
-                    break;
-                }
-                err_pos += 7;
-                return_code = atoi(err_pos) + MIOTYATCLIENT_RETURN_CODE_ATErr;
+            default:
                 break;
             }
-        } else {
-            return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+            state->queries[next].state = state;
+            state->queries[next].item = next;
+            if (miotyAtClient_submit(ctx, &cmd) != MIOTYATCLIENT_RETURN_CODE_OK)
+                break;
+            state->pending |= 1u << next;
+            if (ctx->written > snapshot->pipelineDepth)
+                snapshot->pipelineDepth = ctx->written;
         }
+        if (next == SNAPSHOT_ITEMS && state->pending == 0)
+            break;
+        if (poll_once(ctx) == 0 && ctx->idle)
+            ctx->idle(ctx->user);
     }
-    return return_code;
 }
 
-static miotyAtClient_returnCode get_data_AtResponse(const char *atCmd, size_t sizeCmd, uint8_t *buffer, size_t *sizeBuf, char *response_buf) {
-    uint8_t pos=0;
-    miotyAtClient_returnCode return_code = MIOTYATCLIENT_RETURN_CODE_ERR;
-    while(1) {
-        uint8_t buf[30];
-        size_t len = 30;
-        if(miotyAtClientRead(buf, &len)) {
-            for (uint8_t i=0; i<len; i++) {
-                if(isalpha(buf[i]))
-                    buf[i] = toupper(buf[i]);
-                response_buf[i+pos] = buf[i];
-            }
-            pos += len;
-            response_buf[pos+1] = '\0';
-            if (strstr(response_buf, "\r\n0\r\n") || strstr(response_buf, "0\r\n")==response_buf) {
-                return_code = MIOTYATCLIENT_RETURN_CODE_OK;
-                char *data_pos = strstr(response_buf, atCmd+2);
-                data_pos += (sizeCmd-2);
-                data_pos = strstr(data_pos, "\t");
-                data_pos++;
-                char *end_pos = strstr(data_pos, "\x1a\r");
-                size_t len_data = (*sizeBuf)*2;
-                if (end_pos != 0){
-                    len_data = end_pos - data_pos;
-                    *sizeBuf = len_data/2;
-                }
-                string_hex2byteArray((uint8_t *)data_pos, len_data, buffer, *sizeBuf);
-                break;
-            } else if (strstr(response_buf, "\r\n1\r\n")) {
-                char *err_pos = strstr(response_buf, "-MNFO:");
-                if (err_pos == NULL)
-                    err_pos = strstr(response_buf, "-MERR:");
-                if (err_pos == NULL) {
-                    return_code = MIOTYATCLIENT_RETURN_CODE_ERR;
-                    break;
-                }
-                err_pos += 6;
-                return_code = atoi(err_pos);
-                break;
-            } else if (strstr(response_buf, "\r\n2\r\n")) {
-                char *err_pos = strstr(response_buf, "AT!ERR:");
-                if (err_pos == NULL) {
-                    return_code = MIOTYATCLIENT_RETURN_CODE_ATErr;
-                    break;
-                }
-                err_pos += 7;
-                return_code = atoi(err_pos) + MIOTYATCLIENT_RETURN_CODE_ATErr;
-                break;
-            }
-        } else {
-            return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+static void snapshot_done(miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user) {
+    const snapshot_query *query = user;
+    snapshot_state *state = query->state;
+    const uint16_t bit = 1u << query->item;
+
+    state->pending &= ~bit;
+    if (result->returnCode == MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished && ctx->pipelineRejected && !state->sequential) {
+        state->refused |= bit;
+        return;
+    }
+    if (result->returnCode != MIOTYATCLIENT_RETURN_CODE_OK) {
+        if (state->snapshot->returnCode == MIOTYATCLIENT_RETURN_CODE_OK)
+            state->snapshot->returnCode = result->returnCode;
+        return;
+    }
+    snapshot_store(ctx, state->snapshot, query->item, result);
+}
+
+// takes over the answer of one query into the snapshot, the packet counter mirror and the cache
+static void snapshot_store(miotyAtClient_ctx *ctx, miotyAtClient_snapshot *snapshot, uint8_t item, const miotyAtClient_result *result) {
+    miotyAtClient_cache *cache = &ctx->cache;
+    const uint16_t bit = 1u << item;
+    uint8_t cacheBit = 0;
+
+    switch (bit) {
+    case MIOTYATCLIENT_SNAPSHOT_EP_INFO:
+        snapshot->epInfo[result->sizeData] = '\0';
+        break;
+    case MIOTYATCLIENT_SNAPSHOT_CORE_LIB_INFO:
+        snapshot->coreLibInfo[result->sizeData] = '\0';
+        break;
+    case MIOTYATCLIENT_SNAPSHOT_EUI:
+        if (result->sizeData != sizeof(snapshot->eui))
+            return;
+        memcpy(cache->eui, snapshot->eui, sizeof(cache->eui));
+        cacheBit = CACHE_EUI;
+        break;
+    case MIOTYATCLIENT_SNAPSHOT_SHORT_ADDRESS:
+        if (result->sizeData != sizeof(snapshot->shortAddress))
+            return;
+        memcpy(cache->shortAddress, snapshot->shortAddress, sizeof(cache->shortAddress));
+        cacheBit = CACHE_SHORT_ADDRESS;
+        break;
+    case MIOTYATCLIENT_SNAPSHOT_PACKET_COUNTER:
+        snapshot->packetCounter = result->value;
+        observe_packet_counter(ctx, result->value, false);
+        break;
+    case MIOTYATCLIENT_SNAPSHOT_ATTACHED:
+        snapshot->attached = cache->attached = result->value;
+        cacheBit = CACHE_ATTACHED;
+        break;
+    case MIOTYATCLIENT_SNAPSHOT_TX_POWER:
+        snapshot->txPower = cache->txPower = result->value;
+        cacheBit = CACHE_TX_POWER;
+        break;
+    case MIOTYATCLIENT_SNAPSHOT_UPLINK_MODE:
+        snapshot->uplinkMode = cache->uplinkMode = result->value;
+        cacheBit = CACHE_UPLINK_MODE;
+        break;
+    case MIOTYATCLIENT_SNAPSHOT_UPLINK_PROFILE:
+        snapshot->uplinkProfile = cache->uplinkProfile = result->value;
+        cacheBit = CACHE_UPLINK_PROFILE;
+        break;
+    default: // MIOTYATCLIENT_SNAPSHOT_DOWNLINK_REQUEST
+        snapshot->downlinkRequest = cache->downlinkRequest = result->value;
+        cacheBit = CACHE_DOWNLINK_REQUEST;
+        break;
+    }
+    snapshot->valid |= bit;
+    if (cache->enabled)
+        cache->valid |= cacheBit;
+}
+
+// the command resets the packet counter of the modem, the next value seen is reported as reset
+static void counter_reset(miotyAtClient_ctx *ctx) {
+    if (ctx->packetCounterValid)
+        ctx->packetCounterReset = true;
+    ctx->packetCounterValid = false;
+}
+
+// continues the mirror with a counter reported by the modem, after an uplink it should have advanced by one
+static void observe_packet_counter(miotyAtClient_ctx *ctx, uint32_t counter, bool uplink) {
+    const uint32_t expected = ctx->packetCounter + (uplink ? 1 : 0);
+    /* after an attach, detach or factory reset the counter is compared with the last known one */
+    const bool report = (ctx->packetCounterValid || ctx->packetCounterReset) && counter != expected;
+    ctx->packetCounter = counter;
+    ctx->packetCounterValid = true;
+    ctx->packetCounterReset = false;
+    if (report && ctx->onPacketCounter) {
+        miotyAtClient_packetCounterEvent event = (counter > expected) ? MIOTYATCLIENT_PACKET_COUNTER_SKIP
+                                                                      : MIOTYATCLIENT_PACKET_COUNTER_RESET;
+        ctx->onPacketCounter(ctx, event, expected, counter);
+    }
+}
+
+// processes the received bytes and the deadline, returns the number of bytes processed
+static size_t poll_once(miotyAtClient_ctx *ctx) {
+    ctx->feeding = true;
+    size_t processed = feed_ring(ctx);
+    /* between commands only URCs can arrive, the read callback is only used for them if somebody listens,
+       stray output is drained before the next command is written */
+    if (ctx->read && (ctx->active || ctx->quieting || listening(ctx))) {
+        uint8_t buf[MIOTYATCLIENT_READ_CHUNK_SIZE];
+        size_t len = sizeof(buf);
+        if (!ctx->read(ctx->user, buf, &len)) {
+            complete_cmd(ctx, MIOTYATCLIENT_RETURN_CODE_ATReadFailed);
+        } else if (len > 0) {
+            parse(ctx, buf, len);
+            processed += len;
         }
     }
-    return return_code;
+    if (ctx->active && ctx->clock && (int32_t)(ctx->clock(ctx->user) - ctx->deadline) >= 0)
+        time_out(ctx);
+    ctx->feeding = false;
+    start_next(ctx);
+    return processed;
 }
 
-static miotyAtClient_returnCode get_string_AtResponse(const char *atCmd, size_t sizeCmd, uint8_t *buffer, size_t *sizeBuf, char *response_buf) {
-    uint8_t pos=0;
-    miotyAtClient_returnCode return_code = MIOTYATCLIENT_RETURN_CODE_ERR;
-    while(1) {
-        uint8_t buf[30];
-        size_t len = 30;
-        if(miotyAtClientRead(buf, &len)) {
-            for (uint8_t i=0; i<len; i++) {
-                response_buf[i+pos] = buf[i];
-            }
-            pos += len;
-            response_buf[pos+1] = '\0';
-            if (strstr(response_buf, "\r\n0\r\n") || strstr(response_buf, "0\r\n")==response_buf) {
-                return_code = MIOTYATCLIENT_RETURN_CODE_OK;
-                char *string_pos = strstr(response_buf, atCmd+2);
-                string_pos += (sizeCmd - 2);
-                string_pos++;  // ':' 
-                char *end_pos = strstr(string_pos, "\r");
-                if (end_pos != 0){
-                    size_t len_data = end_pos - string_pos;
-                    *sizeBuf = len_data;
-                    memcpy(buffer, string_pos, len_data);
-                }
-                break;
-            } else if (strstr(response_buf, "\r\n1\r\n")) {
-                char *err_pos = strstr(response_buf, "-MNFO:");
-                if (err_pos == NULL)
-                    err_pos = strstr(response_buf, "-MERR:");
-                if (err_pos == NULL) {
-                    return_code = MIOTYATCLIENT_RETURN_CODE_ERR;
-                    break;
-                }
-                err_pos += 6;
-                return_code = atoi(err_pos);
-                break;
-            } else if (strstr(response_buf, "\r\n2\r\n")) {
-                char *err_pos = strstr(response_buf, "AT!ERR:");
-                if (err_pos == NULL) {
-                    return_code = MIOTYATCLIENT_RETURN_CODE_ATErr;
-                    break;
-                }
-                err_pos += 7;
-                return_code = atoi(err_pos) + MIOTYATCLIENT_RETURN_CODE_ATErr;
-                break;
-            }
+// parses the bytes waiting in the receive ring, returns their number
+static size_t feed_ring(miotyAtClient_ctx *ctx) {
+    size_t processed = 0;
+#if MIOTYATCLIENT_RX_RING_SIZE > 0
+    /* the tokenizer works directly on the ring, in at most two contiguous pieces */
+    miotyAtClient_rxIndex tail = ctx->rxTail;
+    miotyAtClient_rxIndex head = RX_LOAD_ACQUIRE(&ctx->rxHead);
+    while (tail != head) {
+        size_t offset = tail & (MIOTYATCLIENT_RX_RING_SIZE - 1);
+        size_t len = (miotyAtClient_rxIndex)(head - tail);
+        if (len > MIOTYATCLIENT_RX_RING_SIZE - offset)
+            len = MIOTYATCLIENT_RX_RING_SIZE - offset;
+        parse(ctx, &ctx->rxRing[offset], len);
+        tail += len;
+        processed += len;
+        RX_STORE_RELEASE(&ctx->rxTail, tail);
+    }
+#else
+    (void)ctx;
+#endif
+    return processed;
+}
+
+// hands received bytes to the running command and the URC handlers, commands are not written meanwhile
+static void parse(miotyAtClient_ctx *ctx, const uint8_t *data, size_t len) {
+    TRACE_RX(ctx, data, len);
+    if (ctx->quieting) {
+        /* late answers of timed out commands, dropped until the modem is silent */
+        METRICS_RECEIVED(ctx, len);
+        if (ctx->clock)
+            ctx->quietUntil = ctx->clock(ctx->user) + MIOTYATCLIENT_QUIET_MS;
+        return;
+    }
+    if (!ctx->active && !ctx->parser.idle)
+        start_idle(ctx);
+    /* without command written ahead the rest was received before the next command, so it is parsed idle */
+    while (len > 0) {
+        size_t used = miotyAtParser_feed(&ctx->parser, data, len);
+        METRICS_RECEIVED(ctx, used);
+        data += used;
+        len -= used;
+        if (miotyAtParser_urc(&ctx->parser) != MIOTYATPARSER_URC_NONE)
+            dispatch_urc(ctx);
+        if (ctx->active && miotyAtParser_done(&ctx->parser))
+            complete_cmd(ctx, parser_return_code(&ctx->parser));
+    }
+}
+
+// takes in what the modem sent while no command was running, so it can not be taken for the answer of the next one;
+// the read callback is only used if URC handlers make it non-blocking, and a modem that keeps talking is read
+// for MIOTYATCLIENT_QUIET_MS at most, or DRAIN_READS times without clock, so it can not hold the command back
+static void drain_idle(miotyAtClient_ctx *ctx) {
+    ctx->feeding = true;
+    feed_ring(ctx);
+    const uint32_t start = ctx->clock ? ctx->clock(ctx->user) : 0;
+    for (uint32_t reads = 0; ctx->read && listening(ctx); reads++) {
+        if (ctx->clock ? (ctx->clock(ctx->user) - start >= MIOTYATCLIENT_QUIET_MS) : (reads >= DRAIN_READS))
+            break;
+        uint8_t buf[MIOTYATCLIENT_READ_CHUNK_SIZE];
+        size_t len = sizeof(buf);
+        if (!ctx->read(ctx->user, buf, &len) || len == 0)
+            break;
+        parse(ctx, buf, len);
+    }
+    ctx->feeding = false;
+}
+
+static bool listening(const miotyAtClient_ctx *ctx) {
+    return ctx->urcCount > 0 || ctx->urcLineHandler != NULL;
+}
+
+// the answer of the command at the head may still arrive, and would be taken for the one of the command
+// written ahead of it or of the next one, so all written commands time out and the line has to calm down
+static void time_out(miotyAtClient_ctx *ctx) {
+    ctx->quieting = true;
+    ctx->quietUntil = ctx->clock(ctx->user) + MIOTYATCLIENT_QUIET_MS;
+    while (ctx->active)
+        complete_cmd(ctx, MIOTYATCLIENT_RETURN_CODE_Timeout);
+}
+
+static bool quieting(miotyAtClient_ctx *ctx) {
+    if (ctx->quieting && (!ctx->clock || (int32_t)(ctx->clock(ctx->user) - ctx->quietUntil) >= 0))
+        ctx->quieting = false;
+    return ctx->quieting;
+}
+
+// writes the command at the head of the queue, as long as the modem is not busy with another one,
+// or the next queries while it is busy with queries, up to the pipeline depth
+static void start_next(miotyAtClient_ctx *ctx) {
+    while (!ctx->feeding && ctx->queueCount > ctx->written && !quieting(ctx)) {
+        miotyAtClient_cmd *cmd = &ctx->queue[(ctx->queueHead + ctx->written) % MIOTYATCLIENT_CMD_QUEUE_SIZE];
+        if (ctx->written > 0) {
+            if (ctx->written >= ctx->pipelineDepth || !pipelinable(&ctx->queue[ctx->queueHead]) || !pipelinable(cmd))
+                return;
+            cmd->flags |= CMD_FLAG_AHEAD;
         } else {
-            return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+            drain_idle(ctx);
+            start_parser(ctx, cmd);
         }
+        ctx->written++;
+        write_cmd(ctx, cmd);
+        if (ctx->written == 1 && ctx->clock)
+            ctx->deadline = ctx->clock(ctx->user) + cmd_timeout(ctx, cmd);
+        if (cmd->flags & MIOTYATCLIENT_CMD_FLAG_NO_RESPONSE)
+            complete_cmd(ctx, MIOTYATCLIENT_RETURN_CODE_OK);
     }
-    return return_code;
 }
 
-static miotyAtClient_returnCode check_AtResponse(char *response_buf) {
-    uint8_t pos=0;
-    miotyAtClient_returnCode return_code = MIOTYATCLIENT_RETURN_CODE_ERR;
-    while(1) {
-        uint8_t buf[30];
-        size_t len = 30;
-        if(miotyAtClientRead(buf, &len)) {
-            for (uint8_t i=0; i<len; i++) {
-                if(isalpha(buf[i]))
-                    buf[i] = toupper(buf[i]);
-                response_buf[i+pos] = buf[i];
-            }
-            pos += len;
-            response_buf[pos+1] = '\0';
-            if (strstr(response_buf, "\r\n0\r\n") || strstr(response_buf, "0\r\n")==response_buf) {
-                return_code = MIOTYATCLIENT_RETURN_CODE_OK;
-                break;
-            } else if (strstr(response_buf, "\r\n1\r\n")) {
-                char *err_pos = strstr(response_buf, "-MNFO:");
-                if (err_pos == NULL)
-                    err_pos = strstr(response_buf, "-MERR:");
-                if (err_pos == NULL) {
-                    return_code = MIOTYATCLIENT_RETURN_CODE_ERR;
-                    break;
-                }
-                err_pos += 6;
-                return_code = atoi(err_pos);
-                break;
-            } else if (strstr(response_buf, "\r\n2\r\n")) {
-                char *err_pos = strstr(response_buf, "AT!ERR:");
-                if (err_pos == NULL) {
-                    return_code = MIOTYATCLIENT_RETURN_CODE_ATErr;
-                    break;
-                }
-                err_pos += 7;
-                return_code = atoi(err_pos) + MIOTYATCLIENT_RETURN_CODE_ATErr;
-                break;
-            }
+// queries only read the modem, so they may be written before the previous one is answered
+static bool pipelinable(const miotyAtClient_cmd *cmd) {
+    return cmd->timeoutClass == MIOTYATCLIENT_TIMEOUT_DEFAULT && !(cmd->flags & MIOTYATCLIENT_CMD_FLAG_NO_RESPONSE) &&
+           (cmd->form == MIOTYATCLIENT_CMD_FORM_QUERY ||
+            (cmd->form == MIOTYATCLIENT_CMD_FORM_EXEC && cmd->respType == MIOTYATPARSER_VALUE_STRING));
+}
+
+// prepares the tokenizer for the answer of the command at the head of the queue
+static void start_parser(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd) {
+    const char *respKey = cmd->respKey ? cmd->respKey : cmd->atCmd + 2;
+    size_t sizeRespKey = cmd->respKey ? cmd->sizeRespKey : cmd->sizeCmd - 2;
+    miotyAtParser_init(&ctx->parser, respKey, sizeRespKey, cmd->respType, cmd->rxData, cmd->sizeRxData);
+    set_urc_keys(ctx);
+    ctx->active = true;
+}
+
+// prepares the tokenizer for output of the modem while no command is running
+static void start_idle(miotyAtClient_ctx *ctx) {
+    miotyAtParser_initIdle(&ctx->parser);
+    set_urc_keys(ctx);
+}
+
+static void set_urc_keys(miotyAtClient_ctx *ctx) {
+    miotyAtParser_setUrc(&ctx->parser, ctx->urcKeys, ctx->urcCount, ctx->urcLineHandler != NULL,
+                         ctx->urcBuf, sizeof(ctx->urcBuf));
+}
+
+// hands the URC completed by the tokenizer to its handler
+static void dispatch_urc(miotyAtClient_ctx *ctx) {
+    miotyAtParser *parser = &ctx->parser;
+    const uint8_t index = miotyAtParser_urc(parser);
+    miotyAtClient_urc urc = { .value = parser->urcValue, .data = ctx->urcBuf, .sizeData = parser->urcLen };
+    miotyAtClient_urcFn handler = NULL;
+    void *user = NULL;
+
+    if (index == MIOTYATPARSER_URC_LINE) {
+        urc.type = MIOTYATPARSER_VALUE_STRING;
+        handler = ctx->urcLineHandler;
+        user = ctx->urcLineUser;
+    } else if (index < ctx->urcCount) {
+        urc.key = ctx->urcKeys[index].key;
+        urc.type = ctx->urcKeys[index].type;
+        handler = ctx->urcHandlers[index];
+        user = ctx->urcUsers[index];
+    }
+    /* the payload stays in urcBuf until the tokenizer is fed again */
+    miotyAtParser_urcTaken(parser);
+    if (handler) {
+        METRICS_URC(ctx);
+        handler(ctx, &urc, user);
+    }
+}
+
+static uint32_t cmd_timeout(const miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd) {
+    if (cmd->timeoutMs)
+        return cmd->timeoutMs;
+    if (cmd->timeoutClass < MIOTYATCLIENT_TIMEOUT_CLASS_COUNT)
+        return ctx->timeouts[cmd->timeoutClass];
+    return ctx->timeouts[MIOTYATCLIENT_TIMEOUT_DEFAULT];
+}
+
+// removes the running command from the queue and reports its result
+static void complete_cmd(miotyAtClient_ctx *ctx, miotyAtClient_returnCode returnCode) {
+    if (!ctx->active)
+        return;
+    const miotyAtParser *parser = &ctx->parser;
+    miotyAtClient_cmd cmd = ctx->queue[ctx->queueHead];
+    miotyAtClient_result result = {
+        .returnCode     = returnCode,
+        .seen           = parser->seen,
+        .msta           = parser->msta,
+        .dlMpf          = (parser->seen & MIOTYATPARSER_SEEN_DLMPF) ? parser->dlmpf : 0,
+        .packetCounter  = parser->packetCounter,
+        .value          = parser->value,
+        .modemError     = parser_modem_error(parser),
+        .data           = cmd.rxData,
+        .sizeData       = parser->outLen,
+    };
+    METRICS_COMPLETED(ctx, &cmd, returnCode);
+    TRACE_COMPLETED(ctx, returnCode);
+    ctx->queueHead = (ctx->queueHead + 1) % MIOTYATCLIENT_CMD_QUEUE_SIZE;
+    ctx->queueCount--;
+    ctx->written--;
+    ctx->active = false;
+    if (ctx->written > 0) {
+        /* the next command was written ahead, its answer follows this one */
+        start_parser(ctx, &ctx->queue[ctx->queueHead]);
+        if (ctx->clock)
+            ctx->deadline = ctx->clock(ctx->user) + cmd_timeout(ctx, &ctx->queue[ctx->queueHead]);
+    } else {
+        start_idle(ctx);
+    }
+    if ((cmd.flags & CMD_FLAG_AHEAD) && returnCode == MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished) {
+        ctx->pipelineDepth = 1;
+        ctx->pipelineRejected = true;
+    }
+
+    /* uplinks report the counter after their transmission, without answer it is unknown whether they were sent */
+    bool uplink = cmd.timeoutClass == MIOTYATCLIENT_TIMEOUT_UPLINK || cmd.timeoutClass == MIOTYATCLIENT_TIMEOUT_BIDI;
+    if (result.seen & MIOTYATPARSER_SEEN_MPCT)
+        observe_packet_counter(ctx, result.packetCounter, uplink);
+    else if (uplink && (returnCode == MIOTYATCLIENT_RETURN_CODE_Timeout || returnCode == MIOTYATCLIENT_RETURN_CODE_ATReadFailed))
+        ctx->packetCounterValid = false;
+    if (cmd.done)
+        cmd.done(ctx, &result, cmd.user);
+}
+
+static miotyAtClient_returnCode parser_return_code(const miotyAtParser *parser) {
+    switch (parser->result) {
+    case MIOTYATPARSER_RESULT_OK:
+        if (parser->respType != MIOTYATPARSER_VALUE_NONE && !(parser->seen & MIOTYATPARSER_SEEN_RESPONSE))
+            return MIOTYATCLIENT_RETURN_CODE_ERR;
+        if (parser->seen & MIOTYATPARSER_SEEN_OVERFLOW)
+            return MIOTYATCLIENT_RETURN_CODE_BufferSizeInsufficient;
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    /* errors outside their range would be taken for OK, for an error of the other kind or one of the library */
+    case MIOTYATPARSER_RESULT_MAC_ERR:
+        if (!(parser->seen & MIOTYATPARSER_SEEN_MAC_ERR))
+            return MIOTYATCLIENT_RETURN_CODE_ERR;
+        if (parser->macError == 0 || parser->macError >= MIOTYATCLIENT_RETURN_CODE_ATErr)
+            return MIOTYATCLIENT_RETURN_CODE_MacError;
+        return (miotyAtClient_returnCode)parser->macError;
+    default:
+        if (!(parser->seen & MIOTYATPARSER_SEEN_AT_ERR) ||
+            parser->atError >= MIOTYATCLIENT_RETURN_CODE_Timeout - MIOTYATCLIENT_RETURN_CODE_ATErr)
+            return MIOTYATCLIENT_RETURN_CODE_ATErr;
+        return (miotyAtClient_returnCode)(parser->atError + MIOTYATCLIENT_RETURN_CODE_ATErr);
+    }
+}
+
+static uint32_t parser_modem_error(const miotyAtParser *parser) {
+    if (parser->result == MIOTYATPARSER_RESULT_MAC_ERR && (parser->seen & MIOTYATPARSER_SEEN_MAC_ERR))
+        return parser->macError;
+    if (parser->result == MIOTYATPARSER_RESULT_AT_ERR && (parser->seen & MIOTYATPARSER_SEEN_AT_ERR))
+        return parser->atError;
+    return 0;
+}
+
+static void write_cmd(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd) {
+    tx_stream tx = { .ctx = ctx };
+    TRACE_WRITTEN(&tx, cmd);
+    if (cmd->flags & CMD_FLAG_TERMINATED) {
+        tx_ref(&tx, cmd->atCmd, cmd->sizeCmd + (cmd->form == MIOTYATCLIENT_CMD_FORM_QUERY ? 2 : 1));
+        tx_flush(&tx);
+        METRICS_WRITTEN(ctx, cmd, &tx);
+        return;
+    }
+    tx_ref(&tx, cmd->atCmd, cmd->sizeCmd);
+    switch (cmd->form) {
+    case MIOTYATCLIENT_CMD_FORM_QUERY:
+        tx_ref(&tx, "?\r", 2);
+        break;
+    case MIOTYATCLIENT_CMD_FORM_SET_INT: {
+        char info[12];
+        tx_copy(&tx, "=", 1);
+        tx_copy(&tx, info, string_uint2str_la_zt(cmd->value, info) - info);
+        tx_copy(&tx, "\r", 1);
+        break;
+    }
+    case MIOTYATCLIENT_CMD_FORM_SET_BYTES:
+        write_cmd_bytes(&tx, cmd->data, cmd->sizeData);
+        break;
+    default:
+        tx_ref(&tx, "\r", 1);
+        break;
+    }
+    tx_flush(&tx);
+    METRICS_WRITTEN(ctx, cmd, &tx);
+}
+
+// appends "=<len>\t<hex>\x1A\r", the hex string is encoded chunk by chunk
+static void write_cmd_bytes(tx_stream *tx, const uint8_t *data, size_t sizeData) {
+    char lenString[12];
+    tx_copy(tx, "=", 1);
+    tx_copy(tx, lenString, string_uint2str_la_zt(sizeData, lenString) - lenString);
+    tx_copy(tx, "\t", 1);
+    while (sizeData > 0) {
+        size_t room = (MIOTYATCLIENT_WRITE_CHUNK_SIZE - tx->fill) / 2;
+        if (room == 0) {
+            tx_flush(tx);
+            continue;
+        }
+        size_t n = sizeData < room ? sizeData : room;
+        tx->fill += string_byteArray2hex(data, n, (char *)&tx->buf[tx->fill], 2 * n);
+        data += n;
+        sizeData -= n;
+    }
+    tx_ref(tx, "\x1A\r", 2);
+}
+
+// queues the bytes of the chunk buffer not referenced yet
+static void tx_mark(tx_stream *tx) {
+    if (tx->fill > tx->mark) {
+        tx->iov[tx->count].data = &tx->buf[tx->mark];
+        tx->iov[tx->count].len = tx->fill - tx->mark;
+        tx->count++;
+        tx->mark = tx->fill;
+    }
+}
+
+// writes everything gathered so far, with one call of the transport
+static void tx_flush(tx_stream *tx) {
+    miotyAtClient_ctx *ctx = tx->ctx;
+    if (ctx->writev) {
+        tx_mark(tx);
+        for (size_t i = 0; i < tx->count; i++)
+            METRICS_SENT(tx, tx->iov[i].len);
+        if (tx->count > 0) {
+            TRACE_TX(tx, tx->iov, tx->count);
+            ctx->writev(ctx->user, tx->iov, tx->count);
+        }
+        tx->count = 0;
+    } else if (tx->fill > 0) {
+        METRICS_SENT(tx, tx->fill);
+        TRACE_TX_BYTES(tx, tx->buf, tx->fill);
+        ctx->write(ctx->user, tx->buf, tx->fill);
+    }
+    tx->fill = 0;
+    tx->mark = 0;
+}
+
+// appends bytes that are only valid during the call, by copying them to the chunk buffer
+static void tx_copy(tx_stream *tx, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len > 0) {
+        if (tx->fill == MIOTYATCLIENT_WRITE_CHUNK_SIZE)
+            tx_flush(tx);
+        size_t n = MIOTYATCLIENT_WRITE_CHUNK_SIZE - tx->fill;
+        if (n > len)
+            n = len;
+        memcpy(&tx->buf[tx->fill], p, n);
+        tx->fill += n;
+        p += n;
+        len -= n;
+    }
+}
+
+// appends bytes that stay valid until the command is written, e.g. the constant command strings
+static void tx_ref(tx_stream *tx, const void *data, size_t len) {
+    miotyAtClient_ctx *ctx = tx->ctx;
+    if (!ctx->writev) {
+        /* short pieces are cheaper to copy than to write separately */
+        if (len <= MIOTYATCLIENT_WRITE_CHUNK_SIZE - tx->fill) {
+            tx_copy(tx, data, len);
         } else {
-            return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+            tx_flush(tx);
+            METRICS_SENT(tx, len);
+            TRACE_TX_BYTES(tx, data, len);
+            ctx->write(ctx->user, data, len);
+        }
+        return;
+    }
+    /* room for the pending part of buf and the new piece, a full iov is written right away */
+    if (tx->count + (tx->fill > tx->mark) + 1 > MIOTYATCLIENT_WRITEV_MAX)
+        tx_flush(tx);
+    tx_mark(tx);
+    tx->iov[tx->count].data = data;
+    tx->iov[tx->count].len = len;
+    tx->count++;
+    if (tx->count == MIOTYATCLIENT_WRITEV_MAX)
+        tx_flush(tx);
+}
+
+#if MIOTYATCLIENT_METRICS
+static bool metrics_now(const miotyAtClient_ctx *ctx, uint32_t *now) {
+    miotyAtClient_clockFn clock = ctx->metricsClock ? ctx->metricsClock : ctx->clock;
+    if (!clock)
+        return false;
+    *now = clock(ctx->user);
+    return true;
+}
+
+// the counters are only changed between begin and end, miotyAtClient_getMetrics retries copies that overlap
+static void metrics_begin(miotyAtClient_ctx *ctx) {
+    ctx->metricsSeq++;
+    METRICS_FENCE();
+}
+
+static void metrics_end(miotyAtClient_ctx *ctx) {
+    METRICS_FENCE();
+    ctx->metricsSeq++;
+}
+
+// remembers when and with how many bytes a queued command was written
+static void metrics_written(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd, uint32_t sent) {
+    const size_t slot = (size_t)(cmd - ctx->queue);
+    if (slot >= MIOTYATCLIENT_CMD_QUEUE_SIZE)
+        return;
+    metrics_now(ctx, &ctx->metricsStart[slot]);
+    ctx->metricsTx[slot] = sent;
+    metrics_begin(ctx);
+    ctx->metrics.txBytes += sent;
+    metrics_end(ctx);
+}
+
+static void metrics_received(miotyAtClient_ctx *ctx, size_t len) {
+    if (ctx->active)
+        ctx->metricsRx += (uint32_t)len;
+    metrics_begin(ctx);
+    ctx->metrics.rxBytes += (uint32_t)len;
+    metrics_end(ctx);
+}
+
+// adds the command at the head of the queue to the statistics, before it is removed
+static void metrics_completed(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd, miotyAtClient_returnCode returnCode) {
+    const uint8_t slot = ctx->queueHead;
+    uint32_t now;
+    const bool timed = metrics_now(ctx, &now);
+    metrics_begin(ctx);
+    miotyAtClient_metrics *metrics = &ctx->metrics;
+    metrics->returnCodes[metrics_code_index(returnCode)]++;
+    miotyAtClient_cmdMetrics *m = metrics_slot(metrics, cmd);
+    if (m) {
+        m->count++;
+        if (returnCode != MIOTYATCLIENT_RETURN_CODE_OK)
+            m->errors++;
+        if (returnCode == MIOTYATCLIENT_RETURN_CODE_Timeout)
+            m->timeouts++;
+        m->txBytes += ctx->metricsTx[slot];
+        m->rxBytes += ctx->metricsRx;
+        if (timed) {
+            const uint32_t latency = now - ctx->metricsStart[slot];
+            /* bucket = number of significant bits of the latency */
+            uint8_t bucket = 0;
+            for (uint32_t v = latency; v && bucket < MIOTYATCLIENT_METRICS_BUCKETS - 1; v >>= 1)
+                bucket++;
+            m->latency[bucket]++;
+            if (m->timed == 0 || latency < m->latencyMin)
+                m->latencyMin = latency;
+            if (latency > m->latencyMax)
+                m->latencyMax = latency;
+            m->latencySum += latency;
+            m->timed++;
+        }
+    } else {
+        metrics->otherCommands++;
+    }
+    metrics_end(ctx);
+    ctx->metricsRx = 0;
+}
+
+static void metrics_urc(miotyAtClient_ctx *ctx) {
+    metrics_begin(ctx);
+    ctx->metrics.urcs++;
+    metrics_end(ctx);
+}
+
+// statistics of a command, taken from a free slot at its first completion, NULL if all are taken
+static miotyAtClient_cmdMetrics *metrics_slot(miotyAtClient_metrics *metrics, const miotyAtClient_cmd *cmd) {
+    size_t len = cmd->sizeCmd < MIOTYATCLIENT_METRICS_NAME_SIZE - 1 ? cmd->sizeCmd : MIOTYATCLIENT_METRICS_NAME_SIZE - 1;
+    for (uint8_t i = 0; i < MIOTYATCLIENT_METRICS_COMMANDS; i++) {
+        miotyAtClient_cmdMetrics *m = &metrics->commands[i];
+        if (m->atCmd[0] == '\0') {
+            memcpy(m->atCmd, cmd->atCmd, len);
+            m->atCmd[len] = '\0';
+            return m;
         }
+        if (memcmp(m->atCmd, cmd->atCmd, len) == 0 && m->atCmd[len] == '\0')
+            return m;
     }
-    return return_code;
+    return NULL;
+}
+
+// index of a return code in miotyAtClient_metrics.returnCodes, the enum is dense within its ranges
+static uint8_t metrics_code_index(miotyAtClient_returnCode code) {
+    const unsigned c = (unsigned)code;
+    if (c <= MIOTYATCLIENT_RETURN_CODE_DownlinkDataCorrupted)
+        return (uint8_t)c;
+    if (c == MIOTYATCLIENT_RETURN_CODE_FeatureNotSupported)
+        return 23;
+    if (c >= MIOTYATCLIENT_RETURN_CODE_ATErr && c <= MIOTYATCLIENT_RETURN_CODE_ATReadFailed)
+        return (uint8_t)(24 + c - MIOTYATCLIENT_RETURN_CODE_ATErr);
+    if (c >= MIOTYATCLIENT_RETURN_CODE_Timeout && c <= MIOTYATCLIENT_RETURN_CODE_Dropped)
+        return (uint8_t)(33 + c - MIOTYATCLIENT_RETURN_CODE_Timeout);
+    return MIOTYATCLIENT_METRICS_RETURN_CODES - 1;
+}
+#endif
+
+#if MIOTYATCLIENT_TRACE
+// numbers a command written to the modem, its records in the trace carry the number
+static void trace_written(tx_stream *tx, const miotyAtClient_cmd *cmd) {
+    miotyAtClient_ctx *ctx = tx->ctx;
+    const size_t slot = (size_t)(cmd - ctx->queue);
+    if (++ctx->traceCmd == 0)
+        ctx->traceCmd = 1;
+    tx->traceCmd = ctx->traceCmd;
+    if (slot < MIOTYATCLIENT_CMD_QUEUE_SIZE)
+        ctx->traceCmds[slot] = ctx->traceCmd;
+}
+
+static void trace_record(miotyAtClient_ctx *ctx, miotyAtTrace_type type, uint8_t cmd, const miotyAtClient_iovec *iov, size_t count) {
+    miotyAtTrace *trace = ctx->trace;
+    if (!trace)
+        return;
+    uint32_t time = 0;
+    if (trace->clock)
+        time = trace->clock(trace->clockUser);
+    else if (ctx->clock)
+        time = ctx->clock(ctx->user);
+    miotyAtTrace_record(trace, type, cmd, time, iov, count);
+}
+
+static void trace_sent(tx_stream *tx, const void *data, size_t len) {
+    miotyAtClient_iovec iov = { data, len };
+    trace_record(tx->ctx, MIOTYATTRACE_TX, tx->traceCmd, &iov, 1);
+}
+
+// received bytes belong to the command at the head of the queue, between commands to none
+static void trace_received(miotyAtClient_ctx *ctx, const uint8_t *data, size_t len) {
+    miotyAtClient_iovec iov = { data, len };
+    trace_record(ctx, MIOTYATTRACE_RX, ctx->active ? ctx->traceCmds[ctx->queueHead] : 0, &iov, 1);
+}
+
+static void trace_completed(miotyAtClient_ctx *ctx, miotyAtClient_returnCode returnCode) {
+    const uint8_t code[2] = { (uint8_t)returnCode, (uint8_t)((unsigned)returnCode >> 8) };
+    miotyAtClient_iovec iov = { code, sizeof(code) };
+    trace_record(ctx, MIOTYATTRACE_DONE, ctx->traceCmds[ctx->queueHead], &iov, 1);
 }
+#endif
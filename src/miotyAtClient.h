@@ -36,10 +36,22 @@
 #ifndef _AT_CLIENT_H
 #define _AT_CLIENT_H
 
+#include "miotyAtParser.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * Return codes, from three ranges that do not overlap:
+ *
+ *  - 1 to 199: MAC error n of the modem (-MNFO:n, -MERR:n) is returned as n
+ *  - 200 to 249: AT error n of the modem (AT!ERR:n) is returned as 200 + n
+ *  - 250 to 255: codes of the library itself, not in the protocol
+ *
+ * A modem error that does not fit its range, e.g. AT!ERR:50 or -MERR:0, is returned as MacError or ATErr;
+ * the number the modem sent is in \ref miotyAtClient_result modemError.
+ */
 typedef enum miotyAtClient_returnCode {
     MIOTYATCLIENT_RETURN_CODE_OK                         =   0, // ok
     MIOTYATCLIENT_RETURN_CODE_MacError                   =   1, // generic mac error
@@ -68,12 +80,707 @@ typedef enum miotyAtClient_returnCode {
     MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar           = 206, // unexpected character
     MIOTYATCLIENT_RETURN_CODE_ATArgInvalid               = 207, // invalid argument
     MIOTYATCLIENT_RETURN_CODE_ATReadFailed               = 208, // reading data failed
+    MIOTYATCLIENT_RETURN_CODE_Timeout                    = 250, // no response within the deadline, not in protocol
+    MIOTYATCLIENT_RETURN_CODE_Expired                    = 251, // queued message not sent within its time to live, not in protocol
+    MIOTYATCLIENT_RETURN_CODE_Dropped                    = 252, // queued message discarded because the queue was full, not in protocol
 } miotyAtClient_returnCode;
 
 
 void miotyAtClientWrite(const uint8_t *data, size_t len);
 bool miotyAtClientRead (uint8_t       *data, size_t *len_out);
 
+#ifndef MIOTYATCLIENT_CMD_QUEUE_SIZE
+/** Number of commands that can be submitted to a client context before they are completed */
+#define MIOTYATCLIENT_CMD_QUEUE_SIZE    4
+#endif
+
+#ifndef MIOTYATCLIENT_READ_CHUNK_SIZE
+/** Size of the buffer handed to the read callback */
+#define MIOTYATCLIENT_READ_CHUNK_SIZE   32
+#endif
+
+#ifndef MIOTYATCLIENT_WRITE_CHUNK_SIZE
+/** Size of the buffer the hex encoded data of a command is written from, independent of the data size */
+#define MIOTYATCLIENT_WRITE_CHUNK_SIZE  64
+#endif
+
+#ifndef MIOTYATCLIENT_WRITEV_MAX
+/** Maximum number of pieces handed to the gather write callback at once */
+#define MIOTYATCLIENT_WRITEV_MAX        4
+#endif
+
+#if MIOTYATCLIENT_WRITE_CHUNK_SIZE < 16 || MIOTYATCLIENT_WRITEV_MAX < 2
+#error "MIOTYATCLIENT_WRITE_CHUNK_SIZE must be at least 16 and MIOTYATCLIENT_WRITEV_MAX at least 2"
+#endif
+
+#ifndef MIOTYATCLIENT_PIPELINE_DEPTH
+/** Default number of queries written to the modem before the first is answered, see \ref miotyAtClient_setPipelining */
+#define MIOTYATCLIENT_PIPELINE_DEPTH    1
+#endif
+
+#ifndef MIOTYATCLIENT_SNAPSHOT_INFO_SIZE
+/** Size of the ATI and AT-LIBV strings of \ref miotyAtClient_snapshot, including the terminating NUL */
+#define MIOTYATCLIENT_SNAPSHOT_INFO_SIZE    64
+#endif
+
+#ifndef MIOTYATCLIENT_URC_HANDLERS
+/** Number of unsolicited result code handlers per context, see \ref miotyAtClient_addUrcHandler */
+#define MIOTYATCLIENT_URC_HANDLERS      4
+#endif
+
+#ifndef MIOTYATCLIENT_URC_SIZE
+/** Size of the buffer for the payload of an unsolicited result code, longer ones are cut */
+#define MIOTYATCLIENT_URC_SIZE          64
+#endif
+
+#ifndef MIOTYATCLIENT_METRICS
+/** 1 to count commands, latencies, return codes and bytes in every context, see \ref miotyAtClient_getMetrics, 0 compiles them away */
+#define MIOTYATCLIENT_METRICS           0
+#endif
+
+#ifndef MIOTYATCLIENT_METRICS_COMMANDS
+/** Number of distinct commands with statistics of their own in \ref miotyAtClient_metrics */
+#define MIOTYATCLIENT_METRICS_COMMANDS  16
+#endif
+
+#ifndef MIOTYATCLIENT_METRICS_BUCKETS
+/** Buckets of a latency histogram: bucket 0 counts 0 ticks, bucket i 2^(i-1) to 2^i - 1 ticks, the last one all longer */
+#define MIOTYATCLIENT_METRICS_BUCKETS   16
+#endif
+
+#ifndef MIOTYATCLIENT_TRACE
+/** 1 to let contexts record their AT exchange into a trace ring, see \ref miotyAtClient_setTrace, 0 compiles it away */
+#define MIOTYATCLIENT_TRACE             0
+#endif
+
+#ifndef MIOTYATCLIENT_RX_RING_SIZE
+/** Size of the receive ring of a client context fed by \ref miotyAtClient_feedRx, power of two, 0 to disable */
+#define MIOTYATCLIENT_RX_RING_SIZE      128
+#endif
+
+#if (MIOTYATCLIENT_RX_RING_SIZE & (MIOTYATCLIENT_RX_RING_SIZE - 1)) != 0
+#error "MIOTYATCLIENT_RX_RING_SIZE must be a power of two"
+#endif
+
+#if defined(__AVR__)
+#if MIOTYATCLIENT_RX_RING_SIZE > 128
+#error "MIOTYATCLIENT_RX_RING_SIZE must not exceed 128 on 8 bit MCUs"
+#endif
+typedef uint8_t miotyAtClient_rxIndex;      // single byte accesses are atomic on 8 bit MCUs
+#else
+typedef size_t  miotyAtClient_rxIndex;
+#endif
+
+/** Default deadlines in ms of the timeout classes, can be changed with \ref miotyAtClient_setTimeout */
+#ifndef MIOTYATCLIENT_TIMEOUT_DEFAULT_MS
+#define MIOTYATCLIENT_TIMEOUT_DEFAULT_MS    2000
+#endif
+#ifndef MIOTYATCLIENT_TIMEOUT_UPLINK_MS
+#define MIOTYATCLIENT_TIMEOUT_UPLINK_MS     15000
+#endif
+#ifndef MIOTYATCLIENT_TIMEOUT_BIDI_MS
+#define MIOTYATCLIENT_TIMEOUT_BIDI_MS       30000
+#endif
+#ifndef MIOTYATCLIENT_TIMEOUT_ATTACH_MS
+#define MIOTYATCLIENT_TIMEOUT_ATTACH_MS     30000
+#endif
+#ifndef MIOTYATCLIENT_QUIET_MS
+/** Time in ms the modem must stay silent after a timeout before the next command is written */
+#define MIOTYATCLIENT_QUIET_MS              100
+#endif
+
+struct miotyAtClient_ctx;
+
+/**
+ * @brief Callback writing data to the MIOTY™ modem of a client context
+ *
+ * @param[in]   user    User pointer given to \ref miotyAtClient_init
+ * @param[in]   data    Data to write
+ * @param[in]   len     Number of bytes in data
+ */
+typedef void (*miotyAtClient_writeFn)(void *user, const uint8_t *data, size_t len);
+
+/** Piece of a command handed to \ref miotyAtClient_writevFn */
+typedef struct miotyAtClient_iovec {
+    const void *data;
+    size_t      len;
+} miotyAtClient_iovec;
+
+/**
+ * @brief Callback writing several pieces of a command to the MIOTY™ modem at once, e.g. with writev() or a DMA descriptor chain
+ *
+ * @param[in]   user    User pointer given to \ref miotyAtClient_init
+ * @param[in]   iov     Pieces to write in order, only valid during the call
+ * @param[in]   count   Number of pieces
+ */
+typedef void (*miotyAtClient_writevFn)(void *user, const miotyAtClient_iovec *iov, size_t count);
+
+/**
+ * @brief Callback reading data from the MIOTY™ modem of a client context
+ *
+ * The callback is called while a command waits for its answer, and may block until data arrives then.
+ * For \ref miotyAtClient_poll, while URC handlers are registered (\ref miotyAtClient_addUrcHandler) and while
+ * the modem calms down after a timeout, it is also called with no answer expected; it should not block then,
+ * but return with *len_out = 0 if no data is available. With URC handlers it is also called before each command
+ * is written until it returns no data, to take in indications the modem sent meanwhile.
+ *
+ * @param[in]       user        User pointer given to \ref miotyAtClient_init
+ * @param[out]      data        Buffer for the received data
+ * @param[in,out]   len_out     Size of data, set to the number of bytes read
+ *
+ * @return      false if reading failed
+ */
+typedef bool (*miotyAtClient_readFn)(void *user, uint8_t *data, size_t *len_out);
+
+/**
+ * @brief Monotonic clock of a client context
+ *
+ * @param[in]   user    User pointer given to \ref miotyAtClient_init
+ *
+ * @return      Milliseconds since an arbitrary point in time, may wrap around
+ */
+typedef uint32_t (*miotyAtClient_clockFn)(void *user);
+
+/**
+ * @brief Called by blocking functions while they wait for received data, e.g. to sleep until the next interrupt
+ *
+ * @param[in]   user    User pointer given to \ref miotyAtClient_init
+ */
+typedef void (*miotyAtClient_idleFn)(void *user);
+
+/** Events of the packet counter mirror, see \ref miotyAtClient_setPacketCounterEvent */
+typedef enum miotyAtClient_packetCounterEvent {
+    MIOTYATCLIENT_PACKET_COUNTER_SKIP  = 0, // the counter advanced further than the uplinks seen by the context
+    MIOTYATCLIENT_PACKET_COUNTER_RESET = 1, // the counter went back, e.g. after a detach or a factory reset
+} miotyAtClient_packetCounterEvent;
+
+/**
+ * @brief Called when the packet counter reported by the modem does not continue the mirror of the context
+ *
+ * @param[in]   ctx         Client context
+ * @param[in]   event       Kind of discontinuity
+ * @param[in]   expected    Counter the context expected, also after an attach, detach or factory reset: the last known
+ *                          one, plus one if the counter was reported by an uplink
+ * @param[in]   actual      Counter reported by the modem, the new value of the mirror
+ */
+typedef void (*miotyAtClient_packetCounterFn)(struct miotyAtClient_ctx *ctx, miotyAtClient_packetCounterEvent event,
+                                              uint32_t expected, uint32_t actual);
+
+/** Deadline classes of the commands */
+typedef enum miotyAtClient_timeoutClass {
+    MIOTYATCLIENT_TIMEOUT_DEFAULT     = 0, // queries, settings and local commands
+    MIOTYATCLIENT_TIMEOUT_UPLINK      = 1, // AT-U, AT-UMPF, AT-TU
+    MIOTYATCLIENT_TIMEOUT_BIDI        = 2, // AT-B, AT-BMPF, AT-TB
+    MIOTYATCLIENT_TIMEOUT_ATTACH      = 3, // AT-MAOA, AT-MDOA
+    MIOTYATCLIENT_TIMEOUT_CLASS_COUNT
+} miotyAtClient_timeoutClass;
+
+/** How the arguments of a command are sent */
+typedef enum miotyAtClient_cmdForm {
+    MIOTYATCLIENT_CMD_FORM_EXEC      = 0, // "<cmd>\r"
+    MIOTYATCLIENT_CMD_FORM_QUERY     = 1, // "<cmd>?\r"
+    MIOTYATCLIENT_CMD_FORM_SET_INT   = 2, // "<cmd>=<value>\r"
+    MIOTYATCLIENT_CMD_FORM_SET_BYTES = 3, // "<cmd>=<len>\t<hex data>\x1A\r"
+} miotyAtClient_cmdForm;
+
+/** The modem does not answer the command (AT-RST, ATZ, AT-SBTL, AT-SHDN) */
+#define MIOTYATCLIENT_CMD_FLAG_NO_RESPONSE  0x01
+
+/** Kind of uplink for \ref miotyAtClient_prepareUplink */
+typedef enum miotyAtClient_uplinkType {
+    MIOTYATCLIENT_UPLINK_UNI              = 0, // AT-U
+    MIOTYATCLIENT_UPLINK_UNI_MPF          = 1, // AT-UMPF
+    MIOTYATCLIENT_UPLINK_BIDI             = 2, // AT-B
+    MIOTYATCLIENT_UPLINK_BIDI_MPF         = 3, // AT-BMPF
+    MIOTYATCLIENT_UPLINK_UNI_TRANSPARENT  = 4, // AT-TU
+    MIOTYATCLIENT_UPLINK_BIDI_TRANSPARENT = 5, // AT-TB
+} miotyAtClient_uplinkType;
+
+/**
+ * @brief Result of a completed command
+ */
+typedef struct miotyAtClient_result {
+    miotyAtClient_returnCode returnCode;
+    uint8_t         seen;               // MIOTYATPARSER_SEEN_* flags of the fields sent by the modem
+    uint8_t         msta;               // -MSTA: MAC state
+    uint8_t         dlMpf;              // -DLMPF: downlink MPF field, 0 if none was received
+    uint32_t        packetCounter;      // -MPCT: packet counter
+    uint32_t        value;              // value of an integer response
+    uint32_t        modemError;         // number of the MAC or AT error the modem answered, 0 for none
+    uint8_t        *data;               // rxData of the command
+    size_t          sizeData;           // bytes written to data
+} miotyAtClient_result;
+
+/**
+ * @brief Completion callback of a submitted command
+ *
+ * @param[in]   ctx     Client context the command was submitted to
+ * @param[in]   result  Result of the command, only valid during the call
+ * @param[in]   user    User pointer of the command
+ */
+typedef void (*miotyAtClient_doneFn)(struct miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user);
+
+/**
+ * @brief Unsolicited result code (URC) received from the modem
+ */
+typedef struct miotyAtClient_urc {
+    const char     *key;                // registered key, NULL for a line that matched no key
+    uint8_t         type;               // miotyAtParser_valueType of the payload, STRING for a line that matched no key
+    uint32_t        value;              // payload of an INT URC
+    const uint8_t  *data;               // payload of a DATA or STRING URC, the whole line if it matched no key
+    size_t          sizeData;           // bytes in data, at most MIOTYATCLIENT_URC_SIZE
+} miotyAtClient_urc;
+
+/**
+ * @brief Handler of an unsolicited result code
+ *
+ * Called from \ref miotyAtClient_poll, \ref miotyAtClient_feed or a waiting blocking function,
+ * with the same restrictions as a completion callback.
+ *
+ * @param[in]   ctx     Client context that received the URC
+ * @param[in]   urc     URC and its payload, only valid during the call
+ * @param[in]   user    User pointer given to \ref miotyAtClient_addUrcHandler
+ */
+typedef void (*miotyAtClient_urcFn)(struct miotyAtClient_ctx *ctx, const miotyAtClient_urc *urc, void *user);
+
+/**
+ * @brief AT command for \ref miotyAtClient_submit
+ *
+ * The buffers data and rxData are not copied and must stay valid until the command is completed.
+ */
+typedef struct miotyAtClient_cmd {
+    const char             *atCmd;          // command without arguments, e.g. "AT-MEUI"
+    uint8_t                 sizeCmd;        // length of atCmd
+    uint8_t                 form;           // miotyAtClient_cmdForm
+    uint8_t                 flags;          // MIOTYATCLIENT_CMD_FLAG_*
+    uint8_t                 respType;       // miotyAtParser_valueType of the response field
+    const char             *respKey;        // name of the response field, NULL for atCmd without "AT"
+    uint8_t                 sizeRespKey;    // length of respKey
+    uint8_t                 timeoutClass;   // miotyAtClient_timeoutClass
+    uint32_t                timeoutMs;      // deadline of this command, 0 for the one of timeoutClass
+    const uint8_t          *data;           // argument for MIOTYATCLIENT_CMD_FORM_SET_BYTES
+    size_t                  sizeData;       // size of data
+    uint32_t                value;          // argument for MIOTYATCLIENT_CMD_FORM_SET_INT
+    uint8_t                *rxData;         // buffer for data and string responses
+    size_t                  sizeRxData;     // size of rxData
+    miotyAtClient_doneFn    done;           // completion callback, may be NULL
+    void                   *user;           // handed to done
+} miotyAtClient_cmd;
+
+/** Bits of \ref miotyAtClient_snapshot valid, one per query */
+#define MIOTYATCLIENT_SNAPSHOT_EP_INFO          0x0001  // ATI
+#define MIOTYATCLIENT_SNAPSHOT_CORE_LIB_INFO    0x0002  // AT-LIBV
+#define MIOTYATCLIENT_SNAPSHOT_EUI              0x0004  // AT-MEUI?
+#define MIOTYATCLIENT_SNAPSHOT_SHORT_ADDRESS    0x0008  // AT-MSAD?
+#define MIOTYATCLIENT_SNAPSHOT_PACKET_COUNTER   0x0010  // AT-MPCT?
+#define MIOTYATCLIENT_SNAPSHOT_ATTACHED         0x0020  // AT-MAS?
+#define MIOTYATCLIENT_SNAPSHOT_TX_POWER         0x0040  // AT-UTPL?
+#define MIOTYATCLIENT_SNAPSHOT_UPLINK_MODE      0x0080  // AT-UM?
+#define MIOTYATCLIENT_SNAPSHOT_UPLINK_PROFILE   0x0100  // AT-UP?
+#define MIOTYATCLIENT_SNAPSHOT_DOWNLINK_REQUEST 0x0200  // AT-MRDR?
+#define MIOTYATCLIENT_SNAPSHOT_ALL              0x03FF
+
+/**
+ * @brief Status of a modem read by \ref miotyAtClient_getSnapshot
+ */
+typedef struct miotyAtClient_snapshot {
+    uint16_t        valid;              // MIOTYATCLIENT_SNAPSHOT_* bits of the members read successfully
+    miotyAtClient_returnCode returnCode;    // first error of the queries, MIOTYATCLIENT_RETURN_CODE_OK if all succeeded
+    char            epInfo[MIOTYATCLIENT_SNAPSHOT_INFO_SIZE];       // ATI, NUL terminated
+    char            coreLibInfo[MIOTYATCLIENT_SNAPSHOT_INFO_SIZE];  // AT-LIBV, NUL terminated
+    uint8_t         eui[8];
+    uint8_t         shortAddress[2];
+    uint32_t        packetCounter;
+    bool            attached;
+    bool            downlinkRequest;
+    uint32_t        txPower;
+    uint32_t        uplinkMode;
+    uint32_t        uplinkProfile;
+    uint32_t        durationMs;         // from the first query to the last answer, 0 without clock
+    uint8_t         pipelineDepth;      // most queries the modem had to answer at once, 1 if sent one after the other
+} miotyAtClient_snapshot;
+
+#if MIOTYATCLIENT_METRICS
+/** Number of return code counters of \ref miotyAtClient_metrics, read them with \ref miotyAtClient_metricsReturnCode */
+#define MIOTYATCLIENT_METRICS_RETURN_CODES  37
+
+/** Size of the command names of \ref miotyAtClient_cmdMetrics, including the terminating NUL, longer ones are cut */
+#define MIOTYATCLIENT_METRICS_NAME_SIZE     12
+
+/**
+ * @brief Statistics of one command, see \ref miotyAtClient_metrics
+ *
+ * Latencies are measured from writing the command to its completion, in ticks of the metrics clock,
+ * see \ref miotyAtClient_setMetricsClock. Commands without clock are counted but not timed.
+ */
+typedef struct miotyAtClient_cmdMetrics {
+    char            atCmd[MIOTYATCLIENT_METRICS_NAME_SIZE];    // e.g. "AT-B", NUL terminated, empty if the slot is unused
+    uint32_t        count;              // completed
+    uint32_t        errors;             // completed with a return code other than OK
+    uint32_t        timeouts;           // completed with MIOTYATCLIENT_RETURN_CODE_Timeout
+    uint32_t        txBytes;            // written to the modem
+    uint32_t        rxBytes;            // received while the command was answered
+    uint32_t        timed;              // completed while a clock was set, the latencies below cover these
+    uint32_t        latencyMin;
+    uint32_t        latencyMax;
+    uint32_t        latencySum;         // divided by timed gives the average
+    uint32_t        latency[MIOTYATCLIENT_METRICS_BUCKETS];    // histogram, see MIOTYATCLIENT_METRICS_BUCKETS
+} miotyAtClient_cmdMetrics;
+
+/**
+ * @brief Statistics of a client context, read by \ref miotyAtClient_getMetrics
+ *
+ * Counters wrap around at 2^32.
+ */
+typedef struct miotyAtClient_metrics {
+    miotyAtClient_cmdMetrics commands[MIOTYATCLIENT_METRICS_COMMANDS];  // in the order of their first completion
+    uint32_t        otherCommands;      // completed commands that found no free slot in commands
+    uint32_t        returnCodes[MIOTYATCLIENT_METRICS_RETURN_CODES];
+    uint32_t        txBytes;            // written for commands
+    uint32_t        rxBytes;            // received, between commands too
+    uint32_t        urcs;               // unsolicited result codes dispatched to a handler
+} miotyAtClient_metrics;
+#endif
+
+/**
+ * @brief Modem settings remembered by a client context, see \ref miotyAtClient_enableCache. Private.
+ */
+typedef struct miotyAtClient_cache {
+    bool            enabled;
+    uint8_t         valid;              // bit per member below
+    uint8_t         eui[8];             // AT-MEUI
+    uint8_t         shortAddress[2];    // AT-MSAD
+    bool            attached;           // AT-MAS
+    bool            downlinkRequest;    // AT-MRDR
+    uint32_t        txPower;            // AT-UTPL
+    uint32_t        uplinkMode;         // AT-UM
+    uint32_t        uplinkProfile;      // AT-UP
+} miotyAtClient_cache;
+
+/**
+ * @brief State of the client for one MIOTY™ modem. Members are private, use \ref miotyAtClient_init.
+ *
+ * Every context is independent, so several modems can be driven from one process,
+ * or from one thread per modem. A context must only be used from one thread at a time.
+ */
+typedef struct miotyAtClient_ctx {
+    miotyAtClient_writeFn   write;
+    miotyAtClient_writevFn  writev;
+    miotyAtClient_readFn    read;
+    void                   *user;
+    miotyAtParser           parser;
+    miotyAtClient_cmd       queue[MIOTYATCLIENT_CMD_QUEUE_SIZE];
+    uint8_t                 queueHead;
+    uint8_t                 queueCount;
+    bool                    active;         // command at queueHead was written
+    uint8_t                 written;        // commands from queueHead on written to the modem
+    uint8_t                 pipelineDepth;
+    bool                    pipelineSet;        // the depth was chosen with miotyAtClient_setPipelining
+    bool                    pipelineRejected;   // the modem refused a command written ahead
+    bool                    feeding;
+    miotyAtClient_clockFn   clock;
+    uint32_t                deadline;       // of the command at queueHead
+    bool                    quieting;       // after a timeout, input is dropped until quietUntil
+    uint32_t                quietUntil;
+    uint32_t                timeouts[MIOTYATCLIENT_TIMEOUT_CLASS_COUNT];
+    miotyAtClient_idleFn    idle;
+    miotyAtClient_cache     cache;
+    uint32_t                packetCounter;          // mirror of the modem packet counter
+    bool                    packetCounterValid;
+    bool                    packetCounterReset;     // a command reset the counter, not seen yet
+    miotyAtClient_packetCounterFn onPacketCounter;
+    miotyAtParser_urcKey    urcKeys[MIOTYATCLIENT_URC_HANDLERS];
+    miotyAtClient_urcFn     urcHandlers[MIOTYATCLIENT_URC_HANDLERS];
+    void                   *urcUsers[MIOTYATCLIENT_URC_HANDLERS];
+    uint8_t                 urcCount;
+    miotyAtClient_urcFn     urcLineHandler;     // lines between commands that match no key
+    void                   *urcLineUser;
+    uint8_t                 urcBuf[MIOTYATCLIENT_URC_SIZE];
+#if MIOTYATCLIENT_METRICS
+    miotyAtClient_metrics   metrics;
+    volatile uint32_t       metricsSeq;     // odd while metrics is updated
+    miotyAtClient_clockFn   metricsClock;   // NULL for clock
+    uint32_t                metricsStart[MIOTYATCLIENT_CMD_QUEUE_SIZE]; // clock when the queued command was written
+    uint32_t                metricsTx[MIOTYATCLIENT_CMD_QUEUE_SIZE];    // bytes written for the queued command
+    uint32_t                metricsRx;      // bytes received for the command at queueHead
+#endif
+#if MIOTYATCLIENT_TRACE
+    struct miotyAtTrace    *trace;          // NULL if not traced
+    uint8_t                 traceCmd;       // number of the last command written, 0 is skipped
+    uint8_t                 traceCmds[MIOTYATCLIENT_CMD_QUEUE_SIZE];    // numbers of the queued commands
+#endif
+#if MIOTYATCLIENT_RX_RING_SIZE > 0
+    volatile miotyAtClient_rxIndex rxHead;  // written by the producer only
+    volatile miotyAtClient_rxIndex rxTail;  // written by the consumer only
+    uint32_t                rxDropped;      // bytes lost because the ring was full
+    uint8_t                 rxRing[MIOTYATCLIENT_RX_RING_SIZE];
+#endif
+} miotyAtClient_ctx;
+
+/**
+ * @brief Initialize a client context for one MIOTY™ modem
+ *
+ * @param[out]  ctx     Context to initialize
+ * @param[in]   write   Transport write callback of this modem
+ * @param[in]   read    Transport read callback of this modem, NULL if received data is pushed with \ref miotyAtClient_feedRx
+ * @param[in]   user    Pointer handed to the callbacks, e.g. the UART of this modem
+ */
+void miotyAtClient_init(miotyAtClient_ctx *ctx, miotyAtClient_writeFn write, miotyAtClient_readFn read, void *user);
+
+/**
+ * @brief Context used by the functions without _ex suffix, bound to miotyAtClientWrite/miotyAtClientRead
+ */
+miotyAtClient_ctx *miotyAtClient_defaultCtx(void);
+
+/**
+ * @brief Set the monotonic clock used for command deadlines
+ *
+ * Without a clock commands wait for the response forever.
+ * With a clock a command without response is completed with MIOTYATCLIENT_RETURN_CODE_Timeout,
+ * as long as the read callback does not block longer than the deadline itself. The commands written ahead
+ * of it are completed the same way, and the next command is only written once the modem has been silent
+ * for MIOTYATCLIENT_QUIET_MS, so a late answer is dropped instead of taken for the one of the next command.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       clock   Clock callback, NULL to disable deadlines
+ */
+void miotyAtClient_setClock(miotyAtClient_ctx *ctx, miotyAtClient_clockFn clock);
+
+/**
+ * @brief Change the default deadline of a class of commands
+ *
+ * @param[in,out]   ctx             Client context
+ * @param[in]       timeoutClass    Deadline class
+ * @param[in]       timeoutMs       Time in ms from writing a command until its result must be received
+ */
+void miotyAtClient_setTimeout(miotyAtClient_ctx *ctx, miotyAtClient_timeoutClass timeoutClass, uint32_t timeoutMs);
+
+/**
+ * @brief Prepare an uplink command for \ref miotyAtClient_submit
+ *
+ * @param[out]  cmd         Command to prepare, done and user can be set afterwards
+ * @param[in]   type        Kind of the uplink
+ * @param[in]   msg         Message to be sent, must stay valid until the command is completed
+ * @param[in]   sizeMsg     Size of msg
+ * @param[out]  data        Buffer for downlink data of bidirectional uplinks, may be NULL otherwise
+ * @param[in]   sizeData    Size of data
+ */
+void miotyAtClient_prepareUplink(miotyAtClient_cmd *cmd, miotyAtClient_uplinkType type, const uint8_t *msg, size_t sizeMsg,
+                                 uint8_t *data, size_t sizeData);
+
+/**
+ * @brief Queue a command without waiting for its completion
+ *
+ * The command is written to the modem as soon as all commands submitted before are completed.
+ * Its done callback is called from \ref miotyAtClient_poll or \ref miotyAtClient_feed.
+ * Blocking functions must not be called from the done callback.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       cmd     Command, copied into the queue of ctx
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK if queued, MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished if the queue is full
+ */
+miotyAtClient_returnCode miotyAtClient_submit(miotyAtClient_ctx *ctx, const miotyAtClient_cmd *cmd);
+
+/**
+ * @brief Advance the submitted commands, reads once from the read callback of ctx and checks the deadline
+ *
+ * Applications using \ref miotyAtClient_feed without read callback should call it as well to check the deadline.
+ *
+ * @param[in,out]   ctx     Client context
+ *
+ * @return      true if there are commands left that are not completed yet, or the modem has to become silent after a timeout
+ */
+bool miotyAtClient_poll(miotyAtClient_ctx *ctx);
+
+/**
+ * @brief Advance the submitted commands with bytes received from the modem
+ *
+ * Alternative to \ref miotyAtClient_poll for applications that read the transport themselves.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       data    Received bytes
+ * @param[in]       len     Number of bytes in data
+ */
+void miotyAtClient_feed(miotyAtClient_ctx *ctx, const uint8_t *data, size_t len);
+
+#if MIOTYATCLIENT_RX_RING_SIZE > 0
+/**
+ * @brief Push received bytes into the receive ring of a client context
+ *
+ * Safe to call from a UART interrupt, a DMA half/full complete callback or a reader thread,
+ * as long as there is only one producer per context. The bytes are parsed by the next
+ * \ref miotyAtClient_poll or by a waiting blocking function, directly from the ring.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       data    Received bytes
+ * @param[in]       len     Number of bytes in data
+ *
+ * @return      Number of bytes stored, less than len if the ring is full
+ */
+size_t miotyAtClient_feedRx(miotyAtClient_ctx *ctx, const uint8_t *data, size_t len);
+#endif
+
+/**
+ * @brief Set a gather write callback used instead of the write callback
+ *
+ * Commands are always written in pieces of at most MIOTYATCLIENT_WRITE_CHUNK_SIZE encoded bytes.
+ * With the write callback the command string and short pieces are copied into one chunk,
+ * with the gather callback they are passed by reference and only the hex encoded data is copied.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       writev  Gather write callback, NULL to use the write callback
+ */
+void miotyAtClient_setWritev(miotyAtClient_ctx *ctx, miotyAtClient_writevFn writev);
+
+/**
+ * @brief Set the function blocking calls execute while waiting for data instead of spinning
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       idle    Idle callback, NULL to spin
+ */
+void miotyAtClient_setIdle(miotyAtClient_ctx *ctx, miotyAtClient_idleFn idle);
+
+/**
+ * @brief Answer repeated queries of the modem settings from memory
+ *
+ * With the cache enabled, the EUI, short address, attachment, transmit power, uplink mode, uplink profile
+ * and downlink request flag are read from the modem once and then served from memory. Successful sets
+ * update the cache. Reset, factory reset, bootloader start, shutdown, attach and detach invalidate it.
+ * Commands queued with \ref miotyAtClient_submit bypass the cache; call \ref miotyAtClient_invalidateCache
+ * after changing a setting that way.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       enable  true to enable, false to disable and forget the cached values
+ */
+void miotyAtClient_enableCache(miotyAtClient_ctx *ctx, bool enable);
+
+/**
+ * @brief Forget the cached settings, the next queries read them from the modem again
+ */
+void miotyAtClient_invalidateCache(miotyAtClient_ctx *ctx);
+
+/**
+ * @brief Set the callback reporting skips and resets of the packet counter
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       event   Callback, NULL for none
+ */
+void miotyAtClient_setPacketCounterEvent(miotyAtClient_ctx *ctx, miotyAtClient_packetCounterFn event);
+
+/**
+ * @brief Register the handler of an unsolicited result code (URC)
+ *
+ * Lines starting with key are taken out of the output of the modem, whether a command is running or not,
+ * and passed to the handler with their payload parsed as type. Other lines received while no command is
+ * running go to the handler registered with key NULL, or are dropped; they never reach the next command.
+ * With a handler registered, \ref miotyAtClient_poll also reads while no command is running,
+ * so the read callback must not block then.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       key     Upper case name of the URC without ':', e.g. "+DLIND", up to MIOTYATPARSER_KEY_SIZE characters;
+ *                          NULL for the lines between commands that match no key. Only the pointer is stored,
+ *                          so the string must outlive the registration, e.g. a string literal
+ * @param[in]       type    Kind of the payload behind ':', MIOTYATPARSER_VALUE_NONE for a URC without value
+ * @param[in]       handler Called for each URC
+ * @param[in]       user    Handed to handler
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK, MIOTYATCLIENT_RETURN_CODE_BufferSizeInsufficient if MIOTYATCLIENT_URC_HANDLERS are registered,
+ *              MIOTYATCLIENT_RETURN_CODE_ArgumentOOR if key is empty or longer than MIOTYATPARSER_KEY_SIZE
+ */
+miotyAtClient_returnCode miotyAtClient_addUrcHandler(miotyAtClient_ctx *ctx, const char *key, miotyAtParser_valueType type,
+                                                     miotyAtClient_urcFn handler, void *user);
+
+/**
+ * @brief Remove the handler of an unsolicited result code
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       key     Key given to \ref miotyAtClient_addUrcHandler, NULL for the handler of the other lines
+ */
+void miotyAtClient_removeUrcHandler(miotyAtClient_ctx *ctx, const char *key);
+
+/**
+ * @brief Write queries to the modem before the previous ones are answered
+ *
+ * Only queries in the default timeout class are written ahead (AT-xxx? and ATI/AT-LIBV), up to depth
+ * commands at once; settings, uplinks, attach and commands without answer always wait for the modem.
+ * The answers are assigned to the commands in order. If the modem refuses a query written ahead with
+ * MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished, the context falls back to depth 1 by itself.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       depth   Most commands written at once, 1 to wait for every answer (default MIOTYATCLIENT_PIPELINE_DEPTH)
+ */
+void miotyAtClient_setPipelining(miotyAtClient_ctx *ctx, uint8_t depth);
+
+/**
+ * @brief Number of submitted commands that are not completed yet
+ */
+size_t miotyAtClient_pending(const miotyAtClient_ctx *ctx);
+
+#if MIOTYATCLIENT_METRICS
+/**
+ * @brief Set the clock command latencies are measured with, e.g. a microsecond timer
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       clock   Clock in any unit, NULL for the clock of the context (milliseconds)
+ */
+void miotyAtClient_setMetricsClock(miotyAtClient_ctx *ctx, miotyAtClient_clockFn clock);
+
+/**
+ * @brief Copy the statistics of a client context
+ *
+ * The client does not lock while it updates them: the copy is repeated until no update happened
+ * meanwhile, so this may be called from another thread, but not from an interrupt that preempts
+ * the one driving the context.
+ *
+ * @param[in]   ctx         Client context
+ * @param[out]  metrics     Statistics
+ */
+void miotyAtClient_getMetrics(const miotyAtClient_ctx *ctx, miotyAtClient_metrics *metrics);
+
+/**
+ * @brief Clear the statistics of a client context, from the thread driving it
+ */
+void miotyAtClient_resetMetrics(miotyAtClient_ctx *ctx);
+
+/**
+ * @brief Number of commands completed with a return code
+ *
+ * @param[in]   metrics     Statistics
+ * @param[in]   code        Return code, codes not in miotyAtClient_returnCode share one counter
+ */
+uint32_t miotyAtClient_metricsReturnCode(const miotyAtClient_metrics *metrics, miotyAtClient_returnCode code);
+#endif
+
+#if MIOTYATCLIENT_TRACE
+struct miotyAtTrace;
+
+/**
+ * @brief Record the AT exchange of a context into a trace ring, see miotyAtTrace.h
+ *
+ * Every write, every received chunk and every completed command is recorded, numbered per command.
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[in]       trace   Trace prepared with miotyAtTrace_init, NULL to stop recording
+ */
+void miotyAtClient_setTrace(miotyAtClient_ctx *ctx, struct miotyAtTrace *trace);
+#endif
+
+
+/**
+ * @brief Read the identity, settings and state of the modem at once (ATI, AT-LIBV, AT-MEUI?, AT-MSAD?,
+ *        AT-MPCT?, AT-MAS?, AT-UTPL?, AT-UM?, AT-UP?, AT-MRDR?)
+ *
+ * The queries are pipelined as deep as \ref miotyAtClient_setPipelining allows. If it was never called and a
+ * clock is set (\ref miotyAtClient_setClock), they are pipelined up to MIOTYATCLIENT_CMD_QUEUE_SIZE deep, unless
+ * the modem refused that before; queries it refuses are repeated one after the other. The packet counter mirror and the enabled cache are
+ * updated with the values read.
+ *
+ * @param[out]  snapshot    Status of the modem, members without valid bit are undefined
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK if all queries succeeded, else the first error, see snapshot->valid
+ */
+miotyAtClient_returnCode miotyAtClient_getSnapshot(miotyAtClient_snapshot *snapshot);
 
 /**
  * @brief Soft reset of the MIOTY™ modem. Persistent fields shall keep their current value.
@@ -146,7 +853,11 @@ miotyAtClient_returnCode miotyAtClient_getOrSetEui(uint8_t *eui64, bool set);
 miotyAtClient_returnCode miotyAtClient_getOrSetShortAddress(uint8_t *shortAddress, bool set);
 
 /**
- * @brief Send AT command to get the current packet counter (AT-MPCT)
+ * @brief Get the current packet counter
+ *
+ * The client mirrors the counter: it is read once with AT-MPCT and then advanced from the -MPCT:
+ * field of every uplink response, so this call only queries the modem if the mirror is not known,
+ * e.g. after an attach, a detach or an uplink without answer.
  *
  * @param[out]   counter         Pointer to store the packet counter
  *
@@ -155,6 +866,15 @@ miotyAtClient_returnCode miotyAtClient_getOrSetShortAddress(uint8_t *shortAddres
  */
 miotyAtClient_returnCode miotyAtClient_getPacketCounter(uint32_t *counter);
 
+/**
+ * @brief Read the current packet counter from the modem (AT-MPCT) and update the mirror
+ *
+ * @param[out]   counter         Pointer to store the packet counter
+ *
+ * @return      miotyAtClient_returnCode    indicating success/error of AT_cmd execution
+ */
+miotyAtClient_returnCode miotyAtClient_refreshPacketCounter(uint32_t *counter);
+
 /**
  * @brief Get/Set Uplink transmit power (AT-UTPL)
  *
@@ -217,7 +937,9 @@ miotyAtClient_returnCode miotyAtClient_sendMessageUniMPF(const uint8_t *msg, siz
  * \param[out]      dl_mpf          Received downlink MPF field
  * \param[out]      packetCounter   packet Counter after successful transmission
  *
- * \return          miotyAtClient_returnCode    indicating success/error of AT_cmd execution
+ * \return          miotyAtClient_returnCode    indicating success/error of AT_cmd execution,
+ *                  MIOTYATCLIENT_RETURN_CODE_BufferSizeInsufficient if the downlink is larger than data,
+ *                  data then holds its first size_data bytes
  */
 miotyAtClient_returnCode miotyAtClient_sendMessageBidi(const uint8_t *msg, size_t sizeMsg,
                                                        uint8_t *data, size_t *size_data,
@@ -233,7 +955,9 @@ miotyAtClient_returnCode miotyAtClient_sendMessageBidi(const uint8_t *msg, size_
  * \param[out]      dl_mpf          Received downlink MPF field
  * \param[out]      packetCounter   packet Counter after successful transmission
  *
- * \return          miotyAtClient_returnCode    indicating success/error of AT_cmd execution
+ * \return          miotyAtClient_returnCode    indicating success/error of AT_cmd execution,
+ *                  MIOTYATCLIENT_RETURN_CODE_BufferSizeInsufficient if the downlink is larger than data,
+ *                  data then holds its first size_data bytes
  */
 miotyAtClient_returnCode miotyAtClient_sendMessageBidiMPF(const uint8_t *msg, size_t sizeMsg,
                                                           uint8_t *data, size_t *size_data,
@@ -259,7 +983,9 @@ miotyAtClient_returnCode miotyAtClient_sendMessageUniTransparent(const uint8_t *
  * \param[out]      size_data       Size of the Buffer, will be set to size of data returned by AT_cmd
  * \param[out]      packetCounter   packet Counter after successful transmission
  *
- * \return          miotyAtClient_returnCode    indicating success/error of AT_cmd execution
+ * \return          miotyAtClient_returnCode    indicating success/error of AT_cmd execution,
+ *                  MIOTYATCLIENT_RETURN_CODE_BufferSizeInsufficient if the downlink is larger than data,
+ *                  data then holds its first size_data bytes
  */
 miotyAtClient_returnCode miotyAtClient_sendMessageBidiTransparent(const uint8_t *msg, size_t sizeMsg,
                                                                   uint8_t *data, size_t *size_data,
@@ -414,6 +1140,59 @@ miotyAtClient_returnCode miotyAtClient_startRxCont(uint32_t frequency);
  */
 miotyAtClient_returnCode miotyAtClient_stopRxCont(void);
 
+/**
+ * @name Client context variants
+ * Each function behaves like the function of the same name without _ex suffix,
+ * but talks to the modem bound to ctx instead of the one behind miotyAtClientWrite/miotyAtClientRead.
+ * @{
+ */
+miotyAtClient_returnCode miotyAtClient_getSnapshot_ex(miotyAtClient_ctx *ctx, miotyAtClient_snapshot *snapshot);
+miotyAtClient_returnCode miotyAtClient_reset_ex(miotyAtClient_ctx *ctx);
+miotyAtClient_returnCode miotyAtClient_factoryReset_ex(miotyAtClient_ctx *ctx);
+miotyAtClient_returnCode miotyAtClient_startBootloader_ex(miotyAtClient_ctx *ctx);
+miotyAtClient_returnCode miotyAtClient_shutdown_ex(miotyAtClient_ctx *ctx);
+miotyAtClient_returnCode miotyAtClient_setNetworkKey_ex(miotyAtClient_ctx *ctx, const uint8_t *nwKey);
+miotyAtClient_returnCode miotyAtClient_getOrSetIPv6SubnetMask_ex(miotyAtClient_ctx *ctx, uint8_t *ipv6, bool set);
+miotyAtClient_returnCode miotyAtClient_getOrSetEui_ex(miotyAtClient_ctx *ctx, uint8_t *eui64, bool set);
+miotyAtClient_returnCode miotyAtClient_getOrSetShortAddress_ex(miotyAtClient_ctx *ctx, uint8_t *shortAddress, bool set);
+miotyAtClient_returnCode miotyAtClient_getPacketCounter_ex(miotyAtClient_ctx *ctx, uint32_t *counter);
+miotyAtClient_returnCode miotyAtClient_refreshPacketCounter_ex(miotyAtClient_ctx *ctx, uint32_t *counter);
+miotyAtClient_returnCode miotyAtClient_getOrSetTransmitPower_ex(miotyAtClient_ctx *ctx, uint32_t *txPower, bool set);
+miotyAtClient_returnCode miotyAtClient_uplinkMode_ex(miotyAtClient_ctx *ctx, uint32_t *ulMode, bool set);
+miotyAtClient_returnCode miotyAtClient_uplinkProfile_ex(miotyAtClient_ctx *ctx, uint32_t *ulProfile, bool set);
+miotyAtClient_returnCode miotyAtClient_sendMessageUni_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                         uint32_t *packetCounter);
+miotyAtClient_returnCode miotyAtClient_sendMessageUniMPF_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                            uint32_t *packetCounter);
+miotyAtClient_returnCode miotyAtClient_sendMessageBidi_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                          uint8_t *data, size_t *size_data,
+                                                          uint8_t *dl_mpf, uint32_t *packetCounter);
+miotyAtClient_returnCode miotyAtClient_sendMessageBidiMPF_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                             uint8_t *data, size_t *size_data,
+                                                             uint8_t *dl_mpf, uint32_t *packetCounter);
+miotyAtClient_returnCode miotyAtClient_sendMessageUniTransparent_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                                    uint32_t *packetCounter);
+miotyAtClient_returnCode miotyAtClient_sendMessageBidiTransparent_ex(miotyAtClient_ctx *ctx, const uint8_t *msg, size_t sizeMsg,
+                                                                     uint8_t *data, size_t *size_data,
+                                                                     uint32_t *packetCounter);
+miotyAtClient_returnCode miotyAtClient_macAttach_ex(miotyAtClient_ctx *ctx, const uint8_t *nonce4B, uint8_t *msta);
+miotyAtClient_returnCode miotyAtClient_macDetach_ex(miotyAtClient_ctx *ctx, const uint8_t *data, size_t sizeData, uint8_t *msta);
+miotyAtClient_returnCode miotyAtClient_macAttachLocal_ex(miotyAtClient_ctx *ctx, uint8_t *msta);
+miotyAtClient_returnCode miotyAtClient_macDetachLocal_ex(miotyAtClient_ctx *ctx, uint8_t *msta);
+miotyAtClient_returnCode miotyAtClient_getAttachment_ex(miotyAtClient_ctx *ctx, bool *attached);
+miotyAtClient_returnCode miotyAtClient_downlinkRequestResponseFlag_ex(miotyAtClient_ctx *ctx, bool *flag, bool set);
+miotyAtClient_returnCode miotyAtClient_getEpInfo_ex(miotyAtClient_ctx *ctx, uint8_t *buffer, size_t *sizeBuf);
+miotyAtClient_returnCode miotyAtClient_getCoreLibInfo_ex(miotyAtClient_ctx *ctx, uint8_t *buffer, size_t *sizeBuf);
+miotyAtClient_returnCode miotyAtClient_txInhibit_ex(miotyAtClient_ctx *ctx, bool *enable, bool set);
+miotyAtClient_returnCode miotyAtClient_txActive_ex(miotyAtClient_ctx *ctx, bool *enable, bool set);
+miotyAtClient_returnCode miotyAtClient_rxActive_ex(miotyAtClient_ctx *ctx, bool *enable, bool set);
+miotyAtClient_returnCode miotyAtClient_startTxContUnmodulated_ex(miotyAtClient_ctx *ctx, uint32_t frequency);
+miotyAtClient_returnCode miotyAtClient_startTxContModulated_ex(miotyAtClient_ctx *ctx, uint32_t frequency);
+miotyAtClient_returnCode miotyAtClient_stopTxCont_ex(miotyAtClient_ctx *ctx);
+miotyAtClient_returnCode miotyAtClient_startRxCont_ex(miotyAtClient_ctx *ctx, uint32_t frequency);
+miotyAtClient_returnCode miotyAtClient_stopRxCont_ex(miotyAtClient_ctx *ctx);
+/** @} */
+
 #ifdef __cplusplus
 }
 #endif
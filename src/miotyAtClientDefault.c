@@ -0,0 +1,214 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Default client context bound to miotyAtClientWrite/miotyAtClientRead.
+ *
+ * Kept in its own translation unit, so applications using only client contexts
+ * do not need to provide the global transport functions.
+ */
+
+#include "miotyAtClient.h"
+
+static void default_write(void *user, const uint8_t *data, size_t len);
+static bool default_read(void *user, uint8_t *data, size_t *len_out);
+
+static miotyAtClient_ctx default_ctx = {
+    .write = default_write,
+    .read  = default_read,
+    .timeouts = {
+        [MIOTYATCLIENT_TIMEOUT_DEFAULT] = MIOTYATCLIENT_TIMEOUT_DEFAULT_MS,
+        [MIOTYATCLIENT_TIMEOUT_UPLINK]  = MIOTYATCLIENT_TIMEOUT_UPLINK_MS,
+        [MIOTYATCLIENT_TIMEOUT_BIDI]    = MIOTYATCLIENT_TIMEOUT_BIDI_MS,
+        [MIOTYATCLIENT_TIMEOUT_ATTACH]  = MIOTYATCLIENT_TIMEOUT_ATTACH_MS,
+    },
+    .pipelineDepth = MIOTYATCLIENT_PIPELINE_DEPTH,
+};
+
+
+miotyAtClient_ctx *miotyAtClient_defaultCtx(void) {
+    return &default_ctx;
+}
+
+miotyAtClient_returnCode miotyAtClient_getSnapshot(miotyAtClient_snapshot *snapshot) {
+    return miotyAtClient_getSnapshot_ex(&default_ctx, snapshot);
+}
+
+miotyAtClient_returnCode miotyAtClient_reset(void) {
+    return miotyAtClient_reset_ex(&default_ctx);
+}
+
+miotyAtClient_returnCode miotyAtClient_factoryReset(void) {
+    return miotyAtClient_factoryReset_ex(&default_ctx);
+}
+
+miotyAtClient_returnCode miotyAtClient_startBootloader(void) {
+    return miotyAtClient_startBootloader_ex(&default_ctx);
+}
+
+miotyAtClient_returnCode miotyAtClient_shutdown(void) {
+    return miotyAtClient_shutdown_ex(&default_ctx);
+}
+
+miotyAtClient_returnCode miotyAtClient_setNetworkKey(const uint8_t *nwKey) {
+    return miotyAtClient_setNetworkKey_ex(&default_ctx, nwKey);
+}
+
+miotyAtClient_returnCode miotyAtClient_getOrSetIPv6SubnetMask(uint8_t *ipv6, bool set) {
+    return miotyAtClient_getOrSetIPv6SubnetMask_ex(&default_ctx, ipv6, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_getOrSetEui(uint8_t *eui64, bool set) {
+    return miotyAtClient_getOrSetEui_ex(&default_ctx, eui64, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_getOrSetShortAddress(uint8_t *shortAddress, bool set) {
+    return miotyAtClient_getOrSetShortAddress_ex(&default_ctx, shortAddress, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_getPacketCounter(uint32_t *counter) {
+    return miotyAtClient_getPacketCounter_ex(&default_ctx, counter);
+}
+
+miotyAtClient_returnCode miotyAtClient_refreshPacketCounter(uint32_t *counter) {
+    return miotyAtClient_refreshPacketCounter_ex(&default_ctx, counter);
+}
+
+miotyAtClient_returnCode miotyAtClient_getOrSetTransmitPower(uint32_t *txPower, bool set) {
+    return miotyAtClient_getOrSetTransmitPower_ex(&default_ctx, txPower, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_uplinkMode(uint32_t *ulMode, bool set) {
+    return miotyAtClient_uplinkMode_ex(&default_ctx, ulMode, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_uplinkProfile(uint32_t *ulProfile, bool set) {
+    return miotyAtClient_uplinkProfile_ex(&default_ctx, ulProfile, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_sendMessageUni(const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
+    return miotyAtClient_sendMessageUni_ex(&default_ctx, msg, sizeMsg, packetCounter);
+}
+
+miotyAtClient_returnCode miotyAtClient_sendMessageUniMPF(const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
+    return miotyAtClient_sendMessageUniMPF_ex(&default_ctx, msg, sizeMsg, packetCounter);
+}
+
+miotyAtClient_returnCode miotyAtClient_sendMessageBidi(const uint8_t *msg, size_t sizeMsg,
+                                                       uint8_t *data, size_t *size_data,
+                                                       uint8_t *dl_mpf, uint32_t *packetCounter) {
+    return miotyAtClient_sendMessageBidi_ex(&default_ctx, msg, sizeMsg, data, size_data, dl_mpf, packetCounter);
+}
+
+miotyAtClient_returnCode miotyAtClient_sendMessageBidiMPF(const uint8_t *msg, size_t sizeMsg,
+                                                          uint8_t *data, size_t *size_data,
+                                                          uint8_t *dl_mpf, uint32_t *packetCounter) {
+    return miotyAtClient_sendMessageBidiMPF_ex(&default_ctx, msg, sizeMsg, data, size_data, dl_mpf, packetCounter);
+}
+
+miotyAtClient_returnCode miotyAtClient_sendMessageUniTransparent(const uint8_t *msg, size_t sizeMsg, uint32_t *packetCounter) {
+    return miotyAtClient_sendMessageUniTransparent_ex(&default_ctx, msg, sizeMsg, packetCounter);
+}
+
+miotyAtClient_returnCode miotyAtClient_sendMessageBidiTransparent(const uint8_t *msg, size_t sizeMsg,
+                                                                  uint8_t *data, size_t *size_data,
+                                                                  uint32_t *packetCounter) {
+    return miotyAtClient_sendMessageBidiTransparent_ex(&default_ctx, msg, sizeMsg, data, size_data, packetCounter);
+}
+
+miotyAtClient_returnCode miotyAtClient_macAttach(const uint8_t *nonce4B, uint8_t *msta) {
+    return miotyAtClient_macAttach_ex(&default_ctx, nonce4B, msta);
+}
+
+miotyAtClient_returnCode miotyAtClient_macDetach(const uint8_t *data, size_t sizeData, uint8_t *msta) {
+    return miotyAtClient_macDetach_ex(&default_ctx, data, sizeData, msta);
+}
+
+miotyAtClient_returnCode miotyAtClient_macAttachLocal(uint8_t *msta) {
+    return miotyAtClient_macAttachLocal_ex(&default_ctx, msta);
+}
+
+miotyAtClient_returnCode miotyAtClient_macDetachLocal(uint8_t *msta) {
+    return miotyAtClient_macDetachLocal_ex(&default_ctx, msta);
+}
+
+miotyAtClient_returnCode miotyAtClient_getAttachment(bool *attached) {
+    return miotyAtClient_getAttachment_ex(&default_ctx, attached);
+}
+
+miotyAtClient_returnCode miotyAtClient_downlinkRequestResponseFlag(bool *flag, bool set) {
+    return miotyAtClient_downlinkRequestResponseFlag_ex(&default_ctx, flag, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_getEpInfo(uint8_t *buffer, size_t *sizeBuf) {
+    return miotyAtClient_getEpInfo_ex(&default_ctx, buffer, sizeBuf);
+}
+
+miotyAtClient_returnCode miotyAtClient_getCoreLibInfo(uint8_t *buffer, size_t *sizeBuf) {
+    return miotyAtClient_getCoreLibInfo_ex(&default_ctx, buffer, sizeBuf);
+}
+
+miotyAtClient_returnCode miotyAtClient_txInhibit(bool *enable, bool set) {
+    return miotyAtClient_txInhibit_ex(&default_ctx, enable, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_txActive(bool *enable, bool set) {
+    return miotyAtClient_txActive_ex(&default_ctx, enable, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_rxActive(bool *enable, bool set) {
+    return miotyAtClient_rxActive_ex(&default_ctx, enable, set);
+}
+
+miotyAtClient_returnCode miotyAtClient_startTxContUnmodulated(uint32_t frequency) {
+    return miotyAtClient_startTxContUnmodulated_ex(&default_ctx, frequency);
+}
+
+miotyAtClient_returnCode miotyAtClient_startTxContModulated(uint32_t frequency) {
+    return miotyAtClient_startTxContModulated_ex(&default_ctx, frequency);
+}
+
+miotyAtClient_returnCode miotyAtClient_stopTxCont(void) {
+    return miotyAtClient_stopTxCont_ex(&default_ctx);
+}
+
+miotyAtClient_returnCode miotyAtClient_startRxCont(uint32_t frequency) {
+    return miotyAtClient_startRxCont_ex(&default_ctx, frequency);
+}
+
+miotyAtClient_returnCode miotyAtClient_stopRxCont(void) {
+    return miotyAtClient_stopRxCont_ex(&default_ctx);
+}
+
+
+static void default_write(void *user, const uint8_t *data, size_t len) {
+    (void)user;
+    miotyAtClientWrite(data, len);
+}
+
+static bool default_read(void *user, uint8_t *data, size_t *len_out) {
+    (void)user;
+    return miotyAtClientRead(data, len_out);
+}
@@ -0,0 +1,585 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Firmware update of a m.YON modem over XMODEM-CRC/XMODEM-1K.
+ *
+ * The last block is padded with CPMEOF (0x1A). In XMODEM-1K mode the tail of the image is sent in
+ * 128 byte blocks once less than 7 of them are left, which pads less than a 1024 byte block would.
+ *
+ * An image in memory is sent without copying. An image read from a source callback goes through two
+ * block buffers: while a block is on the wire and being stored by the bootloader, the next one is read
+ * into the other buffer, so the source is only waited for when it is slower than the modem.
+ *
+ * A .gbl image is a sequence of tags, each a 32 bit tag id and a 32 bit length followed by its data,
+ * all little endian. The end tag holds the CRC-32 of the image up to and including its own id and length.
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#include <string.h>
+#include "miotyAtFwUpdate.h"
+#include "data_tools/crc16.h"
+#include "data_tools/crc32.h"
+
+#define XM_SOH      0x01    // 128 byte block
+#define XM_STX      0x02    // 1024 byte block
+#define XM_EOT      0x04
+#define XM_ACK      0x06
+#define XM_NAK      0x15
+#define XM_CAN      0x18
+#define XM_CRC      'C'     // receiver requests XMODEM-CRC
+#define XM_PAD      0x1A
+
+#define BLOCK_SIZE      128
+#define BLOCK_SIZE_1K   1024
+
+#define GBL_TAG_HEADER      0x03A617EBu
+#define GBL_TAG_APPLICATION 0xF40A0AF4u
+#define GBL_TAG_BOOTLOADER  0xF50909F5u
+#define GBL_TAG_ENC_INIT    0xFA0606FAu
+#define GBL_TAG_ENC_DATA    0xF90707F9u
+#define GBL_TAG_SIGNATURE   0xF70A0AF7u
+#define GBL_TAG_END         0xFC0404FCu
+#define GBL_TAG_HEAD_SIZE   8       // id and length
+
+/* answers of the bootloader, and the two ways waiting for one can fail */
+enum {
+    ANSWER_ACK,
+    ANSWER_NAK,
+    ANSWER_REQUEST,     // 'C' instead of an answer to the first block: a transfer was not started yet
+    ANSWER_CANCEL,
+    ANSWER_TIMEOUT,
+    ANSWER_READ_FAILED,
+};
+
+#define BYTE_TIMEOUT        (-1)
+#define BYTE_READ_FAILED    (-2)
+
+/* the image, in memory or behind a source with two block buffers */
+typedef struct {
+    const uint8_t                  *mem;
+    const miotyAtFwUpdate_source   *src;
+    size_t                          size;
+    size_t                          offset[2];  // of the data in the buffers
+    size_t                          len[2];     // 0 if the buffer holds nothing
+} fw_image;
+
+static miotyAtClient_returnCode update(miotyAtClient_ctx *ctx, const miotyAtFwUpdate_config *cfg,
+                                       fw_image *image, miotyAtFwUpdate_result *result);
+static size_t block_size(size_t blockSize, size_t left);
+static const uint8_t *fetch(fw_image *image, int slot, size_t offset, size_t len);
+static int read_byte(miotyAtClient_ctx *ctx, uint32_t deadline);
+static bool settle(miotyAtClient_ctx *ctx, uint32_t ms);
+static void write_bytes(miotyAtClient_ctx *ctx, const void *data, size_t len);
+static void write_block(miotyAtClient_ctx *ctx, uint8_t seq, const uint8_t *data, size_t len, size_t blockSize);
+static int await_answer(miotyAtClient_ctx *ctx, uint32_t timeoutMs, bool request);
+static miotyAtClient_returnCode finish(const miotyAtFwUpdate_config *cfg, miotyAtFwUpdate_result *result,
+                                       miotyAtFwUpdate_status status);
+static miotyAtClient_returnCode inspect(fw_image *image, const char *name, miotyAtFwUpdate_imageInfo *info);
+static bool name_version(const char *name, miotyAtInfo_version *version);
+static uint32_t get_le32(const uint8_t *p);
+
+
+void miotyAtFwUpdate_defaultConfig(miotyAtFwUpdate_config *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->bootBaud = 115200;
+    cfg->appBaud = 9600;
+    cfg->maxRetries = 10;
+    cfg->settleMs = 500;
+    cfg->startTimeoutMs = 10000;
+    cfg->blockTimeoutMs = 5000;
+}
+
+miotyAtClient_returnCode miotyAtFwUpdate_run(miotyAtClient_ctx *ctx, const miotyAtFwUpdate_config *cfg,
+                                             const uint8_t *image, size_t size, miotyAtFwUpdate_result *result) {
+    fw_image img = { .mem = image, .size = size };
+    return update(ctx, cfg, &img, result);
+}
+
+miotyAtClient_returnCode miotyAtFwUpdate_runSource(miotyAtClient_ctx *ctx, const miotyAtFwUpdate_config *cfg,
+                                                   const miotyAtFwUpdate_source *source, miotyAtFwUpdate_result *result) {
+    if (!source->read || source->sizeBuffer < 2 * BLOCK_SIZE) {
+        if (result)
+            memset(result, 0, sizeof(*result));
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentOOR;
+    }
+    fw_image img = { .src = source, .size = source->size };
+    return update(ctx, cfg, &img, result);
+}
+
+miotyAtClient_returnCode miotyAtFwUpdate_inspect(const uint8_t *image, size_t size, const char *name,
+                                                 miotyAtFwUpdate_imageInfo *info) {
+    fw_image img = { .mem = image, .size = size };
+    return inspect(&img, name, info);
+}
+
+miotyAtClient_returnCode miotyAtFwUpdate_inspectSource(const miotyAtFwUpdate_source *source, const char *name,
+                                                       miotyAtFwUpdate_imageInfo *info) {
+    if (!source->read || source->sizeBuffer < 2 * BLOCK_SIZE) {
+        memset(info, 0, sizeof(*info));
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentOOR;
+    }
+    fw_image img = { .src = source, .size = source->size };
+    return inspect(&img, name, info);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+bool miotyAtFwUpdate_readFile(void *user, size_t offset, uint8_t *data, size_t *len_out) {
+    const int fd = *(const int *)user;
+    ssize_t n;
+    do {
+        n = pread(fd, data, *len_out, (off_t)offset);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0)
+        return false;
+    *len_out = (size_t)n;
+    return true;
+}
+#endif
+
+static miotyAtClient_returnCode update(miotyAtClient_ctx *ctx, const miotyAtFwUpdate_config *cfg,
+                                       fw_image *image, miotyAtFwUpdate_result *result) {
+    miotyAtFwUpdate_config defaults;
+    miotyAtFwUpdate_result local;
+    if (!cfg) {
+        miotyAtFwUpdate_defaultConfig(&defaults);
+        cfg = &defaults;
+    }
+    if (!result)
+        result = &local;
+
+    /* cfg->resume may be result itself */
+    size_t offset = 0;
+    uint32_t blocks = 0;
+    uint16_t resumeBlockSize = 0;
+    if (cfg->resume && cfg->resume->bytesSent > 0 && cfg->resume->bytesSent <= image->size) {
+        offset = cfg->resume->bytesSent;
+        blocks = cfg->resume->blocks;
+        resumeBlockSize = cfg->resume->blockSize;
+    }
+    memset(result, 0, sizeof(*result));
+
+    if (!ctx->read || !ctx->clock || image->size == 0)
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentOOR;
+    if (miotyAtClient_pending(ctx) > 0)
+        return MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished;
+
+    uint32_t start = ctx->clock(ctx->user);
+    if (!cfg->inBootloader && offset == 0) {
+        /* a bootloader left running by an earlier attempt ends with a CR, the AT interface ignores it */
+        write_bytes(ctx, "\r", 1);
+        if (!settle(ctx, cfg->settleMs))
+            return finish(cfg, result, MIOTYATFWUPDATE_STATUS_TRANSPORT);
+        /* a modem that does not tell its version is updated */
+        miotyAtInfo_epInfo info;
+        if (cfg->imageVersion && miotyAtInfo_readEpInfo(ctx, &info) == MIOTYATCLIENT_RETURN_CODE_OK) {
+            result->modemVersion = info.fw;
+            if (miotyAtInfo_compareVersion(&info.fw, cfg->imageVersion) == 0) {
+                result->status = MIOTYATFWUPDATE_STATUS_SKIPPED;
+                return MIOTYATCLIENT_RETURN_CODE_OK;
+            }
+        }
+        miotyAtClient_returnCode ret = miotyAtClient_startBootloader_ex(ctx);
+        if (ret != MIOTYATCLIENT_RETURN_CODE_OK) {
+            result->status = MIOTYATFWUPDATE_STATUS_BOOTLOADER;
+            return ret;
+        }
+    }
+    if (cfg->setBaud)
+        cfg->setBaud(cfg->user, cfg->bootBaud);
+
+    /* answers to the interrupted transfer may still arrive and must not be taken for answers to the
+       resumed one; a request means that the bootloader waits for a new transfer */
+    if (offset > 0) {
+        uint32_t deadline = ctx->clock(ctx->user) + cfg->settleMs;
+        int c;
+        while ((c = read_byte(ctx, deadline)) >= 0 && c != XM_CRC)
+            ;
+        if (c == BYTE_READ_FAILED)
+            return finish(cfg, result, MIOTYATFWUPDATE_STATUS_TRANSPORT);
+        if (c == XM_CRC) {
+            offset = 0;
+            blocks = 0;
+            resumeBlockSize = 0;
+        }
+    } else {
+        /* the bootloader repeats its request until the first block, bytes before it are noise of the restart */
+        uint32_t deadline = ctx->clock(ctx->user) + cfg->startTimeoutMs;
+        for (;;) {
+            int c = read_byte(ctx, deadline);
+            if (c == XM_CRC)
+                break;
+            if (c == BYTE_TIMEOUT)
+                return finish(cfg, result, MIOTYATFWUPDATE_STATUS_NO_START);
+            if (c == BYTE_READ_FAILED)
+                return finish(cfg, result, MIOTYATFWUPDATE_STATUS_TRANSPORT);
+        }
+    }
+    uint32_t transferStart = ctx->clock(ctx->user);
+    result->startMs = transferStart - start;
+    const size_t resumeOffset = offset;
+    result->resumed = offset > 0;
+    result->bytesSent = offset;
+    result->blocks = blocks;
+    result->blockSize = resumeBlockSize;
+
+    /* 1024 byte blocks need two 1024 byte buffers for a source */
+    const bool try1k = cfg->block1k && (image->mem || image->src->sizeBuffer >= 2 * BLOCK_SIZE_1K);
+    size_t blockSize = (try1k && (offset == 0 || resumeBlockSize == BLOCK_SIZE_1K)) ? BLOCK_SIZE_1K : BLOCK_SIZE;
+    bool acked1k = resumeBlockSize == BLOCK_SIZE_1K;
+    uint8_t seq = (uint8_t)(blocks + 1);
+    uint32_t newBlocks = 0;
+    uint64_t blockMsSum = 0;
+    int slot = 0;
+    while (offset < image->size) {
+        size_t bs = block_size(blockSize, image->size - offset);
+        size_t len = image->size - offset < bs ? image->size - offset : bs;
+        const uint8_t *data = fetch(image, slot, offset, len);
+        if (!data)
+            return finish(cfg, result, MIOTYATFWUPDATE_STATUS_SOURCE);
+
+        uint32_t blockStart = ctx->clock(ctx->user);
+        int answer;
+        for (uint8_t tries = 0;; tries++) {
+            write_block(ctx, seq, data, len, bs);
+            /* read the next block while this one is sent and stored, a failure is reported when it is due */
+            if (tries == 0 && image->src && offset + len < image->size) {
+                size_t next = offset + len;
+                size_t nextBs = block_size(blockSize, image->size - next);
+                fetch(image, !slot, next, image->size - next < nextBs ? image->size - next : nextBs);
+            }
+            /* a request answering the first resumed block means that the bootloader waits for a new transfer */
+            const bool resuming = result->resumed && offset == resumeOffset;
+            answer = await_answer(ctx, cfg->blockTimeoutMs, offset == 0 || resuming);
+            if (answer == ANSWER_REQUEST && resuming)
+                break;
+            if (answer == ANSWER_REQUEST)
+                answer = ANSWER_NAK;
+            if (answer != ANSWER_NAK && answer != ANSWER_TIMEOUT)
+                break;
+            result->retries++;
+            /* a bootloader without XMODEM-1K refuses the first 1024 byte block, it gets 128 byte blocks from now on */
+            if (bs == BLOCK_SIZE_1K && !acked1k) {
+                blockSize = BLOCK_SIZE;
+                result->fallback = true;
+                break;
+            }
+            if (tries >= cfg->maxRetries) {
+                static const uint8_t cancel[] = { XM_CAN, XM_CAN, XM_CAN };
+                write_bytes(ctx, cancel, sizeof(cancel));
+                return finish(cfg, result, MIOTYATFWUPDATE_STATUS_BLOCK);
+            }
+        }
+        if (answer == ANSWER_CANCEL)
+            return finish(cfg, result, MIOTYATFWUPDATE_STATUS_CANCELLED);
+        if (answer == ANSWER_READ_FAILED)
+            return finish(cfg, result, MIOTYATFWUPDATE_STATUS_TRANSPORT);
+        if (answer == ANSWER_REQUEST) {
+            offset = 0;
+            seq = 1;
+            acked1k = false;
+            blockSize = try1k ? BLOCK_SIZE_1K : BLOCK_SIZE;
+            result->resumed = false;
+            result->bytesSent = 0;
+            result->blocks = 0;
+            result->blockSize = 0;
+            continue;
+        }
+        if (answer != ANSWER_ACK)
+            continue;   // falling back to 128 byte blocks
+
+        uint32_t blockMs = ctx->clock(ctx->user) - blockStart;
+        if (newBlocks == 0 || blockMs < result->blockMsMin)
+            result->blockMsMin = blockMs;
+        if (blockMs > result->blockMsMax)
+            result->blockMsMax = blockMs;
+        blockMsSum += blockMs;
+        newBlocks++;
+        if (bs == BLOCK_SIZE_1K)
+            acked1k = true;
+        offset += len;
+        seq++;
+        slot = !slot;
+        result->blocks++;
+        result->bytesSent = offset;
+        result->blockSize = (uint16_t)bs;
+        result->blockMsAvg = (uint32_t)(blockMsSum / newBlocks);
+        if (cfg->progress)
+            cfg->progress(cfg->user, offset, image->size, blockMs);
+    }
+
+    for (uint8_t tries = 0;; tries++) {
+        static const uint8_t eot = XM_EOT;
+        write_bytes(ctx, &eot, 1);
+        int answer = await_answer(ctx, cfg->blockTimeoutMs, false);
+        if (answer == ANSWER_ACK)
+            break;
+        if (answer == ANSWER_READ_FAILED)
+            return finish(cfg, result, MIOTYATFWUPDATE_STATUS_TRANSPORT);
+        if (answer == ANSWER_CANCEL || tries >= cfg->maxRetries)
+            return finish(cfg, result, MIOTYATFWUPDATE_STATUS_END);
+    }
+    result->transferMs = ctx->clock(ctx->user) - transferStart;
+    return finish(cfg, result, MIOTYATFWUPDATE_STATUS_OK);
+}
+
+// size of the next block, 128 byte blocks for the tail of a XMODEM-1K transfer
+static size_t block_size(size_t blockSize, size_t left) {
+    return (blockSize == BLOCK_SIZE_1K && left > BLOCK_SIZE_1K - BLOCK_SIZE) ? BLOCK_SIZE_1K : BLOCK_SIZE;
+}
+
+// len bytes of the image from offset, read into the buffer slot unless it holds them already, NULL if that failed
+static const uint8_t *fetch(fw_image *image, int slot, size_t offset, size_t len) {
+    if (image->mem)
+        return image->mem + offset;
+    const miotyAtFwUpdate_source *src = image->src;
+    uint8_t *buf = src->buffer + (size_t)slot * (src->sizeBuffer / 2);
+    if (image->len[slot] > 0 && image->offset[slot] == offset && image->len[slot] >= len)
+        return buf;
+    image->offset[slot] = offset;
+    image->len[slot] = 0;
+    size_t got = 0;
+    while (got < len) {
+        size_t n = len - got;
+        if (!src->read(src->user, offset + got, buf + got, &n) || n == 0)
+            return NULL;
+        got += n;
+    }
+    image->len[slot] = len;
+    return buf;
+}
+
+// next received byte, BYTE_TIMEOUT or BYTE_READ_FAILED
+static int read_byte(miotyAtClient_ctx *ctx, uint32_t deadline) {
+    for (;;) {
+        uint8_t c;
+        size_t len = 1;
+        if (!ctx->read(ctx->user, &c, &len))
+            return BYTE_READ_FAILED;
+        if (len == 1)
+            return c;
+        if ((int32_t)(ctx->clock(ctx->user) - deadline) >= 0)
+            return BYTE_TIMEOUT;
+        if (ctx->idle)
+            ctx->idle(ctx->user);
+    }
+}
+
+// waits and drops everything received meanwhile, false if reading failed
+static bool settle(miotyAtClient_ctx *ctx, uint32_t ms) {
+    uint32_t deadline = ctx->clock(ctx->user) + ms;
+    int c;
+    while ((c = read_byte(ctx, deadline)) >= 0)
+        ;
+    return c == BYTE_TIMEOUT;
+}
+
+static void write_bytes(miotyAtClient_ctx *ctx, const void *data, size_t len) {
+    if (ctx->writev) {
+        miotyAtClient_iovec iov = { data, len };
+        ctx->writev(ctx->user, &iov, 1);
+    } else {
+        ctx->write(ctx->user, data, len);
+    }
+}
+
+// writes header, data straight from the image, padding and CRC
+static void write_block(miotyAtClient_ctx *ctx, uint8_t seq, const uint8_t *data, size_t len, size_t blockSize) {
+    uint8_t header[3] = { blockSize == BLOCK_SIZE_1K ? XM_STX : XM_SOH, seq, (uint8_t)~seq };
+    uint8_t pad[BLOCK_SIZE];
+    size_t padLen = blockSize - len;    // less than BLOCK_SIZE, see the choice of blockSize
+    uint16_t crc = crc16_xmodem(0, data, len);
+    if (padLen > 0) {
+        memset(pad, XM_PAD, padLen);
+        crc = crc16_xmodem(crc, pad, padLen);
+    }
+    uint8_t trailer[2] = { (uint8_t)(crc >> 8), (uint8_t)crc };
+
+    if (ctx->writev) {
+        miotyAtClient_iovec iov[4] = { { header, sizeof(header) }, { data, len } };
+        size_t count = 2;
+        if (padLen > 0)
+            iov[count++] = (miotyAtClient_iovec){ pad, padLen };
+        iov[count++] = (miotyAtClient_iovec){ trailer, sizeof(trailer) };
+        /* the callback may take no more than MIOTYATCLIENT_WRITEV_MAX pieces */
+        for (size_t i = 0; i < count; i += MIOTYATCLIENT_WRITEV_MAX)
+            ctx->writev(ctx->user, &iov[i], count - i < MIOTYATCLIENT_WRITEV_MAX ? count - i : MIOTYATCLIENT_WRITEV_MAX);
+    } else {
+        ctx->write(ctx->user, header, sizeof(header));
+        ctx->write(ctx->user, data, len);
+        if (padLen > 0)
+            ctx->write(ctx->user, pad, padLen);
+        ctx->write(ctx->user, trailer, sizeof(trailer));
+    }
+}
+
+// waits for the answer to a block or the end of transmission, other bytes are noise, so is a request unless expected
+static int await_answer(miotyAtClient_ctx *ctx, uint32_t timeoutMs, bool request) {
+    uint32_t deadline = ctx->clock(ctx->user) + timeoutMs;
+    bool cancel = false;
+    for (;;) {
+        int c = read_byte(ctx, deadline);
+        switch (c) {
+        case XM_ACK:
+            return ANSWER_ACK;
+        case XM_NAK:
+            return ANSWER_NAK;
+        case XM_CAN:
+            /* a single CAN may be noise, the receiver cancels with two */
+            if (cancel)
+                return ANSWER_CANCEL;
+            cancel = true;
+            continue;
+        case XM_CRC:
+            if (request)
+                return ANSWER_REQUEST;
+            break;
+        case BYTE_TIMEOUT:
+            return ANSWER_TIMEOUT;
+        case BYTE_READ_FAILED:
+            return ANSWER_READ_FAILED;
+        default:
+            break;
+        }
+        cancel = false;
+    }
+}
+
+// restores the AT baud rate and maps the status to a return code
+static miotyAtClient_returnCode finish(const miotyAtFwUpdate_config *cfg, miotyAtFwUpdate_result *result,
+                                       miotyAtFwUpdate_status status) {
+    result->status = status;
+    if (cfg->setBaud)
+        cfg->setBaud(cfg->user, cfg->appBaud);
+    switch (status) {
+    case MIOTYATFWUPDATE_STATUS_OK:
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    case MIOTYATFWUPDATE_STATUS_NO_START:
+        return MIOTYATCLIENT_RETURN_CODE_Timeout;
+    case MIOTYATFWUPDATE_STATUS_TRANSPORT:
+        return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+    case MIOTYATFWUPDATE_STATUS_SOURCE:
+        return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+    default:
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    }
+}
+
+// walks the tags of a .gbl image and checks the CRC of its end tag
+static miotyAtClient_returnCode inspect(fw_image *image, const char *name, miotyAtFwUpdate_imageInfo *info) {
+    memset(info, 0, sizeof(*info));
+    size_t offset = 0;
+    const uint8_t *p;
+    for (;;) {
+        if (image->size - offset < GBL_TAG_HEAD_SIZE)
+            return MIOTYATCLIENT_RETURN_CODE_ERR;
+        if (!(p = fetch(image, 0, offset, GBL_TAG_HEAD_SIZE)))
+            return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+        uint32_t tag = get_le32(p);
+        uint32_t len = get_le32(p + 4);
+        size_t data = offset + GBL_TAG_HEAD_SIZE;
+        if (len > image->size - data || (info->tagCount == 0) != (tag == GBL_TAG_HEADER))
+            return MIOTYATCLIENT_RETURN_CODE_ERR;
+        info->tagCount++;
+
+        if (tag == GBL_TAG_END) {
+            if (len != 4 || data + len != image->size)
+                return MIOTYATCLIENT_RETURN_CODE_ERR;
+            break;
+        }
+        if (tag == GBL_TAG_HEADER && len >= 4) {
+            if (!(p = fetch(image, 0, data, 4)))
+                return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+            info->gblVersion = get_le32(p);
+        } else if (tag == GBL_TAG_APPLICATION && len >= 8) {
+            /* type, version, capabilities and product id */
+            if (!(p = fetch(image, 0, data, 8)))
+                return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+            uint32_t version = get_le32(p + 4);
+            info->version.major = (uint16_t)(version >> 24);
+            info->version.minor = (uint16_t)((version >> 16) & 0xFF);
+            info->version.patch = (uint16_t)(version & 0xFFFF);
+            info->hasVersion = true;
+            info->tags |= MIOTYATFWUPDATE_GBL_APPLICATION;
+        } else if (tag == GBL_TAG_BOOTLOADER) {
+            info->tags |= MIOTYATFWUPDATE_GBL_BOOTLOADER;
+        } else if (tag == GBL_TAG_ENC_INIT || tag == GBL_TAG_ENC_DATA) {
+            info->tags |= MIOTYATFWUPDATE_GBL_ENCRYPTED;
+        } else if (tag == GBL_TAG_SIGNATURE) {
+            info->tags |= MIOTYATFWUPDATE_GBL_SIGNED;
+        }
+        offset = data + len;
+    }
+
+    /* the CRC covers everything up to the CRC itself, read in chunks the size of a block buffer */
+    const size_t end = image->size - 4;
+    const size_t chunk = image->mem ? end : image->src->sizeBuffer / 2;
+    uint32_t crc = 0;
+    for (size_t pos = 0; pos < end; pos += chunk) {
+        size_t n = end - pos < chunk ? end - pos : chunk;
+        if (!(p = fetch(image, 0, pos, n)))
+            return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+        crc = crc32_update(crc, p, n);
+    }
+    if (!(p = fetch(image, 0, end, 4)))
+        return MIOTYATCLIENT_RETURN_CODE_ATReadFailed;
+    if (get_le32(p) != crc)
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+
+    if (!info->hasVersion && name && name_version(name, &info->version)) {
+        info->hasVersion = true;
+        info->versionFromName = true;
+    }
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+// last major.minor.patch in a file name that is not part of a longer number
+static bool name_version(const char *name, miotyAtInfo_version *version) {
+    const size_t len = strlen(name);
+    bool found = false;
+    for (size_t i = 0; i < len; i++) {
+        if (name[i] < '0' || name[i] > '9' || (i > 0 && ((name[i - 1] >= '0' && name[i - 1] <= '9') || name[i - 1] == '.')))
+            continue;
+        miotyAtInfo_version v;
+        size_t n = miotyAtInfo_parseVersion(name + i, len - i, &v);
+        size_t dots = 0;
+        for (size_t k = i; k < i + n; k++)
+            dots += name[k] == '.';
+        if (dots == 2) {
+            *version = v;
+            found = true;
+        }
+    }
+    return found;
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
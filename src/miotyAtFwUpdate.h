@@ -0,0 +1,247 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Firmware update of a m.YON modem: bootloader start, baud rate switch and XMODEM transfer.
+ *
+ * \ref miotyAtFwUpdate_run restarts the modem into its bootloader with AT-SBTL, switches the UART to
+ * the bootloader baud rate and sends the .gbl image with XMODEM-CRC. With block1k the image is sent
+ * in XMODEM-1K blocks of 1024 bytes; if the bootloader refuses the first of them the transfer falls
+ * back to 128 byte blocks by itself. Blocks are written straight from the image with the gather write
+ * callback if the context has one, the CRC-16 is table driven.
+ *
+ * \ref miotyAtFwUpdate_runSource reads the image block by block from a callback instead, e.g. from SPI
+ * flash, an SD card or a file, into two block buffers: the next block is read while the current one is
+ * sent and stored by the bootloader.
+ *
+ * A transfer interrupted e.g. by a restart of the host can be resumed while the bootloader still waits
+ * for the next block: pass the result of the interrupted run, which may be kept in non-volatile memory,
+ * as cfg->resume. If the bootloader requests a new transfer instead, the image is sent from the start.
+ *
+ * With cfg->imageVersion the firmware version of the modem is read with ATI first and the update is
+ * skipped if it runs that version already. \ref miotyAtFwUpdate_inspect checks a .gbl image and finds
+ * its version, in the application tag if that is not encrypted, in the file name otherwise.
+ *
+ * The transfer uses the transport callbacks and the clock of the client context directly, so the
+ * context needs a read callback and a clock, and no command may be queued meanwhile.
+ */
+
+#ifndef _AT_FW_UPDATE_H
+#define _AT_FW_UPDATE_H
+
+#include "miotyAtClient.h"
+#include "miotyAtInfo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Switches the UART of the modem to another baud rate, e.g. Serial.end() and Serial.begin(baud)
+ *
+ * @param[in]   user    User pointer of \ref miotyAtFwUpdate_config
+ * @param[in]   baud    New baud rate
+ */
+typedef void (*miotyAtFwUpdate_baudFn)(void *user, uint32_t baud);
+
+/**
+ * @brief Called after every block acknowledged by the bootloader, e.g. for a progress bar
+ *
+ * @param[in]   user        User pointer of \ref miotyAtFwUpdate_config
+ * @param[in]   sent        Bytes of the image acknowledged so far
+ * @param[in]   size        Size of the image
+ * @param[in]   blockMs     Time from writing the block to its acknowledge, retries included
+ */
+typedef void (*miotyAtFwUpdate_progressFn)(void *user, size_t sent, size_t size, uint32_t blockMs);
+
+/**
+ * @brief Reads a piece of the firmware image
+ *
+ * @param[in]       user        User pointer of \ref miotyAtFwUpdate_source
+ * @param[in]       offset      Position in the image
+ * @param[out]      data        Buffer for the piece
+ * @param[in,out]   len_out     Size of the piece, set to the number of bytes read, at least 1
+ *
+ * @return      false if reading failed
+ */
+typedef bool (*miotyAtFwUpdate_readFn)(void *user, size_t offset, uint8_t *data, size_t *len_out);
+
+/** Firmware image read block by block by \ref miotyAtFwUpdate_runSource */
+typedef struct miotyAtFwUpdate_source {
+    miotyAtFwUpdate_readFn  read;
+    void                   *user;           // handed to read
+    size_t                  size;           // of the image
+    uint8_t                *buffer;         // two block buffers, 256 bytes, 2048 bytes for XMODEM-1K
+    size_t                  sizeBuffer;
+} miotyAtFwUpdate_source;
+
+struct miotyAtFwUpdate_result;
+
+/** Settings of \ref miotyAtFwUpdate_run, see \ref miotyAtFwUpdate_defaultConfig */
+typedef struct miotyAtFwUpdate_config {
+    uint32_t                    bootBaud;       // baud rate of the bootloader
+    uint32_t                    appBaud;        // baud rate of the AT interface, restored afterwards
+    miotyAtFwUpdate_baudFn      setBaud;        // NULL if the UART is not switched
+    miotyAtFwUpdate_progressFn  progress;       // may be NULL
+    void                       *user;           // handed to setBaud and progress
+    bool                        block1k;        // try XMODEM-1K blocks
+    bool                        inBootloader;   // the bootloader runs already, e.g. started with SAFEBOOT
+    uint8_t                     maxRetries;     // per block and for the end of transmission
+    uint32_t                    settleMs;       // wait after the CR that ends a bootloader left running
+    uint32_t                    startTimeoutMs; // wait for the bootloader to request the transfer
+    uint32_t                    blockTimeoutMs; // wait for the acknowledge of a block
+    const struct miotyAtFwUpdate_result *resume;    // interrupted run to continue, NULL to start over
+    const miotyAtInfo_version  *imageVersion;   // skip the update if the modem runs it, NULL to update always
+} miotyAtFwUpdate_config;
+
+/** Step a firmware update ended in */
+typedef enum miotyAtFwUpdate_status {
+    MIOTYATFWUPDATE_STATUS_OK           = 0,    // image transferred and acknowledged
+    MIOTYATFWUPDATE_STATUS_BOOTLOADER   = 1,    // AT-SBTL failed
+    MIOTYATFWUPDATE_STATUS_NO_START     = 2,    // the bootloader did not request the transfer
+    MIOTYATFWUPDATE_STATUS_BLOCK        = 3,    // a block was not acknowledged within maxRetries
+    MIOTYATFWUPDATE_STATUS_CANCELLED    = 4,    // the bootloader cancelled the transfer
+    MIOTYATFWUPDATE_STATUS_END          = 5,    // the end of transmission was not acknowledged
+    MIOTYATFWUPDATE_STATUS_TRANSPORT    = 6,    // the read callback failed
+    MIOTYATFWUPDATE_STATUS_SOURCE       = 7,    // reading the image failed
+    MIOTYATFWUPDATE_STATUS_SKIPPED      = 8,    // the modem runs cfg->imageVersion already
+} miotyAtFwUpdate_status;
+
+/** Outcome of \ref miotyAtFwUpdate_run */
+typedef struct miotyAtFwUpdate_result {
+    miotyAtFwUpdate_status  status;
+    size_t                  bytesSent;      // of the image, acknowledged by the bootloader, resumed ones included
+    uint32_t                blocks;         // acknowledged, resumed ones included
+    uint16_t                blockSize;      // used at the end, 128 or 1024
+    bool                    fallback;       // XMODEM-1K was refused, 128 byte blocks were used
+    bool                    resumed;        // continued an interrupted transfer
+    uint32_t                retries;        // blocks sent again after a NAK or timeout
+    uint32_t                startMs;        // from AT-SBTL to the transfer request of the bootloader
+    uint32_t                transferMs;     // from the first block to the acknowledged end of transmission
+    uint32_t                blockMsMin;     // per block latency, from writing it to its acknowledge
+    uint32_t                blockMsMax;
+    uint32_t                blockMsAvg;
+    miotyAtInfo_version     modemVersion;   // firmware before the update if read for cfg->imageVersion, 0.0.0 otherwise
+} miotyAtFwUpdate_result;
+
+/** Tags of a .gbl image, see \ref miotyAtFwUpdate_imageInfo */
+#define MIOTYATFWUPDATE_GBL_APPLICATION     0x01    // application tag with version, not encrypted
+#define MIOTYATFWUPDATE_GBL_BOOTLOADER      0x02    // bootloader upgrade
+#define MIOTYATFWUPDATE_GBL_ENCRYPTED       0x04    // encryption init and encrypted data tags
+#define MIOTYATFWUPDATE_GBL_SIGNED          0x08    // signature tag
+
+/** Outcome of \ref miotyAtFwUpdate_inspect */
+typedef struct miotyAtFwUpdate_imageInfo {
+    uint32_t                gblVersion;     // of the file format, from the header tag
+    uint32_t                tagCount;       // header and end tag included
+    uint8_t                 tags;           // MIOTYATFWUPDATE_GBL_xxx found
+    bool                    hasVersion;     // version is valid
+    bool                    versionFromName;    // version was taken from the file name
+    miotyAtInfo_version     version;        // of the firmware in the image
+} miotyAtFwUpdate_imageInfo;
+
+/**
+ * @brief Fill a configuration with the settings of the m.YON: bootloader at 115200, AT at 9600 baud,
+ *        128 byte blocks, 10 retries, 500 ms settle time, 10 s start and 5 s block timeout
+ */
+void miotyAtFwUpdate_defaultConfig(miotyAtFwUpdate_config *cfg);
+
+/**
+ * @brief Update the firmware of the modem of a client context, blocks until done
+ *
+ * @param[in,out]   ctx     Client context with read callback and clock, no command may be queued
+ * @param[in]       cfg     Settings, NULL for \ref miotyAtFwUpdate_defaultConfig
+ * @param[in]       image   Firmware image, e.g. the content of a .gbl file
+ * @param[in]       size    Size of image
+ * @param[out]      result  Outcome, may be NULL
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK if the image was transferred or the modem runs cfg->imageVersion already,
+ *              MIOTYATCLIENT_RETURN_CODE_ArgumentOOR if the context has no read callback or clock or the image is empty,
+ *              MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished if commands are queued,
+ *              the return code of AT-SBTL if it failed,
+ *              MIOTYATCLIENT_RETURN_CODE_Timeout if the bootloader did not answer,
+ *              MIOTYATCLIENT_RETURN_CODE_ATReadFailed if reading failed,
+ *              MIOTYATCLIENT_RETURN_CODE_ERR if the bootloader refused the image, see result->status
+ */
+miotyAtClient_returnCode miotyAtFwUpdate_run(miotyAtClient_ctx *ctx, const miotyAtFwUpdate_config *cfg,
+                                             const uint8_t *image, size_t size, miotyAtFwUpdate_result *result);
+
+/**
+ * @brief Update the firmware of the modem of a client context with an image read from a callback, blocks until done
+ *
+ * Like \ref miotyAtFwUpdate_run, XMODEM-1K is only tried with buffers for two 1024 byte blocks.
+ *
+ * @param[in,out]   ctx     Client context with read callback and clock, no command may be queued
+ * @param[in]       cfg     Settings, NULL for \ref miotyAtFwUpdate_defaultConfig
+ * @param[in]       source  Image
+ * @param[out]      result  Outcome, may be NULL
+ *
+ * @return      see \ref miotyAtFwUpdate_run, MIOTYATCLIENT_RETURN_CODE_ArgumentOOR also if the buffers are too small,
+ *              MIOTYATCLIENT_RETURN_CODE_ATReadFailed also if reading the image failed
+ */
+miotyAtClient_returnCode miotyAtFwUpdate_runSource(miotyAtClient_ctx *ctx, const miotyAtFwUpdate_config *cfg,
+                                                   const miotyAtFwUpdate_source *source, miotyAtFwUpdate_result *result);
+
+/**
+ * @brief Check the structure of a .gbl image and find the version of its firmware
+ *
+ * Walks the tags of the image, which must start with the header tag and end with the end tag, and
+ * checks the CRC-32 of the end tag. The version is taken from the application tag, in which it is
+ * stored as major in the high byte, minor in the next one and patch in the low 16 bits. Encrypted
+ * images like the m.YON releases hide that tag, their version is taken from the name of the file
+ * instead, the last "major.minor.patch" in it, e.g. 1.3.0 in "0544930_FW_m.YON_bidi_1.3.0.gbl".
+ *
+ * @param[in]   image   Image
+ * @param[in]   size    Size of image
+ * @param[in]   name    File name or path of the image, may be NULL
+ * @param[out]  info    Tags and version found
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK if the image is valid, its version may still be unknown,
+ *              MIOTYATCLIENT_RETURN_CODE_ERR if it is not a .gbl image or damaged
+ */
+miotyAtClient_returnCode miotyAtFwUpdate_inspect(const uint8_t *image, size_t size, const char *name,
+                                                 miotyAtFwUpdate_imageInfo *info);
+
+/**
+ * @brief \ref miotyAtFwUpdate_inspect for an image read from a callback, the buffers of source are used for the CRC
+ *
+ * @return      see \ref miotyAtFwUpdate_inspect, MIOTYATCLIENT_RETURN_CODE_ArgumentOOR if source has no buffers,
+ *              MIOTYATCLIENT_RETURN_CODE_ATReadFailed if reading the image failed
+ */
+miotyAtClient_returnCode miotyAtFwUpdate_inspectSource(const miotyAtFwUpdate_source *source, const char *name,
+                                                       miotyAtFwUpdate_imageInfo *info);
+
+#if defined(__unix__) || defined(__APPLE__)
+/**
+ * @brief \ref miotyAtFwUpdate_readFn reading a file with pread(), user points to its int file descriptor
+ */
+bool miotyAtFwUpdate_readFile(void *user, size_t offset, uint8_t *data, size_t *len_out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Parsers of the ATI and AT-LIBV answers.
+ */
+
+#include <string.h>
+#include "miotyAtInfo.h"
+
+/* longest answer read by miotyAtInfo_readEpInfo and miotyAtInfo_readCoreLibInfo */
+#define INFO_BUFFER_SIZE    MIOTYATCLIENT_SNAPSHOT_INFO_SIZE
+
+static bool is_space(char c);
+static size_t parse_part(const char *str, size_t len, uint16_t *part);
+static void copy_name(char *dest, const char *str, size_t len);
+
+
+size_t miotyAtInfo_parseVersion(const char *str, size_t len, miotyAtInfo_version *version) {
+    uint16_t parts[3] = { 0 };
+    size_t pos = 0;
+    int count = 0;
+    while (count < 3) {
+        size_t n = parse_part(str + pos, len - pos, &parts[count]);
+        if (n == 0)
+            break;
+        /* "1." without a digit after the dot ends before the dot */
+        pos += n;
+        count++;
+        if (count == 3 || pos + 1 >= len || str[pos] != '.' || str[pos + 1] < '0' || str[pos + 1] > '9')
+            break;
+        pos++;
+    }
+    /* a single number is no version, nor is one with an overlong part */
+    if (count < 2 || (pos < len && str[pos] >= '0' && str[pos] <= '9'))
+        return 0;
+    version->major = parts[0];
+    version->minor = parts[1];
+    version->patch = parts[2];
+    return pos;
+}
+
+int miotyAtInfo_compareVersion(const miotyAtInfo_version *a, const miotyAtInfo_version *b) {
+    if (a->major != b->major)
+        return a->major < b->major ? -1 : 1;
+    if (a->minor != b->minor)
+        return a->minor < b->minor ? -1 : 1;
+    if (a->patch != b->patch)
+        return a->patch < b->patch ? -1 : 1;
+    return 0;
+}
+
+bool miotyAtInfo_parseEpInfo(const char *str, size_t len, miotyAtInfo_epInfo *info) {
+    memset(info, 0, sizeof(*info));
+    size_t pos = 0;
+    int word = 0;
+    while (pos < len) {
+        while (pos < len && is_space(str[pos]))
+            pos++;
+        size_t start = pos;
+        while (pos < len && !is_space(str[pos]))
+            pos++;
+        size_t n = pos - start;
+        if (n == 0)
+            break;
+
+        const char *w = str + start;
+        miotyAtInfo_version *version = NULL;
+        uint8_t field = 0;
+        if (n > 3 && w[2] == ':') {
+            if (w[0] == 'F' && w[1] == 'W') {
+                version = &info->fw;
+                field = MIOTYATINFO_EP_FW;
+            } else if (w[0] == 'H' && w[1] == 'W') {
+                version = &info->hw;
+                field = MIOTYATINFO_EP_HW;
+            } else if (w[0] == 'A' && w[1] == 'T') {
+                version = &info->at;
+                field = MIOTYATINFO_EP_AT;
+            }
+        }
+        if (version) {
+            if (miotyAtInfo_parseVersion(w + 3, n - 3, version) == n - 3)
+                info->fields |= field;
+            else
+                memset(version, 0, sizeof(*version));
+        } else if (word == 0) {
+            copy_name(info->vendor, w, n);
+        } else if (word == 1) {
+            copy_name(info->product, w, n);
+        }
+        word++;
+    }
+    return (info->fields & MIOTYATINFO_EP_FW) != 0;
+}
+
+bool miotyAtInfo_parseCoreLibInfo(const char *str, size_t len, miotyAtInfo_coreLibInfo *info) {
+    memset(info, 0, sizeof(*info));
+    while (len > 0 && is_space(str[len - 1]))
+        len--;
+    size_t start = len;
+    while (start > 0 && !is_space(str[start - 1]))
+        start--;
+    if (start == len || miotyAtInfo_parseVersion(str + start, len - start, &info->version) != len - start) {
+        memset(&info->version, 0, sizeof(info->version));
+        return false;
+    }
+    size_t end = start;
+    while (end > 0 && is_space(str[end - 1]))
+        end--;
+    size_t begin = 0;
+    while (begin < end && is_space(str[begin]))
+        begin++;
+    copy_name(info->name, str + begin, end - begin);
+    return true;
+}
+
+miotyAtClient_returnCode miotyAtInfo_readEpInfo(miotyAtClient_ctx *ctx, miotyAtInfo_epInfo *info) {
+    uint8_t buffer[INFO_BUFFER_SIZE];
+    size_t size = sizeof(buffer);
+    memset(info, 0, sizeof(*info));
+    miotyAtClient_returnCode ret = miotyAtClient_getEpInfo_ex(ctx, buffer, &size);
+    if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
+        return ret;
+    if (!miotyAtInfo_parseEpInfo((const char *)buffer, size, info))
+        return MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar;
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+miotyAtClient_returnCode miotyAtInfo_readCoreLibInfo(miotyAtClient_ctx *ctx, miotyAtInfo_coreLibInfo *info) {
+    uint8_t buffer[INFO_BUFFER_SIZE];
+    size_t size = sizeof(buffer);
+    memset(info, 0, sizeof(*info));
+    miotyAtClient_returnCode ret = miotyAtClient_getCoreLibInfo_ex(ctx, buffer, &size);
+    if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
+        return ret;
+    if (!miotyAtInfo_parseCoreLibInfo((const char *)buffer, size, info))
+        return MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar;
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\0';
+}
+
+// digits of one part of a version, 0 if there are none or the part exceeds 65535
+static size_t parse_part(const char *str, size_t len, uint16_t *part) {
+    uint32_t value = 0;
+    size_t pos = 0;
+    while (pos < len && str[pos] >= '0' && str[pos] <= '9') {
+        value = value * 10 + (uint32_t)(str[pos] - '0');
+        if (value > 0xFFFF)
+            return 0;
+        pos++;
+    }
+    *part = (uint16_t)value;
+    return pos;
+}
+
+static void copy_name(char *dest, const char *str, size_t len) {
+    if (len >= MIOTYATINFO_NAME_SIZE)
+        len = MIOTYATINFO_NAME_SIZE - 1;
+    memcpy(dest, str, len);
+    dest[len] = '\0';
+}
@@ -0,0 +1,142 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Versions of a m.YON modem, parsed from the answers of ATI and AT-LIBV.
+ *
+ * ATI answers e.g. "Swissphone m.YON_bidi FW:1.3.0 HW:1.0 AT:2.2.0", AT-LIBV "MIOTY EP lib 2.2.0".
+ * The parsers work on the strings returned by \ref miotyAtClient_getEpInfo_ex and
+ * \ref miotyAtClient_getCoreLibInfo_ex or stored in \ref miotyAtClient_snapshot, the read functions
+ * run the command and parse its answer at once.
+ */
+
+#ifndef _AT_INFO_H
+#define _AT_INFO_H
+
+#include "miotyAtClient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of the name strings of \ref miotyAtInfo_epInfo and \ref miotyAtInfo_coreLibInfo, including the terminating NUL */
+#define MIOTYATINFO_NAME_SIZE   24
+
+/** Version number major.minor.patch, patch is 0 for versions with two parts like HW:1.0 */
+typedef struct miotyAtInfo_version {
+    uint16_t    major;
+    uint16_t    minor;
+    uint16_t    patch;
+} miotyAtInfo_version;
+
+/** Fields found in an ATI answer, see \ref miotyAtInfo_epInfo */
+#define MIOTYATINFO_EP_FW       0x01    // FW:
+#define MIOTYATINFO_EP_HW       0x02    // HW:
+#define MIOTYATINFO_EP_AT       0x04    // AT:
+
+/** ATI answer, parsed by \ref miotyAtInfo_parseEpInfo */
+typedef struct miotyAtInfo_epInfo {
+    char                vendor[MIOTYATINFO_NAME_SIZE];  // e.g. "Swissphone", NUL terminated, truncated if longer
+    char                product[MIOTYATINFO_NAME_SIZE]; // e.g. "m.YON_bidi"
+    miotyAtInfo_version fw;             // firmware
+    miotyAtInfo_version hw;             // hardware
+    miotyAtInfo_version at;             // AT protocol
+    uint8_t             fields;         // MIOTYATINFO_EP_xxx of the versions found
+} miotyAtInfo_epInfo;
+
+/** AT-LIBV answer, parsed by \ref miotyAtInfo_parseCoreLibInfo */
+typedef struct miotyAtInfo_coreLibInfo {
+    char                name[MIOTYATINFO_NAME_SIZE];    // e.g. "MIOTY EP lib", NUL terminated, truncated if longer
+    miotyAtInfo_version version;
+} miotyAtInfo_coreLibInfo;
+
+/**
+ * @brief Parse a version number with two or three parts, e.g. "1.3.0" or "1.0"
+ *
+ * @param[in]   str     Characters, the version must start at the first one
+ * @param[in]   len     Number of characters
+ * @param[out]  version Version, undefined if 0 is returned
+ *
+ * @return      number of characters of the version, 0 if str does not start with one or a part exceeds 65535
+ */
+size_t miotyAtInfo_parseVersion(const char *str, size_t len, miotyAtInfo_version *version);
+
+/**
+ * @brief Compare two versions
+ *
+ * @return      negative if a is older than b, 0 if they are equal, positive if a is newer
+ */
+int miotyAtInfo_compareVersion(const miotyAtInfo_version *a, const miotyAtInfo_version *b);
+
+/**
+ * @brief Parse an ATI answer
+ *
+ * The answer is split at spaces: the first word is the vendor, the second the product; "FW:", "HW:"
+ * and "AT:" words give the versions, in any order, unknown words are skipped.
+ *
+ * @param[in]   str     ATI answer, need not be NUL terminated
+ * @param[in]   len     Number of characters
+ * @param[out]  info    Parsed answer
+ *
+ * @return      false if the answer has no firmware version
+ */
+bool miotyAtInfo_parseEpInfo(const char *str, size_t len, miotyAtInfo_epInfo *info);
+
+/**
+ * @brief Parse an AT-LIBV answer: the name up to the last word, which is the version
+ *
+ * @param[in]   str     AT-LIBV answer, need not be NUL terminated
+ * @param[in]   len     Number of characters
+ * @param[out]  info    Parsed answer
+ *
+ * @return      false if the answer does not end with a version
+ */
+bool miotyAtInfo_parseCoreLibInfo(const char *str, size_t len, miotyAtInfo_coreLibInfo *info);
+
+/**
+ * @brief Read and parse the end-point information (ATI)
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[out]      info    Parsed answer
+ *
+ * @return      the return code of ATI, MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar if the answer has no firmware version
+ */
+miotyAtClient_returnCode miotyAtInfo_readEpInfo(miotyAtClient_ctx *ctx, miotyAtInfo_epInfo *info);
+
+/**
+ * @brief Read and parse the end-point core lib information (AT-LIBV)
+ *
+ * @param[in,out]   ctx     Client context
+ * @param[out]      info    Parsed answer
+ *
+ * @return      the return code of AT-LIBV, MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar if the answer does not end with a version
+ */
+miotyAtClient_returnCode miotyAtInfo_readCoreLibInfo(miotyAtClient_ctx *ctx, miotyAtInfo_coreLibInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
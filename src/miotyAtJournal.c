@@ -0,0 +1,280 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Crash-safe store-and-forward journal of unidirectional uplinks, backed by a memory-mapped file.
+ *
+ * File layout: a header with the geometry, then slotCount records of slotSize bytes. Record seq is
+ * stored in slot seq % slotCount. The checksum covers the immutable part of a record; the state
+ * and the packet counters are changed with single aligned stores afterwards.
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "miotyAtJournal.h"
+#include "data_tools/crc32.h"
+
+#define JOURNAL_MAGIC       0x4A4E594Du     // "MYNJ"
+#define JOURNAL_VERSION     1
+
+enum {
+    RECORD_EMPTY     = 0,
+    RECORD_PENDING   = 1,       // appended, not written to the modem
+    RECORD_SENDING   = 2,       // written to the modem, counterBefore is valid
+    RECORD_COMMITTED = 3,       // completed, counter is valid
+};
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    version;
+    uint32_t    slotCount;
+    uint32_t    slotSize;
+    uint32_t    maxMsgSize;
+    uint32_t    checksum;       // of the members above
+} journal_header;
+
+typedef struct {
+    uint32_t    seq;
+    uint32_t    checksum;       // of seq, sizeMsg, type and msg
+    uint16_t    sizeMsg;
+    uint8_t     type;
+    uint8_t     state;          // RECORD_*
+    uint32_t    counterBefore;  // modem packet counter before the uplink was written
+    uint32_t    counter;        // -MPCT: of the completed uplink
+    uint8_t     msg[];
+} journal_record;
+
+#define HEADER_SIZE     64
+
+static uint32_t record_checksum(const journal_record *rec);
+static journal_record *record_at(const miotyAtJournal *journal, uint32_t seq);
+static void set_state(miotyAtJournal *journal, journal_record *rec, uint8_t state);
+static void sync_range(const miotyAtJournal *journal, const void *start, size_t len);
+static miotyAtClient_returnCode read_counter(miotyAtJournal *journal);
+static void commit(miotyAtJournal *journal, journal_record *rec, uint32_t counter);
+
+
+miotyAtClient_returnCode miotyAtJournal_open(miotyAtJournal *journal, miotyAtClient_ctx *ctx, const char *path,
+                                             uint32_t slotCount, uint32_t maxMsgSize, bool sync) {
+    memset(journal, 0, sizeof(*journal));
+    journal->fd = -1;
+    journal->ctx = ctx;
+    journal->sync = sync;
+
+    journal->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (journal->fd < 0)
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    struct stat st;
+    if (fstat(journal->fd, &st) != 0)
+        goto fail;
+
+    /* a crash while the file was created leaves it empty or with a zero header, both are created anew */
+    static const journal_header blank;
+    journal_header header = blank;
+    if (st.st_size > 0 && pread(journal->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+        goto fail;
+    if (memcmp(&header, &blank, sizeof(header)) == 0) {
+        if (slotCount == 0 || maxMsgSize == 0 || maxMsgSize > UINT16_MAX) {
+            miotyAtJournal_close(journal);
+            return MIOTYATCLIENT_RETURN_CODE_ArgumentOOR;
+        }
+        header.magic = JOURNAL_MAGIC;
+        header.version = JOURNAL_VERSION;
+        header.slotCount = slotCount;
+        header.slotSize = (sizeof(journal_record) + maxMsgSize + 7) & ~7u;
+        header.maxMsgSize = maxMsgSize;
+        header.checksum = crc32_update(0, (const uint8_t *)&header, offsetof(journal_header, checksum));
+        if (ftruncate(journal->fd, 0) != 0
+            || ftruncate(journal->fd, HEADER_SIZE + (off_t)header.slotCount * header.slotSize) != 0
+            || pwrite(journal->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+            goto fail;
+        if (sync)
+            fsync(journal->fd);
+    } else if (header.magic != JOURNAL_MAGIC || header.version != JOURNAL_VERSION
+               || header.checksum != crc32_update(0, (const uint8_t *)&header, offsetof(journal_header, checksum))
+               || st.st_size < HEADER_SIZE + (off_t)header.slotCount * header.slotSize) {
+        goto fail;
+    }
+
+    journal->slotCount = header.slotCount;
+    journal->slotSize = header.slotSize;
+    journal->maxMsgSize = header.maxMsgSize;
+    journal->mapSize = HEADER_SIZE + (size_t)header.slotCount * header.slotSize;
+    void *map = mmap(NULL, journal->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, journal->fd, 0);
+    if (map == MAP_FAILED)
+        goto fail;
+    journal->map = map;
+
+    /* records not committed form the range [tail, head) of sequence numbers, records with a
+       broken checksum were torn by a crash during append and are free */
+    bool any = false, anyLive = false;
+    uint32_t maxSeq = 0, minLive = 0;
+    for (uint32_t i = 0; i < journal->slotCount; i++) {
+        const journal_record *rec = (const journal_record *)(journal->map + HEADER_SIZE + (size_t)i * journal->slotSize);
+        if (rec->state == RECORD_EMPTY || rec->sizeMsg > journal->maxMsgSize
+            || rec->seq % journal->slotCount != i || rec->checksum != record_checksum(rec))
+            continue;
+        if (!any || (int32_t)(rec->seq - maxSeq) > 0)
+            maxSeq = rec->seq;
+        any = true;
+        if (rec->state != RECORD_COMMITTED && (!anyLive || (int32_t)(rec->seq - minLive) < 0)) {
+            minLive = rec->seq;
+            anyLive = true;
+        }
+    }
+    journal->head = any ? maxSeq + 1 : 1;
+    journal->tail = anyLive ? minLive : journal->head;
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+
+fail:
+    miotyAtJournal_close(journal);
+    return MIOTYATCLIENT_RETURN_CODE_ERR;
+}
+
+void miotyAtJournal_close(miotyAtJournal *journal) {
+    if (journal->map) {
+        if (journal->sync)
+            msync(journal->map, journal->mapSize, MS_SYNC);
+        munmap(journal->map, journal->mapSize);
+        journal->map = NULL;
+    }
+    if (journal->fd >= 0) {
+        close(journal->fd);
+        journal->fd = -1;
+    }
+}
+
+miotyAtClient_returnCode miotyAtJournal_append(miotyAtJournal *journal, miotyAtClient_uplinkType type,
+                                               const uint8_t *msg, size_t sizeMsg) {
+    if (sizeMsg > journal->maxMsgSize)
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentSizeMismatch;
+    if (type != MIOTYATCLIENT_UPLINK_UNI && type != MIOTYATCLIENT_UPLINK_UNI_MPF && type != MIOTYATCLIENT_UPLINK_UNI_TRANSPARENT)
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentOOR;
+    if (journal->head - journal->tail >= journal->slotCount)
+        return MIOTYATCLIENT_RETURN_CODE_Dropped;
+
+    journal_record *rec = record_at(journal, journal->head);
+    rec->state = RECORD_EMPTY;
+    rec->seq = journal->head;
+    rec->sizeMsg = (uint16_t)sizeMsg;
+    rec->type = (uint8_t)type;
+    memcpy(rec->msg, msg, sizeMsg);
+    rec->checksum = record_checksum(rec);
+    set_state(journal, rec, RECORD_PENDING);
+    journal->head++;
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+miotyAtClient_returnCode miotyAtJournal_flush(miotyAtJournal *journal) {
+    while (journal->tail != journal->head) {
+        journal_record *rec = record_at(journal, journal->tail);
+        miotyAtClient_returnCode ret = read_counter(journal);
+        if (ret != MIOTYATCLIENT_RETURN_CODE_OK)
+            return ret;
+
+        /* written before a crash or a failed command: the modem counter tells whether it was sent */
+        if (rec->state == RECORD_SENDING && journal->packetCounter != rec->counterBefore) {
+            commit(journal, rec, journal->packetCounter);
+            continue;
+        }
+
+        rec->counterBefore = journal->packetCounter;
+        set_state(journal, rec, RECORD_SENDING);
+        uint32_t counter = 0;
+        miotyAtClient_ctx *ctx = journal->ctx;
+        switch (rec->type) {
+        case MIOTYATCLIENT_UPLINK_UNI_MPF:
+            ret = miotyAtClient_sendMessageUniMPF_ex(ctx, rec->msg, rec->sizeMsg, &counter);
+            break;
+        case MIOTYATCLIENT_UPLINK_UNI_TRANSPARENT:
+            ret = miotyAtClient_sendMessageUniTransparent_ex(ctx, rec->msg, rec->sizeMsg, &counter);
+            break;
+        default:
+            ret = miotyAtClient_sendMessageUni_ex(ctx, rec->msg, rec->sizeMsg, &counter);
+            break;
+        }
+        if (ret != MIOTYATCLIENT_RETURN_CODE_OK) {
+            /* the uplink may have been sent anyway, e.g. on a timeout, the counter is read again */
+            journal->packetCounterKnown = false;
+            return ret;
+        }
+        commit(journal, rec, counter);
+    }
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+size_t miotyAtJournal_pending(const miotyAtJournal *journal) {
+    return journal->head - journal->tail;
+}
+
+
+static journal_record *record_at(const miotyAtJournal *journal, uint32_t seq) {
+    return (journal_record *)(journal->map + HEADER_SIZE + (size_t)(seq % journal->slotCount) * journal->slotSize);
+}
+
+static uint32_t record_checksum(const journal_record *rec) {
+    uint32_t crc = crc32_update(0, (const uint8_t *)&rec->seq, sizeof(rec->seq));
+    crc = crc32_update(crc, (const uint8_t *)&rec->sizeMsg, sizeof(rec->sizeMsg) + sizeof(rec->type));
+    return crc32_update(crc, rec->msg, rec->sizeMsg);
+}
+
+// the state is stored last, so a record is only valid once everything else is in the file
+static void set_state(miotyAtJournal *journal, journal_record *rec, uint8_t state) {
+    __atomic_store_n(&rec->state, state, __ATOMIC_RELEASE);
+    sync_range(journal, rec, journal->slotSize);
+}
+
+static void sync_range(const miotyAtJournal *journal, const void *start, size_t len) {
+    if (!journal->sync)
+        return;
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t from = (uintptr_t)start & ~(page - 1);
+    msync((void *)from, (uintptr_t)start + len - from, MS_SYNC);
+}
+
+static miotyAtClient_returnCode read_counter(miotyAtJournal *journal) {
+    if (journal->packetCounterKnown)
+        return MIOTYATCLIENT_RETURN_CODE_OK;
+    miotyAtClient_returnCode ret = miotyAtClient_refreshPacketCounter_ex(journal->ctx, &journal->packetCounter);
+    journal->packetCounterKnown = (ret == MIOTYATCLIENT_RETURN_CODE_OK);
+    return ret;
+}
+
+static void commit(miotyAtJournal *journal, journal_record *rec, uint32_t counter) {
+    rec->counter = counter;
+    set_state(journal, rec, RECORD_COMMITTED);
+    journal->packetCounter = counter;
+    journal->packetCounterKnown = true;
+    journal->tail++;
+}
+
+#endif /* __unix__ || __APPLE__ */
@@ -0,0 +1,136 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Crash-safe store-and-forward journal of unidirectional uplinks, backed by a memory-mapped file.
+ *
+ * Uplinks are appended to a ring of fixed-size records in a file mapped with mmap, so they survive a
+ * restart of the process. \ref miotyAtJournal_flush sends them in order and marks every record as
+ * committed with the packet counter returned in -MPCT:. Before an uplink is written the modem packet
+ * counter is stored in its record; after a restart a record caught in between is committed without
+ * being sent again if the modem counter moved on, and resent otherwise. This assumes that every
+ * uplink of the modem is sent through the journal.
+ *
+ * Without sync the records survive a crash of the process, with sync also a power loss, at the cost
+ * of an msync per state change.
+ *
+ * Only available on POSIX systems (MIOTYATJOURNAL_AVAILABLE is defined then).
+ */
+
+#ifndef _AT_JOURNAL_H
+#define _AT_JOURNAL_H
+
+#include "miotyAtClient.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MIOTYATJOURNAL_AVAILABLE 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Journal file opened by \ref miotyAtJournal_open. Members are private.
+ */
+typedef struct miotyAtJournal {
+    miotyAtClient_ctx  *ctx;
+    int                 fd;
+    uint8_t            *map;
+    size_t              mapSize;
+    uint32_t            slotCount;
+    uint32_t            slotSize;
+    uint32_t            maxMsgSize;
+    uint32_t            tail;           // sequence number of the oldest record not committed
+    uint32_t            head;           // sequence number of the next record
+    uint32_t            packetCounter;  // of the modem, valid if packetCounterKnown
+    bool                packetCounterKnown;
+    bool                sync;
+} miotyAtJournal;
+
+/**
+ * @brief Open or create a journal file and find the records not committed yet
+ *
+ * An existing file keeps its geometry, slotCount and maxMsgSize are only used to create a new one.
+ * A file left empty or with a zero header by a crash during its creation is created anew.
+ *
+ * @param[out]  journal     Journal
+ * @param[in]   ctx         Client context the uplinks are sent with
+ * @param[in]   path        Journal file
+ * @param[in]   slotCount   Number of records of a new file
+ * @param[in]   maxMsgSize  Largest message of a new file
+ * @param[in]   sync        msync every change, for persistence across power loss
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK,
+ *              MIOTYATCLIENT_RETURN_CODE_ArgumentOOR if slotCount or maxMsgSize are invalid,
+ *              MIOTYATCLIENT_RETURN_CODE_ERR if the file can not be opened or is not a journal
+ */
+miotyAtClient_returnCode miotyAtJournal_open(miotyAtJournal *journal, miotyAtClient_ctx *ctx, const char *path,
+                                             uint32_t slotCount, uint32_t maxMsgSize, bool sync);
+
+/**
+ * @brief Unmap and close the journal file, records not committed stay in it
+ */
+void miotyAtJournal_close(miotyAtJournal *journal);
+
+/**
+ * @brief Append an uplink to the journal, it is sent by the next \ref miotyAtJournal_flush
+ *
+ * @param[in,out]   journal     Journal
+ * @param[in]       type        MIOTYATCLIENT_UPLINK_UNI, MIOTYATCLIENT_UPLINK_UNI_MPF or MIOTYATCLIENT_UPLINK_UNI_TRANSPARENT
+ * @param[in]       msg         Message, copied
+ * @param[in]       sizeMsg     Size of msg
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK,
+ *              MIOTYATCLIENT_RETURN_CODE_ArgumentSizeMismatch if the message is larger than the records,
+ *              MIOTYATCLIENT_RETURN_CODE_ArgumentOOR if type is not unidirectional,
+ *              MIOTYATCLIENT_RETURN_CODE_Dropped if every record holds an uplink not committed yet
+ */
+miotyAtClient_returnCode miotyAtJournal_append(miotyAtJournal *journal, miotyAtClient_uplinkType type,
+                                               const uint8_t *msg, size_t sizeMsg);
+
+/**
+ * @brief Send the uplinks not committed yet, oldest first. Blocks until all are sent or one fails.
+ *
+ * Call after \ref miotyAtJournal_open to replay the uplinks left by a previous run.
+ *
+ * @param[in,out]   journal     Journal
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK if all were sent, else the return code of the failed command,
+ *              the failed uplink is retried by the next flush
+ */
+miotyAtClient_returnCode miotyAtJournal_flush(miotyAtJournal *journal);
+
+/**
+ * @brief Number of uplinks not committed yet
+ */
+size_t miotyAtJournal_pending(const miotyAtJournal *journal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __unix__ || __APPLE__ */
+
+#endif
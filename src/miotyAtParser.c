@@ -0,0 +1,385 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Resumable single pass tokenizer for MIOTY™ AT protocol v2.x.x responses.
+ */
+
+#include <string.h>
+#include "miotyAtParser.h"
+#include "data_tools/hex_kernels.h"
+
+enum {
+    STATE_KEY,          // collecting the field name at the start of a line
+    STATE_NUMBER,       // decimal value
+    STATE_DATA_LEN,     // announced length in front of the '\t' of a hex field
+    STATE_DATA_HEX,     // hex encoded bytes
+    STATE_STRING,       // text up to the end of the line
+    STATE_SKIP,         // uninteresting rest of a line
+    STATE_LINE,         // rest of an unknown line received while idle
+    STATE_DONE,         // result line received
+};
+
+/** Bytes decoded at once in STATE_DATA_HEX */
+#define HEX_BLOCK   32
+
+enum {
+    FIELD_NONE,
+    FIELD_RESPONSE,
+    FIELD_MPCT,
+    FIELD_MSTA,
+    FIELD_DLMPF,
+    FIELD_MAC_ERR,
+    FIELD_AT_ERR,
+    FIELD_URC,
+};
+
+typedef struct {
+    const char *key;
+    uint8_t     len;
+    uint8_t     field;
+} known_field;
+
+static const known_field known_fields[] = {
+    { "-MPCT",  5, FIELD_MPCT    },
+    { "-MSTA",  5, FIELD_MSTA    },
+    { "-DLMPF", 6, FIELD_DLMPF   },
+    { "-MNFO",  5, FIELD_MAC_ERR },
+    { "-MERR",  5, FIELD_MAC_ERR },
+    { "AT!ERR", 6, FIELD_AT_ERR  },
+};
+
+static uint8_t lookup_field(miotyAtParser *parser);
+static uint8_t lookup_urc(const miotyAtParser *parser);
+static void put_line(miotyAtParser *parser, uint8_t c);
+static void start_value(miotyAtParser *parser);
+static void finish_number(miotyAtParser *parser);
+static void put_byte(miotyAtParser *parser, uint8_t b);
+static void next_line(miotyAtParser *parser);
+static int8_t hex_value(uint8_t c);
+
+
+void miotyAtParser_init(miotyAtParser *parser, const char *respKey, size_t respKeyLen,
+                        miotyAtParser_valueType type, uint8_t *out, size_t outSize) {
+    memset(parser, 0, sizeof(*parser));
+    parser->state = STATE_KEY;
+    parser->nibble = 0xFF;
+    parser->respKey = respKey;
+    parser->respKeyLen = respKey ? respKeyLen : 0;
+    parser->respType = type;
+    parser->out = out;
+    parser->outSize = out ? outSize : 0;
+    parser->result = MIOTYATPARSER_RESULT_PENDING;
+    parser->urc = MIOTYATPARSER_URC_NONE;
+}
+
+void miotyAtParser_initIdle(miotyAtParser *parser) {
+    miotyAtParser_init(parser, NULL, 0, MIOTYATPARSER_VALUE_NONE, NULL, 0);
+    parser->idle = true;
+}
+
+void miotyAtParser_setUrc(miotyAtParser *parser, const miotyAtParser_urcKey *keys, uint8_t count, bool lines,
+                          uint8_t *out, size_t outSize) {
+    parser->urcKeys = keys;
+    parser->urcCount = keys ? count : 0;
+    parser->urcLines = lines;
+    parser->urcOut = out;
+    parser->urcOutSize = out ? outSize : 0;
+}
+
+size_t miotyAtParser_feed(miotyAtParser *parser, const uint8_t *data, size_t len) {
+    size_t i;
+    size_t scalarEnd = 0;   // data before it is decoded one pair at a time after a block failed
+    for (i = 0; i < len && parser->state != STATE_DONE && parser->urc == MIOTYATPARSER_URC_NONE; i++) {
+        uint8_t c = data[i];
+        switch (parser->state) {
+        case STATE_KEY:
+            if (c == '\n') {
+                uint8_t urc = lookup_urc(parser);
+                if (urc != MIOTYATPARSER_URC_NONE) {
+                    /* a URC without value */
+                    parser->urcLen = 0;
+                    parser->urc = urc;
+                } else if (!parser->idle && parser->keyLen == 1 && parser->key[0] >= '0' && parser->key[0] <= '2') {
+                    parser->result = parser->key[0] - '0';
+                    parser->state = STATE_DONE;
+                    break;
+                } else if (parser->idle && parser->urcLines && parser->keyLen > 0) {
+                    parser->urc = MIOTYATPARSER_URC_LINE;
+                }
+                next_line(parser);
+            } else if (c == ':') {
+                parser->field = lookup_field(parser);
+                if (parser->idle && parser->field != FIELD_URC) {
+                    /* between commands only URCs are expected */
+                    parser->field = FIELD_NONE;
+                    put_line(parser, c);
+                    parser->state = parser->urcLines ? STATE_LINE : STATE_SKIP;
+                } else {
+                    start_value(parser);
+                }
+            } else if (c != '\r') {
+                put_line(parser, c);
+                if (parser->keyLen < MIOTYATPARSER_KEY_SIZE) {
+                    parser->key[parser->keyLen++] = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+                } else {
+                    parser->state = (parser->idle && parser->urcLines) ? STATE_LINE : STATE_SKIP;
+                }
+            }
+            break;
+
+        case STATE_NUMBER:
+            if (c >= '0' && c <= '9') {
+                parser->number = parser->number * 10 + (c - '0');
+            } else {
+                finish_number(parser);
+                if (c == '\n')
+                    next_line(parser);
+                else
+                    parser->state = STATE_SKIP;
+            }
+            break;
+
+        case STATE_DATA_LEN:
+            if (c >= '0' && c <= '9') {
+                parser->number = parser->number * 10 + (c - '0');
+            } else if (c == '\t') {
+                if (parser->field == FIELD_RESPONSE)
+                    parser->value = parser->number;
+                parser->state = STATE_DATA_HEX;
+            } else if (c == '\n') {
+                next_line(parser);
+            } else {
+                parser->state = STATE_SKIP;
+            }
+            break;
+
+        case STATE_DATA_HEX: {
+            /* whole blocks of hex pairs go to the vectorised decoder, the block with the end of the data falls back */
+            if (parser->nibble == 0xFF && parser->field == FIELD_RESPONSE && i >= scalarEnd) {
+                size_t room = parser->outSize - parser->outLen;
+                size_t n = (len - i) / 2 < room ? (len - i) / 2 : room;
+                if (n > HEX_BLOCK)
+                    n = HEX_BLOCK;
+                if (n >= 16) {
+                    if (hex_decode((const char *)&data[i], n, &parser->out[parser->outLen])) {
+                        parser->outLen += n;
+                        i += 2 * n - 1;
+                        break;
+                    }
+                    /* the block holds the end of the data, it is not tried again one pair later */
+                    scalarEnd = i + 2 * n;
+                }
+            }
+            int8_t v = hex_value(c);
+            if (v >= 0) {
+                if (parser->nibble == 0xFF) {
+                    parser->nibble = v;
+                } else {
+                    put_byte(parser, (parser->nibble << 4) | v);
+                    parser->nibble = 0xFF;
+                }
+            } else {
+                if (parser->field == FIELD_DLMPF)
+                    parser->seen |= MIOTYATPARSER_SEEN_DLMPF;
+                else if (parser->field == FIELD_RESPONSE)
+                    parser->seen |= MIOTYATPARSER_SEEN_RESPONSE;
+                if (c == '\n')
+                    next_line(parser);
+                else
+                    parser->state = STATE_SKIP;
+            }
+            break;
+        }
+
+        case STATE_STRING:
+            if (c == '\r' || c == '\n') {
+                if (parser->field == FIELD_RESPONSE)
+                    parser->seen |= MIOTYATPARSER_SEEN_RESPONSE;
+                if (c == '\n')
+                    next_line(parser);
+                else
+                    parser->state = STATE_SKIP;
+            } else {
+                put_byte(parser, c);
+            }
+            break;
+
+        case STATE_LINE:
+            if (c == '\n') {
+                parser->urc = MIOTYATPARSER_URC_LINE;
+                next_line(parser);
+            } else if (c != '\r') {
+                put_line(parser, c);
+            }
+            break;
+
+        default: // STATE_SKIP
+            if (c == '\n')
+                next_line(parser);
+            break;
+        }
+    }
+    return i;
+}
+
+
+static bool key_equals(const miotyAtParser *parser, const char *key, uint8_t len) {
+    return parser->keyLen == len && memcmp(parser->key, key, len) == 0;
+}
+
+static uint8_t lookup_field(miotyAtParser *parser) {
+    const uint8_t keyLen = parser->keyLen;
+    const uint8_t respLen = parser->respKeyLen;
+
+    if (parser->respType != MIOTYATPARSER_VALUE_NONE && key_equals(parser, parser->respKey, respLen))
+        return FIELD_RESPONSE;
+
+    for (uint8_t i = 0; i < sizeof(known_fields)/sizeof(known_fields[0]); i++) {
+        if (key_equals(parser, known_fields[i].key, known_fields[i].len))
+            return known_fields[i].field;
+    }
+
+    parser->urcIndex = lookup_urc(parser);
+    if (parser->urcIndex != MIOTYATPARSER_URC_NONE) {
+        parser->urcLen = 0;
+        parser->urcValue = 0;
+        return FIELD_URC;
+    }
+
+    /* the response name may be prefixed ("ATI" for "I") or extended ("-BMPF" for "-B") */
+    if (parser->respType != MIOTYATPARSER_VALUE_NONE && respLen > 0 && keyLen > respLen) {
+        if (memcmp(parser->key, parser->respKey, respLen) == 0 ||
+            memcmp(parser->key + keyLen - respLen, parser->respKey, respLen) == 0)
+            return FIELD_RESPONSE;
+    }
+    return FIELD_NONE;
+}
+
+static uint8_t lookup_urc(const miotyAtParser *parser) {
+    for (uint8_t i = 0; i < parser->urcCount; i++) {
+        if (key_equals(parser, parser->urcKeys[i].key, parser->urcKeys[i].keyLen))
+            return i;
+    }
+    return MIOTYATPARSER_URC_NONE;
+}
+
+static void start_value(miotyAtParser *parser) {
+    parser->number = 0;
+    parser->nibble = 0xFF;
+    switch (parser->field) {
+    case FIELD_NONE:
+        parser->state = STATE_SKIP;
+        break;
+    case FIELD_URC:
+        switch (parser->urcKeys[parser->urcIndex].type) {
+        case MIOTYATPARSER_VALUE_INT:       parser->state = STATE_NUMBER;   break;
+        case MIOTYATPARSER_VALUE_DATA:      parser->state = STATE_DATA_LEN; break;
+        case MIOTYATPARSER_VALUE_STRING:    parser->state = STATE_STRING;   break;
+        default:                            parser->state = STATE_SKIP;     break;
+        }
+        break;
+    case FIELD_DLMPF:
+        parser->state = STATE_DATA_LEN;
+        break;
+    case FIELD_RESPONSE:
+        if (parser->respType == MIOTYATPARSER_VALUE_DATA)
+            parser->state = STATE_DATA_LEN;
+        else if (parser->respType == MIOTYATPARSER_VALUE_STRING)
+            parser->state = STATE_STRING;
+        else
+            parser->state = STATE_NUMBER;
+        break;
+    default:
+        parser->state = STATE_NUMBER;
+        break;
+    }
+}
+
+static void finish_number(miotyAtParser *parser) {
+    switch (parser->field) {
+    case FIELD_RESPONSE:
+        parser->value = parser->number;
+        parser->seen |= MIOTYATPARSER_SEEN_RESPONSE;
+        break;
+    case FIELD_MPCT:
+        parser->packetCounter = parser->number;
+        parser->seen |= MIOTYATPARSER_SEEN_MPCT;
+        break;
+    case FIELD_MSTA:
+        parser->msta = parser->number;
+        parser->seen |= MIOTYATPARSER_SEEN_MSTA;
+        break;
+    case FIELD_MAC_ERR:
+        parser->macError = parser->number;
+        parser->seen |= MIOTYATPARSER_SEEN_MAC_ERR;
+        break;
+    case FIELD_AT_ERR:
+        parser->atError = parser->number;
+        parser->seen |= MIOTYATPARSER_SEEN_AT_ERR;
+        break;
+    case FIELD_URC:
+        parser->urcValue = parser->number;
+        break;
+    default:
+        break;
+    }
+}
+
+static void put_byte(miotyAtParser *parser, uint8_t b) {
+    if (parser->field == FIELD_DLMPF) {
+        parser->dlmpf = b;
+    } else if (parser->field == FIELD_URC) {
+        if (parser->urcLen < parser->urcOutSize)
+            parser->urcOut[parser->urcLen++] = b;
+    } else if (parser->outLen < parser->outSize) {
+        parser->out[parser->outLen++] = b;
+    } else {
+        parser->seen |= MIOTYATPARSER_SEEN_OVERFLOW;
+    }
+}
+
+// keeps the text of a line received while idle, in case it turns out to be an unknown line
+static void put_line(miotyAtParser *parser, uint8_t c) {
+    if (parser->idle && parser->urcLines && parser->urcLen < parser->urcOutSize)
+        parser->urcOut[parser->urcLen++] = c;
+}
+
+static void next_line(miotyAtParser *parser) {
+    if (parser->field == FIELD_URC)
+        parser->urc = parser->urcIndex;
+    parser->state = STATE_KEY;
+    parser->field = FIELD_NONE;
+    parser->keyLen = 0;
+}
+
+static int8_t hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
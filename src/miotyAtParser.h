@@ -0,0 +1,209 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Resumable single pass tokenizer for MIOTY™ AT protocol v2.x.x responses.
+ *
+ * The tokenizer consumes the modem output byte by byte and never looks at a byte twice.
+ * It can be fed chunks of any size, the state is kept in \ref miotyAtParser between calls.
+ *
+ * Lines starting with a registered key are unsolicited result codes (URCs) of the modem. They are
+ * taken out of the response, parsed into a separate buffer and reported one by one, see
+ * \ref miotyAtParser_setUrc. Between commands the tokenizer runs idle, see \ref miotyAtParser_initIdle.
+ */
+
+#ifndef _AT_PARSER_H
+#define _AT_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum length of a field name (the part of a line before ':') */
+#define MIOTYATPARSER_KEY_SIZE  8
+
+/** Result line of the modem: "0" ok, "1" MAC error, "2" AT error */
+#define MIOTYATPARSER_RESULT_OK         0
+#define MIOTYATPARSER_RESULT_MAC_ERR    1
+#define MIOTYATPARSER_RESULT_AT_ERR     2
+#define MIOTYATPARSER_RESULT_PENDING    0xFF
+
+/** Flags in miotyAtParser.seen, set as soon as the field was completely received */
+#define MIOTYATPARSER_SEEN_RESPONSE     0x01 // the response field of the running command
+#define MIOTYATPARSER_SEEN_MPCT         0x02 // -MPCT:
+#define MIOTYATPARSER_SEEN_MSTA         0x04 // -MSTA:
+#define MIOTYATPARSER_SEEN_DLMPF        0x08 // -DLMPF:
+#define MIOTYATPARSER_SEEN_MAC_ERR      0x10 // -MNFO: or -MERR:
+#define MIOTYATPARSER_SEEN_AT_ERR       0x20 // AT!ERR:
+#define MIOTYATPARSER_SEEN_OVERFLOW     0x40 // response data did not fit into the output buffer
+
+/** Values of miotyAtParser.urc besides the index of the URC key */
+#define MIOTYATPARSER_URC_LINE          0xFE // line received between commands that matches no key
+#define MIOTYATPARSER_URC_NONE          0xFF
+
+/** Kind of value the response field of a command carries */
+typedef enum miotyAtParser_valueType {
+    MIOTYATPARSER_VALUE_NONE   = 0, // command has no response field
+    MIOTYATPARSER_VALUE_INT    = 1, // "<key>:<decimal>"
+    MIOTYATPARSER_VALUE_DATA   = 2, // "<key>:<len>\t<hex>\x1A"
+    MIOTYATPARSER_VALUE_STRING = 3, // "<key>:<text>\r"
+} miotyAtParser_valueType;
+
+/** Key of an unsolicited result code */
+typedef struct miotyAtParser_urcKey {
+    const char *key;                            // upper case name without ':', e.g. "+DLIND"
+    uint8_t     keyLen;
+    uint8_t     type;                           // miotyAtParser_valueType of the payload
+} miotyAtParser_urcKey;
+
+/**
+ * @brief State of the tokenizer. Treat as opaque, only the result members may be read
+ *        after \ref miotyAtParser_done returned true.
+ */
+typedef struct miotyAtParser {
+    /* tokenizer state */
+    uint8_t     state;
+    uint8_t     field;
+    uint8_t     keyLen;
+    uint8_t     nibble;                         // high nibble of a hex byte, 0xFF if none
+    char        key[MIOTYATPARSER_KEY_SIZE];
+    uint32_t    number;
+
+    /* expected response of the running command */
+    const char *respKey;
+    uint8_t     respKeyLen;
+    uint8_t     respType;                       // miotyAtParser_valueType
+    uint8_t    *out;
+    size_t      outSize;
+
+    /* results */
+    uint8_t     result;                         // MIOTYATPARSER_RESULT_*
+    uint8_t     seen;                           // MIOTYATPARSER_SEEN_*
+    uint8_t     dlmpf;
+    uint8_t     msta;
+    uint32_t    value;                          // value of an INT response, length announced by a DATA response
+    size_t      outLen;                         // bytes written to out
+    uint32_t    packetCounter;
+    uint32_t    macError;
+    uint32_t    atError;
+
+    /* unsolicited result codes */
+    const miotyAtParser_urcKey *urcKeys;
+    uint8_t     urcCount;
+    bool        idle;                           // no command running, result lines are unsolicited as well
+    bool        urcLines;                       // report unknown lines received while idle
+    uint8_t     urcIndex;                       // key of the URC line being parsed
+    uint8_t     urc;                            // complete URC, index into urcKeys or MIOTYATPARSER_URC_*
+    uint8_t    *urcOut;                         // payload of DATA and STRING URCs, text of unknown lines
+    size_t      urcOutSize;
+    size_t      urcLen;                         // bytes written to urcOut
+    uint32_t    urcValue;                       // payload of INT URCs
+} miotyAtParser;
+
+/**
+ * @brief Prepare the tokenizer for the response of a new command
+ *
+ * @param[out]  parser      Tokenizer state
+ * @param[in]   respKey     Name of the response field without ':' (e.g. "-MEUI"), may be NULL if type is NONE
+ * @param[in]   respKeyLen  Length of respKey
+ * @param[in]   type        Kind of the response field
+ * @param[out]  out         Buffer for DATA and STRING responses
+ * @param[in]   outSize     Size of out
+ */
+void miotyAtParser_init(miotyAtParser *parser, const char *respKey, size_t respKeyLen,
+                        miotyAtParser_valueType type, uint8_t *out, size_t outSize);
+
+/**
+ * @brief Prepare the tokenizer for modem output received while no command is running
+ *
+ * Result lines are not taken as the end of a response then, so stray output can not complete
+ * the next command. Call \ref miotyAtParser_setUrc afterwards to receive the URCs.
+ *
+ * @param[out]  parser      Tokenizer state
+ */
+void miotyAtParser_initIdle(miotyAtParser *parser);
+
+/**
+ * @brief Set the keys of the unsolicited result codes, after \ref miotyAtParser_init or \ref miotyAtParser_initIdle
+ *
+ * A line whose name matches a key, with or without ':' and value, is not part of the response.
+ * It is reported by \ref miotyAtParser_urc after the line end.
+ *
+ * @param[in,out]   parser      Tokenizer state
+ * @param[in]       keys        Keys, must stay valid while the tokenizer is used
+ * @param[in]       count       Number of keys, less than MIOTYATPARSER_URC_LINE
+ * @param[in]       lines       Report other lines received while idle as MIOTYATPARSER_URC_LINE
+ * @param[out]      out         Buffer for DATA and STRING payloads and the text of other lines, longer ones are cut
+ * @param[in]       outSize     Size of out
+ */
+void miotyAtParser_setUrc(miotyAtParser *parser, const miotyAtParser_urcKey *keys, uint8_t count, bool lines,
+                          uint8_t *out, size_t outSize);
+
+/**
+ * @brief Feed received bytes to the tokenizer
+ *
+ * Parsing stops at the end of the result line and of each URC line, bytes behind it are not consumed.
+ *
+ * @param[in,out]   parser  Tokenizer state
+ * @param[in]       data    Received bytes
+ * @param[in]       len     Number of bytes in data
+ *
+ * @return  Number of bytes consumed
+ */
+size_t miotyAtParser_feed(miotyAtParser *parser, const uint8_t *data, size_t len);
+
+/**
+ * @brief Check whether the result line of the response was received
+ */
+static inline bool miotyAtParser_done(const miotyAtParser *parser) {
+    return parser->result != MIOTYATPARSER_RESULT_PENDING;
+}
+
+/**
+ * @brief Complete URC waiting to be taken: index into the keys, MIOTYATPARSER_URC_LINE or MIOTYATPARSER_URC_NONE
+ *
+ * The payload is in urcValue or urcOut/urcLen. Feeding continues only after \ref miotyAtParser_urcTaken.
+ */
+static inline uint8_t miotyAtParser_urc(const miotyAtParser *parser) {
+    return parser->urc;
+}
+
+/**
+ * @brief Release the URC reported by \ref miotyAtParser_urc, its payload is overwritten by the next one
+ */
+static inline void miotyAtParser_urcTaken(miotyAtParser *parser) {
+    parser->urc = MIOTYATPARSER_URC_NONE;
+    parser->urcLen = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
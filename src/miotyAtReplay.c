@@ -0,0 +1,427 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Recording and bit-exact replay of the transport of a client context.
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "miotyAtReplay.h"
+
+#define HEADER_SIZE     12
+
+/* event tags */
+#define EVENT_WRITE     0
+#define EVENT_READ      1
+#define EVENT_EMPTY     2
+#define EVENT_FAIL      3
+#define EVENT_COUNT     4
+
+/* header flags */
+#define FLAG_CLOCK      0x01    // the context had a clock
+
+static void recorder_write(void *user, const uint8_t *data, size_t len);
+static void recorder_writev(void *user, const miotyAtClient_iovec *iov, size_t count);
+static bool recorder_read(void *user, uint8_t *data, size_t *len_out);
+static uint32_t recorder_clock(void *user);
+static void recorder_idle(void *user);
+static uint32_t recorder_now(const miotyAtReplay_recorder *recorder);
+static void recorder_event(miotyAtReplay_recorder *recorder, uint8_t tag, uint32_t time);
+static void recorder_flush_empty(miotyAtReplay_recorder *recorder);
+static void put_varint(miotyAtReplay_recorder *recorder, uint64_t value);
+static bool next_event(miotyAtReplay *replay);
+static bool get_varint(miotyAtReplay *replay, uint64_t *value);
+static void pace(miotyAtReplay *replay);
+static uint64_t now_ns(void);
+
+
+miotyAtClient_returnCode miotyAtReplay_record(miotyAtReplay_recorder *recorder, miotyAtClient_ctx *ctx, const char *path) {
+    memset(recorder, 0, sizeof(*recorder));
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file)
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    const uint32_t ticksPerSecond = ctx->clock ? 1000 : 1000000;
+    const uint8_t header[HEADER_SIZE] = {
+        'M', 'R', 'E', 'C', MIOTYATREPLAY_VERSION, ctx->clock ? FLAG_CLOCK : 0, 0, 0,
+        (uint8_t)ticksPerSecond, (uint8_t)(ticksPerSecond >> 8), (uint8_t)(ticksPerSecond >> 16), (uint8_t)(ticksPerSecond >> 24),
+    };
+    if (fwrite(header, 1, sizeof(header), recorder->file) != sizeof(header))
+        recorder->failed = true;
+
+    recorder->write = ctx->write;
+    recorder->writev = ctx->writev;
+    recorder->read = ctx->read;
+    recorder->clock = ctx->clock;
+    recorder->idle = ctx->idle;
+    recorder->user = ctx->user;
+    recorder->startNs = now_ns();
+    recorder->last = recorder_now(recorder);
+    ctx->write = recorder_write;
+    ctx->writev = ctx->writev ? recorder_writev : NULL;
+    ctx->read = ctx->read ? recorder_read : NULL;
+    ctx->clock = ctx->clock ? recorder_clock : NULL;
+    ctx->idle = ctx->idle ? recorder_idle : NULL;
+    ctx->user = recorder;
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+miotyAtClient_returnCode miotyAtReplay_stopRecording(miotyAtReplay_recorder *recorder, miotyAtClient_ctx *ctx) {
+    if (ctx->user == recorder) {
+        ctx->write = recorder->write;
+        ctx->writev = recorder->writev;
+        ctx->read = recorder->read;
+        ctx->clock = recorder->clock;
+        ctx->idle = recorder->idle;
+        ctx->user = recorder->user;
+    }
+    if (!recorder->file)
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    recorder_flush_empty(recorder);
+    if (ferror(recorder->file))
+        recorder->failed = true;
+    if (fclose(recorder->file) != 0)
+        recorder->failed = true;
+    recorder->file = NULL;
+    return recorder->failed ? MIOTYATCLIENT_RETURN_CODE_ERR : MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+miotyAtClient_returnCode miotyAtReplay_open(miotyAtReplay *replay, const char *path) {
+    memset(replay, 0, sizeof(*replay));
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    uint8_t *data = NULL;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0)
+        data = malloc(size > 0 ? (size_t)size : 1);
+    const bool failed = !data || fread(data, 1, (size_t)size, file) != (size_t)size;
+    fclose(file);
+    if (failed) {
+        free(data);
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    }
+    miotyAtClient_returnCode rc = miotyAtReplay_load(replay, data, (size_t)size);
+    if (rc != MIOTYATCLIENT_RETURN_CODE_OK)
+        free(data);
+    else
+        replay->owned = data;
+    return rc;
+}
+
+miotyAtClient_returnCode miotyAtReplay_load(miotyAtReplay *replay, const uint8_t *data, size_t size) {
+    memset(replay, 0, sizeof(*replay));
+    if (size < HEADER_SIZE || memcmp(data, "MREC", 4) != 0 || data[4] != MIOTYATREPLAY_VERSION)
+        return MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar;
+    replay->data = data;
+    replay->size = size;
+    replay->clock = (data[5] & FLAG_CLOCK) != 0;
+    replay->ticksPerSecond = data[8] | (uint32_t)data[9] << 8 | (uint32_t)data[10] << 16 | (uint32_t)data[11] << 24;
+    if (replay->ticksPerSecond == 0)
+        return MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar;
+    miotyAtReplay_rewind(replay);
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+void miotyAtReplay_close(miotyAtReplay *replay) {
+    free(replay->owned);
+    replay->owned = NULL;
+    replay->data = NULL;
+    replay->size = 0;
+}
+
+void miotyAtReplay_bind(miotyAtReplay *replay, miotyAtClient_ctx *ctx, bool paced) {
+    replay->paced = paced;
+    ctx->write = miotyAtReplay_write;
+    ctx->writev = NULL;
+    ctx->read = miotyAtReplay_read;
+    /* without the clock of the recording the client would take other paths, e.g. deadlines and pipelining */
+    ctx->clock = replay->clock ? miotyAtReplay_clockMs : NULL;
+    ctx->idle = NULL;
+    ctx->user = replay;
+}
+
+void miotyAtReplay_rewind(miotyAtReplay *replay) {
+    replay->pos = HEADER_SIZE;
+    replay->time = 0;
+    replay->remaining = 0;
+    replay->emptyLeft = 0;
+    replay->startNs = 0;
+    replay->mismatches = 0;
+    replay->overruns = 0;
+}
+
+void miotyAtReplay_write(void *user, const uint8_t *data, size_t len) {
+    miotyAtReplay *replay = user;
+    bool differs = false;
+    while (len > 0) {
+        /* reads the client no longer makes are skipped, received bytes it did not read yet are not */
+        if (replay->remaining == 0 || replay->type != EVENT_WRITE) {
+            if (replay->remaining > 0) {
+                differs = true;
+                break;
+            }
+            if (replay->emptyLeft > 0) {
+                replay->emptyLeft = 0;
+                replay->time = replay->emptyStart + replay->emptySpan;
+            }
+            if (!next_event(replay)) {
+                replay->overruns++;
+                return;
+            }
+            if (replay->type != EVENT_WRITE) {
+                differs = true;
+                if (replay->type != EVENT_READ)
+                    continue;
+                break;
+            }
+        }
+        size_t n = len < replay->remaining ? len : replay->remaining;
+        if (memcmp(data, replay->bytes, n) != 0)
+            differs = true;
+        replay->bytes += n;
+        replay->remaining -= n;
+        data += n;
+        len -= n;
+    }
+    if (differs)
+        replay->mismatches++;
+}
+
+bool miotyAtReplay_read(void *user, uint8_t *data, size_t *len_out) {
+    miotyAtReplay *replay = user;
+    if (replay->remaining == 0 && replay->emptyLeft == 0) {
+        if (!next_event(replay)) {
+            replay->overruns++;
+            *len_out = 0;
+            return false;
+        }
+    }
+    pace(replay);
+    if (replay->emptyLeft > 0) {
+        /* the clock moves through the run of empty reads as it did while recording */
+        uint32_t done = replay->emptyCount - --replay->emptyLeft;
+        replay->time = replay->emptyStart +
+                       (replay->emptyCount > 1 ? (uint32_t)((uint64_t)replay->emptySpan * (done - 1) / (replay->emptyCount - 1))
+                                               : replay->emptySpan);
+        *len_out = 0;
+        return true;
+    }
+    switch (replay->type) {
+    case EVENT_READ: {
+        size_t n = *len_out < replay->remaining ? *len_out : replay->remaining;
+        memcpy(data, replay->bytes, n);
+        replay->bytes += n;
+        replay->remaining -= n;
+        *len_out = n;
+        return true;
+    }
+    case EVENT_FAIL:
+        *len_out = 0;
+        return false;
+    default:
+        /* the client reads where it wrote while recording, it would wait forever for the next chunk */
+        replay->mismatches++;
+        *len_out = 0;
+        return false;
+    }
+}
+
+uint32_t miotyAtReplay_clockMs(void *user) {
+    const miotyAtReplay *replay = user;
+    return (uint32_t)((uint64_t)replay->time * 1000 / replay->ticksPerSecond);
+}
+
+// makes the next event of the recording the current one, false at its end
+static bool next_event(miotyAtReplay *replay) {
+    uint64_t delta, len;
+    if (replay->pos >= replay->size)
+        return false;
+    const uint8_t tag = replay->data[replay->pos++];
+    if (tag >= EVENT_COUNT || !get_varint(replay, &delta)) {
+        replay->pos = replay->size;
+        return false;
+    }
+    replay->type = tag;
+    replay->time += (uint32_t)delta;
+    switch (tag) {
+    case EVENT_WRITE:
+    case EVENT_READ:
+        if (!get_varint(replay, &len) || len > replay->size - replay->pos) {
+            replay->pos = replay->size;
+            return false;
+        }
+        replay->bytes = &replay->data[replay->pos];
+        replay->remaining = (size_t)len;
+        replay->pos += (size_t)len;
+        /* an empty write or read takes no call to consume */
+        return len > 0 || next_event(replay);
+    case EVENT_EMPTY: {
+        uint64_t count, span;
+        if (!get_varint(replay, &count) || !get_varint(replay, &span) || count == 0) {
+            replay->pos = replay->size;
+            return false;
+        }
+        replay->emptyCount = replay->emptyLeft = (uint32_t)count;
+        replay->emptyStart = replay->time;
+        replay->emptySpan = (uint32_t)span;
+        return true;
+    }
+    default:
+        return true;
+    }
+}
+
+static bool get_varint(miotyAtReplay *replay, uint64_t *value) {
+    *value = 0;
+    for (unsigned shift = 0; shift < 64 && replay->pos < replay->size; shift += 7) {
+        const uint8_t b = replay->data[replay->pos++];
+        *value |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// waits until the recorded time of the current event has passed since the replay started
+static void pace(miotyAtReplay *replay) {
+    if (!replay->paced)
+        return;
+    const uint64_t now = now_ns();
+    if (replay->startNs == 0)
+        replay->startNs = now - (uint64_t)replay->time * 1000000000u / replay->ticksPerSecond;
+    const uint64_t due = replay->startNs + (uint64_t)replay->time * 1000000000u / replay->ticksPerSecond;
+    if (due > now) {
+        struct timespec ts = { .tv_sec = (time_t)((due - now) / 1000000000u), .tv_nsec = (long)((due - now) % 1000000000u) };
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        }
+    }
+}
+
+static void recorder_write(void *user, const uint8_t *data, size_t len) {
+    miotyAtReplay_recorder *recorder = user;
+    recorder_event(recorder, EVENT_WRITE, recorder_now(recorder));
+    put_varint(recorder, len);
+    if (recorder->file && fwrite(data, 1, len, recorder->file) != len)
+        recorder->failed = true;
+    recorder->write(recorder->user, data, len);
+}
+
+// a gathered write is stored as one write of all pieces
+static void recorder_writev(void *user, const miotyAtClient_iovec *iov, size_t count) {
+    miotyAtReplay_recorder *recorder = user;
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++)
+        len += iov[i].len;
+    recorder_event(recorder, EVENT_WRITE, recorder_now(recorder));
+    put_varint(recorder, len);
+    for (size_t i = 0; i < count; i++)
+        if (recorder->file && fwrite(iov[i].data, 1, iov[i].len, recorder->file) != iov[i].len)
+            recorder->failed = true;
+    recorder->writev(recorder->user, iov, count);
+}
+
+static bool recorder_read(void *user, uint8_t *data, size_t *len_out) {
+    miotyAtReplay_recorder *recorder = user;
+    const bool ok = recorder->read(recorder->user, data, len_out);
+    const uint32_t time = recorder_now(recorder);
+    if (ok && *len_out == 0) {
+        if (recorder->emptyCount++ == 0)
+            recorder->emptyFirst = time;
+        recorder->emptyLast = time;
+        return ok;
+    }
+    recorder_event(recorder, ok ? EVENT_READ : EVENT_FAIL, time);
+    if (ok) {
+        put_varint(recorder, *len_out);
+        if (recorder->file && fwrite(data, 1, *len_out, recorder->file) != *len_out)
+            recorder->failed = true;
+    }
+    return ok;
+}
+
+static uint32_t recorder_clock(void *user) {
+    const miotyAtReplay_recorder *recorder = user;
+    return recorder->clock(recorder->user);
+}
+
+static void recorder_idle(void *user) {
+    const miotyAtReplay_recorder *recorder = user;
+    recorder->idle(recorder->user);
+}
+
+static uint32_t recorder_now(const miotyAtReplay_recorder *recorder) {
+    if (recorder->clock)
+        return recorder->clock(recorder->user);
+    return (uint32_t)((now_ns() - recorder->startNs) / 1000u);
+}
+
+// stores the tag and time of an event, after the pending run of empty reads
+static void recorder_event(miotyAtReplay_recorder *recorder, uint8_t tag, uint32_t time) {
+    recorder_flush_empty(recorder);
+    if (recorder->file && fputc(tag, recorder->file) == EOF)
+        recorder->failed = true;
+    put_varint(recorder, (uint32_t)(time - recorder->last));
+    recorder->last = time;
+}
+
+static void recorder_flush_empty(miotyAtReplay_recorder *recorder) {
+    if (recorder->emptyCount == 0)
+        return;
+    const uint32_t count = recorder->emptyCount;
+    recorder->emptyCount = 0;
+    recorder_event(recorder, EVENT_EMPTY, recorder->emptyFirst);
+    put_varint(recorder, count);
+    put_varint(recorder, (uint32_t)(recorder->emptyLast - recorder->emptyFirst));
+    recorder->last = recorder->emptyLast;
+}
+
+static void put_varint(miotyAtReplay_recorder *recorder, uint64_t value) {
+    uint8_t buf[10];
+    size_t n = 0;
+    do {
+        buf[n] = (uint8_t)(value & 0x7F);
+        value >>= 7;
+        if (value)
+            buf[n] |= 0x80;
+        n++;
+    } while (value);
+    if (recorder->file && fwrite(buf, 1, n, recorder->file) != n)
+        recorder->failed = true;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#endif /* __unix__ || __APPLE__ */
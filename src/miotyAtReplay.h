@@ -0,0 +1,217 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Record the transport of a client context to a file and replay it bit-exact.
+ *
+ * A recorder is put between a client context and its transport:
+ *
+ *      miotyAtSerial_bind(&serial, &ctx);
+ *      miotyAtReplay_record(&recorder, &ctx, "capture.mrec");
+ *      ...
+ *      miotyAtReplay_stopRecording(&recorder, &ctx);
+ *
+ * Every call of the write, gather write and read callbacks is stored with its bytes and the time since the
+ * previous call, so the chunking of the received bytes is kept as the modem delivered it. Runs of reads that
+ * returned nothing are stored as one event.
+ *
+ * A replay binds a context to a recording instead of a transport. Reads return the recorded chunks one per
+ * call, writes are compared with the recorded ones, and the clock of the context follows the recorded times
+ * if it had a clock while recording, so the client takes the same path as during the recording, e.g. for a
+ * regression test of the parser against a corpus of field captures. Unpaced, the replay runs as fast as the client can, to measure its
+ * CPU cost; paced, every recorded chunk is delivered at its recorded time.
+ *
+ * Bytes the application pushes with miotyAtClient_feed or miotyAtClient_feedRx do not pass the
+ * transport callbacks and are not recorded.
+ *
+ * File format, varints are unsigned LEB128:
+ *      header      "MREC", version (1), flags (bit 0: the context had a clock), 2 reserved bytes,
+ *                  ticks per second (u32 little endian)
+ *      write       0, time delta, length, bytes
+ *      read        1, time delta, length, bytes
+ *      empty reads 2, time delta, count, duration of the run
+ *      read error  3, time delta
+ *
+ * Only available on POSIX systems (MIOTYATREPLAY_AVAILABLE is defined then).
+ */
+
+#ifndef _AT_REPLAY_H
+#define _AT_REPLAY_H
+
+#include "miotyAtClient.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MIOTYATREPLAY_AVAILABLE 1
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Version of the file format */
+#define MIOTYATREPLAY_VERSION   1
+
+/**
+ * @brief Recording started by \ref miotyAtReplay_record. Members are private.
+ */
+typedef struct miotyAtReplay_recorder {
+    FILE                   *file;
+    bool                    failed;         // writing the file failed
+    miotyAtClient_writeFn   write;          // transport of the context
+    miotyAtClient_writevFn  writev;
+    miotyAtClient_readFn    read;
+    miotyAtClient_clockFn   clock;
+    miotyAtClient_idleFn    idle;
+    void                   *user;
+    uint64_t                startNs;        // monotonic time of the start, if the context has no clock
+    uint32_t                last;           // time of the previous event
+    uint32_t                emptyCount;     // reads without bytes not stored yet
+    uint32_t                emptyFirst;
+    uint32_t                emptyLast;
+} miotyAtReplay_recorder;
+
+/**
+ * @brief Replay of a recording, see \ref miotyAtReplay_open. Members are private.
+ */
+typedef struct miotyAtReplay {
+    const uint8_t          *data;
+    size_t                  size;
+    uint8_t                *owned;          // data read from a file, freed by miotyAtReplay_close
+    uint32_t                ticksPerSecond;
+    bool                    clock;          // the recorded context had a clock
+    size_t                  pos;            // of the next event
+    uint32_t                time;           // recorded time of the last event delivered
+    const uint8_t          *bytes;          // of the write or read event being consumed
+    size_t                  remaining;      // bytes of it not consumed yet
+    uint8_t                 type;           // of the event being consumed
+    uint32_t                emptyLeft;      // reads left of an empty read run
+    uint32_t                emptyCount;
+    uint32_t                emptyStart;     // recorded time of the run
+    uint32_t                emptySpan;
+    bool                    paced;
+    uint64_t                startNs;        // monotonic time of the first call, for pacing
+    uint32_t                mismatches;     // writes that differed from the recording
+    uint32_t                overruns;       // reads and writes past the end of the recording
+} miotyAtReplay;
+
+/**
+ * @brief Start recording the transport of a context to a file
+ *
+ * Takes over the write, gather write, read, clock and idle callbacks of ctx and passes every call on to
+ * them. Times are those of the clock of ctx in milliseconds, or microseconds of CLOCK_MONOTONIC without.
+ *
+ * @param[out]      recorder    Recorder, must stay valid while recording
+ * @param[in,out]   ctx         Client context with its transport set up
+ * @param[in]       path        File to create
+ *
+ * @return  MIOTYATCLIENT_RETURN_CODE_OK, MIOTYATCLIENT_RETURN_CODE_ERR if the file can not be created
+ */
+miotyAtClient_returnCode miotyAtReplay_record(miotyAtReplay_recorder *recorder, miotyAtClient_ctx *ctx, const char *path);
+
+/**
+ * @brief Close the file and give the context its transport back
+ *
+ * @return  MIOTYATCLIENT_RETURN_CODE_OK, MIOTYATCLIENT_RETURN_CODE_ERR if writing the file failed
+ */
+miotyAtClient_returnCode miotyAtReplay_stopRecording(miotyAtReplay_recorder *recorder, miotyAtClient_ctx *ctx);
+
+/**
+ * @brief Read a recording into memory
+ *
+ * @param[out]  replay  Replay
+ * @param[in]   path    Recording
+ *
+ * @return  MIOTYATCLIENT_RETURN_CODE_OK, MIOTYATCLIENT_RETURN_CODE_ERR if the file can not be read,
+ *          MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar if it is no recording of this version
+ */
+miotyAtClient_returnCode miotyAtReplay_open(miotyAtReplay *replay, const char *path);
+
+/**
+ * @brief Replay a recording in memory, which is not copied
+ *
+ * @return  MIOTYATCLIENT_RETURN_CODE_OK, MIOTYATCLIENT_RETURN_CODE_ATUnexpectedChar if data is no recording of this version
+ */
+miotyAtClient_returnCode miotyAtReplay_load(miotyAtReplay *replay, const uint8_t *data, size_t size);
+
+/**
+ * @brief Free the memory of a recording read by \ref miotyAtReplay_open
+ */
+void miotyAtReplay_close(miotyAtReplay *replay);
+
+/**
+ * @brief Set the transport and clock of a context to the replay, gather write and idle callbacks are removed
+ *
+ * The clock is only set if the recorded context had one, else it is removed, like during the recording.
+ *
+ * @param[in]       replay  Replay, must stay valid as long as ctx is used
+ * @param[in,out]   ctx     Client context
+ * @param[in]       paced   true to deliver the recorded chunks at their recorded times, false as fast as possible
+ */
+void miotyAtReplay_bind(miotyAtReplay *replay, miotyAtClient_ctx *ctx, bool paced);
+
+/**
+ * @brief Start the replay over, e.g. for the next round of a benchmark
+ */
+void miotyAtReplay_rewind(miotyAtReplay *replay);
+
+/**
+ * @brief Write callback of a replay, compares the bytes with the recording
+ */
+void miotyAtReplay_write(void *replay, const uint8_t *data, size_t len);
+
+/**
+ * @brief Read callback of a replay, returns the next recorded chunk
+ *
+ * Fails past the end of the recording, and where the recording continues with a write, counted as mismatch.
+ */
+bool miotyAtReplay_read(void *replay, uint8_t *data, size_t *len_out);
+
+/**
+ * @brief Clock of a replay, the recorded time in milliseconds
+ */
+uint32_t miotyAtReplay_clockMs(void *replay);
+
+/**
+ * @brief true if every recorded event was replayed
+ */
+static inline bool miotyAtReplay_finished(const miotyAtReplay *replay) {
+    return replay->pos >= replay->size && replay->remaining == 0 && replay->emptyLeft == 0;
+}
+
+/**
+ * @brief Number of calls that differed from the recording or went past its end, 0 if the client behaved as recorded
+ */
+static inline uint32_t miotyAtReplay_mismatches(const miotyAtReplay *replay) {
+    return replay->mismatches + replay->overruns;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __unix__ || __APPLE__ */
+
+#endif /* _AT_REPLAY_H */
@@ -0,0 +1,257 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Retry engine with jittered exponential backoff.
+ */
+
+#include <string.h>
+#include "miotyAtRetry.h"
+
+#define DEFAULT_SEED    0x2545F491u
+
+typedef struct {
+    const uint8_t  *msg;
+    size_t          sizeMsg;
+    uint8_t        *data;
+    size_t         *sizeData;
+    size_t          sizeBuffer;     // of data, restored before every attempt
+    uint8_t        *dlMpf;
+    uint32_t       *packetCounter;
+} send_args;
+
+static const miotyAtRetry_limits default_limits[MIOTYATCLIENT_TIMEOUT_CLASS_COUNT] = {
+    [MIOTYATCLIENT_TIMEOUT_DEFAULT] = { 4,  100,  1000 },
+    [MIOTYATCLIENT_TIMEOUT_UPLINK]  = { 3, 2000,  8000 },
+    [MIOTYATCLIENT_TIMEOUT_BIDI]    = { 3, 4000, 16000 },
+    [MIOTYATCLIENT_TIMEOUT_ATTACH]  = { 2, 5000,  5000 },
+};
+
+static bool take_budget(miotyAtRetry *retry);
+static void give_budget(miotyAtRetry *retry);
+static void earn_budget(miotyAtRetry *retry);
+static uint32_t backoff(miotyAtRetry *retry, const miotyAtRetry_limits *limits, uint8_t attempt);
+static uint32_t next_random(miotyAtRetry *retry);
+static void wait_ms(miotyAtRetry *retry, uint32_t ms);
+static miotyAtClient_returnCode send_uni(miotyAtClient_ctx *ctx, void *arg);
+static miotyAtClient_returnCode send_bidi(miotyAtClient_ctx *ctx, void *arg);
+
+
+void miotyAtRetry_init(miotyAtRetry *retry, miotyAtClient_ctx *ctx) {
+    memset(retry, 0, sizeof(*retry));
+    retry->ctx = ctx;
+    memcpy(retry->limits, default_limits, sizeof(retry->limits));
+    retry->classify = miotyAtRetry_classify;
+    retry->random = DEFAULT_SEED;
+    miotyAtRetry_setBudget(retry, 10, 10);
+}
+
+void miotyAtRetry_setLimits(miotyAtRetry *retry, miotyAtClient_timeoutClass timeoutClass, const miotyAtRetry_limits *limits) {
+    if (timeoutClass < MIOTYATCLIENT_TIMEOUT_CLASS_COUNT)
+        retry->limits[timeoutClass] = *limits;
+}
+
+void miotyAtRetry_setBudget(miotyAtRetry *retry, uint16_t maxRetries, uint16_t callsPerRetry) {
+    retry->budgetMax = maxRetries;
+    retry->budget = maxRetries;
+    retry->callsPerRetry = callsPerRetry;
+    retry->earned = 0;
+}
+
+void miotyAtRetry_setClassifier(miotyAtRetry *retry, miotyAtRetry_classifyFn classify, void *user) {
+    retry->classify = classify ? classify : miotyAtRetry_classify;
+    retry->classifyUser = user;
+}
+
+void miotyAtRetry_setHook(miotyAtRetry *retry, miotyAtRetry_hookFn hook, void *user) {
+    retry->hook = hook;
+    retry->hookUser = user;
+}
+
+void miotyAtRetry_setReattach(miotyAtRetry *retry, miotyAtRetry_reattachFn reattach, void *user) {
+    retry->reattach = reattach;
+    retry->reattachUser = user;
+}
+
+void miotyAtRetry_setSleep(miotyAtRetry *retry, miotyAtRetry_sleepFn sleep, void *user) {
+    retry->sleep = sleep;
+    retry->sleepUser = user;
+}
+
+void miotyAtRetry_seed(miotyAtRetry *retry, uint32_t seed) {
+    /* xorshift never leaves 0 */
+    retry->random = seed ? seed : DEFAULT_SEED;
+}
+
+miotyAtRetry_action miotyAtRetry_classify(miotyAtClient_returnCode returnCode, miotyAtClient_timeoutClass timeoutClass, void *user) {
+    (void)user;
+    const bool uplink = timeoutClass == MIOTYATCLIENT_TIMEOUT_UPLINK || timeoutClass == MIOTYATCLIENT_TIMEOUT_BIDI;
+    switch (returnCode) {
+    case MIOTYATCLIENT_RETURN_CODE_OK:
+        return MIOTYATRETRY_SUCCESS;
+    case MIOTYATCLIENT_RETURN_CODE_MacError:
+    case MIOTYATCLIENT_RETURN_CODE_MacFramingError:
+    case MIOTYATCLIENT_RETURN_CODE_ERR:
+    case MIOTYATCLIENT_RETURN_CODE_PreviousCommandNotFinished:
+        return MIOTYATRETRY_RETRY;
+    /* the uplink may have been sent, or was sent and only the downlink failed: sending again duplicates it */
+    case MIOTYATCLIENT_RETURN_CODE_MacNoDownlinkReceived:
+    case MIOTYATCLIENT_RETURN_CODE_MacDownlinkErr:
+    case MIOTYATCLIENT_RETURN_CODE_DownlinkDataCorrupted:
+    case MIOTYATCLIENT_RETURN_CODE_ATReadFailed:
+    case MIOTYATCLIENT_RETURN_CODE_Timeout:
+        return uplink ? MIOTYATRETRY_FATAL : MIOTYATRETRY_RETRY;
+    case MIOTYATCLIENT_RETURN_CODE_MacNodeNotAttached:
+        return MIOTYATRETRY_REATTACH;
+    default:
+        return MIOTYATRETRY_FATAL;
+    }
+}
+
+miotyAtClient_returnCode miotyAtRetry_run(miotyAtRetry *retry, miotyAtClient_timeoutClass timeoutClass,
+                                          miotyAtRetry_opFn op, void *arg) {
+    if (timeoutClass >= MIOTYATCLIENT_TIMEOUT_CLASS_COUNT)
+        timeoutClass = MIOTYATCLIENT_TIMEOUT_DEFAULT;
+    const miotyAtRetry_limits *limits = &retry->limits[timeoutClass];
+    retry->stats.calls++;
+    for (uint8_t attempt = 1;; attempt++) {
+        miotyAtClient_returnCode rc = op(retry->ctx, arg);
+        miotyAtRetry_action action = retry->classify(rc, timeoutClass, retry->classifyUser);
+        if (action == MIOTYATRETRY_SUCCESS && attempt == 1)
+            earn_budget(retry);
+        if (action == MIOTYATRETRY_SUCCESS || action == MIOTYATRETRY_FATAL || attempt >= limits->maxAttempts ||
+            (action == MIOTYATRETRY_REATTACH && !retry->reattach))
+            return rc;
+        if (!take_budget(retry)) {
+            retry->stats.exhausted++;
+            return rc;
+        }
+
+        miotyAtRetry_event event = {
+            .returnCode = rc, .action = action, .timeoutClass = timeoutClass, .attempt = attempt,
+            .delayMs = backoff(retry, limits, attempt),
+        };
+        if (retry->hook && !retry->hook(&event, retry->hookUser)) {
+            give_budget(retry);
+            retry->stats.vetoed++;
+            return rc;
+        }
+        wait_ms(retry, event.delayMs);
+        if (action == MIOTYATRETRY_REATTACH) {
+            retry->stats.reattaches++;
+            rc = retry->reattach(retry->ctx, retry->reattachUser);
+            if (rc != MIOTYATCLIENT_RETURN_CODE_OK)
+                return rc;
+        }
+        retry->stats.retries++;
+    }
+}
+
+miotyAtClient_returnCode miotyAtRetry_sendMessageUni(miotyAtRetry *retry, const uint8_t *msg, size_t sizeMsg,
+                                                     uint32_t *packetCounter) {
+    send_args args = { .msg = msg, .sizeMsg = sizeMsg, .packetCounter = packetCounter };
+    return miotyAtRetry_run(retry, MIOTYATCLIENT_TIMEOUT_UPLINK, send_uni, &args);
+}
+
+miotyAtClient_returnCode miotyAtRetry_sendMessageBidi(miotyAtRetry *retry, const uint8_t *msg, size_t sizeMsg,
+                                                      uint8_t *data, size_t *size_data,
+                                                      uint8_t *dl_mpf, uint32_t *packetCounter) {
+    send_args args = { .msg = msg, .sizeMsg = sizeMsg, .data = data, .sizeData = size_data, .sizeBuffer = *size_data,
+                       .dlMpf = dl_mpf, .packetCounter = packetCounter };
+    return miotyAtRetry_run(retry, MIOTYATCLIENT_TIMEOUT_BIDI, send_bidi, &args);
+}
+
+static bool take_budget(miotyAtRetry *retry) {
+    if (retry->budgetMax == 0)
+        return true;
+    if (retry->budget == 0)
+        return false;
+    retry->budget--;
+    return true;
+}
+
+static void give_budget(miotyAtRetry *retry) {
+    if (retry->budgetMax != 0 && retry->budget < retry->budgetMax)
+        retry->budget++;
+}
+
+static void earn_budget(miotyAtRetry *retry) {
+    if (retry->budgetMax == 0 || retry->callsPerRetry == 0 || retry->budget >= retry->budgetMax)
+        return;
+    if (++retry->earned >= retry->callsPerRetry) {
+        retry->earned = 0;
+        retry->budget++;
+    }
+}
+
+// base delay doubled per attempt up to the cap, half of it fixed and half random ("equal jitter")
+static uint32_t backoff(miotyAtRetry *retry, const miotyAtRetry_limits *limits, uint8_t attempt) {
+    uint32_t delay = limits->baseDelayMs;
+    for (uint8_t i = 1; i < attempt && delay < limits->maxDelayMs; i++)
+        delay = delay > UINT32_MAX / 2 ? UINT32_MAX : 2 * delay;
+    if (delay > limits->maxDelayMs)
+        delay = limits->maxDelayMs;
+    const uint32_t half = delay / 2;
+    return delay - half + (half ? next_random(retry) % (half + 1) : 0);
+}
+
+static uint32_t next_random(miotyAtRetry *retry) {
+    uint32_t x = retry->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    retry->random = x;
+    return x;
+}
+
+// keeps the context serving URCs while it waits
+static void wait_ms(miotyAtRetry *retry, uint32_t ms) {
+    miotyAtClient_ctx *ctx = retry->ctx;
+    if (ms == 0)
+        return;
+    if (retry->sleep) {
+        retry->sleep(retry->sleepUser, ms);
+        return;
+    }
+    if (!ctx->clock)
+        return;
+    const uint32_t start = ctx->clock(ctx->user);
+    while (ctx->clock(ctx->user) - start < ms) {
+        if (!miotyAtClient_poll(ctx) && ctx->idle)
+            ctx->idle(ctx->user);
+    }
+}
+
+static miotyAtClient_returnCode send_uni(miotyAtClient_ctx *ctx, void *arg) {
+    const send_args *args = arg;
+    return miotyAtClient_sendMessageUni_ex(ctx, args->msg, args->sizeMsg, args->packetCounter);
+}
+
+static miotyAtClient_returnCode send_bidi(miotyAtClient_ctx *ctx, void *arg) {
+    const send_args *args = arg;
+    *args->sizeData = args->sizeBuffer;
+    return miotyAtClient_sendMessageBidi_ex(ctx, args->msg, args->sizeMsg, args->data, args->sizeData,
+                                            args->dlMpf, args->packetCounter);
+}
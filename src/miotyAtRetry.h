@@ -0,0 +1,236 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Retries with jittered exponential backoff around the blocking client functions.
+ *
+ * Every return code is classified as success, transient (retry), fatal, or as needing a new attach first.
+ * Transient failures are retried after a delay that doubles with every attempt up to a cap, with a random
+ * part so that several devices hit by the same disturbance do not retry in step. Attempts and delays are
+ * limited per deadline class of the command, e.g. queries are retried sooner and more often than uplinks.
+ * A budget shared by all calls limits the retries to a share of the successful calls, so a bad radio link
+ * does not multiply the traffic. Every retry is reported to a hook, which may veto it.
+ *
+ *      miotyAtRetry retry;
+ *      miotyAtRetry_init(&retry, &ctx);
+ *      miotyAtRetry_setHook(&retry, log_retry, NULL);
+ *      rc = miotyAtRetry_sendMessageUni(&retry, msg, sizeof(msg), &packetCounter);
+ *
+ * Uplinks that failed with a timeout or a read error may have been sent nevertheless, and a failed downlink
+ * means the uplink went out; sending them again would duplicate them with the next packet counter, so the
+ * default classifier does not retry these. Use miotyAtJournal, which checks the packet counter of the modem
+ * before it sends again, or a classifier of your own if the uplinks may be duplicated.
+ */
+
+#ifndef _AT_RETRY_H
+#define _AT_RETRY_H
+
+#include "miotyAtClient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** What to do after a call returned */
+typedef enum miotyAtRetry_action {
+    MIOTYATRETRY_SUCCESS    = 0,    // done, the call succeeded
+    MIOTYATRETRY_RETRY      = 1,    // transient failure, call again after the backoff delay
+    MIOTYATRETRY_FATAL      = 2,    // done, calling again would fail the same way
+    MIOTYATRETRY_REATTACH   = 3,    // the end-point lost its attachment, attach and call again
+} miotyAtRetry_action;
+
+/**
+ * @brief Classifies the return code of a call, see \ref miotyAtRetry_classify
+ *
+ * @param[in]   returnCode      Return code of the call
+ * @param[in]   timeoutClass    Deadline class of the command
+ * @param[in]   user            User pointer of \ref miotyAtRetry_setClassifier
+ */
+typedef miotyAtRetry_action (*miotyAtRetry_classifyFn)(miotyAtClient_returnCode returnCode,
+                                                       miotyAtClient_timeoutClass timeoutClass, void *user);
+
+/** A retry, handed to the hook before the delay */
+typedef struct miotyAtRetry_event {
+    miotyAtClient_returnCode    returnCode;     // of the failed attempt
+    miotyAtRetry_action         action;         // MIOTYATRETRY_RETRY or MIOTYATRETRY_REATTACH
+    miotyAtClient_timeoutClass  timeoutClass;
+    uint8_t                     attempt;        // number of the failed attempt, 1 for the first call
+    uint32_t                    delayMs;        // before the next attempt
+} miotyAtRetry_event;
+
+/** Called for every retry, returns false to veto it: the call then ends with the failure of the attempt */
+typedef bool (*miotyAtRetry_hookFn)(const miotyAtRetry_event *event, void *user);
+
+/** Attaches the end-point again, e.g. with miotyAtClient_macAttachLocal_ex */
+typedef miotyAtClient_returnCode (*miotyAtRetry_reattachFn)(miotyAtClient_ctx *ctx, void *user);
+
+/** Waits before the next attempt */
+typedef void (*miotyAtRetry_sleepFn)(void *user, uint32_t ms);
+
+/** A call retried by \ref miotyAtRetry_run */
+typedef miotyAtClient_returnCode (*miotyAtRetry_opFn)(miotyAtClient_ctx *ctx, void *arg);
+
+/** Limits of one deadline class, see \ref miotyAtRetry_setLimits */
+typedef struct miotyAtRetry_limits {
+    uint8_t     maxAttempts;    // calls including the first, 1 for no retries
+    uint32_t    baseDelayMs;    // before the first retry, doubled for every further one
+    uint32_t    maxDelayMs;     // cap of the delay
+} miotyAtRetry_limits;
+
+/** Counters of a retry engine */
+typedef struct miotyAtRetry_stats {
+    uint32_t    calls;
+    uint32_t    retries;        // calls made again, after reattaches too
+    uint32_t    reattaches;
+    uint32_t    exhausted;      // failures returned because the budget was used up
+    uint32_t    vetoed;         // failures returned because the hook vetoed the retry
+} miotyAtRetry_stats;
+
+/**
+ * @brief Retry engine of a client context, see \ref miotyAtRetry_init. Members are private.
+ */
+typedef struct miotyAtRetry {
+    miotyAtClient_ctx          *ctx;
+    miotyAtRetry_limits         limits[MIOTYATCLIENT_TIMEOUT_CLASS_COUNT];
+    miotyAtRetry_classifyFn     classify;
+    void                       *classifyUser;
+    miotyAtRetry_hookFn         hook;
+    void                       *hookUser;
+    miotyAtRetry_reattachFn     reattach;
+    void                       *reattachUser;
+    miotyAtRetry_sleepFn        sleep;
+    void                       *sleepUser;
+    uint16_t                    budgetMax;      // 0 for no budget
+    uint16_t                    budget;         // retries left
+    uint16_t                    callsPerRetry;  // successful first attempts that earn one retry
+    uint16_t                    earned;         // successful first attempts towards the next retry
+    uint32_t                    random;         // xorshift state
+    miotyAtRetry_stats          stats;
+} miotyAtRetry;
+
+/**
+ * @brief Prepare a retry engine with the default classifier, limits and budget
+ *
+ * Queries and settings: 4 attempts, 100 ms doubled up to 1 s; uplinks: 3 attempts, 2 s up to 8 s;
+ * bidirectional uplinks: 3 attempts, 4 s up to 16 s; attach and detach: 2 attempts, 5 s.
+ * Budget: 10 retries, one more for every 10 calls that succeed at the first attempt.
+ * Delays are waited with the clock and idle callback of ctx, without clock they are skipped unless
+ * \ref miotyAtRetry_setSleep provides a sleep function.
+ *
+ * @param[out]  retry   Retry engine
+ * @param[in]   ctx     Client context the calls are made with, must stay valid while retry is used
+ */
+void miotyAtRetry_init(miotyAtRetry *retry, miotyAtClient_ctx *ctx);
+
+/**
+ * @brief Set the attempts and delays of the commands of a deadline class
+ */
+void miotyAtRetry_setLimits(miotyAtRetry *retry, miotyAtClient_timeoutClass timeoutClass, const miotyAtRetry_limits *limits);
+
+/**
+ * @brief Set the retry budget shared by all calls
+ *
+ * @param[in,out]   retry           Retry engine
+ * @param[in]       maxRetries      Retries the budget holds, it starts full; 0 for no budget
+ * @param[in]       callsPerRetry   Calls succeeding at the first attempt that earn one retry back, 0 for none
+ */
+void miotyAtRetry_setBudget(miotyAtRetry *retry, uint16_t maxRetries, uint16_t callsPerRetry);
+
+/**
+ * @brief Replace the classifier, NULL for \ref miotyAtRetry_classify
+ */
+void miotyAtRetry_setClassifier(miotyAtRetry *retry, miotyAtRetry_classifyFn classify, void *user);
+
+/**
+ * @brief Set the hook called for every retry, NULL for none
+ *
+ * The hook is called before the delay, once the retry passed the limits and the budget; a vetoed retry
+ * gives its share of the budget back.
+ */
+void miotyAtRetry_setHook(miotyAtRetry *retry, miotyAtRetry_hookFn hook, void *user);
+
+/**
+ * @brief Set how the end-point is attached again, NULL to treat a lost attachment as fatal (default)
+ */
+void miotyAtRetry_setReattach(miotyAtRetry *retry, miotyAtRetry_reattachFn reattach, void *user);
+
+/**
+ * @brief Set the function the delays are waited with, NULL for the clock and idle callback of the context
+ */
+void miotyAtRetry_setSleep(miotyAtRetry *retry, miotyAtRetry_sleepFn sleep, void *user);
+
+/**
+ * @brief Seed the random part of the delays, e.g. with the EUI, so devices do not retry in step
+ */
+void miotyAtRetry_seed(miotyAtRetry *retry, uint32_t seed);
+
+/**
+ * @brief Default classifier
+ *
+ * Retried: MacError, MacFramingError, ERR and PreviousCommandNotFinished, for commands other than uplinks also
+ * MacNoDownlinkReceived, MacDownlinkErr, DownlinkDataCorrupted, ATReadFailed and Timeout. For the deadline
+ * classes MIOTYATCLIENT_TIMEOUT_UPLINK and MIOTYATCLIENT_TIMEOUT_BIDI these are fatal, the uplink may have been
+ * sent. MacNodeNotAttached needs a reattach. All others are fatal.
+ */
+miotyAtRetry_action miotyAtRetry_classify(miotyAtClient_returnCode returnCode, miotyAtClient_timeoutClass timeoutClass, void *user);
+
+/**
+ * @brief Call op until it succeeds, fails for good, or the attempts or the budget are used up
+ *
+ * @param[in,out]   retry           Retry engine
+ * @param[in]       timeoutClass    Deadline class of the command op runs, selects the limits
+ * @param[in]       op              Call, made with the context of retry
+ * @param[in]       arg             Handed to op
+ *
+ * @return  Return code of the last attempt, or of the reattach if that failed
+ */
+miotyAtClient_returnCode miotyAtRetry_run(miotyAtRetry *retry, miotyAtClient_timeoutClass timeoutClass,
+                                          miotyAtRetry_opFn op, void *arg);
+
+/**
+ * @brief \ref miotyAtClient_sendMessageUni_ex with retries
+ */
+miotyAtClient_returnCode miotyAtRetry_sendMessageUni(miotyAtRetry *retry, const uint8_t *msg, size_t sizeMsg,
+                                                     uint32_t *packetCounter);
+
+/**
+ * @brief \ref miotyAtClient_sendMessageBidi_ex with retries, size_data is the size of data for every attempt
+ */
+miotyAtClient_returnCode miotyAtRetry_sendMessageBidi(miotyAtRetry *retry, const uint8_t *msg, size_t sizeMsg,
+                                                      uint8_t *data, size_t *size_data,
+                                                      uint8_t *dl_mpf, uint32_t *packetCounter);
+
+/**
+ * @brief Counters since \ref miotyAtRetry_init
+ */
+static inline const miotyAtRetry_stats *miotyAtRetry_getStats(const miotyAtRetry *retry) {
+    return &retry->stats;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AT_RETRY_H */
@@ -0,0 +1,287 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Serial transport for POSIX hosts.
+ *
+ * The tty is non-blocking with VMIN = 1 and VTIME = 0, every wait is a poll() on it, so the process never
+ * hangs in read() or write() and a deadline of the client is at most MIOTYATSERIAL_IDLE_MS late.
+ * Without data read() fails with EAGAIN then, so a read of 0 bytes is the end of file of a hung up
+ * tty; that and POLLHUP/POLLERR fail the transport with EIO instead of being polled forever.
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "miotyAtSerial.h"
+
+#define IOV_BATCH   16      // pieces handed to one writev()
+
+typedef struct {
+    uint32_t    baud;
+    speed_t     speed;
+} baud_rate;
+
+static const baud_rate baud_rates[] = {
+    { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 },
+#ifdef B57600
+    { 57600, B57600 },
+#endif
+#ifdef B115200
+    { 115200, B115200 },
+#endif
+#ifdef B230400
+    { 230400, B230400 },
+#endif
+#ifdef B460800
+    { 460800, B460800 },
+#endif
+#ifdef B921600
+    { 921600, B921600 },
+#endif
+};
+
+static miotyAtClient_returnCode configure(miotyAtSerial *serial, speed_t speed, bool restore);
+static void fail(miotyAtSerial *serial, int err);
+static bool wait_fd(miotyAtSerial *serial, short events, int timeoutMs);
+
+
+miotyAtClient_returnCode miotyAtSerial_open(miotyAtSerial *serial, const char *path, uint32_t baud) {
+    serial->fd = -1;
+    serial->peerFd = -1;
+    serial->error = 0;
+    serial->restore = false;
+
+    const baud_rate *rate = NULL;
+    for (size_t i = 0; i < sizeof(baud_rates) / sizeof(baud_rates[0]); i++) {
+        if (baud_rates[i].baud == baud)
+            rate = &baud_rates[i];
+    }
+    if (!rate)
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentOOR;
+
+    serial->fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (serial->fd < 0)
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    return configure(serial, rate->speed, true);
+}
+
+miotyAtClient_returnCode miotyAtSerial_openLoopback(miotyAtSerial *serial) {
+    serial->fd = -1;
+    serial->error = 0;
+    serial->restore = false;
+
+    serial->peerFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (serial->peerFd < 0)
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    const char *name;
+    if (grantpt(serial->peerFd) != 0 || unlockpt(serial->peerFd) != 0 || (name = ptsname(serial->peerFd)) == NULL
+        || fcntl(serial->peerFd, F_SETFL, O_NONBLOCK) != 0 || fcntl(serial->peerFd, F_SETFD, FD_CLOEXEC) != 0) {
+        miotyAtSerial_close(serial);
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    }
+    serial->fd = open(name, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (serial->fd < 0) {
+        miotyAtSerial_close(serial);
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    }
+    /* the speed of a pty has no effect, but raw mode keeps the line discipline from touching the data */
+    return configure(serial, B38400, false);
+}
+
+void miotyAtSerial_close(miotyAtSerial *serial) {
+    if (serial->fd >= 0) {
+        if (serial->restore)
+            tcsetattr(serial->fd, TCSANOW, &serial->saved);
+        close(serial->fd);
+    }
+    if (serial->peerFd >= 0)
+        close(serial->peerFd);
+    serial->fd = -1;
+    serial->peerFd = -1;
+    serial->restore = false;
+}
+
+void miotyAtSerial_bind(miotyAtSerial *serial, miotyAtClient_ctx *ctx) {
+    miotyAtClient_init(ctx, miotyAtSerial_write, miotyAtSerial_read, serial);
+    miotyAtClient_setWritev(ctx, miotyAtSerial_writev);
+    miotyAtClient_setClock(ctx, miotyAtSerial_clockMs);
+    miotyAtClient_setIdle(ctx, miotyAtSerial_idle);
+}
+
+bool miotyAtSerial_service(miotyAtSerial *serial, miotyAtClient_ctx *ctx) {
+    uint8_t buf[MIOTYATSERIAL_READ_SIZE];
+    while (serial->error == 0) {
+        ssize_t n = read(serial->fd, buf, sizeof(buf));
+        if (n > 0) {
+            miotyAtClient_feed(ctx, buf, (size_t)n);
+            if ((size_t)n < sizeof(buf))
+                break;
+        } else if (n == 0) {
+            fail(serial, EIO);
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else if (errno != EINTR) {
+            fail(serial, errno);
+        }
+    }
+    /* deadlines and queued commands, the read callback reports a failure to the running command */
+    miotyAtClient_poll(ctx);
+    return serial->error == 0;
+}
+
+void miotyAtSerial_write(void *user, const uint8_t *data, size_t len) {
+    miotyAtClient_iovec iov = { data, len };
+    miotyAtSerial_writev(user, &iov, 1);
+}
+
+void miotyAtSerial_writev(void *user, const miotyAtClient_iovec *iov, size_t count) {
+    miotyAtSerial *serial = user;
+    struct iovec vec[IOV_BATCH];
+    while (count > 0 && serial->error == 0) {
+        size_t n = count < IOV_BATCH ? count : IOV_BATCH;
+        for (size_t i = 0; i < n; i++) {
+            vec[i].iov_base = (void *)iov[i].data;
+            vec[i].iov_len = iov[i].len;
+        }
+        iov += n;
+        count -= n;
+
+        /* a full output buffer takes partial writes, continue behind the bytes taken */
+        struct iovec *v = vec;
+        while (n > 0 && serial->error == 0) {
+            ssize_t w = writev(serial->fd, v, (int)n);
+            if (w < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    if (!wait_fd(serial, POLLOUT, MIOTYATSERIAL_WRITE_TIMEOUT_MS))
+                        fail(serial, ETIMEDOUT);
+                } else if (errno != EINTR) {
+                    fail(serial, errno);
+                }
+                continue;
+            }
+            size_t done = (size_t)w;
+            while (n > 0 && done >= v->iov_len) {
+                done -= v->iov_len;
+                v++;
+                n--;
+            }
+            if (n > 0) {
+                v->iov_base = (uint8_t *)v->iov_base + done;
+                v->iov_len -= done;
+            }
+        }
+    }
+}
+
+bool miotyAtSerial_read(void *user, uint8_t *data, size_t *len_out) {
+    miotyAtSerial *serial = user;
+    size_t len = *len_out;
+    *len_out = 0;
+    while (serial->error == 0) {
+        ssize_t n = read(serial->fd, data, len);
+        if (n > 0 || (n == 0 && len == 0)) {
+            *len_out = (size_t)n;
+            break;
+        }
+        if (n == 0)
+            fail(serial, EIO);
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        else if (errno != EINTR)
+            fail(serial, errno);
+    }
+    return serial->error == 0;
+}
+
+uint32_t miotyAtSerial_clockMs(void *user) {
+    (void)user;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
+
+void miotyAtSerial_idle(void *user) {
+    miotyAtSerial *serial = user;
+    if (serial->error == 0)
+        wait_fd(serial, POLLIN, MIOTYATSERIAL_IDLE_MS);
+}
+
+// raw mode, 8N1, no flow control, reads return right away as the tty is non-blocking
+static miotyAtClient_returnCode configure(miotyAtSerial *serial, speed_t speed, bool restore) {
+    struct termios tio;
+    if (tcgetattr(serial->fd, &tio) != 0) {
+        miotyAtSerial_close(serial);
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    }
+    serial->saved = tio;
+    tio.c_iflag &= ~(tcflag_t)(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF | IXANY);
+    tio.c_oflag &= ~(tcflag_t)OPOST;
+    tio.c_lflag &= ~(tcflag_t)(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(tcflag_t)(CSIZE | PARENB | CSTOPB);
+#ifdef CRTSCTS
+    tio.c_cflag &= ~(tcflag_t)CRTSCTS;
+#endif
+    tio.c_cflag |= CS8 | CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (cfsetispeed(&tio, speed) != 0 || cfsetospeed(&tio, speed) != 0 || tcsetattr(serial->fd, TCSANOW, &tio) != 0) {
+        miotyAtSerial_close(serial);
+        return MIOTYATCLIENT_RETURN_CODE_ERR;
+    }
+    serial->restore = restore;
+    tcflush(serial->fd, TCIOFLUSH);
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+// remembers the first error, the read callback reports it to the client
+static void fail(miotyAtSerial *serial, int err) {
+    if (serial->error == 0)
+        serial->error = err;
+}
+
+// waits for events on the tty, false on timeout or error; a hang up without data left to read fails the transport
+static bool wait_fd(miotyAtSerial *serial, short events, int timeoutMs) {
+    struct pollfd pfd = { .fd = serial->fd, .events = events, .revents = 0 };
+    int r;
+    do {
+        r = poll(&pfd, 1, timeoutMs);
+    } while (r < 0 && errno == EINTR);
+    if (r > 0 && ((pfd.revents & (POLLERR | POLLNVAL)) || (pfd.revents & (POLLHUP | POLLIN)) == POLLHUP)) {
+        fail(serial, EIO);
+        return false;
+    }
+    return r > 0;
+}
+
+#endif /* __unix__ || __APPLE__ */
@@ -0,0 +1,181 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Serial transport for POSIX hosts, e.g. a m.YON modem on /dev/ttyUSB0.
+ *
+ * The tty is opened non-blocking in raw mode, so it can be driven by the blocking functions as well
+ * as by an event loop:
+ *
+ *      miotyAtSerial serial;
+ *      miotyAtSerial_open(&serial, "/dev/ttyUSB0", 115200);
+ *      miotyAtSerial_bind(&serial, &ctx);
+ *
+ * Blocking functions then sleep in poll() on the tty instead of spinning. An event loop waits for
+ * \ref miotyAtSerial_fd to become readable with epoll/poll/select and calls \ref miotyAtSerial_service,
+ * which reads everything available in large chunks and parses it in place. Commands are written
+ * with writev() straight from the pieces the client hands over.
+ *
+ * \ref miotyAtSerial_openLoopback opens a pseudo terminal instead of a device, the other end of it
+ * is \ref miotyAtSerial_peerFd. With myonSim_serve of the host simulator on that end the transport
+ * is tested without hardware.
+ *
+ * Only available on POSIX systems (MIOTYATSERIAL_AVAILABLE is defined then).
+ */
+
+#ifndef _AT_SERIAL_H
+#define _AT_SERIAL_H
+
+#include "miotyAtClient.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MIOTYATSERIAL_AVAILABLE 1
+
+#include <termios.h>
+
+#ifndef MIOTYATSERIAL_READ_SIZE
+/** Size of the chunks read by \ref miotyAtSerial_service */
+#define MIOTYATSERIAL_READ_SIZE         1024
+#endif
+
+#ifndef MIOTYATSERIAL_IDLE_MS
+/** Longest sleep of a blocking function between two checks of its deadline */
+#define MIOTYATSERIAL_IDLE_MS           10
+#endif
+
+#ifndef MIOTYATSERIAL_WRITE_TIMEOUT_MS
+/** Longest wait for room in the output buffer of the tty before a write fails */
+#define MIOTYATSERIAL_WRITE_TIMEOUT_MS  1000
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Serial port opened by \ref miotyAtSerial_open or \ref miotyAtSerial_openLoopback. Members are private.
+ */
+typedef struct miotyAtSerial {
+    int             fd;             // tty, non-blocking
+    int             peerFd;         // master side of the loopback pty, -1 for a device
+    int             error;          // errno of the first failed read or write, 0 if none
+    bool            restore;        // saved holds the settings to restore on close
+    struct termios  saved;
+} miotyAtSerial;
+
+/**
+ * @brief Open a tty and configure it for the modem: raw mode, 8N1, no flow control, the given baud rate
+ *
+ * @param[out]  serial  Serial port
+ * @param[in]   path    Device, e.g. /dev/ttyUSB0
+ * @param[in]   baud    Baud rate, e.g. 115200
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK,
+ *              MIOTYATCLIENT_RETURN_CODE_ArgumentOOR if the baud rate is not supported,
+ *              MIOTYATCLIENT_RETURN_CODE_ERR if the device can not be opened or configured
+ */
+miotyAtClient_returnCode miotyAtSerial_open(miotyAtSerial *serial, const char *path, uint32_t baud);
+
+/**
+ * @brief Open a pseudo terminal pair, the transport uses the slave side configured like a device
+ *
+ * The master side is returned by \ref miotyAtSerial_peerFd, non-blocking; whatever is written to it
+ * is read by the client and vice versa.
+ *
+ * @param[out]  serial  Serial port
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK, MIOTYATCLIENT_RETURN_CODE_ERR if no pseudo terminal is available
+ */
+miotyAtClient_returnCode miotyAtSerial_openLoopback(miotyAtSerial *serial);
+
+/**
+ * @brief Restore the tty settings and close the serial port, both sides of a loopback
+ */
+void miotyAtSerial_close(miotyAtSerial *serial);
+
+/**
+ * @brief File descriptor of the tty, for poll/epoll/select. Reading or writing it directly bypasses the client.
+ */
+static inline int miotyAtSerial_fd(const miotyAtSerial *serial) {
+    return serial->fd;
+}
+
+/**
+ * @brief File descriptor of the other end of a loopback, -1 for a device
+ */
+static inline int miotyAtSerial_peerFd(const miotyAtSerial *serial) {
+    return serial->peerFd;
+}
+
+/**
+ * @brief Initialize a client context with this serial port as its transport
+ *
+ * Sets the write, gather write and read callbacks, a CLOCK_MONOTONIC clock and an idle callback
+ * that sleeps until the tty is readable, at most MIOTYATSERIAL_IDLE_MS.
+ *
+ * @param[in]   serial  Serial port, must stay valid as long as ctx is used
+ * @param[out]  ctx     Client context to initialize
+ */
+void miotyAtSerial_bind(miotyAtSerial *serial, miotyAtClient_ctx *ctx);
+
+/**
+ * @brief Read everything available from the tty and advance the commands of ctx, for event loops
+ *
+ * Call when \ref miotyAtSerial_fd is readable and when the next deadline of ctx is due,
+ * it never blocks.
+ *
+ * @param[in,out]   serial  Serial port bound to ctx
+ * @param[in,out]   ctx     Client context
+ *
+ * @return      false if the tty failed or was hung up, see \ref miotyAtSerial_error
+ */
+bool miotyAtSerial_service(miotyAtSerial *serial, miotyAtClient_ctx *ctx);
+
+/**
+ * @brief errno of the first failed read or write, 0 if none
+ *
+ * After a failure the read callback reports it, so the running command is completed with
+ * MIOTYATCLIENT_RETURN_CODE_ATReadFailed instead of waiting for its deadline.
+ */
+static inline int miotyAtSerial_error(const miotyAtSerial *serial) {
+    return serial->error;
+}
+
+/**
+ * @brief Transport callbacks used by \ref miotyAtSerial_bind, user is the miotyAtSerial
+ */
+void miotyAtSerial_write(void *user, const uint8_t *data, size_t len);
+void miotyAtSerial_writev(void *user, const miotyAtClient_iovec *iov, size_t count);
+bool miotyAtSerial_read(void *user, uint8_t *data, size_t *len_out);
+uint32_t miotyAtSerial_clockMs(void *user);
+void miotyAtSerial_idle(void *user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __unix__ || __APPLE__ */
+
+#endif
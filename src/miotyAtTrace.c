@@ -0,0 +1,140 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Binary trace ring of the AT exchange.
+ */
+
+#include <string.h>
+#include "miotyAtTrace.h"
+
+static void drop_oldest(miotyAtTrace *trace);
+static uint32_t put(const miotyAtTrace *trace, uint32_t pos, const void *data, uint32_t len);
+static uint32_t get(const miotyAtTrace *trace, uint32_t pos, void *data, uint32_t len);
+static void put_le32(uint8_t *p, uint32_t v);
+
+
+void miotyAtTrace_init(miotyAtTrace *trace, uint8_t *buf, size_t size) {
+    memset(trace, 0, sizeof(*trace));
+    trace->buf = buf;
+    trace->size = size > UINT32_MAX ? UINT32_MAX : (uint32_t)size;
+    trace->ticksPerSecond = 1000;
+}
+
+void miotyAtTrace_setClock(miotyAtTrace *trace, miotyAtClient_clockFn clock, void *user, uint32_t ticksPerSecond) {
+    trace->clock = clock;
+    trace->clockUser = user;
+    trace->ticksPerSecond = clock ? ticksPerSecond : 1000;
+}
+
+void miotyAtTrace_clear(miotyAtTrace *trace) {
+    trace->head = 0;
+    trace->tail = 0;
+    trace->used = 0;
+    trace->dropped = 0;
+}
+
+void miotyAtTrace_record(miotyAtTrace *trace, miotyAtTrace_type type, uint8_t cmd, uint32_t time,
+                         const miotyAtClient_iovec *iov, size_t count) {
+    if (trace->size <= MIOTYATTRACE_RECORD_HEADER)
+        return;
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+        total += iov[i].len;
+    uint32_t len = total > UINT16_MAX ? UINT16_MAX : (uint32_t)total;
+    if (len > trace->size - MIOTYATTRACE_RECORD_HEADER)
+        len = trace->size - MIOTYATTRACE_RECORD_HEADER;
+    while (trace->size - trace->used < MIOTYATTRACE_RECORD_HEADER + len)
+        drop_oldest(trace);
+
+    uint8_t header[MIOTYATTRACE_RECORD_HEADER];
+    put_le32(header, time);
+    header[4] = (uint8_t)type | (len < total ? MIOTYATTRACE_TRUNCATED : 0);
+    header[5] = cmd;
+    header[6] = (uint8_t)len;
+    header[7] = (uint8_t)(len >> 8);
+    uint32_t pos = put(trace, trace->head, header, sizeof(header));
+    uint32_t room = len;
+    for (size_t i = 0; i < count && room > 0; i++) {
+        uint32_t n = iov[i].len < room ? (uint32_t)iov[i].len : room;
+        pos = put(trace, pos, iov[i].data, n);
+        room -= n;
+    }
+    trace->head = pos;
+    trace->used += MIOTYATTRACE_RECORD_HEADER + len;
+}
+
+size_t miotyAtTrace_dump(const miotyAtTrace *trace, uint8_t *out, size_t sizeOut) {
+    const size_t size = MIOTYATTRACE_FILE_HEADER + trace->used;
+    if (!out)
+        return size;
+    if (sizeOut < size)
+        return 0;
+    memcpy(out, "MTRC", 4);
+    out[4] = MIOTYATTRACE_VERSION;
+    out[5] = out[6] = out[7] = 0;
+    put_le32(&out[8], trace->ticksPerSecond);
+    put_le32(&out[12], trace->dropped);
+    get(trace, trace->tail, &out[MIOTYATTRACE_FILE_HEADER], trace->used);
+    return size;
+}
+
+static void drop_oldest(miotyAtTrace *trace) {
+    uint8_t header[MIOTYATTRACE_RECORD_HEADER];
+    get(trace, trace->tail, header, sizeof(header));
+    uint32_t len = MIOTYATTRACE_RECORD_HEADER + (header[6] | (uint32_t)header[7] << 8);
+    trace->tail = (uint32_t)(((uint64_t)trace->tail + len) % trace->size);
+    trace->used -= len;
+    trace->dropped++;
+}
+
+// copies len bytes to the ring at pos, returns the position behind them
+static uint32_t put(const miotyAtTrace *trace, uint32_t pos, const void *data, uint32_t len) {
+    uint32_t first = trace->size - pos;
+    if (first > len)
+        first = len;
+    memcpy(&trace->buf[pos], data, first);
+    memcpy(trace->buf, (const uint8_t *)data + first, len - first);
+    pos += len;
+    return pos >= trace->size ? pos - trace->size : pos;
+}
+
+// copies len bytes of the ring at pos, returns the position behind them
+static uint32_t get(const miotyAtTrace *trace, uint32_t pos, void *data, uint32_t len) {
+    uint32_t first = trace->size - pos;
+    if (first > len)
+        first = len;
+    memcpy(data, &trace->buf[pos], first);
+    memcpy((uint8_t *)data + first, trace->buf, len - first);
+    pos += len;
+    return pos >= trace->size ? pos - trace->size : pos;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
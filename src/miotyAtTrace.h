@@ -0,0 +1,142 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Binary trace of the AT exchange of a client context, for analysis after the fact.
+ *
+ * Attached to a context with \ref miotyAtClient_setTrace (requires MIOTYATCLIENT_TRACE), the trace records
+ * every write to the modem, every received chunk and the return code of every completed command into a ring
+ * in memory provided by the application. Nothing is formatted while recording: a record is an 8 byte header
+ * with timestamp, type, command number and length, followed by the bytes as they went over the wire. When the
+ * ring is full the oldest records are dropped.
+ *
+ * \ref miotyAtTrace_dump copies the records oldest first behind a 16 byte file header. The host tool
+ * extras/trace/myon_trace renders such a dump as an annotated AT transcript.
+ *
+ * File header, little endian:  "MTRC", version (1), 3 reserved bytes, ticks per second (u32), dropped records (u32)
+ * Record, little endian:       time (u32), type (u8, bit 7 set if the data was cut), command (u8), length (u16), data
+ */
+
+#ifndef _AT_TRACE_H
+#define _AT_TRACE_H
+
+#include "miotyAtClient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Version of the dump format written by \ref miotyAtTrace_dump */
+#define MIOTYATTRACE_VERSION        1
+
+/** Size of the file header of a dump */
+#define MIOTYATTRACE_FILE_HEADER    16
+
+/** Size of the header of a record */
+#define MIOTYATTRACE_RECORD_HEADER  8
+
+/** Record types */
+typedef enum miotyAtTrace_type {
+    MIOTYATTRACE_TX     = 0,    // bytes written to the modem
+    MIOTYATTRACE_RX     = 1,    // bytes received from the modem
+    MIOTYATTRACE_DONE   = 2,    // command completed, data is its miotyAtClient_returnCode as u16
+} miotyAtTrace_type;
+
+/** Set in the type byte of a record whose data did not fit into the ring and was cut */
+#define MIOTYATTRACE_TRUNCATED      0x80
+
+/**
+ * @brief Trace ring, see \ref miotyAtTrace_init. Members are private.
+ */
+typedef struct miotyAtTrace {
+    uint8_t                *buf;
+    uint32_t                size;
+    uint32_t                head;           // offset of the next record
+    uint32_t                tail;           // offset of the oldest record
+    uint32_t                used;           // bytes between tail and head
+    uint32_t                dropped;        // records overwritten since the last clear
+    miotyAtClient_clockFn   clock;          // NULL for the clock of the context
+    void                   *clockUser;
+    uint32_t                ticksPerSecond;
+} miotyAtTrace;
+
+/**
+ * @brief Prepare a trace ring
+ *
+ * Timestamps are taken from the clock of the traced context (milliseconds) until \ref miotyAtTrace_setClock
+ * sets another one, and are 0 without clock.
+ *
+ * @param[out]  trace   Trace
+ * @param[in]   buf     Memory of the ring, must stay valid while the trace is used
+ * @param[in]   size    Size of buf, at least MIOTYATTRACE_RECORD_HEADER + 1
+ */
+void miotyAtTrace_init(miotyAtTrace *trace, uint8_t *buf, size_t size);
+
+/**
+ * @brief Set the clock of the timestamps, e.g. a microsecond timer
+ *
+ * @param[in,out]   trace           Trace
+ * @param[in]       clock           Clock, NULL for the clock of the traced context
+ * @param[in]       user            Handed to clock
+ * @param[in]       ticksPerSecond  Rate of clock, stored in dumps so the decoder can show times in seconds
+ */
+void miotyAtTrace_setClock(miotyAtTrace *trace, miotyAtClient_clockFn clock, void *user, uint32_t ticksPerSecond);
+
+/**
+ * @brief Drop all records
+ */
+void miotyAtTrace_clear(miotyAtTrace *trace);
+
+/**
+ * @brief Append a record, dropping the oldest ones as needed
+ *
+ * Called by the client context the trace is attached to; the pieces are stored one after the other as one record.
+ *
+ * @param[in,out]   trace   Trace
+ * @param[in]       type    miotyAtTrace_type
+ * @param[in]       cmd     Number of the command the record belongs to, 0 for none
+ * @param[in]       time    Timestamp
+ * @param[in]       iov     Pieces of the data
+ * @param[in]       count   Number of pieces
+ */
+void miotyAtTrace_record(miotyAtTrace *trace, miotyAtTrace_type type, uint8_t cmd, uint32_t time,
+                         const miotyAtClient_iovec *iov, size_t count);
+
+/**
+ * @brief Copy the records oldest first, behind a file header
+ *
+ * @param[in]   trace   Trace
+ * @param[out]  out     Memory for the dump, NULL to get its size
+ * @param[in]   sizeOut Size of out
+ *
+ * @return  Size of the dump, 0 if out is too small for it
+ */
+size_t miotyAtTrace_dump(const miotyAtTrace *trace, uint8_t *out, size_t sizeOut);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AT_TRACE_H */
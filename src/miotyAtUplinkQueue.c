@@ -0,0 +1,323 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Bounded uplink queue with priority classes in front of a MIOTY™ client context.
+ */
+
+#include <string.h>
+#include "miotyAtUplinkQueue.h"
+
+#define SLOT_NONE   0xFF
+
+static uint32_t now_ms(const miotyAtUplinkQueue *queue);
+static bool expired(const miotyAtUplinkQueue *queue, const miotyAtUplinkQueue_slot *slot, uint32_t now);
+static void unlink_slot(miotyAtUplinkQueue *queue, uint8_t index);
+static void discard(miotyAtUplinkQueue *queue, uint8_t index, miotyAtClient_returnCode returnCode);
+static void report(miotyAtUplinkQueue *queue, miotyAtUplinkQueue_doneFn done, void *user, miotyAtClient_returnCode returnCode);
+static uint8_t pick_victim(const miotyAtUplinkQueue *queue, uint8_t priority);
+static void expire_all(miotyAtUplinkQueue *queue);
+static void refill(miotyAtUplinkQueue *queue);
+static void uplink_done(miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user);
+static void update_backpressure(miotyAtUplinkQueue *queue);
+
+
+void miotyAtUplinkQueue_init(miotyAtUplinkQueue *queue, miotyAtClient_ctx *ctx, miotyAtUplinkQueue_dropPolicy policy) {
+    memset(queue, 0, sizeof(*queue));
+    queue->ctx = ctx;
+    queue->policy = policy;
+    for (uint8_t i = 0; i < MIOTYATUPLINKQUEUE_PRIORITY_COUNT; i++)
+        queue->head[i] = queue->tail[i] = SLOT_NONE;
+    for (uint8_t i = 0; i < MIOTYATUPLINKQUEUE_SIZE; i++)
+        queue->slots[i].next = (i + 1 < MIOTYATUPLINKQUEUE_SIZE) ? i + 1 : SLOT_NONE;
+    queue->free = 0;
+    queue->highWatermark = (MIOTYATUPLINKQUEUE_SIZE * 3 + 3) / 4;
+    queue->lowWatermark = MIOTYATUPLINKQUEUE_SIZE / 2;
+}
+
+miotyAtClient_returnCode miotyAtUplinkQueue_push(miotyAtUplinkQueue *queue, miotyAtClient_uplinkType type,
+                                                 miotyAtUplinkQueue_priority priority, const uint8_t *msg, size_t sizeMsg,
+                                                 uint32_t ttlMs, miotyAtUplinkQueue_doneFn done, void *user) {
+    if (sizeMsg > MIOTYATUPLINKQUEUE_MSG_SIZE)
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentSizeMismatch;
+    if ((unsigned)type > MIOTYATCLIENT_UPLINK_BIDI_TRANSPARENT || (unsigned)priority >= MIOTYATUPLINKQUEUE_PRIORITY_COUNT)
+        return MIOTYATCLIENT_RETURN_CODE_ArgumentOOR;
+
+    /* expired messages make room before anything is dropped */
+    if (queue->free == SLOT_NONE)
+        expire_all(queue);
+    uint8_t index = queue->free;
+    miotyAtUplinkQueue_doneFn victimDone = NULL;
+    void *victimUser = NULL;
+    if (index == SLOT_NONE) {
+        index = pick_victim(queue, priority);
+        if (index == SLOT_NONE) {
+            queue->stats.dropped++;
+            return MIOTYATCLIENT_RETURN_CODE_Dropped;
+        }
+        /* the slot of the dropped message is taken over before its callback may push again */
+        unlink_slot(queue, index);
+        victimDone = queue->slots[index].done;
+        victimUser = queue->slots[index].user;
+        queue->stats.dropped++;
+    } else {
+        queue->free = queue->slots[index].next;
+    }
+
+    miotyAtUplinkQueue_slot *slot = &queue->slots[index];
+    memcpy(slot->data, msg, sizeMsg);
+    slot->sizeData = sizeMsg;
+    slot->pushedMs = now_ms(queue);
+    slot->ttlMs = ttlMs;
+    slot->done = done;
+    slot->user = user;
+    slot->type = type;
+    slot->priority = priority;
+    slot->next = SLOT_NONE;
+
+    if (queue->tail[priority] == SLOT_NONE)
+        queue->head[priority] = index;
+    else
+        queue->slots[queue->tail[priority]].next = index;
+    queue->tail[priority] = index;
+
+    queue->stats.pushed++;
+    queue->stats.depth++;
+    queue->stats.depthByPriority[priority]++;
+    if (queue->stats.depth > queue->stats.maxDepth)
+        queue->stats.maxDepth = queue->stats.depth;
+
+    report(queue, victimDone, victimUser, MIOTYATCLIENT_RETURN_CODE_Dropped);
+    refill(queue);
+    update_backpressure(queue);
+    return MIOTYATCLIENT_RETURN_CODE_OK;
+}
+
+void miotyAtUplinkQueue_service(miotyAtUplinkQueue *queue) {
+    expire_all(queue);
+    refill(queue);
+    update_backpressure(queue);
+}
+
+bool miotyAtUplinkQueue_poll(miotyAtUplinkQueue *queue) {
+    miotyAtUplinkQueue_service(queue);
+    miotyAtClient_poll(queue->ctx);
+    return miotyAtUplinkQueue_count(queue) != 0;
+}
+
+void miotyAtUplinkQueue_setWatermarks(miotyAtUplinkQueue *queue, uint8_t high, uint8_t low,
+                                      miotyAtUplinkQueue_backpressureFn onBackpressure, void *user) {
+    if (high > MIOTYATUPLINKQUEUE_SIZE)
+        high = MIOTYATUPLINKQUEUE_SIZE;
+    if (low >= high)
+        low = high - 1;
+    queue->highWatermark = high;
+    queue->lowWatermark = low;
+    queue->onBackpressure = onBackpressure;
+    queue->user = user;
+    update_backpressure(queue);
+}
+
+bool miotyAtUplinkQueue_backpressure(const miotyAtUplinkQueue *queue) {
+    return queue->backpressure;
+}
+
+size_t miotyAtUplinkQueue_count(const miotyAtUplinkQueue *queue) {
+    return queue->stats.depth + queue->stats.inFlight;
+}
+
+void miotyAtUplinkQueue_getStats(const miotyAtUplinkQueue *queue, miotyAtUplinkQueue_stats *stats) {
+    *stats = queue->stats;
+    stats->oldestAgeMs = 0;
+    uint32_t now = now_ms(queue);
+    for (uint8_t p = 0; p < MIOTYATUPLINKQUEUE_PRIORITY_COUNT; p++) {
+        if (queue->head[p] == SLOT_NONE)
+            continue;
+        uint32_t age = now - queue->slots[queue->head[p]].pushedMs;
+        if (age > stats->oldestAgeMs)
+            stats->oldestAgeMs = age;
+    }
+}
+
+
+static uint32_t now_ms(const miotyAtUplinkQueue *queue) {
+    miotyAtClient_ctx *ctx = queue->ctx;
+    return ctx->clock ? ctx->clock(ctx->user) : 0;
+}
+
+static bool expired(const miotyAtUplinkQueue *queue, const miotyAtUplinkQueue_slot *slot, uint32_t now) {
+    return slot->ttlMs != 0 && queue->ctx->clock && now - slot->pushedMs > slot->ttlMs;
+}
+
+// removes a waiting slot from the list of its class
+static void unlink_slot(miotyAtUplinkQueue *queue, uint8_t index) {
+    miotyAtUplinkQueue_slot *slot = &queue->slots[index];
+    uint8_t prev = SLOT_NONE;
+    for (uint8_t i = queue->head[slot->priority]; i != index; i = queue->slots[i].next)
+        prev = i;
+    if (prev == SLOT_NONE)
+        queue->head[slot->priority] = slot->next;
+    else
+        queue->slots[prev].next = slot->next;
+    if (queue->tail[slot->priority] == index)
+        queue->tail[slot->priority] = prev;
+    queue->stats.depth--;
+    queue->stats.depthByPriority[slot->priority]--;
+}
+
+// frees an unlinked slot and reports it as not sent
+static void discard(miotyAtUplinkQueue *queue, uint8_t index, miotyAtClient_returnCode returnCode) {
+    miotyAtUplinkQueue_slot *slot = &queue->slots[index];
+    slot->next = queue->free;
+    queue->free = index;
+    if (returnCode == MIOTYATCLIENT_RETURN_CODE_Expired)
+        queue->stats.expired++;
+    else
+        queue->stats.dropped++;
+    report(queue, slot->done, slot->user, returnCode);
+}
+
+static void report(miotyAtUplinkQueue *queue, miotyAtUplinkQueue_doneFn done, void *user, miotyAtClient_returnCode returnCode) {
+    if (done) {
+        miotyAtClient_result result = { .returnCode = returnCode };
+        done(queue, &result, user);
+    }
+}
+
+// waiting slot to give up for a new message of the given class, SLOT_NONE to reject the new one
+static uint8_t pick_victim(const miotyAtUplinkQueue *queue, uint8_t priority) {
+    switch (queue->policy) {
+    case MIOTYATUPLINKQUEUE_DROP_OLDEST: {
+        uint8_t victim = SLOT_NONE;
+        uint32_t now = now_ms(queue), oldest = 0;
+        for (uint8_t p = 0; p < MIOTYATUPLINKQUEUE_PRIORITY_COUNT; p++) {
+            uint8_t i = queue->head[p];
+            if (i != SLOT_NONE && (victim == SLOT_NONE || now - queue->slots[i].pushedMs > oldest)) {
+                victim = i;
+                oldest = now - queue->slots[i].pushedMs;
+            }
+        }
+        return victim;
+    }
+    case MIOTYATUPLINKQUEUE_DROP_LOWEST:
+        for (uint8_t p = MIOTYATUPLINKQUEUE_PRIORITY_COUNT - 1; p > priority; p--) {
+            if (queue->tail[p] != SLOT_NONE)
+                return queue->tail[p];
+        }
+        return SLOT_NONE;
+    default:
+        return SLOT_NONE;
+    }
+}
+
+static void expire_all(miotyAtUplinkQueue *queue) {
+    if (!queue->ctx->clock)
+        return;
+    uint32_t now = now_ms(queue);
+    for (uint8_t p = 0; p < MIOTYATUPLINKQUEUE_PRIORITY_COUNT; p++) {
+        uint8_t i = queue->head[p];
+        while (i != SLOT_NONE) {
+            if (expired(queue, &queue->slots[i], now)) {
+                unlink_slot(queue, i);
+                discard(queue, i, MIOTYATCLIENT_RETURN_CODE_Expired);
+                i = queue->head[p];     // the callback may have changed the list
+            } else {
+                i = queue->slots[i].next;
+            }
+        }
+    }
+}
+
+// hands waiting messages to the client, highest class first, until IN_FLIGHT are in flight
+static void refill(miotyAtUplinkQueue *queue) {
+    uint8_t p = 0;
+    while (queue->stats.inFlight < MIOTYATUPLINKQUEUE_IN_FLIGHT && p < MIOTYATUPLINKQUEUE_PRIORITY_COUNT) {
+        uint8_t index = queue->head[p];
+        if (index == SLOT_NONE) {
+            p++;
+            continue;
+        }
+        miotyAtUplinkQueue_slot *slot = &queue->slots[index];
+        uint32_t now = now_ms(queue);
+        if (expired(queue, slot, now)) {
+            unlink_slot(queue, index);
+            discard(queue, index, MIOTYATCLIENT_RETURN_CODE_Expired);
+            continue;
+        }
+
+        /* the message is written before the response arrives, so its slot takes the downlink */
+        miotyAtClient_cmd cmd;
+        miotyAtClient_prepareUplink(&cmd, (miotyAtClient_uplinkType)slot->type, slot->data, slot->sizeData,
+                                    slot->data, sizeof(slot->data));
+        cmd.done = uplink_done;
+        cmd.user = queue;
+        if (miotyAtClient_submit(queue->ctx, &cmd) != MIOTYATCLIENT_RETURN_CODE_OK)
+            return;     // command queue of the client is full, retried on the next completion or service
+
+        unlink_slot(queue, index);
+        queue->inFlight[(queue->inFlightHead + queue->stats.inFlight) % MIOTYATUPLINKQUEUE_IN_FLIGHT] = index;
+        queue->stats.inFlight++;
+        queue->stats.lastWaitMs = now - slot->pushedMs;
+        if (queue->stats.lastWaitMs > queue->stats.maxWaitMs)
+            queue->stats.maxWaitMs = queue->stats.lastWaitMs;
+    }
+}
+
+// completion of an uplink, they complete in the order they were submitted
+static void uplink_done(miotyAtClient_ctx *ctx, const miotyAtClient_result *result, void *user) {
+    (void)ctx;
+    miotyAtUplinkQueue *queue = user;
+    uint8_t index = queue->inFlight[queue->inFlightHead];
+    miotyAtUplinkQueue_slot *slot = &queue->slots[index];
+    queue->inFlightHead = (queue->inFlightHead + 1) % MIOTYATUPLINKQUEUE_IN_FLIGHT;
+    queue->stats.inFlight--;
+    if (result->returnCode == MIOTYATCLIENT_RETURN_CODE_OK)
+        queue->stats.sent++;
+    else
+        queue->stats.failed++;
+
+    /* the slot is released after the callback, result->data points into it */
+    if (slot->done)
+        slot->done(queue, result, slot->user);
+    slot->next = queue->free;
+    queue->free = index;
+
+    refill(queue);
+    update_backpressure(queue);
+}
+
+static void update_backpressure(miotyAtUplinkQueue *queue) {
+    size_t used = miotyAtUplinkQueue_count(queue);
+    bool active = queue->backpressure;
+    if (!active && used >= queue->highWatermark)
+        active = true;
+    else if (active && used <= queue->lowWatermark)
+        active = false;
+    if (active == queue->backpressure)
+        return;
+    queue->backpressure = active;
+    if (queue->onBackpressure)
+        queue->onBackpressure(queue, active, queue->user);
+}
@@ -0,0 +1,247 @@
+/**
+ * \copyright    Copyright 2026 Swissphone Wireless AG
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in the
+ * Software without restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ * \version     0.3.0
+ * \brief       Bounded uplink queue with priority classes in front of a MIOTY™ client context.
+ *
+ * Producers push messages at any rate, the queue copies them into fixed slots and drains them
+ * to the modem with \ref miotyAtClient_submit. The next uplink is handed to the client while the
+ * previous one is still on air, so the modem gets it as soon as the previous one is completed.
+ *
+ *      miotyAtUplinkQueue queue;
+ *      miotyAtUplinkQueue_init(&queue, miotyAtClient_defaultCtx(), MIOTYATUPLINKQUEUE_DROP_OLDEST);
+ *      miotyAtUplinkQueue_push(&queue, MIOTYATCLIENT_UPLINK_UNI, MIOTYATUPLINKQUEUE_PRIORITY_NORMAL,
+ *                              reading, sizeof(reading), 60000, NULL, NULL);
+ *      while (miotyAtUplinkQueue_poll(&queue))
+ *          ;
+ *
+ * No memory is allocated. Message ages and time to live need the clock of the context, see
+ * \ref miotyAtClient_setClock. Without a clock messages never expire.
+ */
+
+#ifndef _AT_UPLINK_QUEUE_H
+#define _AT_UPLINK_QUEUE_H
+
+#include "miotyAtClient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MIOTYATUPLINKQUEUE_SIZE
+/** Number of messages a queue holds, including the ones handed to the client */
+#define MIOTYATUPLINKQUEUE_SIZE         8
+#endif
+
+#ifndef MIOTYATUPLINKQUEUE_MSG_SIZE
+/** Largest message, also the largest downlink of a bidirectional uplink */
+#define MIOTYATUPLINKQUEUE_MSG_SIZE     64
+#endif
+
+#ifndef MIOTYATUPLINKQUEUE_IN_FLIGHT
+/** Messages handed to the client at once, 2 keeps the next uplink ready behind the running one */
+#define MIOTYATUPLINKQUEUE_IN_FLIGHT    2
+#endif
+
+#if MIOTYATUPLINKQUEUE_SIZE < 1 || MIOTYATUPLINKQUEUE_SIZE > 254
+#error "MIOTYATUPLINKQUEUE_SIZE must be between 1 and 254"
+#endif
+
+#if MIOTYATUPLINKQUEUE_IN_FLIGHT < 1 || MIOTYATUPLINKQUEUE_IN_FLIGHT > MIOTYATCLIENT_CMD_QUEUE_SIZE
+#error "MIOTYATUPLINKQUEUE_IN_FLIGHT must be between 1 and MIOTYATCLIENT_CMD_QUEUE_SIZE"
+#endif
+
+/** Priority classes, messages of a higher class are always sent first, FIFO within a class */
+typedef enum miotyAtUplinkQueue_priority {
+    MIOTYATUPLINKQUEUE_PRIORITY_HIGH    = 0,
+    MIOTYATUPLINKQUEUE_PRIORITY_NORMAL  = 1,
+    MIOTYATUPLINKQUEUE_PRIORITY_LOW     = 2,
+    MIOTYATUPLINKQUEUE_PRIORITY_COUNT
+} miotyAtUplinkQueue_priority;
+
+/** What \ref miotyAtUplinkQueue_push does when all slots are used */
+typedef enum miotyAtUplinkQueue_dropPolicy {
+    MIOTYATUPLINKQUEUE_DROP_NEWEST      = 0, // reject the new message
+    MIOTYATUPLINKQUEUE_DROP_OLDEST      = 1, // drop the longest waiting message
+    MIOTYATUPLINKQUEUE_DROP_LOWEST      = 2, // drop the newest message of the lowest class below the new one
+} miotyAtUplinkQueue_dropPolicy;
+
+struct miotyAtUplinkQueue;
+
+/**
+ * @brief Completion callback of a message
+ *
+ * Called when the uplink is completed, with MIOTYATCLIENT_RETURN_CODE_Expired if its time to live
+ * passed before it was sent, or with MIOTYATCLIENT_RETURN_CODE_Dropped if the drop policy discarded it.
+ * For bidirectional uplinks result->data holds the downlink. Messages may be pushed from the callback.
+ *
+ * @param[in]   queue   Queue the message was pushed to
+ * @param[in]   result  Result of the uplink, only valid during the call
+ * @param[in]   user    User pointer of the message
+ */
+typedef void (*miotyAtUplinkQueue_doneFn)(struct miotyAtUplinkQueue *queue, const miotyAtClient_result *result, void *user);
+
+/**
+ * @brief Called when the backpressure signal of a queue changes
+ *
+ * @param[in]   queue   Queue
+ * @param[in]   active  true if producers should slow down, false if they may continue
+ * @param[in]   user    User pointer given to \ref miotyAtUplinkQueue_setWatermarks
+ */
+typedef void (*miotyAtUplinkQueue_backpressureFn)(struct miotyAtUplinkQueue *queue, bool active, void *user);
+
+/**
+ * @brief Counters and depth of a queue
+ */
+typedef struct miotyAtUplinkQueue_stats {
+    uint32_t    pushed;             // messages accepted by push
+    uint32_t    sent;               // uplinks completed with MIOTYATCLIENT_RETURN_CODE_OK
+    uint32_t    failed;             // uplinks completed with an error
+    uint32_t    expired;            // messages whose time to live passed before they were sent
+    uint32_t    dropped;            // messages discarded by the drop policy, including rejected ones
+    uint8_t     depth;              // messages waiting, not handed to the client yet
+    uint8_t     maxDepth;           // largest depth seen
+    uint8_t     inFlight;           // messages handed to the client
+    uint8_t     depthByPriority[MIOTYATUPLINKQUEUE_PRIORITY_COUNT];
+    uint32_t    oldestAgeMs;        // age of the longest waiting message
+    uint32_t    lastWaitMs;         // time from push to hand over of the last message handed to the client
+    uint32_t    maxWaitMs;          // longest time from push to hand over
+} miotyAtUplinkQueue_stats;
+
+/** Slot of a message. Private. */
+typedef struct miotyAtUplinkQueue_slot {
+    uint8_t                     data[MIOTYATUPLINKQUEUE_MSG_SIZE];  // message, then downlink of a bidirectional uplink
+    size_t                      sizeData;
+    uint32_t                    pushedMs;
+    uint32_t                    ttlMs;
+    miotyAtUplinkQueue_doneFn   done;
+    void                       *user;
+    uint8_t                     type;           // miotyAtClient_uplinkType
+    uint8_t                     priority;
+    uint8_t                     next;           // next slot of the same class or the free list
+} miotyAtUplinkQueue_slot;
+
+/**
+ * @brief State of an uplink queue. Members are private, use \ref miotyAtUplinkQueue_init.
+ */
+typedef struct miotyAtUplinkQueue {
+    miotyAtClient_ctx          *ctx;
+    miotyAtUplinkQueue_slot     slots[MIOTYATUPLINKQUEUE_SIZE];
+    uint8_t                     head[MIOTYATUPLINKQUEUE_PRIORITY_COUNT];    // oldest waiting slot of a class
+    uint8_t                     tail[MIOTYATUPLINKQUEUE_PRIORITY_COUNT];    // newest waiting slot of a class
+    uint8_t                     free;                                       // first unused slot
+    uint8_t                     inFlight[MIOTYATUPLINKQUEUE_IN_FLIGHT];     // slots handed to the client, oldest first
+    uint8_t                     inFlightHead;
+    uint8_t                     policy;                                     // miotyAtUplinkQueue_dropPolicy
+    uint8_t                     highWatermark;
+    uint8_t                     lowWatermark;
+    bool                        backpressure;
+    miotyAtUplinkQueue_backpressureFn onBackpressure;
+    void                       *user;
+    miotyAtUplinkQueue_stats    stats;
+} miotyAtUplinkQueue;
+
+/**
+ * @brief Initialize an empty uplink queue
+ *
+ * The backpressure watermarks are set to 3/4 and 1/2 of MIOTYATUPLINKQUEUE_SIZE.
+ *
+ * @param[out]  queue   Queue to initialize
+ * @param[in]   ctx     Client context the uplinks are sent with
+ * @param[in]   policy  What to do when a message is pushed to a full queue
+ */
+void miotyAtUplinkQueue_init(miotyAtUplinkQueue *queue, miotyAtClient_ctx *ctx, miotyAtUplinkQueue_dropPolicy policy);
+
+/**
+ * @brief Copy a message into the queue, it is sent when no message of a higher class is waiting
+ *
+ * @param[in,out]   queue       Queue
+ * @param[in]       type        Kind of the uplink
+ * @param[in]       priority    Class of the message
+ * @param[in]       msg         Message, copied
+ * @param[in]       sizeMsg     Size of msg, at most MIOTYATUPLINKQUEUE_MSG_SIZE
+ * @param[in]       ttlMs       Time the message may wait before it is sent, 0 for no limit
+ * @param[in]       done        Completion callback, may be NULL
+ * @param[in]       user        Handed to done
+ *
+ * @return      MIOTYATCLIENT_RETURN_CODE_OK if queued,
+ *              MIOTYATCLIENT_RETURN_CODE_ArgumentSizeMismatch if the message is too large,
+ *              MIOTYATCLIENT_RETURN_CODE_ArgumentOOR if type or priority are invalid,
+ *              MIOTYATCLIENT_RETURN_CODE_Dropped if the queue is full and the policy rejects the message,
+ *              also if the callback of a message expired to make room pushed into the freed slot
+ */
+miotyAtClient_returnCode miotyAtUplinkQueue_push(miotyAtUplinkQueue *queue, miotyAtClient_uplinkType type,
+                                                 miotyAtUplinkQueue_priority priority, const uint8_t *msg, size_t sizeMsg,
+                                                 uint32_t ttlMs, miotyAtUplinkQueue_doneFn done, void *user);
+
+/**
+ * @brief Expire old messages and hand the next ones to the client, without reading from the modem
+ *
+ * Useful if the context is driven by \ref miotyAtClient_feed or another loop calling \ref miotyAtClient_poll.
+ */
+void miotyAtUplinkQueue_service(miotyAtUplinkQueue *queue);
+
+/**
+ * @brief Service the queue and poll its client context once
+ *
+ * @return      true if messages are waiting or in flight
+ */
+bool miotyAtUplinkQueue_poll(miotyAtUplinkQueue *queue);
+
+/**
+ * @brief Set the backpressure watermarks and callback
+ *
+ * Backpressure becomes active when the number of used slots reaches high and is released
+ * when it falls to low again.
+ *
+ * @param[in,out]   queue           Queue
+ * @param[in]       high            Used slots activating backpressure, at most MIOTYATUPLINKQUEUE_SIZE
+ * @param[in]       low             Used slots releasing backpressure, below high
+ * @param[in]       onBackpressure  Called when the signal changes, may be NULL
+ * @param[in]       user            Handed to onBackpressure
+ */
+void miotyAtUplinkQueue_setWatermarks(miotyAtUplinkQueue *queue, uint8_t high, uint8_t low,
+                                      miotyAtUplinkQueue_backpressureFn onBackpressure, void *user);
+
+/**
+ * @brief Check whether producers should hold back messages
+ */
+bool miotyAtUplinkQueue_backpressure(const miotyAtUplinkQueue *queue);
+
+/**
+ * @brief Number of messages waiting or in flight
+ */
+size_t miotyAtUplinkQueue_count(const miotyAtUplinkQueue *queue);
+
+/**
+ * @brief Get the counters, the depth and the age of the oldest message of a queue
+ */
+void miotyAtUplinkQueue_getStats(const miotyAtUplinkQueue *queue, miotyAtUplinkQueue_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif